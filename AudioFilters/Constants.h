@@ -11,6 +11,8 @@
 #ifndef Constants_h
 #define Constants_h
 
+#include <stdint.h>
+
 #define BM_DB_TO_GAIN(db) pow(10.0,db/20.0)
 #define BM_GAIN_TO_DB(gain) log10f(gain)*20.0
 #define BM_BUFFER_CHUNK_SIZE 512
@@ -30,6 +32,24 @@
 #ifndef is_aligned
 #define is_aligned(POINTER, BYTE_COUNT) (((uintptr_t)(const void *)(POINTER)) % (BYTE_COUNT) == 0)
 #endif
+
+/*
+ * BM_SIMD_DISPATCH marks a function for compilation in several versions
+ * targeting different instruction sets. On x86_64 with glibc the dynamic
+ * linker picks the AVX2 version when the CPU supports it and the SSE2
+ * version otherwise. On other platforms the function is compiled once for
+ * the baseline instruction set, which is NEON on arm64.
+ *
+ * Vector helper functions called from a dispatched function must be
+ * declared always_inline so that they are compiled for the same target.
+ */
+#ifndef BM_SIMD_DISPATCH
+#if defined(__x86_64__) && defined(__GLIBC__) && (defined(__GNUC__) || defined(__clang__))
+#define BM_SIMD_DISPATCH __attribute__((target_clones("avx2","default")))
+#else
+#define BM_SIMD_DISPATCH
+#endif
+#endif
     
 ///*
 // * This macro handles chunked processing of an array for a process function
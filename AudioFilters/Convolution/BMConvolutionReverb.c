@@ -0,0 +1,657 @@
+//
+//  BMConvolutionReverb.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMConvolutionReverb.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// states of a tail job
+enum {
+	BMCR_JOB_IDLE,
+	BMCR_JOB_QUEUED,
+	BMCR_JOB_RUNNING,
+	BMCR_JOB_REMOVED
+};
+
+#define BMCR_HEAD_LENGTH (2*BMCR_TAIL_BLOCK_SIZE)
+
+// capacity of the handoff buffers, in samples. The output buffer starts
+// with BMCR_HEAD_LENGTH samples of silence.
+#define BMCR_INPUT_BUFFER_LENGTH (4*BMCR_TAIL_BLOCK_SIZE)
+#define BMCR_OUTPUT_BUFFER_LENGTH (BMCR_HEAD_LENGTH + 4*BMCR_TAIL_BLOCK_SIZE)
+
+#define BMCR_MAX_WORKERS 4
+
+
+
+
+#pragma mark - scheduler
+
+/*
+ * Wake-up signal for the workers. Posting must not block because we do it
+ * on the audio thread.
+ */
+#ifdef __APPLE__
+typedef dispatch_semaphore_t BMCRSemaphore;
+static void BMCRSemaphore_init(BMCRSemaphore *s){ *s = dispatch_semaphore_create(0); }
+static void BMCRSemaphore_free(BMCRSemaphore *s){ dispatch_release(*s); }
+static void BMCRSemaphore_post(BMCRSemaphore *s){ dispatch_semaphore_signal(*s); }
+static void BMCRSemaphore_wait(BMCRSemaphore *s){ dispatch_semaphore_wait(*s, DISPATCH_TIME_FOREVER); }
+#else
+typedef sem_t BMCRSemaphore;
+static void BMCRSemaphore_init(BMCRSemaphore *s){ sem_init(s, 0, 0); }
+static void BMCRSemaphore_free(BMCRSemaphore *s){ sem_destroy(s); }
+static void BMCRSemaphore_post(BMCRSemaphore *s){ sem_post(s); }
+static void BMCRSemaphore_wait(BMCRSemaphore *s){ while(sem_wait(s) != 0); }
+#endif
+
+
+/*
+ * Table of registered tail channels. Empty slots are NULL.
+ */
+typedef struct BMCRChannelTable {
+	size_t capacity;
+	BMConvolutionReverbTail * _Atomic channels [];
+} BMCRChannelTable;
+
+
+/*
+ * The scheduler is shared by all instances of the reverb. Tail channels
+ * are registered in a table that is replaced by a larger one when it is
+ * full. Registration takes a lock but that only happens in init and free.
+ * The workers access the table without locks.
+ */
+typedef struct BMCRScheduler {
+	BMCRChannelTable * _Atomic table;
+	pthread_t workers [BMCR_MAX_WORKERS];
+	size_t numWorkers;
+	BMCRSemaphore wakeUp;
+	atomic_bool running;
+
+	// number of workers currently scanning the channel table
+	atomic_int numScanning;
+
+	size_t numInstances;
+} BMCRScheduler;
+
+static BMCRScheduler BMCRGlobalScheduler;
+static pthread_mutex_t BMCRSchedulerLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void BMConvolutionReverbTail_process(BMConvolutionReverbTail *This);
+
+
+
+
+static double BMCR_currentTime(void){
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + 1.0e-9 * (double)t.tv_nsec;
+}
+
+
+
+
+/*!
+ *BMCRScheduler_claimEarliestJob
+ *
+ * @abstract find the queued job with the earliest deadline and mark it as running
+ *
+ * @returns the channel, or NULL if no jobs are queued
+ */
+static BMConvolutionReverbTail* BMCRScheduler_claimEarliestJob(BMCRScheduler *This){
+	while(true){
+		atomic_fetch_add(&This->numScanning, 1);
+
+		// load the table after incrementing numScanning, so that the table
+		// can't be freed while we scan it
+		BMCRChannelTable *table = atomic_load(&This->table);
+		BMConvolutionReverbTail *earliest = NULL;
+		double earliestDeadline = 0.0;
+		for(size_t i=0; i<table->capacity; i++){
+			BMConvolutionReverbTail *c = atomic_load(&table->channels[i]);
+			if(c && atomic_load(&c->state) == BMCR_JOB_QUEUED){
+				double deadline = atomic_load(&c->deadline);
+				if(!earliest || deadline < earliestDeadline){
+					earliest = c;
+					earliestDeadline = deadline;
+				}
+			}
+		}
+
+		// claim it. If another worker got there first, scan again.
+		bool claimed = false;
+		if(earliest){
+			int expected = BMCR_JOB_QUEUED;
+			claimed = atomic_compare_exchange_strong(&earliest->state, &expected, BMCR_JOB_RUNNING);
+		}
+
+		atomic_fetch_sub(&This->numScanning, 1);
+
+		if(!earliest) return NULL;
+		if(claimed) return earliest;
+	}
+}
+
+
+
+
+static void* BMCRScheduler_workerThread(void *arg){
+	BMCRScheduler *This = (BMCRScheduler*)arg;
+
+	while(true){
+		BMCRSemaphore_wait(&This->wakeUp);
+		if(!atomic_load(&This->running)) break;
+
+		// run jobs until there are none left. We may find jobs here that
+		// were posted after this worker woke up, so some wake-ups will find
+		// nothing to do.
+		BMConvolutionReverbTail *c;
+		while((c = BMCRScheduler_claimEarliestJob(This))){
+			BMConvolutionReverbTail_process(c);
+			atomic_store(&c->state, BMCR_JOB_IDLE);
+		}
+	}
+
+	return NULL;
+}
+
+
+
+
+/*!
+ *BMCRChannelTable_new
+ *
+ * @returns an empty table with the given capacity
+ */
+static BMCRChannelTable* BMCRChannelTable_new(size_t capacity){
+	BMCRChannelTable *table = malloc(sizeof(BMCRChannelTable) + sizeof(BMConvolutionReverbTail*) * capacity);
+	table->capacity = capacity;
+	for(size_t i=0; i<capacity; i++)
+		atomic_store(&table->channels[i], NULL);
+	return table;
+}
+
+
+
+
+/*
+ * wait until no worker could still hold a pointer from a scan of the
+ * channel table that started before now
+ */
+static void BMCRScheduler_waitForScans(BMCRScheduler *This){
+	while(atomic_load(&This->numScanning) > 0)
+		sched_yield();
+}
+
+
+
+
+static void BMCRScheduler_addInstance(void){
+	pthread_mutex_lock(&BMCRSchedulerLock);
+	BMCRScheduler *This = &BMCRGlobalScheduler;
+
+	// start the workers when the first instance is created
+	if(This->numInstances == 0){
+		atomic_store(&This->table, BMCRChannelTable_new(BMCR_INITIAL_TAIL_CHANNELS));
+		atomic_store(&This->numScanning, 0);
+		atomic_store(&This->running, true);
+		BMCRSemaphore_init(&This->wakeUp);
+
+		// leave one core for the audio thread
+		long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+		This->numWorkers = numCores > 2 ? (size_t)(numCores - 1) : 1;
+		This->numWorkers = BM_MIN(This->numWorkers, (size_t)BMCR_MAX_WORKERS);
+		for(size_t i=0; i<This->numWorkers; i++)
+			pthread_create(&This->workers[i], NULL, BMCRScheduler_workerThread, This);
+	}
+	This->numInstances++;
+
+	pthread_mutex_unlock(&BMCRSchedulerLock);
+}
+
+
+
+
+static void BMCRScheduler_removeInstance(void){
+	pthread_mutex_lock(&BMCRSchedulerLock);
+	BMCRScheduler *This = &BMCRGlobalScheduler;
+
+	// stop the workers when the last instance is freed
+	This->numInstances--;
+	if(This->numInstances == 0){
+		atomic_store(&This->running, false);
+		for(size_t i=0; i<This->numWorkers; i++)
+			BMCRSemaphore_post(&This->wakeUp);
+		for(size_t i=0; i<This->numWorkers; i++)
+			pthread_join(This->workers[i], NULL);
+		BMCRSemaphore_free(&This->wakeUp);
+		free(atomic_load(&This->table));
+		atomic_store(&This->table, NULL);
+	}
+
+	pthread_mutex_unlock(&BMCRSchedulerLock);
+}
+
+
+
+
+static void BMCRScheduler_registerChannel(BMConvolutionReverbTail *c){
+	pthread_mutex_lock(&BMCRSchedulerLock);
+	BMCRScheduler *This = &BMCRGlobalScheduler;
+	BMCRChannelTable *table = atomic_load(&This->table);
+
+	// find an empty slot
+	size_t slot = 0;
+	while(slot < table->capacity && atomic_load(&table->channels[slot]) != NULL)
+		slot++;
+
+	// if the table is full, replace it with one twice as large. The old
+	// table can be freed once no worker is scanning it.
+	if(slot == table->capacity){
+		BMCRChannelTable *larger = BMCRChannelTable_new(2 * table->capacity);
+		for(size_t i=0; i<table->capacity; i++)
+			atomic_store(&larger->channels[i], atomic_load(&table->channels[i]));
+		atomic_store(&This->table, larger);
+		BMCRScheduler_waitForScans(This);
+		free(table);
+		table = larger;
+	}
+
+	atomic_store(&table->channels[slot], c);
+
+	pthread_mutex_unlock(&BMCRSchedulerLock);
+}
+
+
+
+
+static void BMCRScheduler_unregisterChannel(BMConvolutionReverbTail *c){
+	BMCRScheduler *This = &BMCRGlobalScheduler;
+
+	// prevent the job from being claimed, waiting if it is running now
+	while(true){
+		int state = atomic_load(&c->state);
+		if(state != BMCR_JOB_RUNNING &&
+		   atomic_compare_exchange_strong(&c->state, &state, BMCR_JOB_REMOVED))
+			break;
+		sched_yield();
+	}
+
+	pthread_mutex_lock(&BMCRSchedulerLock);
+	BMCRChannelTable *table = atomic_load(&This->table);
+	for(size_t i=0; i<table->capacity; i++)
+		if(atomic_load(&table->channels[i]) == c)
+			atomic_store(&table->channels[i], NULL);
+	pthread_mutex_unlock(&BMCRSchedulerLock);
+
+	// wait until no worker could still hold a pointer to the channel from
+	// a scan that started before we removed it
+	BMCRScheduler_waitForScans(This);
+}
+
+
+
+
+#pragma mark - tail
+
+static void BMConvolutionReverbTail_init(BMConvolutionReverbTail *This,
+										 const float * const *IRs,
+										 size_t numInputs,
+										 size_t length){
+	size_t B = BMCR_TAIL_BLOCK_SIZE;
+	assert(length > BMCR_HEAD_LENGTH);
+
+	This->numInputs = numInputs;
+	This->numPartitions = (length - BMCR_HEAD_LENGTH + B - 1) / B;
+	This->delayLineIndex = 0;
+	This->outputSamplesToDiscard = 0;
+	This->inputZerosPending = 0;
+	atomic_store(&This->state, BMCR_JOB_IDLE);
+	atomic_store(&This->deadline, 0.0);
+
+	BMFFT_init(&This->fft, 2*B);
+	This->timeBuffer = malloc(sizeof(float) * 2 * B);
+	This->accumulatorMemory = malloc(sizeof(float) * 2 * B);
+	This->accumulator.realp = This->accumulatorMemory;
+	This->accumulator.imagp = This->accumulatorMemory + B;
+
+	// kernel and delay line spectra for each input
+	size_t spectraPerInput = 2 * This->numPartitions;
+	This->spectrumMemory = calloc(numInputs * spectraPerInput * 2 * B, sizeof(float));
+	for(size_t i=0; i<numInputs; i++){
+		This->kernel[i] = malloc(sizeof(DSPSplitComplex) * This->numPartitions);
+		This->delayLine[i] = malloc(sizeof(DSPSplitComplex) * This->numPartitions);
+		This->history[i] = calloc(2 * B, sizeof(float));
+		for(size_t p=0; p<This->numPartitions; p++){
+			float *m = This->spectrumMemory + (i*spectraPerInput + 2*p) * 2 * B;
+			This->kernel[i][p].realp = m;
+			This->kernel[i][p].imagp = m + B;
+			This->delayLine[i][p].realp = m + 2*B;
+			This->delayLine[i][p].imagp = m + 3*B;
+
+			// copy one partition of the tail, padded with zeros to 2B
+			memset(This->timeBuffer, 0, sizeof(float) * 2 * B);
+			size_t start = BMCR_HEAD_LENGTH + p*B;
+			size_t partitionLength = BM_MIN(B, length - start);
+			memcpy(This->timeBuffer, IRs[i] + start, sizeof(float) * partitionLength);
+			BMFFT_FFTComplexOutput(&This->fft, This->timeBuffer, &This->kernel[i][p], 2*B);
+
+			// see the note on scaling in BMPartitionedConv_setup
+			float half = 0.5f;
+			vDSP_vsmul(This->kernel[i][p].realp, 1, &half, This->kernel[i][p].realp, 1, B);
+			vDSP_vsmul(This->kernel[i][p].imagp, 1, &half, This->kernel[i][p].imagp, 1, B);
+		}
+
+		TPCircularBufferInit(&This->inputBuffer[i], (uint32_t)(sizeof(float) * BMCR_INPUT_BUFFER_LENGTH));
+	}
+
+	// The tail output for input time t is due at time t + BMCR_HEAD_LENGTH.
+	// Starting the output buffer with that many zeros lines them up.
+	TPCircularBufferInit(&This->outputBuffer, (uint32_t)(sizeof(float) * BMCR_OUTPUT_BUFFER_LENGTH));
+	uint32_t bytesAvailable;
+	float *head = TPCircularBufferHead(&This->outputBuffer, &bytesAvailable);
+	assert(bytesAvailable >= sizeof(float) * BMCR_HEAD_LENGTH);
+	memset(head, 0, sizeof(float) * BMCR_HEAD_LENGTH);
+	TPCircularBufferProduce(&This->outputBuffer, (uint32_t)(sizeof(float) * BMCR_HEAD_LENGTH));
+}
+
+
+
+
+static void BMConvolutionReverbTail_free(BMConvolutionReverbTail *This){
+	BMFFT_free(&This->fft);
+	free(This->timeBuffer);
+	This->timeBuffer = NULL;
+	free(This->accumulatorMemory);
+	This->accumulatorMemory = NULL;
+	free(This->spectrumMemory);
+	This->spectrumMemory = NULL;
+	for(size_t i=0; i<This->numInputs; i++){
+		free(This->kernel[i]);
+		free(This->delayLine[i]);
+		free(This->history[i]);
+		This->kernel[i] = This->delayLine[i] = NULL;
+		This->history[i] = NULL;
+		TPCircularBufferCleanup(&This->inputBuffer[i]);
+	}
+	TPCircularBufferCleanup(&This->outputBuffer);
+}
+
+
+
+
+/*!
+ *BMConvolutionReverbTail_process
+ *
+ * @abstract process all complete blocks of input. This runs on a worker thread.
+ */
+static void BMConvolutionReverbTail_process(BMConvolutionReverbTail *This){
+	size_t B = BMCR_TAIL_BLOCK_SIZE;
+	uint32_t blockBytes = (uint32_t)(sizeof(float) * B);
+
+	while(true){
+		// the audio thread writes all inputs together so they have the same
+		// number of samples available
+		uint32_t bytesAvailable;
+		TPCircularBufferTail(&This->inputBuffer[0], &bytesAvailable);
+		if(bytesAvailable < blockBytes) break;
+
+		// don't compute output that there is no room for
+		TPCircularBufferHead(&This->outputBuffer, &bytesAvailable);
+		if(bytesAvailable < blockBytes) break;
+
+		This->delayLineIndex = This->delayLineIndex == 0 ? This->numPartitions - 1 : This->delayLineIndex - 1;
+
+		for(size_t i=0; i<This->numInputs; i++){
+			// shift the history back one block and append the new input
+			memcpy(This->history[i], This->history[i] + B, blockBytes);
+			float *tail = TPCircularBufferTail(&This->inputBuffer[i], &bytesAvailable);
+			memcpy(This->history[i] + B, tail, blockBytes);
+			TPCircularBufferConsume(&This->inputBuffer[i], blockBytes);
+
+			BMFFT_FFTComplexOutput(&This->fft, This->history[i], &This->delayLine[i][This->delayLineIndex], 2*B);
+		}
+
+		// multiply each partition of the kernel with the input spectrum
+		// from the corresponding number of blocks ago
+		memset(This->accumulatorMemory, 0, sizeof(float) * 2 * B);
+		for(size_t i=0; i<This->numInputs; i++){
+			for(size_t p=0; p<This->numPartitions; p++){
+				size_t slot = This->delayLineIndex + p;
+				if(slot >= This->numPartitions) slot -= This->numPartitions;
+				BMPartitionedConv_complexMultiplyAdd(&This->delayLine[i][slot], &This->kernel[i][p], &This->accumulator, B);
+			}
+		}
+
+		// by overlap-save, the second half of the inverse transform is the
+		// output for this block
+		BMFFT_IFFTComplexInput(&This->fft, &This->accumulator, This->timeBuffer, 2*B);
+		TPCircularBufferProduceBytes(&This->outputBuffer, This->timeBuffer + B, blockBytes);
+	}
+}
+
+
+
+
+/*!
+ *BMConvolutionReverbTail_processAudioThread
+ *
+ * @abstract hand the input to the workers, post a job if a block is ready, and add whatever tail output is ready to output
+ */
+static void BMConvolutionReverbTail_processAudioThread(BMConvolutionReverbTail *This,
+													   const float * const *inputs,
+													   float *output,
+													   size_t numSamples,
+													   double sampleRate){
+	uint32_t bytesAvailable;
+
+	// input. If the workers have fallen so far behind that the input buffer
+	// is full, we drop input here and make up for it with zeros later so
+	// that the timing stays correct.
+	TPCircularBufferHead(&This->inputBuffer[0], &bytesAvailable);
+	size_t samplesAvailable = bytesAvailable / sizeof(float);
+	size_t zeros = BM_MIN(This->inputZerosPending, samplesAvailable);
+	size_t samplesWriting = BM_MIN(numSamples, samplesAvailable - zeros);
+	for(size_t i=0; i<This->numInputs; i++){
+		float *head = TPCircularBufferHead(&This->inputBuffer[i], &bytesAvailable);
+		memset(head, 0, sizeof(float) * zeros);
+		memcpy(head + zeros, inputs[i], sizeof(float) * samplesWriting);
+		TPCircularBufferProduce(&This->inputBuffer[i], (uint32_t)(sizeof(float) * (zeros + samplesWriting)));
+	}
+	This->inputZerosPending += (numSamples - samplesWriting) - zeros;
+
+	// post a job if there is a full block of input and the job isn't
+	// already queued or running. If a worker is running the job now, it
+	// will process the new block before it finishes, or we'll post it on
+	// the next call.
+	TPCircularBufferTail(&This->inputBuffer[0], &bytesAvailable);
+	if(bytesAvailable >= sizeof(float) * BMCR_TAIL_BLOCK_SIZE &&
+	   atomic_load(&This->state) == BMCR_JOB_IDLE){
+		// the output for the oldest block in the buffer is due when the
+		// output buffer runs out
+		TPCircularBufferTail(&This->outputBuffer, &bytesAvailable);
+		double secondsUntilDue = (double)(bytesAvailable / sizeof(float)) / sampleRate;
+		atomic_store(&This->deadline, BMCR_currentTime() + secondsUntilDue);
+
+		int expected = BMCR_JOB_IDLE;
+		if(atomic_compare_exchange_strong(&This->state, &expected, BMCR_JOB_QUEUED))
+			BMCRSemaphore_post(&BMCRGlobalScheduler.wakeUp);
+	}
+
+	// output. Discard anything that arrived too late to use.
+	float *tail = TPCircularBufferTail(&This->outputBuffer, &bytesAvailable);
+	size_t outputAvailable = bytesAvailable / sizeof(float);
+	size_t discard = BM_MIN(This->outputSamplesToDiscard, outputAvailable);
+	This->outputSamplesToDiscard -= discard;
+	outputAvailable -= discard;
+	tail += discard;
+
+	size_t samplesReading = BM_MIN(numSamples, outputAvailable);
+	vDSP_vadd(output, 1, tail, 1, output, 1, samplesReading);
+	TPCircularBufferConsume(&This->outputBuffer, (uint32_t)(sizeof(float) * (discard + samplesReading)));
+
+	// if the worker is late, the output is missing the tail for now
+	This->outputSamplesToDiscard += numSamples - samplesReading;
+}
+
+
+
+
+#pragma mark - reverb
+
+static void BMConvolutionReverb_init(BMConvolutionReverb *This,
+									 const float *IRs [2][2],
+									 size_t length,
+									 double sampleRate){
+	This->sampleRate = sampleRate;
+	This->buffer = malloc(sizeof(float) * 3 * BM_BUFFER_CHUNK_SIZE);
+
+	// head
+	size_t headLength = BM_MIN(length, (size_t)BMCR_HEAD_LENGTH);
+	for(size_t out=0; out<2; out++)
+		for(size_t in=0; in<2; in++){
+			This->headActive[out][in] = IRs[out][in] != NULL;
+			if(This->headActive[out][in])
+				BMPartitionedConv_initZeroLatency(&This->head[out][in],
+												  IRs[out][in],
+												  headLength,
+												  BMPC_DEFAULT_MIN_BLOCK_SIZE,
+												  BMCR_HEAD_MAX_BLOCK_SIZE);
+		}
+
+	// tail
+	This->hasTail = length > BMCR_HEAD_LENGTH;
+	if(This->hasTail){
+		BMCRScheduler_addInstance();
+		for(size_t out=0; out<2; out++){
+			// collect the impulse responses that go to this output. In
+			// stereo mode there is only one.
+			const float *tailIRs [2];
+			size_t numInputs = 0;
+			for(size_t in=0; in<2; in++)
+				if(IRs[out][in]) tailIRs[numInputs++] = IRs[out][in];
+			BMConvolutionReverbTail_init(&This->tail[out], tailIRs, numInputs, length);
+			BMCRScheduler_registerChannel(&This->tail[out]);
+		}
+	}
+}
+
+
+
+
+void BMConvolutionReverb_initStereo(BMConvolutionReverb *This,
+									const float *IRLeft,
+									const float *IRRight,
+									size_t length,
+									double sampleRate){
+	const float *IRs [2][2] = {{IRLeft, NULL}, {NULL, IRRight}};
+	BMConvolutionReverb_init(This, IRs, length, sampleRate);
+}
+
+
+
+
+void BMConvolutionReverb_initTrueStereo(BMConvolutionReverb *This,
+										const float *IRLL,
+										const float *IRRL,
+										const float *IRLR,
+										const float *IRRR,
+										size_t length,
+										double sampleRate){
+	const float *IRs [2][2] = {{IRLL, IRRL}, {IRLR, IRRR}};
+	BMConvolutionReverb_init(This, IRs, length, sampleRate);
+}
+
+
+
+
+void BMConvolutionReverb_free(BMConvolutionReverb *This){
+	if(This->hasTail){
+		for(size_t out=0; out<2; out++){
+			BMCRScheduler_unregisterChannel(&This->tail[out]);
+			BMConvolutionReverbTail_free(&This->tail[out]);
+		}
+		BMCRScheduler_removeInstance();
+	}
+
+	for(size_t out=0; out<2; out++)
+		for(size_t in=0; in<2; in++)
+			if(This->headActive[out][in])
+				BMPartitionedConv_free(&This->head[out][in]);
+
+	free(This->buffer);
+	This->buffer = NULL;
+}
+
+
+
+
+void BMConvolutionReverb_processStereo(BMConvolutionReverb *This,
+									   const float *inputL, const float *inputR,
+									   float *outputL, float *outputR,
+									   size_t numSamples){
+	// The outputs may share memory with the inputs, so we accumulate the
+	// output in temp buffers and copy it out after both inputs are used.
+	float *scratch = This->buffer;
+	float *mix [2] = {This->buffer + BM_BUFFER_CHUNK_SIZE, This->buffer + 2*BM_BUFFER_CHUNK_SIZE};
+
+	while(numSamples > 0){
+		size_t samplesProcessing = BM_MIN(numSamples, (size_t)BM_BUFFER_CHUNK_SIZE);
+		const float *inputs [2] = {inputL, inputR};
+
+		for(size_t out=0; out<2; out++){
+			memset(mix[out], 0, sizeof(float) * samplesProcessing);
+
+			// head
+			for(size_t in=0; in<2; in++)
+				if(This->headActive[out][in]){
+					BMPartitionedConv_process(&This->head[out][in], inputs[in], scratch, samplesProcessing);
+					vDSP_vadd(mix[out], 1, scratch, 1, mix[out], 1, samplesProcessing);
+				}
+
+			// tail
+			if(This->hasTail){
+				const float *tailInputs [2];
+				size_t numInputs = 0;
+				for(size_t in=0; in<2; in++)
+					if(This->headActive[out][in]) tailInputs[numInputs++] = inputs[in];
+				BMConvolutionReverbTail_processAudioThread(&This->tail[out], tailInputs, mix[out], samplesProcessing, This->sampleRate);
+			}
+		}
+
+		memcpy(outputL, mix[0], sizeof(float) * samplesProcessing);
+		memcpy(outputR, mix[1], sizeof(float) * samplesProcessing);
+
+		inputL += samplesProcessing;
+		inputR += samplesProcessing;
+		outputL += samplesProcessing;
+		outputR += samplesProcessing;
+		numSamples -= samplesProcessing;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
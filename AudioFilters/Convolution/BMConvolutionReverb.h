@@ -0,0 +1,177 @@
+//
+//  BMConvolutionReverb.h
+//  AudioFiltersXcodeProject
+//
+//  Stereo and true-stereo convolution reverb for long impulse responses.
+//
+//  The impulse response is split in two. The head, of length
+//  2 * BMCR_TAIL_BLOCK_SIZE, is convolved on the audio thread by
+//  BMPartitionedConv in zero latency mode with small partitions. The tail is
+//  convolved on worker threads in blocks of BMCR_TAIL_BLOCK_SIZE samples.
+//
+//  Input for the tail goes to the workers through a TPCircularBuffer and
+//  the output comes back through another. A block of tail output isn't
+//  needed until one block after the input for it is complete, so the
+//  workers have that long to compute it. The workers are shared by all
+//  instances of the reverb and always run the job with the earliest
+//  deadline first. The audio thread never waits for a worker and never
+//  takes a lock; it only marks jobs as ready with an atomic flag.
+//
+//  The work done on the audio thread is the same for any impulse response
+//  longer than the head, so an 8 second response at 96 kHz costs the audio
+//  thread no more than one of 16384 samples.
+//
+//  If a worker misses its deadline, the missing tail output is replaced with
+//  silence and the late output is discarded when it arrives, so the tail
+//  stays in time with the head.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMConvolutionReverb_h
+#define BMConvolutionReverb_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "BMPartitionedConv.h"
+#include "TPCircularBuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// block size for the tail of the impulse response, computed on workers
+#define BMCR_TAIL_BLOCK_SIZE 8192
+
+// the head is convolved on the audio thread with partitions from
+// BMPC_DEFAULT_MIN_BLOCK_SIZE up to this size
+#define BMCR_HEAD_MAX_BLOCK_SIZE 1024
+
+// initial size of the table of tail channels shared by all instances of
+// the reverb. The table doubles in size when it is full.
+#define BMCR_INITIAL_TAIL_CHANNELS 16
+
+
+/*
+ * The part of the reverb that computes one output channel of the tail. This
+ * is processed on a worker thread.
+ */
+typedef struct BMConvolutionReverbTail {
+	// 1 for stereo, 2 for true stereo
+	size_t numInputs;
+	size_t numPartitions;
+
+	// spectra of the impulse response partitions, [input][partition]
+	DSPSplitComplex *kernel [2];
+
+	// spectra of recent input blocks, [input][partition], and the index of
+	// the newest
+	DSPSplitComplex *delayLine [2];
+	size_t delayLineIndex;
+	float *spectrumMemory;
+
+	// the last two blocks of input, for overlap-save
+	float *history [2];
+
+	// scratch memory for the worker
+	BMFFT fft;
+	float *timeBuffer;
+	DSPSplitComplex accumulator;
+	float *accumulatorMemory;
+
+	// handoff between the audio thread and the workers
+	TPCircularBuffer inputBuffer [2];
+	TPCircularBuffer outputBuffer;
+
+	// job status, shared with the workers
+	atomic_int state;
+	_Atomic double deadline;
+
+	// used only on the audio thread. These keep the tail in time with the
+	// head if a worker is late.
+	size_t outputSamplesToDiscard;
+	size_t inputZerosPending;
+} BMConvolutionReverbTail;
+
+
+
+typedef struct BMConvolutionReverb {
+	// head convolution, [output][input]
+	BMPartitionedConv head [2][2];
+	bool headActive [2][2];
+
+	BMConvolutionReverbTail tail [2];
+	bool hasTail;
+
+	float *buffer;
+	double sampleRate;
+} BMConvolutionReverb;
+
+
+
+/*!
+ *BMConvolutionReverb_initStereo
+ *
+ * @abstract init with one impulse response for each channel. The left input goes only to the left output and the right input only to the right output.
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param IRLeft      impulse response for the left channel
+ * @param IRRight     impulse response for the right channel
+ * @param length      length of each impulse response
+ * @param sampleRate  audio sample rate
+ */
+void BMConvolutionReverb_initStereo(BMConvolutionReverb *This,
+									const float *IRLeft,
+									const float *IRRight,
+									size_t length,
+									double sampleRate);
+
+
+/*!
+ *BMConvolutionReverb_initTrueStereo
+ *
+ * @abstract init with four impulse responses, one from each input to each output
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param IRLL        left input to left output
+ * @param IRRL        right input to left output
+ * @param IRLR        left input to right output
+ * @param IRRR        right input to right output
+ * @param length      length of each impulse response
+ * @param sampleRate  audio sample rate
+ */
+void BMConvolutionReverb_initTrueStereo(BMConvolutionReverb *This,
+										const float *IRLL,
+										const float *IRRL,
+										const float *IRLR,
+										const float *IRRR,
+										size_t length,
+										double sampleRate);
+
+
+/*!
+ *BMConvolutionReverb_free
+ *
+ * @abstract waits for any work in progress on the worker threads, then frees memory. The worker threads stop when the last instance is freed.
+ */
+void BMConvolutionReverb_free(BMConvolutionReverb *This);
+
+
+/*!
+ *BMConvolutionReverb_processStereo
+ *
+ * @abstract the output is 100% wet. In-place processing is supported.
+ */
+void BMConvolutionReverb_processStereo(BMConvolutionReverb *This,
+									   const float *inputL, const float *inputR,
+									   float *outputL, float *outputR,
+									   size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMConvolutionReverb_h */
@@ -0,0 +1,374 @@
+//
+//  BMPartitionedConv.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMPartitionedConv.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "Constants.h"
+#include "BMIntegerMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+static size_t BMPartitionedConv_nextPowerOfTwo(size_t x){
+	size_t p = 1;
+	while(p < x) p <<= 1;
+	return p;
+}
+
+
+
+
+/*!
+ *BMPartitionedConv_addStage
+ *
+ * @abstract append a stage with numPartitions partitions of size blockSize, starting at offset in the kernel
+ */
+static void BMPartitionedConv_addStage(BMPartitionedConv *This, size_t blockSize, size_t numPartitions, size_t offset){
+	This->stages = realloc(This->stages, sizeof(BMPartitionedConvStage) * (This->numStages + 1));
+	BMPartitionedConvStage *stage = This->stages + This->numStages;
+	This->numStages++;
+
+	stage->blockSize = blockSize;
+	stage->numPartitions = numPartitions;
+	stage->offset = offset;
+	stage->delayLineIndex = 0;
+
+	// each spectrum has blockSize complex elements, with the Nyquist term
+	// packed into the imaginary part of the DC term
+	size_t spectrumLength = blockSize;
+	stage->memory = calloc(4 * numPartitions * spectrumLength, sizeof(float));
+	stage->delayLine = malloc(sizeof(DSPSplitComplex) * numPartitions);
+	stage->kernel = malloc(sizeof(DSPSplitComplex) * numPartitions);
+	for(size_t p=0; p<numPartitions; p++){
+		float *m = stage->memory + 4*p*spectrumLength;
+		stage->delayLine[p].realp = m;
+		stage->delayLine[p].imagp = m + spectrumLength;
+		stage->kernel[p].realp = m + 2*spectrumLength;
+		stage->kernel[p].imagp = m + 3*spectrumLength;
+	}
+}
+
+
+
+
+/*!
+ *BMPartitionedConv_setup
+ *
+ * @abstract allocate buffers and compute the kernel spectra once the stages have been planned
+ */
+static void BMPartitionedConv_setup(BMPartitionedConv *This, const float *kernel){
+	// find the largest block size
+	size_t maxBlockSize = This->minBlockSize;
+	for(size_t s=0; s<This->numStages; s++)
+		maxBlockSize = BM_MAX(maxBlockSize, This->stages[s].blockSize);
+
+	BMFFT_init(&This->fft, 2*maxBlockSize);
+	This->timeBuffer = malloc(sizeof(float) * 2 * maxBlockSize);
+	This->accumulatorMemory = malloc(sizeof(float) * 2 * maxBlockSize);
+	This->accumulator.realp = This->accumulatorMemory;
+	This->accumulator.imagp = This->accumulatorMemory + maxBlockSize;
+
+	// the input ring holds the last two blocks of the largest size
+	size_t inputRingLength = 2*maxBlockSize;
+	This->inputRing = calloc(inputRingLength, sizeof(float));
+	This->inputRingMask = inputRingLength - 1;
+
+	// each stage writes its output ahead of the current time by up to
+	// offset + latency samples
+	size_t maxWriteAhead = 0;
+	for(size_t s=0; s<This->numStages; s++)
+		maxWriteAhead = BM_MAX(maxWriteAhead, This->stages[s].offset + This->latency);
+	size_t outputRingLength = BMPartitionedConv_nextPowerOfTwo(maxWriteAhead + This->minBlockSize);
+	This->outputRing = calloc(outputRingLength, sizeof(float));
+	This->outputRingMask = outputRingLength - 1;
+
+	// head
+	if(This->headLength > 0){
+		This->head = malloc(sizeof(float) * This->headLength);
+		memcpy(This->head, kernel, sizeof(float) * This->headLength);
+
+		// the head buffer holds headLength - 1 samples of history followed
+		// by up to minBlockSize new samples
+		This->headBuffer = calloc(This->headLength - 1 + This->minBlockSize, sizeof(float));
+	}
+
+	// compute the spectra of the kernel partitions
+	for(size_t s=0; s<This->numStages; s++){
+		BMPartitionedConvStage *stage = This->stages + s;
+		size_t B = stage->blockSize;
+		for(size_t p=0; p<stage->numPartitions; p++){
+			// copy one partition and pad with zeros to length 2B
+			memset(This->timeBuffer, 0, sizeof(float) * 2 * B);
+			size_t start = stage->offset + p*B;
+			if(start < This->length){
+				size_t partitionLength = BM_MIN(B, This->length - start);
+				memcpy(This->timeBuffer, kernel + start, sizeof(float) * partitionLength);
+			}
+			BMFFT_FFTComplexOutput(&This->fft, This->timeBuffer, &stage->kernel[p], 2*B);
+
+			// The forward FFT scales by 2 and we are going to multiply two
+			// spectra. BMFFT_IFFTComplexInput undoes only one factor of 2.
+			float half = 0.5f;
+			vDSP_vsmul(stage->kernel[p].realp, 1, &half, stage->kernel[p].realp, 1, B);
+			vDSP_vsmul(stage->kernel[p].imagp, 1, &half, stage->kernel[p].imagp, 1, B);
+		}
+	}
+
+	This->samplesProcessed = 0;
+}
+
+
+
+
+static void BMPartitionedConv_initCommon(BMPartitionedConv *This, size_t length, size_t minBlockSize){
+	assert(length > 0);
+	assert(isPowerOfTwo(minBlockSize) && minBlockSize > 1);
+
+	This->length = length;
+	This->minBlockSize = minBlockSize;
+	This->stages = NULL;
+	This->numStages = 0;
+	This->head = NULL;
+	This->headBuffer = NULL;
+	This->headLength = 0;
+	This->latency = 0;
+}
+
+
+
+
+void BMPartitionedConv_initUniform(BMPartitionedConv *This, const float *kernel, size_t length, size_t blockSize){
+	BMPartitionedConv_initCommon(This, length, blockSize);
+
+	// one stage covers the whole kernel. The output of each block is ready
+	// one block after its input, so the latency is one block.
+	This->latency = blockSize;
+	size_t numPartitions = (length + blockSize - 1) / blockSize;
+	BMPartitionedConv_addStage(This, blockSize, numPartitions, 0);
+
+	BMPartitionedConv_setup(This, kernel);
+}
+
+
+
+
+void BMPartitionedConv_initZeroLatency(BMPartitionedConv *This, const float *kernel, size_t length, size_t minBlockSize, size_t maxBlockSize){
+	assert(isPowerOfTwo(maxBlockSize) && maxBlockSize >= minBlockSize);
+	BMPartitionedConv_initCommon(This, length, minBlockSize);
+
+	// the head covers the first block of the kernel
+	This->headLength = BM_MIN(minBlockSize, length);
+
+	// The output of a stage with block size B is ready B samples after its
+	// input, so a stage can start no earlier than B samples into the kernel.
+	// If a stage starts at offset >= B and has at least one partition, the
+	// next stage starts at offset + B >= 2B, so it can use blocks of size
+	// 2B.
+	size_t offset = This->headLength;
+	size_t blockSize = minBlockSize;
+	while(offset < length){
+		size_t remaining = length - offset;
+		size_t numPartitions = (remaining + blockSize - 1) / blockSize;
+		if(blockSize < maxBlockSize)
+			numPartitions = BM_MIN(numPartitions, (size_t)BMPC_PARTITIONS_PER_STAGE);
+
+		BMPartitionedConv_addStage(This, blockSize, numPartitions, offset);
+		offset += numPartitions * blockSize;
+
+		if(blockSize < maxBlockSize)
+			blockSize *= 2;
+	}
+
+	BMPartitionedConv_setup(This, kernel);
+}
+
+
+
+
+void BMPartitionedConv_free(BMPartitionedConv *This){
+	for(size_t s=0; s<This->numStages; s++){
+		free(This->stages[s].memory);
+		free(This->stages[s].delayLine);
+		free(This->stages[s].kernel);
+	}
+	free(This->stages);
+	This->stages = NULL;
+	This->numStages = 0;
+
+	BMFFT_free(&This->fft);
+
+	free(This->head);
+	This->head = NULL;
+	free(This->headBuffer);
+	This->headBuffer = NULL;
+	free(This->inputRing);
+	This->inputRing = NULL;
+	free(This->outputRing);
+	This->outputRing = NULL;
+	free(This->timeBuffer);
+	This->timeBuffer = NULL;
+	free(This->accumulatorMemory);
+	This->accumulatorMemory = NULL;
+}
+
+
+
+
+size_t BMPartitionedConv_getLatency(const BMPartitionedConv *This){
+	return This->latency;
+}
+
+
+
+
+void BMPartitionedConv_clearBuffers(BMPartitionedConv *This){
+	memset(This->inputRing, 0, sizeof(float) * (This->inputRingMask + 1));
+	memset(This->outputRing, 0, sizeof(float) * (This->outputRingMask + 1));
+	if(This->headBuffer)
+		memset(This->headBuffer, 0, sizeof(float) * (This->headLength - 1 + This->minBlockSize));
+	for(size_t s=0; s<This->numStages; s++){
+		BMPartitionedConvStage *stage = This->stages + s;
+		for(size_t p=0; p<stage->numPartitions; p++){
+			memset(stage->delayLine[p].realp, 0, sizeof(float) * stage->blockSize);
+			memset(stage->delayLine[p].imagp, 0, sizeof(float) * stage->blockSize);
+		}
+	}
+	This->samplesProcessed = 0;
+}
+
+
+
+
+#pragma mark - processing
+
+BM_SIMD_DISPATCH
+void BMPartitionedConv_complexMultiplyAdd(const DSPSplitComplex *A, const DSPSplitComplex *B, DSPSplitComplex *C, size_t length){
+	const float * restrict ar = A->realp;
+	const float * restrict ai = A->imagp;
+	const float * restrict br = B->realp;
+	const float * restrict bi = B->imagp;
+	float * restrict cr = C->realp;
+	float * restrict ci = C->imagp;
+
+	// DC and Nyquist
+	float dc = cr[0] + ar[0]*br[0];
+	float nyquist = ci[0] + ai[0]*bi[0];
+
+	for(size_t i=0; i<length; i++){
+		cr[i] += ar[i]*br[i] - ai[i]*bi[i];
+		ci[i] += ar[i]*bi[i] + ai[i]*br[i];
+	}
+
+	cr[0] = dc;
+	ci[0] = nyquist;
+}
+
+
+
+
+/*!
+ *BMPartitionedConv_processStage
+ *
+ * @abstract called when the input ring has just received a complete block for this stage. Computes the output of this stage for that block and adds it into the output ring.
+ */
+static void BMPartitionedConv_processStage(BMPartitionedConv *This, BMPartitionedConvStage *stage){
+	size_t B = stage->blockSize;
+
+	// copy the last 2B input samples out of the ring
+	size_t start = (size_t)(This->samplesProcessed - 2*B) & This->inputRingMask;
+	size_t firstCopy = BM_MIN(2*B, This->inputRingMask + 1 - start);
+	memcpy(This->timeBuffer, This->inputRing + start, sizeof(float) * firstCopy);
+	memcpy(This->timeBuffer + firstCopy, This->inputRing, sizeof(float) * (2*B - firstCopy));
+
+	// transform into the newest slot of the delay line
+	stage->delayLineIndex = stage->delayLineIndex == 0 ? stage->numPartitions - 1 : stage->delayLineIndex - 1;
+	BMFFT_FFTComplexOutput(&This->fft, This->timeBuffer, &stage->delayLine[stage->delayLineIndex], 2*B);
+
+	// multiply each partition of the kernel with the input spectrum from
+	// the corresponding number of blocks ago
+	memset(This->accumulator.realp, 0, sizeof(float) * B);
+	memset(This->accumulator.imagp, 0, sizeof(float) * B);
+	for(size_t p=0; p<stage->numPartitions; p++){
+		size_t slot = stage->delayLineIndex + p;
+		if(slot >= stage->numPartitions) slot -= stage->numPartitions;
+		BMPartitionedConv_complexMultiplyAdd(&stage->delayLine[slot], &stage->kernel[p], &This->accumulator, B);
+	}
+
+	// transform back. By overlap-save, the second half is the output for the
+	// most recent B input samples.
+	BMFFT_IFFTComplexInput(&This->fft, &This->accumulator, This->timeBuffer, 2*B);
+
+	// Add to the output ring. Kernel sample k of this stage delays by
+	// offset + k, so the output for input time t is due at
+	// t + offset + latency. The first input sample of this block arrived
+	// at samplesProcessed - B.
+	size_t writeStart = (size_t)(This->samplesProcessed - B + stage->offset + This->latency) & This->outputRingMask;
+	const float *blockOutput = This->timeBuffer + B;
+	size_t firstWrite = BM_MIN(B, This->outputRingMask + 1 - writeStart);
+	vDSP_vadd(blockOutput, 1, This->outputRing + writeStart, 1, This->outputRing + writeStart, 1, firstWrite);
+	vDSP_vadd(blockOutput + firstWrite, 1, This->outputRing, 1, This->outputRing, 1, B - firstWrite);
+}
+
+
+
+
+void BMPartitionedConv_process(BMPartitionedConv *This, const float *input, float *output, size_t numSamples){
+	while(numSamples > 0){
+		// process up to the end of the current block of the smallest size,
+		// because that is when the next stage might run
+		size_t positionInBlock = (size_t)This->samplesProcessed & (This->minBlockSize - 1);
+		size_t samplesProcessing = BM_MIN(numSamples, This->minBlockSize - positionInBlock);
+
+		// write the input into the ring
+		size_t inputStart = (size_t)This->samplesProcessed & This->inputRingMask;
+		size_t firstCopy = BM_MIN(samplesProcessing, This->inputRingMask + 1 - inputStart);
+		memcpy(This->inputRing + inputStart, input, sizeof(float) * firstCopy);
+		memcpy(This->inputRing, input + firstCopy, sizeof(float) * (samplesProcessing - firstCopy));
+
+		// convolve the head directly
+		if(This->headLength > 0){
+			size_t historyLength = This->headLength - 1;
+			memcpy(This->headBuffer + historyLength, input, sizeof(float) * samplesProcessing);
+			vDSP_conv(This->headBuffer, 1, This->head + historyLength, -1, output, 1, samplesProcessing, This->headLength);
+			memmove(This->headBuffer, This->headBuffer + samplesProcessing, sizeof(float) * historyLength);
+		} else {
+			memset(output, 0, sizeof(float) * samplesProcessing);
+		}
+
+		// add the output of the partitions from the ring and clear the ring
+		// behind us
+		size_t outputStart = (size_t)This->samplesProcessed & This->outputRingMask;
+		size_t firstRead = BM_MIN(samplesProcessing, This->outputRingMask + 1 - outputStart);
+		vDSP_vadd(output, 1, This->outputRing + outputStart, 1, output, 1, firstRead);
+		memset(This->outputRing + outputStart, 0, sizeof(float) * firstRead);
+		vDSP_vadd(output + firstRead, 1, This->outputRing, 1, output + firstRead, 1, samplesProcessing - firstRead);
+		memset(This->outputRing, 0, sizeof(float) * (samplesProcessing - firstRead));
+
+		This->samplesProcessed += samplesProcessing;
+
+		// run each stage whose block is now complete
+		for(size_t s=0; s<This->numStages; s++){
+			BMPartitionedConvStage *stage = This->stages + s;
+			if((This->samplesProcessed & (stage->blockSize - 1)) == 0)
+				BMPartitionedConv_processStage(This, stage);
+		}
+
+		input += samplesProcessing;
+		output += samplesProcessing;
+		numSamples -= samplesProcessing;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,175 @@
+//
+//  BMPartitionedConv.h
+//  AudioFiltersXcodeProject
+//
+//  Frequency-domain convolution for long filter kernels, such as measured
+//  cabinet and room impulse responses.
+//
+//  The kernel is split into partitions. Each partition is convolved with
+//  the input using overlap-save FFT convolution, and the spectra of past
+//  input blocks are kept in a frequency-domain delay line so that each
+//  input block is transformed only once for all the partitions of the
+//  same size.
+//
+//  There are two modes:
+//
+//  Uniform: all partitions have the same size. This is the most efficient
+//  mode but the output is delayed by one block.
+//
+//  Zero latency: the first block of the kernel is convolved directly in
+//  the time domain so there is no delay. The remaining partitions double in
+//  size until they reach maxBlockSize, with a few partitions of each size.
+//  Small partitions give low latency but cost more per sample than large
+//  ones, so this keeps the cost close to that of the uniform mode with
+//  large blocks.
+//
+//  In both modes the cost per sample grows with the log of the block size
+//  rather than with the length of the kernel, plus a small amount for each
+//  partition of the largest size.
+//
+//  All of the work for a block is done in the call to process in which the
+//  block is completed, so the processing time varies from one call to the
+//  next.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMPartitionedConv_h
+#define BMPartitionedConv_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "BMFFT.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of partitions of each size before doubling the size, in zero
+// latency mode
+#define BMPC_PARTITIONS_PER_STAGE 2
+
+#define BMPC_DEFAULT_MIN_BLOCK_SIZE 64
+#define BMPC_DEFAULT_MAX_BLOCK_SIZE 8192
+
+
+typedef struct BMPartitionedConvStage {
+	size_t blockSize, numPartitions;
+
+	// index in the kernel of the first sample of the first partition
+	size_t offset;
+
+	// spectra of the most recent numPartitions input blocks, and the
+	// index of the newest one
+	DSPSplitComplex *delayLine;
+	size_t delayLineIndex;
+
+	// spectra of the kernel partitions
+	DSPSplitComplex *kernel;
+
+	float *memory;
+} BMPartitionedConvStage;
+
+
+typedef struct BMPartitionedConv {
+	BMFFT fft;
+	BMPartitionedConvStage *stages;
+	size_t numStages;
+
+	// the first part of the kernel, convolved directly in zero latency mode
+	float *head;
+	float *headBuffer;
+	size_t headLength;
+
+	// input and output ring buffers. The lengths are powers of two.
+	float *inputRing, *outputRing;
+	size_t inputRingMask, outputRingMask;
+
+	float *timeBuffer;
+	DSPSplitComplex accumulator;
+	float *accumulatorMemory;
+
+	uint64_t samplesProcessed;
+	size_t length, minBlockSize, latency;
+} BMPartitionedConv;
+
+
+
+/*!
+ *BMPartitionedConv_initUniform
+ *
+ * @abstract init with all partitions the same size. The output is delayed by blockSize samples.
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param kernel      filter kernel (impulse response). This is copied.
+ * @param length      length of kernel
+ * @param blockSize   partition size. Must be a power of two.
+ */
+void BMPartitionedConv_initUniform(BMPartitionedConv *This, const float *kernel, size_t length, size_t blockSize);
+
+
+/*!
+ *BMPartitionedConv_initZeroLatency
+ *
+ * @abstract init with a directly convolved head of length minBlockSize and partitions doubling in size from minBlockSize up to maxBlockSize
+ *
+ * @param This          pointer to an uninitialised struct
+ * @param kernel        filter kernel (impulse response). This is copied.
+ * @param length        length of kernel
+ * @param minBlockSize  length of the head and size of the smallest partitions. Must be a power of two. BMPC_DEFAULT_MIN_BLOCK_SIZE is a good choice.
+ * @param maxBlockSize  size of the largest partitions. Must be a power of two >= minBlockSize. BMPC_DEFAULT_MAX_BLOCK_SIZE is a good choice.
+ */
+void BMPartitionedConv_initZeroLatency(BMPartitionedConv *This, const float *kernel, size_t length, size_t minBlockSize, size_t maxBlockSize);
+
+
+/*!
+ *BMPartitionedConv_free
+ */
+void BMPartitionedConv_free(BMPartitionedConv *This);
+
+
+/*!
+ *BMPartitionedConv_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param input       input array of length numSamples
+ * @param output      output array of length numSamples (in-place processing is supported)
+ * @param numSamples  number of samples to process. There is no limit.
+ */
+void BMPartitionedConv_process(BMPartitionedConv *This, const float *input, float *output, size_t numSamples);
+
+
+/*!
+ *BMPartitionedConv_getLatency
+ *
+ * @returns the delay of the output, in samples. This is zero in zero latency mode.
+ */
+size_t BMPartitionedConv_getLatency(const BMPartitionedConv *This);
+
+
+/*!
+ *BMPartitionedConv_clearBuffers
+ *
+ * @abstract clear the input history and any output that is waiting to be written, without changing the kernel
+ */
+void BMPartitionedConv_clearBuffers(BMPartitionedConv *This);
+
+
+
+/*!
+ *BMPartitionedConv_complexMultiplyAdd
+ *
+ * @abstract C += A * B for spectra in the packed format of BMFFT_FFTComplexOutput, where element 0 holds the real-valued DC and Nyquist terms
+ *
+ * @param length number of complex elements in each spectrum
+ */
+void BMPartitionedConv_complexMultiplyAdd(const DSPSplitComplex *A, const DSPSplitComplex *B, DSPSplitComplex *C, size_t length);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMPartitionedConv_h */
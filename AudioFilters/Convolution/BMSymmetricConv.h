@@ -18,7 +18,11 @@
 extern "C" {
 #endif
     
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
     
 #ifndef BMSymmetricConv_h
 #define BMSymmetricConv_h
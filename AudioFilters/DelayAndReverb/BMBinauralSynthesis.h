@@ -11,7 +11,11 @@
 
 #include <stdio.h>
 #include "BMMultiLevelBiquad.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 typedef struct BMBinauralSynthesis {
     BMMultiLevelBiquad filter;
@@ -321,9 +321,6 @@ void BMLongLoopFDN_process(BMLongLoopFDN *This,
 			
 			// reduce samples processing if the requested number of samples in unavailable
 			samplesProcessing = bytesProcessing / sizeof(float);
-			
-			if(samplesProcessing < This->minDelaySamples && numSamples > samplesProcessing)
-				printf("processing short: %zu\n", samplesProcessing);
 		}
 		
 		
@@ -497,9 +494,6 @@ void BMLongLoopFDN_processMultiChannelInput(BMLongLoopFDN *This,
 			
 			// reduce samples processing if the requested number of samples in unavailable
 			samplesProcessing = bytesProcessing / sizeof(float);
-			
-			if(samplesProcessing < This->minDelaySamples && numSamples > samplesProcessing)
-				printf("processing short: %zu\n", samplesProcessing);
 		}
 		
 		
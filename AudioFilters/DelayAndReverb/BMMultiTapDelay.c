@@ -7,7 +7,11 @@
 //
 
 #include "BMMultiTapDelay.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <stdlib.h>
 #include "Constants.h"
 
@@ -34,6 +38,7 @@ void BMMultiTapDelay_Init(BMMultiTapDelay *This,
     This->maxDelayTime = maxDelayTime;
     
     This->buffer = malloc(sizeof(TPCircularBuffer) * This->numberChannel);
+    This->tapKernel = malloc(sizeof(BMSparseTapKernel) * This->numberChannel);
     This->tempBuffer = malloc(sizeof(float*) * This->numberChannel);
     
     This->input = malloc(sizeof(float*) * This->numberChannel);
@@ -56,6 +61,7 @@ void BMMultiTapDelay_Init(BMMultiTapDelay *This,
         This->tempIndices[i] = malloc(sizeof(size_t) * maxTaps);
         This->tempGains[i] = malloc(sizeof(float) * maxTaps);
         This->tempBuffer[i] = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+        BMSparseTapKernel_init(&This->tapKernel[i], maxTaps);
     }
     
     BMMultiTapDelay_setDelayTimes(This, delayTimesL, delayTimesR);
@@ -97,9 +103,13 @@ void BMMultiTapDelay_free(BMMultiTapDelay *This){
         
         free(This->tempGains[i]);
         This->tempGains[i] = NULL;
-
+        
+        BMSparseTapKernel_free(&This->tapKernel[i]);
     }
     
+    free(This->tapKernel);
+    This->tapKernel = NULL;
+    
     free(This->lastTapOutput);
     This->lastTapOutput = NULL;
     
@@ -202,7 +212,6 @@ void BMMultiTapDelay_ProcessBufferMono(BMMultiTapDelay* delay,
     // this function is stereo in, stereo out; fail if the delay was
     // not initialised for that configuration
     
-    BMMultiTapDelaySetting* setting = &delay->setting;
     //this will bridge my code with Sir Hans's style ^_^
     delay->input[0] = input;
     delay->output[0] = output;
@@ -222,8 +231,6 @@ void BMMultiTapDelay_ProcessBufferMono(BMMultiTapDelay* delay,
         
         bytesThisTime = (int32_t)frameThisTime * sizeof(float);
 
-        //set 0 to the tempbuffer
-        memset(delay->tempBuffer[0], 0, BM_BUFFER_CHUNK_SIZE * sizeof(float));
         TPCircularBufferProduceBytes(&delay->buffer[0], delay->input[0]+framesProcessed, bytesThisTime);
         
         //from each read point, we read FrameThisTime frames to process
@@ -231,9 +238,8 @@ void BMMultiTapDelay_ProcessBufferMono(BMMultiTapDelay* delay,
         //this buffer will add directly to the output
         float* buffer = TPCircularBufferTail(&delay->buffer[0], &availableBytes);
         
-        for (int j=0; j<delay->numTaps; j++) {
-            vDSP_vsma(buffer + setting->indices[0][j], 1, &setting->gains[0][j], delay->tempBuffer[0], 1, delay->tempBuffer[0], 1, frameThisTime);
-        }
+        // sum the taps into the temp buffer
+        BMSparseTapKernel_process(&delay->tapKernel[0], buffer, delay->tempBuffer[0], frameThisTime);
         TPCircularBufferConsume(&delay->buffer[0], bytesThisTime);
         
         //we overwrite data to the output
@@ -259,7 +265,6 @@ void BMMultiTapDelay_processBufferStereo(BMMultiTapDelay* delay,
         BMMultiTapDelay_PerformUpdateGains(delay);
 	
     
-    BMMultiTapDelaySetting* setting = &delay->setting;
     //this will bridge my code with Sir Hans's style ^_^
     delay->input[0] = (float*)inputL;
     delay->input[1] = (float*)inputR;
@@ -282,8 +287,6 @@ void BMMultiTapDelay_processBufferStereo(BMMultiTapDelay* delay,
         bytesThisTime = (int32_t)frameThisTime * sizeof(float);
         
         for(size_t i=0; i<delay->numberChannel; i++){
-            //set 0 to the tempbuffer
-            memset(delay->tempBuffer[i], 0, BM_BUFFER_CHUNK_SIZE * sizeof(float));
             TPCircularBufferProduceBytes(&delay->buffer[i], delay->input[i]+framesProcessed, bytesThisTime);
             
             //from each read point, we read FrameThisTime frames to process
@@ -291,9 +294,8 @@ void BMMultiTapDelay_processBufferStereo(BMMultiTapDelay* delay,
             //this buffer will add directly to the output
             float* buffer = TPCircularBufferTail(&delay->buffer[i], &availableBytes);
             
-            for (int j=0; j<delay->numTaps; j++) {
-                vDSP_vsma(buffer + setting->indices[i][j], 1, &setting->gains[i][j], delay->tempBuffer[i], 1, delay->tempBuffer[i], 1, frameThisTime);
-            }
+            // sum the taps into the temp buffer
+            BMSparseTapKernel_process(&delay->tapKernel[i], buffer, delay->tempBuffer[i], frameThisTime);
             TPCircularBufferConsume(&delay->buffer[i], bytesThisTime);
             
             //we overwrite data to the output
@@ -343,8 +345,6 @@ void BMMultiTapDelay_processStereoWithFinalOutput(BMMultiTapDelay* delay,
         bytesThisTime = (int32_t)frameThisTime * sizeof(float);
         
         for(size_t i=0; i<delay->numberChannel; i++){
-            //set 0 to the tempbuffer
-            memset(delay->tempBuffer[i], 0, BM_BUFFER_CHUNK_SIZE * sizeof(float));
             TPCircularBufferProduceBytes(&delay->buffer[i], delay->input[i]+framesProcessed, bytesThisTime);
             
             //from each read point, we read FrameThisTime frames to process
@@ -352,15 +352,17 @@ void BMMultiTapDelay_processStereoWithFinalOutput(BMMultiTapDelay* delay,
             //this buffer will add directly to the output
             float* buffer = TPCircularBufferTail(&delay->buffer[i], &availableBytes);
             
-            for (int j=0; j<delay->numTaps; j++) {
-                if(j==delay->numTaps-1){
-                    //last tap -> store to lasttap output
-                    float gain = 1;
-                    vDSP_vsmul(buffer + setting->indices[i][j], 1, &gain, delay->lastTapOutput[i]+framesProcessed, 1, frameThisTime);
-                }
-                vDSP_vsma(buffer + setting->indices[i][j], 1, &setting->gains[i][j], delay->tempBuffer[i], 1, delay->tempBuffer[i], 1, frameThisTime);
-//                printf("indices %zu\n",setting->indices[i][j]);
+            //last tap -> store to lasttap output. With no taps there is
+            //no last tap so its output is silent.
+            if(delay->numTaps > 0){
+                size_t lastTap = delay->numTaps-1;
+                memcpy(delay->lastTapOutput[i]+framesProcessed, buffer + setting->indices[i][lastTap], bytesThisTime);
+            } else {
+                memset(delay->lastTapOutput[i]+framesProcessed, 0, bytesThisTime);
             }
+            
+            // sum the taps into the temp buffer
+            BMSparseTapKernel_process(&delay->tapKernel[i], buffer, delay->tempBuffer[i], frameThisTime);
             TPCircularBufferConsume(&delay->buffer[i], bytesThisTime);
             
             //we overwrite data to the output
@@ -442,6 +444,7 @@ void BMMultiTapDelay_PerformUpdateIndices(BMMultiTapDelay *This){
         for (int j=0; j<This->numTaps; j++) {
             setting->indices[i][j] = This->tempIndices[i][j];
         }
+        BMSparseTapKernel_setTaps(&This->tapKernel[i], setting->indices[i], setting->gains[i], This->numTaps);
     }
     This->_needUpdateIndices = false;
 }
@@ -455,6 +458,7 @@ void BMMultiTapDelay_PerformUpdateGains(BMMultiTapDelay *This){
         for (int j=0; j<This->numTaps; j++) {
             setting->gains[i][j] = This->tempGains[i][j];
         }
+        BMSparseTapKernel_setTaps(&This->tapKernel[i], setting->indices[i], setting->gains[i], This->numTaps);
     }
     This->_needUpdateGain = false;
 }
@@ -516,7 +520,8 @@ void BMMultiTapDelay_setGains(BMMultiTapDelay *This, float* gainL, float* gainR)
 
 
 /*
- *  Print the impulse response to standard output for testing
+ *  Print the impulse response to standard output for testing. This
+ *  allocates memory and prints, so don't call it on the audio thread.
  */
 void BMMultiTapDelay_impulseResponse(BMMultiTapDelay *This){
     // we include the right channel if the output is stereo
@@ -557,12 +562,10 @@ void BMMultiTapDelay_impulseResponse(BMMultiTapDelay *This){
                                           leftIR, rightIR,
                                           1);
         
-        // process the remaining part of the impulse response
-        //float zero = 0.0f;
-        float* zero = malloc(sizeof(float) * (IRlength - 1));
-        memset(zero, 0, (IRlength - 1) * sizeof(float));
+        // process the remaining part of the impulse response. zeroArray
+        // is longer than IRlength and always contains zeros.
         BMMultiTapDelay_processBufferStereo(This,
-                                          zero, zero,
+                                          This->zeroArray, This->zeroArray,
                                           leftIR + 1, rightIR + 1,
                                           IRlength - 1);
     }else{
@@ -570,10 +573,7 @@ void BMMultiTapDelay_impulseResponse(BMMultiTapDelay *This){
         BMMultiTapDelay_ProcessBufferMono(This, &one, leftIR, 1);
         
         // process the remaining part of the impulse response
-        //float zero = 0.0f;
-        float* zero = malloc(sizeof(float) * (IRlength - 1));
-        memset(zero, 0, (IRlength - 1) * sizeof(float));
-        BMMultiTapDelay_ProcessBufferMono(This, zero, leftIR + 1, IRlength - 1);
+        BMMultiTapDelay_ProcessBufferMono(This, This->zeroArray, leftIR + 1, IRlength - 1);
     }
     
 	
@@ -594,6 +594,9 @@ void BMMultiTapDelay_impulseResponse(BMMultiTapDelay *This){
             printf("%f\n", rightIR[i]);
         printf("%f}\n\n",rightIR[IRlength-1]);
     }
+    
+    free(leftIR);
+    free(rightIR);
 }
 
 
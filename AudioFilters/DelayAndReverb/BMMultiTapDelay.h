@@ -11,6 +11,7 @@
 
 #include <stdio.h>
 #include "TPCircularBuffer.h"
+#include "BMSparseTapKernel.h"
 
 
 /*
@@ -30,6 +31,7 @@ typedef struct{
 typedef struct{
     BMMultiTapDelaySetting setting;
     TPCircularBuffer *buffer;
+    BMSparseTapKernel *tapKernel;
     
     float** tempBuffer;
     float** input;
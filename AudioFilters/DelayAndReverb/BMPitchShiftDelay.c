@@ -10,7 +10,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 void BMPitchShiftDelay_init(BMPitchShiftDelay* This,float duration,size_t delayRange,size_t maxDelayRange,size_t sampleRate,bool startAtMaxRange,bool useFilter){
@@ -33,18 +33,19 @@ extern "C" {
      */
     void BMReverbInitIndices(struct BMReverb *This);
     void BMReverbIncrementIndices(struct BMReverb *This);
-    void BMReverbUpdateDelayTimes(struct BMReverb *This);
+    BMReverbNetwork* BMReverbNewNetwork(struct BMReverb *This);
+    void BMReverbFreeNetwork(void *network);
+    void BMReverbPublishNetwork(struct BMReverb *This);
+    void BMReverbApplyNetwork(struct BMReverb *This, BMReverbNetwork *network);
     void BMReverbUpdateDecayHighShelfFilters(struct BMReverb *This);
     void BMReverbUpdateDecayLowShelfFilters(struct BMReverb *This);
     void BMReverbUpdateRT60DecayTime(struct BMReverb *This);
     double BMReverbDelayGainFromRT60(double rt60, double delayTime);
     void BMReverbProcessWetSample(struct BMReverb *This, float inputL, float inputR, float* outputL, float* outputR);
-    void BMReverbUpdateNumDelayUnits(struct BMReverb *This);
     void BMReverbPointersToNull(struct BMReverb *This);
     void BMReverbRandomiseOrderST(size_t* list, size_t seed, size_t stride, size_t length);
 	void BMReverbRandomiseOrderF(float* list, size_t seed, size_t stride, size_t length);
-    void BMReverbInitDelayOutputSigns(struct BMReverb *This);
-    void BMReverbUpdateSettings(struct BMReverb *This);
+    void BMReverbInitDelayOutputSigns(simd_float4 *delayOutputSigns, size_t delayUnits);
 	void BMReverbSetMidScoopGain(struct BMReverb *This, float gainDb);
     
     
@@ -74,18 +75,25 @@ extern "C" {
         This->maxDelay_seconds = BMREVERB_ROOMSIZE;
         This->rt60 = BMREVERB_RT60;
         This->delayUnits = BMREVERB_NUMDELAYUNITS;
-        This->settingsQueuedForUpdate = false;
         This->slowDecayRT60 = BMREVERB_SLOWDECAYRT60;
         This->newNumDelayUnits = BMREVERB_NUMDELAYUNITS;
-        This->preDelayUpdate = false;
         BMReverbSetHighPassFC(This, BMREVERB_HIGHPASS_FC);
 		BMReverbSetMidScoopGain(This,BMREVERB_MID_SCOOP_GAIN);
         BMReverbSetLowPassFC(This, BMREVERB_LOWPASS_FC);
         BMReverbSetWetMix(This, BMREVERB_WETMIX);
         BMReverbSetStereoWidth(This, BMREVERB_STEREOWIDTH);
         
-        // initialize all the delays and delay-dependent settings
-        BMReverbUpdateNumDelayUnits(This);
+        // allocate memory for buffers
+        This->leftOutputTemp = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
+        This->dryL = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
+        This->dryR = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
+        
+        // initialize all the delays and delay-dependent settings. We aren't
+        // processing yet, so we can switch to the network directly.
+        BMLockFreeHandoff_init(&This->networkHandoff, BMReverbFreeNetwork);
+        BMReverbApplyNetwork(This, BMReverbNewNetwork(This));
+        
+        BMParameterQueue_init(&This->parameterQueue, BMPARAMETERQUEUE_DEFAULT_CAPACITY);
     }
     
     
@@ -106,9 +114,13 @@ extern "C" {
         }
         
         
-        // chunked processing
+        // chunked processing. Chunks also end where a queued parameter
+        // change is due, so that it applies on the right sample.
         while (numSamples > 0) {
-			size_t numSamplesProcessing = BM_MIN(BM_BUFFER_CHUNK_SIZE, numSamples);
+			size_t numSamplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+																	   BM_MIN(BM_BUFFER_CHUNK_SIZE, numSamples),
+																	   BMReverbApplyParameterEvent,
+																	   This);
             
             // backup the input to allow in place processing
             memcpy(This->dryL, inputL, sizeof(float)*numSamplesProcessing);
@@ -118,24 +130,8 @@ extern "C" {
             for (size_t i=0; i < numSamplesProcessing; i++)
                 BMReverbProcessWetSample(This, inputL[i], inputR[i], &outputL[i], &outputR[i]);
 			
-			// narrow the stereo width
-			BMStereoWidener_processAudio(&This->stereoWidth,
-										 outputL, outputR,
-										 outputL, outputR,
-										 numSamplesProcessing);
-
-			// filter the wet signal
-			BMMultiLevelBiquad_processBufferStereo(&This->mainFilter,
-												   outputL, outputR,
-												   outputL, outputR,
-												   numSamplesProcessing);
-
-			// mix wet and dry signals
-			BMWetDryMixer_processBufferRandomPhase(&This->wetDryMixer,
-												   outputL, outputR,
-												   This->dryL, This->dryR,
-												   outputL, outputR,
-												   numSamplesProcessing);
+			// filter the wet signal and mix with dry
+			BMReverbProcessWetOutput(This, outputL, outputR, numSamplesProcessing);
             
 			// advance pointers
 			inputL += numSamplesProcessing;
@@ -146,21 +142,105 @@ extern "C" {
         }
         
 		
-        /*
-         * if an update requiring memory allocation was requested, do it now.
-         */
-        if (This->settingsQueuedForUpdate)
-            BMReverbUpdateSettings(This);
-        if(This->preDelayUpdate){
-            BMReverbUpdateDelayTimes(This);
-            This->preDelayUpdate = false;
+        BMReverbApplyQueuedUpdates(This);
+    }
+    
+    
+    
+    
+    void BMReverbProcessWetOutput(struct BMReverb *This, float* outputL, float* outputR, size_t numSamples){
+        assert(numSamples <= BM_BUFFER_CHUNK_SIZE);
+        
+        // narrow the stereo width
+        BMStereoWidener_processAudio(&This->stereoWidth,
+                                     outputL, outputR,
+                                     outputL, outputR,
+                                     numSamples);
+        
+        // filter the wet signal
+        BMMultiLevelBiquad_processBufferStereo(&This->mainFilter,
+                                               outputL, outputR,
+                                               outputL, outputR,
+                                               numSamples);
+        
+        // mix wet and dry signals
+        BMWetDryMixer_processBufferRandomPhase(&This->wetDryMixer,
+                                               outputL, outputR,
+                                               This->dryL, This->dryR,
+                                               outputL, outputR,
+                                               numSamples);
+    }
+    
+    
+    
+    
+    bool BMReverbPushParameterEvent(struct BMReverb *This, const BMParameterEvent *event){
+        return BMParameterQueue_push(&This->parameterQueue, event);
+    }
+    
+    
+    
+    
+    bool BMReverbPushParameterSnapshot(struct BMReverb *This, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime){
+        return BMParameterQueue_pushSnapshot(&This->parameterQueue, events, numEvents, sampleTime);
+    }
+    
+    
+    
+    
+    void BMReverbApplyParameterEvent(void *reverb, const BMParameterEvent *event){
+        struct BMReverb *This = (struct BMReverb*)reverb;
+        float value = event->values[0];
+        
+        switch (event->parameter) {
+            case BMRV_WET_MIX:
+                BMReverbSetWetMix(This, value);
+                break;
+            case BMRV_STEREO_WIDTH:
+                BMReverbSetStereoWidth(This, value);
+                break;
+            case BMRV_HF_DECAY_MULTIPLIER:
+                BMReverbSetHFDecayMultiplier(This, value);
+                break;
+            case BMRV_LF_DECAY_MULTIPLIER:
+                BMReverbSetLFDecayMultiplier(This, value);
+                break;
+            case BMRV_HF_DECAY_FC:
+                BMReverbSetHFDecayFC(This, value);
+                break;
+            case BMRV_LF_DECAY_FC:
+                BMReverbSetLFDecayFC(This, value);
+                break;
+            case BMRV_RT60_DECAY_TIME:
+                BMReverbSetRT60DecayTime(This, value);
+                break;
+            // the main filter is processed inside the same chunk, so its
+            // coefficients change on the same sample
+            case BMRV_HIGHPASS_FC:
+                BMReverbSetHighPassFC(This, value);
+                break;
+            case BMRV_LOWPASS_FC:
+                BMReverbSetLowPassFC(This, value);
+                break;
+            default:
+                assert(false);
         }
     }
     
     
     
-    void BMReverbUpdateSettings(struct BMReverb *This){
-        BMReverbUpdateNumDelayUnits(This);
+    
+    void BMReverbApplyQueuedUpdates(struct BMReverb *This){
+        /*
+         * if a new delay network was prepared, switch to it now and pass
+         * the old one back to be freed on the thread that prepared the new one
+         */
+        BMReverbNetwork *network = BMLockFreeHandoff_take(&This->networkHandoff);
+        if (network){
+            BMReverbNetwork *oldNetwork = This->network;
+            BMReverbApplyNetwork(This, network);
+            BMLockFreeHandoff_retire(&This->networkHandoff, oldNetwork);
+        }
     }
     
     
@@ -187,21 +267,22 @@ extern "C" {
     
     
     
-    void BMReverbInitDelayOutputSigns(struct BMReverb *This){
+    void BMReverbInitDelayOutputSigns(simd_float4 *delayOutputSigns, size_t delayUnits){
         // init delay output signs with an equal number of + and - for each channel
-        for(size_t i=0; i<This->delayUnits; i++){
+        for(size_t i=0; i<delayUnits; i++){
             // L and R positive
-            This->delayOutputSigns[i].xy = 1.0f;
+            delayOutputSigns[i].xy = 1.0f;
             // L and R negative
-            This->delayOutputSigns[i].zw = -1.0f;
+            delayOutputSigns[i].zw = -1.0f;
         }
         
         // randomise the order of the signs for each channel
         unsigned int seed = 17;
+        size_t halfNumDelays = delayUnits*2;
         // left
-        BMReverbRandomiseOrderF(((float*)&This->delayOutputSigns), seed, 2, This->halfNumDelays);
+        BMReverbRandomiseOrderF(((float*)delayOutputSigns), seed, 2, halfNumDelays);
         //right
-        BMReverbRandomiseOrderF(((float*)&This->delayOutputSigns)+1, seed+1, 2,  This->halfNumDelays);
+        BMReverbRandomiseOrderF(((float*)delayOutputSigns)+1, seed+1, 2,  halfNumDelays);
     }
     
     
@@ -220,7 +301,7 @@ extern "C" {
     
     void BMReverbSetSampleRate(struct BMReverb *This, float sampleRate){
         This->sampleRate = sampleRate;
-        This->settingsQueuedForUpdate = true;
+        BMReverbPublishNetwork(This);
     }
     
 
@@ -302,7 +383,7 @@ extern "C" {
         This->minDelay_seconds = preDelay_seconds;
         This->maxDelay_seconds = roomSize_seconds;
         
-        This->preDelayUpdate = true;
+        BMReverbPublishNetwork(This);
     }
     
     
@@ -493,44 +574,72 @@ extern "C" {
     
     
     
-    // generate a random list of times between min and max
-    void BMReverbUpdateDelayTimes(struct BMReverb *This){
+    // Allocate a new delay network for the current settings, with a random
+    // list of delay times between min and max. This allocates memory so it
+    // must not be called on the audio thread.
+    BMReverbNetwork* BMReverbNewNetwork(struct BMReverb *This){
+        BMReverbNetwork *network = malloc(sizeof(BMReverbNetwork));
+        network->delayUnits = This->newNumDelayUnits;
+        network->sampleRate = This->sampleRate;
+        size_t numDelays = network->delayUnits*4;
+        size_t halfNumDelays = numDelays/2;
+        assert(numDelays <= BMREVERB_NUMDELAYS);
+        
+        // set randomised signs for the output taps
+        BMReverbInitDelayOutputSigns(network->delayOutputSigns, network->delayUnits);
 		
 		// convert the min and max delay times to sample indices
-		size_t minDelay = This->minDelay_seconds * This->sampleRate;
-		size_t maxDelay = This->maxDelay_seconds * This->sampleRate;
+		size_t minDelay = This->minDelay_seconds * network->sampleRate;
+		size_t maxDelay = This->maxDelay_seconds * network->sampleRate;
         
 		// generate random delay times int the specified range
-        BMReverbRandomsInRange(minDelay, maxDelay,This->bufferLengths,This->numDelays);
+        BMReverbRandomsInRange(minDelay, maxDelay,network->bufferLengths,numDelays);
         
 		// sort so that we can ensure that the left and right channels get approximately equal average delay time
-        BMInsertionSort_size_t(This->bufferLengths, This->numDelays);
+        BMInsertionSort_size_t(network->bufferLengths, numDelays);
         
         // randomise the order of the list of delay times
         // left channel
-        BMReverbRandomiseOrderST(&This->bufferLengths[0], 1, 2, This->halfNumDelays);
+        BMReverbRandomiseOrderST(&network->bufferLengths[0], 1, 2, halfNumDelays);
         // right channel
-        BMReverbRandomiseOrderST(&This->bufferLengths[1], 17, 2, This->halfNumDelays);
+        BMReverbRandomiseOrderST(&network->bufferLengths[1], 17, 2, halfNumDelays);
 		
 		// double-check the bounds
-		for(size_t i=0; i<This->numDelays; i++)
-			assert(This->bufferLengths[i] >= minDelay && This->bufferLengths[i] <= maxDelay);
+		for(size_t i=0; i<numDelays; i++)
+			assert(network->bufferLengths[i] >= minDelay && network->bufferLengths[i] <= maxDelay);
 		
 		// count the total number of samples in all delays
-		This->totalSamples = 0;
-		for(size_t i=0; i < This->numDelays; i++)
-			This->totalSamples += This->bufferLengths[i];
+		network->totalSamples = 0;
+		for(size_t i=0; i < numDelays; i++)
+			network->totalSamples += network->bufferLengths[i];
         
         // allocate memory for the main delays in the network
-        if (This->delayLines) free(This->delayLines);
-        This->delayLines = calloc(This->totalSamples,sizeof(float));
+        network->delayLines = calloc(network->totalSamples,sizeof(float));
         
-        // The following depend on delay time and have to be updated
-        // whenever there is a change
-        BMReverbUpdateRT60DecayTime(This);
-        BMReverbUpdateDecayHighShelfFilters(This);
-        BMReverbUpdateDecayLowShelfFilters(This);
-        BMReverbInitIndices(This);
+        return network;
+    }
+    
+    
+    
+    
+    
+    void BMReverbFreeNetwork(void *network){
+        BMReverbNetwork *n = network;
+        if (n){
+            free(n->delayLines);
+            n->delayLines = NULL;
+        }
+        free(n);
+    }
+    
+    
+    
+    
+    
+    // prepare a network for the current settings and queue it for the audio
+    // thread. This also frees networks that the audio thread has finished with.
+    void BMReverbPublishNetwork(struct BMReverb *This){
+        BMLockFreeHandoff_publish(&This->networkHandoff, BMReverbNewNetwork(This));
     }
     
     
@@ -538,48 +647,48 @@ extern "C" {
     
     
     void BMReverbSetNumDelayUnits(struct BMReverb *This, size_t delayUnits){
+        assert(delayUnits <= BMREVERB_NUMDELAYUNITS);
         This->newNumDelayUnits = delayUnits;
-        This->settingsQueuedForUpdate = true;
+        BMReverbPublishNetwork(This);
     }
     
     
     
     
     
-    void BMReverbUpdateNumDelayUnits(struct BMReverb *This){
+    // switch to a new delay network. This doesn't allocate or free memory,
+    // so it is safe on the audio thread.
+    void BMReverbApplyNetwork(struct BMReverb *This, BMReverbNetwork *network){
+        This->network = network;
+        This->delayLines = network->delayLines;
+        This->totalSamples = network->totalSamples;
+        This->sampleRate = network->sampleRate;
         
         // before beginning, calculate some frequently reused values
-        This->delayUnits = This->newNumDelayUnits;
-        This->numDelays = This->newNumDelayUnits*4;
+        This->delayUnits = network->delayUnits;
+        This->numDelays = network->delayUnits*4;
         This->halfNumDelays = This->numDelays/2;
         This->fourthNumDelays = This->numDelays/4;
 		
         // we compute attenuation on half delays because the reverb is stereo
         This->inputAttenuation = 1.0f/sqrtf((float)This->halfNumDelays);
         
-        // free old memory if necessary
-        if (This->leftOutputTemp) BMReverbFree(This);
-        
-        // allocate memory for buffers
-        This->leftOutputTemp = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
-        This->dryL = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
-        This->dryR = malloc(BM_BUFFER_CHUNK_SIZE*sizeof(float));
+        memcpy(This->bufferLengths, network->bufferLengths, sizeof(size_t)*This->numDelays);
+        memcpy(This->delayOutputSigns, network->delayOutputSigns, sizeof(simd_float4)*This->delayUnits);
 		
 		// clear the feedback buffers
 		memset((float*)This->feedbackBuffers,0,sizeof(float)*This->numDelays);
         
-        // set randomised signs for the output taps
-        BMReverbInitDelayOutputSigns(This);
-        
         // init shelf filter arrays for high and low frequency decay
         BMFirstOrderArray4x4_init(&This->HSFArray, This->numDelays, This->sampleRate);
         BMFirstOrderArray4x4_init(&This->LSFArray, This->numDelays, This->sampleRate);
         
-        // Allocate memory for the network delay buffers and update all the
-		// delay-time-dependent parameters
-        BMReverbUpdateDelayTimes(This);
-        
-        This->settingsQueuedForUpdate = false;
+        // The following depend on delay time and have to be updated
+        // whenever there is a change
+        BMReverbUpdateRT60DecayTime(This);
+        BMReverbUpdateDecayHighShelfFilters(This);
+        BMReverbUpdateDecayLowShelfFilters(This);
+        BMReverbInitIndices(This);
     }
     
     
@@ -666,6 +775,7 @@ extern "C" {
     
     
     void BMReverbPointersToNull(struct BMReverb *This){
+        This->network = NULL;
         This->delayLines = NULL;
         This->leftOutputTemp = NULL;
         This->dryL = NULL;
@@ -676,7 +786,9 @@ extern "C" {
     
     
     void BMReverbFree(struct BMReverb *This){
-        free(This->delayLines);
+        BMParameterQueue_free(&This->parameterQueue);
+        BMLockFreeHandoff_free(&This->networkHandoff);
+        BMReverbFreeNetwork(This->network);
         free(This->leftOutputTemp);
         free(This->dryL);
         free(This->dryR);
@@ -16,6 +16,8 @@
 #include "BMMultiLevelBiquad.h"
 #include "BMWetDryMixer.h"
 #include "BMStereoWidener.h"
+#include "BMLockFreeHandoff.h"
+#include "BMParameterQueue.h"
 #include <math.h>
 
 #ifdef __APPLE__
@@ -49,6 +51,32 @@
 extern "C" {
 #endif
 
+// Parameters for BMReverbPushParameterEvent. The event's values[0] is the
+// argument of the setter with the same name. The index is ignored.
+enum BMReverbParameter {
+	BMRV_WET_MIX,
+	BMRV_STEREO_WIDTH,
+	BMRV_HF_DECAY_MULTIPLIER,
+	BMRV_LF_DECAY_MULTIPLIER,
+	BMRV_HF_DECAY_FC,
+	BMRV_LF_DECAY_FC,
+	BMRV_RT60_DECAY_TIME,
+	BMRV_HIGHPASS_FC,
+	BMRV_LOWPASS_FC
+};
+
+// The delay lines and the settings that determine their size. Changing
+// any of these requires memory allocation, so a new network is built on the
+// thread that changes the setting and handed to the audio thread to replace
+// the old one.
+typedef struct BMReverbNetwork {
+	float *delayLines;
+	size_t bufferLengths[BMREVERB_NUMDELAYS];
+	simd_float4 delayOutputSigns[BMREVERB_NUMDELAYUNITS];
+	size_t delayUnits, totalSamples;
+	float sampleRate;
+} BMReverbNetwork;
+
 // the CReverb struct
 typedef struct BMReverb {
 	simd_float4 feedbackBuffers[BMREVERB_NUMDELAYUNITS];
@@ -62,7 +90,9 @@ typedef struct BMReverb {
 	size_t rwIndices[BMREVERB_NUMDELAYS];
 	float inputAttenuation, minDelay_seconds, maxDelay_seconds, sampleRate, wetGain, dryGain, straightStereoMix, crossStereoMix, hfDecayMultiplier, lfDecayMultiplier, highShelfFC, lowShelfFC, rt60, slowDecayRT60, highpassFC, lowpassFC;
 	size_t delayUnits, newNumDelayUnits, numDelays, halfNumDelays, fourthNumDelays, samplesTillNextWrap, totalSamples;
-	bool settingsQueuedForUpdate, preDelayUpdate;
+	BMReverbNetwork *network;
+	BMLockFreeHandoff networkHandoff;
+	BMParameterQueue parameterQueue;
 	BMFirstOrderArray4x4 HSFArray;
 	BMFirstOrderArray4x4 LSFArray;
 	BMMultiLevelBiquad mainFilter;
@@ -84,10 +114,60 @@ void BMReverbFree(struct BMReverb *This);
 // main audio processing function
 void BMReverbProcessBuffer(struct BMReverb *This, const float* inputL, const float* inputR, float* outputL, float* outputR, size_t numSamples);
 
+// Apply the stereo width, output filters and wet/dry mix to numSamples
+// <= BM_BUFFER_CHUNK_SIZE samples of wet signal. The dry input must
+// already be in This->dryL and This->dryR. BMReverbProcessBuffer calls this;
+// it is public so that BMReverbBatch can do the same.
+void BMReverbProcessWetOutput(struct BMReverb *This, float* outputL, float* outputR, size_t numSamples);
+
+// Switch to the newest delay network prepared by one of the settings
+// functions below, if there is one. This does not allocate or free memory.
+// It is called at the end of each call to BMReverbProcessBuffer.
+void BMReverbApplyQueuedUpdates(struct BMReverb *This);
+
+// Apply one event from This->parameterQueue. BMReverbProcessBuffer passes
+// this to BMParameterQueue_nextSegment; BMReverbBatch uses it in the same way.
+void BMReverbApplyParameterEvent(void *reverb, const BMParameterEvent *event);
+
 
 /*
  * settings that can be safely changed during reverb operation
+ *
+ * These take effect immediately, so call them from the audio thread or
+ * while it is stopped. To change them from another thread while the reverb
+ * is running, use BMReverbPushParameterEvent.
+ */
+
+
+/*!
+ *BMReverbPushParameterEvent
+ *
+ * @abstract schedule a change to one of the settings below from a control thread, without locking
+ *
+ * @discussion BMReverbProcessBuffer applies the change on the sample given by event->sampleTime. See BMParameterQueue.h for how timestamps work. Call this from one control thread only.
+ *
+ * @param This   pointer to an initialised struct
+ * @param event  event->parameter is one of enum BMReverbParameter
+ * @returns false if too many events are waiting. The event is dropped in that case.
  */
+bool BMReverbPushParameterEvent(struct BMReverb *This, const BMParameterEvent *event);
+
+
+/*!
+ *BMReverbPushParameterSnapshot
+ *
+ * @abstract schedule several of the settings below to change together on the same sample, without locking
+ *
+ * @discussion The audio thread applies all of the events in the same buffer or none of them. See BMParameterQueue_pushSnapshot. Call this from one control thread only.
+ *
+ * @param This        pointer to an initialised struct
+ * @param events      the parameter of each event is one of enum BMReverbParameter. Their sampleTime is ignored.
+ * @param numEvents   number of events
+ * @param sampleTime  the sample on which the changes take effect
+ * @returns false if there isn't room for all the events. None of them are queued in that case.
+ */
+bool BMReverbPushParameterSnapshot(struct BMReverb *This, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime);
+
 
 /*!
  *BMReverbSetWetGain
@@ -144,8 +224,10 @@ void BMReverbSetSlowDecayState(struct BMReverb *This, bool slowDecay);
 
 /*
  * Settings for which changes will queue until the end of the next buffer.
- * Call these functions any time, but changes won't take effect until
- * it's safe to apply them.
+ * These allocate a new delay network on the calling thread, so don't call
+ * them from the audio thread. The audio thread switches to the new network
+ * at the end of the next buffer and the memory of the old one is released
+ * by the next call to one of these functions, or by BMReverbFree.
  */
 
 // A delay unit is a set of four delay lines.  We are using a sparse
@@ -0,0 +1,472 @@
+//
+//  BMReverbBatch.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMReverbBatch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#define BMRB_LANES BMREVERBBATCH_LANES
+#define BMRB_NUMDELAYS (4 * BMREVERB_NUMDELAYUNITS)
+#define BMRB_MATRIX_ATTENUATION 0.5f // same as BMREVERB_MATRIX_ATTENUATION
+
+// prefetch delay memory this many samples ahead, once every 16 samples
+#define BMRB_PREFETCH_DISTANCE 64
+#define BMRB_PREFETCH_INTERVAL 16
+
+// one float for each lane. The compiler splits this into two registers on
+// targets with 128 bit vectors.
+typedef float BMRBVec __attribute__((vector_size(sizeof(float)*BMRB_LANES),aligned(4),__may_alias__));
+
+#define BMRB_INLINE static inline __attribute__((always_inline))
+
+
+
+
+BMRB_INLINE BMRBVec BMRBVec_load(const float *p){
+	return *(const BMRBVec *)p;
+}
+
+BMRB_INLINE void BMRBVec_store(float *p, BMRBVec v){
+	*(BMRBVec *)p = v;
+}
+
+
+
+
+void BMReverbBatch_init(BMReverbBatch *This, size_t maxInstances){
+	This->maxInstances = maxInstances;
+	This->active = malloc(sizeof(BMReverb*) * maxInstances);
+	This->activeIndices = malloc(sizeof(size_t) * maxInstances);
+
+	size_t delayArrayLength = BMRB_NUMDELAYS * BMRB_LANES;
+	size_t ioArrayLength = BM_BUFFER_CHUNK_SIZE * BMRB_LANES;
+	This->feedback = malloc(sizeof(float) * delayArrayLength);
+	This->x1 = malloc(sizeof(float) * delayArrayLength);
+	This->y1 = malloc(sizeof(float) * delayArrayLength);
+	This->b0 = malloc(sizeof(float) * delayArrayLength);
+	This->b1 = malloc(sizeof(float) * delayArrayLength);
+	This->a1neg = malloc(sizeof(float) * delayArrayLength);
+	This->decay = malloc(sizeof(float) * delayArrayLength);
+	This->signs = malloc(sizeof(float) * delayArrayLength);
+	This->inputAttenuation = malloc(sizeof(float) * BMRB_LANES);
+	This->inputL = malloc(sizeof(float) * ioArrayLength);
+	This->inputR = malloc(sizeof(float) * ioArrayLength);
+	This->outputL = malloc(sizeof(float) * ioArrayLength);
+	This->outputR = malloc(sizeof(float) * ioArrayLength);
+	This->zeros = calloc(BM_BUFFER_CHUNK_SIZE + 1, sizeof(float));
+}
+
+
+
+
+void BMReverbBatch_free(BMReverbBatch *This){
+	free(This->active);
+	This->active = NULL;
+	free(This->activeIndices);
+	This->activeIndices = NULL;
+	free(This->feedback);
+	This->feedback = NULL;
+	free(This->x1);
+	This->x1 = NULL;
+	free(This->y1);
+	This->y1 = NULL;
+	free(This->b0);
+	This->b0 = NULL;
+	free(This->b1);
+	This->b1 = NULL;
+	free(This->a1neg);
+	This->a1neg = NULL;
+	free(This->decay);
+	This->decay = NULL;
+	free(This->signs);
+	This->signs = NULL;
+	free(This->inputAttenuation);
+	This->inputAttenuation = NULL;
+	free(This->inputL);
+	This->inputL = NULL;
+	free(This->inputR);
+	This->inputR = NULL;
+	free(This->outputL);
+	This->outputL = NULL;
+	free(This->outputR);
+	This->outputR = NULL;
+	free(This->zeros);
+	This->zeros = NULL;
+}
+
+
+
+
+/*
+ * Copy the network state and coefficients of up to BMRB_LANES instances
+ * into the batch. Unused lanes are set to zero so that they stay silent.
+ */
+static void BMReverbBatch_loadGroup(BMReverbBatch *This, BMReverb **group, size_t numLanes){
+	for(size_t l=0; l<BMRB_LANES; l++){
+		if(l < numLanes){
+			BMReverb *r = group[l];
+			const float *feedback = (const float*)r->feedbackBuffers;
+			const float *x1 = (const float*)r->HSFArray.x1;
+			const float *y1 = (const float*)r->HSFArray.y1;
+			const float *b0 = (const float*)r->HSFArray.b0;
+			const float *b1 = (const float*)r->HSFArray.b1;
+			const float *a1neg = (const float*)r->HSFArray.a1neg;
+			const float *decay = (const float*)r->decayGainAttenuation;
+			const float *signs = (const float*)r->delayOutputSigns;
+			for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+				size_t i = d*BMRB_LANES + l;
+				This->feedback[i] = feedback[d];
+				This->x1[i] = x1[d];
+				This->y1[i] = y1[d];
+				This->b0[i] = b0[d];
+				This->b1[i] = b1[d];
+				This->a1neg[i] = a1neg[d];
+				This->decay[i] = decay[d];
+				This->signs[i] = signs[d];
+			}
+			This->inputAttenuation[l] = r->inputAttenuation;
+		} else {
+			for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+				size_t i = d*BMRB_LANES + l;
+				This->feedback[i] = This->x1[i] = This->y1[i] = 0.0f;
+				This->b0[i] = This->b1[i] = This->a1neg[i] = 0.0f;
+				This->decay[i] = This->signs[i] = 0.0f;
+			}
+			This->inputAttenuation[l] = 0.0f;
+		}
+	}
+}
+
+
+
+
+/*
+ * Copy the network state back to the instances
+ */
+static void BMReverbBatch_storeGroup(const BMReverbBatch *This, BMReverb **group, size_t numLanes){
+	for(size_t l=0; l<numLanes; l++){
+		BMReverb *r = group[l];
+		float *feedback = (float*)r->feedbackBuffers;
+		float *x1 = (float*)r->HSFArray.x1;
+		float *y1 = (float*)r->HSFArray.y1;
+		for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+			size_t i = d*BMRB_LANES + l;
+			feedback[d] = This->feedback[i];
+			x1[d] = This->x1[i];
+			y1[d] = This->y1[i];
+		}
+	}
+}
+
+
+
+
+/*
+ * The first part of BMReverbProcessWetSample: mix the input into the
+ * feedback, then apply the broadband and high frequency decay.
+ */
+BMRB_INLINE void BMReverbBatch_decay(const BMReverbBatch *This,
+									 BMRBVec *feedback, BMRBVec *x1, BMRBVec *y1,
+									 BMRBVec inputAttenuation, size_t n){
+	// attenuate the input. Even numbered delays take input from the left
+	// channel and odd numbered delays from the right.
+	BMRBVec inputL = BMRBVec_load(This->inputL + n*BMRB_LANES) * inputAttenuation;
+	BMRBVec inputR = BMRBVec_load(This->inputR + n*BMRB_LANES) * inputAttenuation;
+
+	for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+		// mix input and apply broadband decay
+		BMRBVec in = (d % 2 == 0) ? inputL : inputR;
+		BMRBVec x0 = (in + feedback[d]) * BMRBVec_load(This->decay + d*BMRB_LANES);
+
+		// high frequency decay
+		BMRBVec y0 = BMRBVec_load(This->b0 + d*BMRB_LANES) * x0
+				   + BMRBVec_load(This->b1 + d*BMRB_LANES) * x1[d]
+				   + BMRBVec_load(This->a1neg + d*BMRB_LANES) * y1[d];
+		// BMReverb calls BMFirstOrderArray4x4_processSample in place, so the
+		// filter stores its output in x1 as well as in y1. Do the same here
+		// so that the batch sounds exactly like the single instance.
+		x1[d] = y0;
+		y1[d] = y0;
+		feedback[d] = y0;
+	}
+}
+
+
+
+
+/*
+ * The last part of BMReverbProcessWetSample: sum the delay outputs into
+ * the left and right outputs and mix the feedback.
+ */
+BMRB_INLINE void BMReverbBatch_outputAndMix(BMReverbBatch *This, BMRBVec *feedback, size_t n){
+	// sum the delay outputs with their signs, in the same order as
+	// BMReverbProcessWetSample
+	BMRBVec outputL = {0}, outputR = {0};
+	for(size_t d=0; d<BMRB_NUMDELAYS; d+=4){
+		BMRBVec t0 = feedback[d]   * BMRBVec_load(This->signs + d*BMRB_LANES);
+		BMRBVec t1 = feedback[d+1] * BMRBVec_load(This->signs + (d+1)*BMRB_LANES);
+		BMRBVec t2 = feedback[d+2] * BMRBVec_load(This->signs + (d+2)*BMRB_LANES);
+		BMRBVec t3 = feedback[d+3] * BMRBVec_load(This->signs + (d+3)*BMRB_LANES);
+		outputL += t0 + t2;
+		outputR += t1 + t3;
+	}
+	BMRBVec_store(This->outputL + n*BMRB_LANES, outputL);
+	BMRBVec_store(This->outputR + n*BMRB_LANES, outputR);
+
+	// Mix the feedback as in BMBlockCirculantMix4x4. Delay d = 4v + c is
+	// element c of vector v in the single instance version. The mixing
+	// combines the four delays with the same c.
+	BMRBVec mixed [BMRB_NUMDELAYS];
+	for(size_t c=0; c<4; c++){
+		BMRBVec a = feedback[c], b = feedback[4+c], e = feedback[8+c], f = feedback[12+c];
+		// level 4
+		BMRBVec t0 = a + e, t2 = a - e;
+		BMRBVec t1 = b + f, t3 = b - f;
+		// level 3
+		mixed[c] = t0 + t1;
+		mixed[4+c] = t0 - t1;
+		mixed[8+c] = t2 + t3;
+		mixed[12+c] = t2 - t3;
+	}
+
+	// rotate right by one delay and attenuate to keep the feedback unitary
+	feedback[0] = mixed[BMRB_NUMDELAYS-1] * BMRB_MATRIX_ATTENUATION;
+	for(size_t d=1; d<BMRB_NUMDELAYS; d++)
+		feedback[d] = mixed[d-1] * BMRB_MATRIX_ATTENUATION;
+}
+
+
+
+
+/*
+ * This does the same thing as BMReverbIncrementIndices. We have our own
+ * copy so that it can be inlined.
+ */
+BMRB_INLINE void BMReverbBatch_incrementIndices(BMReverb *r, size_t increment){
+	for(size_t i=0; i<BMRB_NUMDELAYS; i++) r->rwIndices[i] += increment;
+
+	r->samplesTillNextWrap -= increment;
+
+	if(r->samplesTillNextWrap == 0){
+		r->samplesTillNextWrap = SIZE_MAX;
+		for(size_t i=0; i<BMRB_NUMDELAYS; i++){
+			size_t distToEnd = r->bufferEndIndices[i] - r->rwIndices[i];
+			if(distToEnd == 0){
+				r->rwIndices[i] = r->bufferStartIndices[i];
+				distToEnd = r->bufferLengths[i];
+			}
+			if(r->samplesTillNextWrap > distToEnd) r->samplesTillNextWrap = distToEnd;
+		}
+	}
+}
+
+
+
+
+/*!
+ *BMReverbBatch_processGroup
+ *
+ * @abstract compute numSamples of wet output for a group of instances that have been loaded with BMReverbBatch_loadGroup. This is the same computation as BMReverbProcessWetSample, with one instance in each vector lane.
+ */
+BM_SIMD_DISPATCH
+static void BMReverbBatch_processGroup(BMReverbBatch *This, BMReverb **group, size_t numLanes, size_t numSamples){
+	BMRBVec feedback [BMRB_NUMDELAYS];
+	BMRBVec x1 [BMRB_NUMDELAYS];
+	BMRBVec y1 [BMRB_NUMDELAYS];
+	for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+		feedback[d] = BMRBVec_load(This->feedback + d*BMRB_LANES);
+		x1[d] = BMRBVec_load(This->x1 + d*BMRB_LANES);
+		y1[d] = BMRBVec_load(This->y1 + d*BMRB_LANES);
+	}
+	BMRBVec inputAttenuation = BMRBVec_load(This->inputAttenuation);
+
+	// the read / write position in each delay of each lane. Unused lanes
+	// point to a buffer of zeros.
+	float *rw [BMRB_NUMDELAYS][BMRB_LANES];
+
+	size_t n = 0;
+	while(n < numSamples){
+		// Find the number of samples until one of the delays wraps around
+		// to the start of its buffer. Until then, each delay reads the
+		// sample after the one it writes.
+		size_t samplesTillNextWrap = SIZE_MAX;
+		for(size_t l=0; l<numLanes; l++)
+			samplesTillNextWrap = BM_MIN(samplesTillNextWrap, group[l]->samplesTillNextWrap);
+		size_t samplesWithoutWrap = BM_MIN(samplesTillNextWrap - 1, numSamples - n);
+
+		for(size_t l=0; l<BMRB_LANES; l++)
+			for(size_t d=0; d<BMRB_NUMDELAYS; d++)
+				rw[d][l] = l < numLanes ? group[l]->delayLines + group[l]->rwIndices[d] : This->zeros;
+
+		for(size_t i=0; i<samplesWithoutWrap; i++){
+			// There are too many delays for the hardware prefetcher to
+			// track, so we request the memory for each delay a few cache
+			// lines before we need it.
+			if(i % BMRB_PREFETCH_INTERVAL == 0)
+				for(size_t d=0; d<BMRB_NUMDELAYS; d++)
+					for(size_t l=0; l<numLanes; l++)
+						__builtin_prefetch(rw[d][l] + i + BMRB_PREFETCH_DISTANCE, 1);
+
+			BMReverbBatch_decay(This, feedback, x1, y1, inputAttenuation, n+i);
+
+			// Write into the delays and read the delay outputs. Each
+			// instance has its own delays so this is done one lane at a
+			// time.
+			for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+				BMRBVec v = feedback[d];
+				for(size_t l=0; l<BMRB_LANES; l++){
+					rw[d][l][i] = v[l];
+					v[l] = rw[d][l][i+1];
+				}
+				feedback[d] = v;
+			}
+
+			BMReverbBatch_outputAndMix(This, feedback, n+i);
+		}
+		for(size_t l=0; l<numLanes; l++)
+			BMReverbBatch_incrementIndices(group[l], samplesWithoutWrap);
+		n += samplesWithoutWrap;
+
+		// the sample where a delay wraps
+		if(n < numSamples){
+			BMReverbBatch_decay(This, feedback, x1, y1, inputAttenuation, n);
+			float *feedbackLanes = (float*)feedback;
+			for(size_t l=0; l<numLanes; l++){
+				BMReverb *r = group[l];
+				for(size_t d=0; d<BMRB_NUMDELAYS; d++)
+					r->delayLines[r->rwIndices[d]] = feedbackLanes[d*BMRB_LANES + l];
+				BMReverbBatch_incrementIndices(r, 1);
+				for(size_t d=0; d<BMRB_NUMDELAYS; d++)
+					feedbackLanes[d*BMRB_LANES + l] = r->delayLines[r->rwIndices[d]];
+			}
+			BMReverbBatch_outputAndMix(This, feedback, n);
+			n++;
+		}
+	}
+
+	for(size_t d=0; d<BMRB_NUMDELAYS; d++){
+		BMRBVec_store(This->feedback + d*BMRB_LANES, feedback[d]);
+		BMRBVec_store(This->x1 + d*BMRB_LANES, x1[d]);
+		BMRBVec_store(This->y1 + d*BMRB_LANES, y1[d]);
+	}
+}
+
+
+
+
+void BMReverbBatch_process(BMReverbBatch *This,
+						   BMReverb **reverbs,
+						   const float **inputsL, const float **inputsR,
+						   float **outputsL, float **outputsR,
+						   size_t numInstances,
+						   size_t numSamples){
+	assert(numInstances <= This->maxInstances);
+
+	// Like BMReverbProcessBuffer, don't process instances with nan values
+	// in the input. The remaining instances are packed into the lanes.
+	size_t numActive = 0;
+	for(size_t k=0; k<numInstances; k++){
+		assert(reverbs[k]->fourthNumDelays == BMREVERB_NUMDELAYUNITS);
+		if(isnan(inputsL[k][0]) || isnan(inputsR[k][0])){
+			memset(outputsL[k], 0, sizeof(float)*numSamples);
+			memset(outputsR[k], 0, sizeof(float)*numSamples);
+		} else {
+			This->active[numActive] = reverbs[k];
+			This->activeIndices[numActive] = k;
+			numActive++;
+		}
+	}
+
+	// chunked processing. As in BMReverbProcessBuffer, chunks also end
+	// where a queued parameter change is due for any of the instances.
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		size_t samplesProcessing = BM_MIN(BM_BUFFER_CHUNK_SIZE, numSamples - samplesProcessed);
+		for(size_t a=0; a<numActive; a++)
+			samplesProcessing = BMParameterQueue_applyDueEvents(&This->active[a]->parameterQueue,
+																samplesProcessing,
+																BMReverbApplyParameterEvent,
+																This->active[a]);
+		for(size_t a=0; a<numActive; a++)
+			BMParameterQueue_advanceTime(&This->active[a]->parameterQueue, samplesProcessing);
+
+		// backup the input to allow in place processing
+		for(size_t a=0; a<numActive; a++){
+			size_t k = This->activeIndices[a];
+			memcpy(This->active[a]->dryL, inputsL[k] + samplesProcessed, sizeof(float)*samplesProcessing);
+			memcpy(This->active[a]->dryR, inputsR[k] + samplesProcessed, sizeof(float)*samplesProcessing);
+		}
+
+		for(size_t first=0; first<numActive; first+=BMRB_LANES){
+			BMReverb **group = This->active + first;
+			size_t numLanes = BM_MIN(BMRB_LANES, numActive - first);
+
+			// interleave the inputs of the group
+			memset(This->inputL, 0, sizeof(float)*samplesProcessing*BMRB_LANES);
+			memset(This->inputR, 0, sizeof(float)*samplesProcessing*BMRB_LANES);
+			for(size_t l=0; l<numLanes; l++){
+				const float *dryL = group[l]->dryL;
+				const float *dryR = group[l]->dryR;
+				for(size_t n=0; n<samplesProcessing; n++){
+					This->inputL[n*BMRB_LANES + l] = dryL[n];
+					This->inputR[n*BMRB_LANES + l] = dryR[n];
+				}
+			}
+
+			// compute the wet signal
+			BMReverbBatch_loadGroup(This, group, numLanes);
+			BMReverbBatch_processGroup(This, group, numLanes, samplesProcessing);
+			BMReverbBatch_storeGroup(This, group, numLanes);
+
+			// de-interleave the wet outputs
+			for(size_t l=0; l<numLanes; l++){
+				size_t k = This->activeIndices[first + l];
+				float *outputL = outputsL[k] + samplesProcessed;
+				float *outputR = outputsR[k] + samplesProcessed;
+				for(size_t n=0; n<samplesProcessing; n++){
+					outputL[n] = This->outputL[n*BMRB_LANES + l];
+					outputR[n] = This->outputR[n*BMRB_LANES + l];
+				}
+			}
+		}
+
+		// filter the wet signals and mix with dry
+		for(size_t a=0; a<numActive; a++){
+			size_t k = This->activeIndices[a];
+			BMReverbProcessWetOutput(This->active[a],
+									 outputsL[k] + samplesProcessed,
+									 outputsR[k] + samplesProcessed,
+									 samplesProcessing);
+		}
+
+		samplesProcessed += samplesProcessing;
+	}
+
+	for(size_t a=0; a<numActive; a++)
+		BMReverbApplyQueuedUpdates(This->active[a]);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
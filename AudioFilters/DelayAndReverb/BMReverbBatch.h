@@ -0,0 +1,112 @@
+//
+//  BMReverbBatch.h
+//  AudioFiltersXcodeProject
+//
+//  Processes many independent BMReverb instances together, for rendering
+//  hundreds of voices that each have their own reverb.
+//
+//  BMReverbProcessBuffer computes the feedback delay network one sample at
+//  a time, using vectors of four floats across the delays within one
+//  instance. The batch processor instead puts one instance in each lane of
+//  an eight lane vector and runs eight instances in lock step, so that all
+//  the arithmetic in the network is done eight instances at a time. Each
+//  instance still uses its own delay lines, coefficients and settings, and
+//  its output is the same as if it had been processed by
+//  BMReverbProcessBuffer, up to rounding error. With fewer than
+//  BMREVERBBATCH_LANES instances part of each vector is wasted, so this is
+//  only worthwhile for larger numbers of instances.
+//
+//  The instances are ordinary BMReverb structs. Initialise and configure
+//  them as usual with BMReverbInit and the BMReverbSet... functions. The
+//  batch does not own them and keeps no state between calls, so an instance
+//  may be processed in a batch in one buffer and alone in the next.
+//
+//  Events pushed with BMReverbPushParameterEvent take effect on the sample
+//  given by their timestamps, as they do in BMReverbProcessBuffer. The whole
+//  batch is processed in chunks that end where any instance has an event
+//  due, so the wet/dry crossfade of an instance may be split differently
+//  from when it is processed alone.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMReverbBatch_h
+#define BMReverbBatch_h
+
+#include <stddef.h>
+#include "BMReverb.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of reverb instances processed in parallel
+#define BMREVERBBATCH_LANES 8
+
+typedef struct BMReverbBatch {
+	// network state and coefficients for one group of BMREVERBBATCH_LANES
+	// instances, stored as [delay][lane]
+	float *feedback, *x1, *y1, *b0, *b1, *a1neg, *decay, *signs;
+	float *inputAttenuation;
+
+	// inputs and outputs for one group, stored as [sample][lane]
+	float *inputL, *inputR, *outputL, *outputR;
+
+	// delay line for unused lanes
+	float *zeros;
+
+	// the instances processed in the current call, excluding those with
+	// invalid input, and their indices in the arguments to the process
+	// function
+	BMReverb **active;
+	size_t *activeIndices;
+	size_t maxInstances;
+} BMReverbBatch;
+
+
+
+/*!
+ *BMReverbBatch_init
+ *
+ * @param This          pointer to an uninitialised struct
+ * @param maxInstances  maximum number of instances processed in one call
+ */
+void BMReverbBatch_init(BMReverbBatch *This, size_t maxInstances);
+
+
+/*!
+ *BMReverbBatch_free
+ *
+ * @abstract frees the memory used by the batch. This does not free the reverb instances.
+ */
+void BMReverbBatch_free(BMReverbBatch *This);
+
+
+/*!
+ *BMReverbBatch_process
+ *
+ * @abstract process numSamples of stereo audio through each of the reverbs. This is equivalent to calling BMReverbProcessBuffer on each instance.
+ *
+ * @param This          pointer to an initialised struct
+ * @param reverbs       array of numInstances pointers to initialised reverbs. Each reverb must have BMREVERB_NUMDELAYUNITS delay units, which is the default.
+ * @param inputsL       left input for each instance
+ * @param inputsR       right input for each instance
+ * @param outputsL      left output for each instance. In place processing is supported.
+ * @param outputsR      right output for each instance
+ * @param numInstances  number of reverbs, <= maxInstances
+ * @param numSamples    number of samples to process in each channel of each instance
+ */
+void BMReverbBatch_process(BMReverbBatch *This,
+						   BMReverb **reverbs,
+						   const float **inputsL, const float **inputsR,
+						   float **outputsL, float **outputsR,
+						   size_t numInstances,
+						   size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMReverbBatch_h */
@@ -8,14 +8,24 @@
 
 #include "BMSimpleFDN.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMFastHadamard.h"
 #include "BMIntegerMath.h"
+#include "Constants.h"
 
 
 #define UNIQUESUMS_ATTEMPTS_LIMIT 5000
 
+// longest block for BMSimpleFDN_processBuffer. With 64 delays the block
+// buffers take 64KB.
+#define BMSIMPLEFDN_MAX_BLOCK_SIZE 256
+
 
 // forward declarations
 float BMSimpleFDN_gainFromRT60(float rt60, float delayTime);
@@ -625,9 +635,7 @@ void BMSimpleFDN_init(BMSimpleFDN *This,
     This->attenuationCoefficients = malloc(sizeof(float) * numDelays);
     This->rwIndices = calloc(numDelays, sizeof(size_t));
     This->outputTapSigns = malloc(sizeof(float) * numDelays);
-    This->buffer1 = malloc(sizeof(float) * 3 * numDelays);
-    This->buffer2 = This->buffer1 + numDelays;
-    This->buffer3 = This->buffer2 + numDelays;
+    This->buffer1 = malloc(sizeof(float) * numDelays);
 
     // compute delay times according to the specified method
     if(method == DTM_VELVETNOISE)
@@ -662,12 +670,36 @@ void BMSimpleFDN_init(BMSimpleFDN *This,
     for(size_t i=1; i<This->numDelays; i++)
         This->delays[i] = This->delays[i-1] + This->delayLengths[i-1];
     
-    // set the attenuation coefficients
-    float matrixAttenuation = sqrt(1.0 / (double) This->numDelays);
+    // the block size for buffer processing can not exceed the shortest delay
+    size_t minDelayLength = This->delayLengths[0];
+    for(size_t i=1; i<This->numDelays; i++)
+        minDelayLength = BM_MIN(minDelayLength, This->delayLengths[i]);
+    This->blockSize = BM_MIN(minDelayLength, BMSIMPLEFDN_MAX_BLOCK_SIZE);
+    
+    // allocate one buffer per delay for block processing
+    This->blockBuffers = malloc(sizeof(float*) * numDelays);
+    This->blockBuffers[0] = malloc(sizeof(float) * numDelays * This->blockSize);
+    for(size_t i=1; i<This->numDelays; i++)
+        This->blockBuffers[i] = This->blockBuffers[i-1] + This->blockSize;
+    
+    // for single sample processing, each channel of the mixing matrix is one
+    // element of buffer1
+    This->sampleChannels = malloc(sizeof(float*) * numDelays);
+    for(size_t i=0; i<This->numDelays; i++)
+        This->sampleChannels[i] = This->buffer1 + i;
+    
+    BMMixingMatrix_init(&This->mixingMatrix, BMMM_HADAMARD, numDelays, This->blockSize);
+    
+    // set the attenuation coefficients. The mixing matrix is orthogonal so
+    // it needs no attenuation of its own.
+    //
+    // The output taps sum N delays with random signs, so scale them by
+    // 1/sqrt(N) to keep the output level independent of the number of
+    // delays.
+    This->outputGain = sqrt(1.0 / (double) This->numDelays);
     for(size_t i=0; i<This->numDelays; i++){
         float delayTime = (float)This->delayLengths[i] / This->sampleRate;
-        float rt60attenuation = BMSimpleFDN_gainFromRT60(This->RT60DecayTime, delayTime);
-        This->attenuationCoefficients[i] = matrixAttenuation * rt60attenuation;
+        This->attenuationCoefficients[i] = BMSimpleFDN_gainFromRT60(This->RT60DecayTime, delayTime);
     }
 }
 
@@ -688,12 +720,12 @@ float BMSimpleFDN_processSample(BMSimpleFDN *This, float input){
         This->buffer1[i] = readSample  *This->attenuationCoefficients[i];
         
         // sum to output
-        output += This->buffer1[i]  *This->outputTapSigns[i];
+        output += This->buffer1[i]  *(This->outputTapSigns[i] * This->outputGain);
     }
     
     
     // mix the feedback
-    BMFastHadamardTransform(This->buffer1, This->buffer1, This->buffer2, This->buffer3, This->numDelays);
+    BMMixingMatrix_processInPlace(&This->mixingMatrix, This->sampleChannels, 1);
     
     
     // write back to the delays
@@ -717,13 +749,103 @@ float BMSimpleFDN_processSample(BMSimpleFDN *This, float input){
 
 
 
+/*
+ * read numSamples from a delay starting at readIndex, attenuate them into
+ * output and sum them with the given sign into mix
+ */
+static void BMSimpleFDN_readDelay(BMSimpleFDN *This, size_t delay, float* output, float* mix, size_t numSamples){
+    const float* d = This->delays[delay];
+    size_t length = This->delayLengths[delay];
+    size_t readIndex = This->rwIndices[delay];
+    float gain = This->attenuationCoefficients[delay];
+    float sign = This->outputTapSigns[delay] * This->outputGain;
+    
+    // the block may wrap around the end of the delay
+    size_t firstPart = BM_MIN(numSamples, length - readIndex);
+    const float* segments [2] = {d + readIndex, d - firstPart};
+    size_t ends [2] = {firstPart, numSamples};
+    size_t k = 0;
+    for(size_t s=0; s<2; s++){
+        const float* segment = segments[s];
+        for(; k<ends[s]; k++){
+            float x = segment[k] * gain;
+            output[k] = x;
+            mix[k] += sign * x;
+        }
+    }
+}
+
+
+
+
+/*
+ * add input to the block and write it to a delay starting at writeIndex
+ */
+static void BMSimpleFDN_writeDelay(BMSimpleFDN *This, size_t delay, const float* block, const float* input, size_t numSamples){
+    float* d = This->delays[delay];
+    size_t length = This->delayLengths[delay];
+    size_t writeIndex = This->rwIndices[delay];
+    
+    size_t firstPart = BM_MIN(numSamples, length - writeIndex);
+    float* segments [2] = {d + writeIndex, d - firstPart};
+    size_t ends [2] = {firstPart, numSamples};
+    size_t k = 0;
+    for(size_t s=0; s<2; s++){
+        float* segment = segments[s];
+        for(; k<ends[s]; k++)
+            segment[k] = block[k] + input[k];
+    }
+    
+    // advance the delay index and wrap
+    writeIndex += numSamples;
+    if(writeIndex >= length)
+        writeIndex -= length;
+    This->rwIndices[delay] = writeIndex;
+}
+
+
+
+
+static void BMSimpleFDN_processBlock(BMSimpleFDN *This,
+                                     const float* input,
+                                     float* output,
+                                     size_t numSamples){
+    float** blocks = This->blockBuffers;
+    
+    // read from the delays, attenuate, and sum to output
+    memset(output, 0, sizeof(float) * numSamples);
+    for(size_t i=0; i<This->numDelays; i++)
+        BMSimpleFDN_readDelay(This, i, blocks[i], output, numSamples);
+    
+    // mix the feedback
+    BMMixingMatrix_processInPlace(&This->mixingMatrix, blocks, numSamples);
+    
+    // mix input with feedback and write back to the delays
+    for(size_t i=0; i<This->numDelays; i++)
+        BMSimpleFDN_writeDelay(This, i, blocks[i], input, numSamples);
+}
+
+
+
+
+void BMSimpleFDN_setMixingMatrix(BMSimpleFDN *This, enum BMMixingMatrixType type){
+    BMMixingMatrix_free(&This->mixingMatrix);
+    BMMixingMatrix_init(&This->mixingMatrix, type, This->numDelays, This->blockSize);
+}
+
+
+
+
 void BMSimpleFDN_processBuffer(BMSimpleFDN *This,
                                const float* input,
                                float* output,
                                size_t numSamples){
-    
-    for(size_t i=0; i<numSamples; i++)
-        output[i] = BMSimpleFDN_processSample(This, input[i]);
+    size_t samplesProcessed = 0;
+    while(samplesProcessed < numSamples){
+        size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, This->blockSize);
+        BMSimpleFDN_processBlock(This, input + samplesProcessed, output + samplesProcessed, samplesProcessing);
+        samplesProcessed += samplesProcessing;
+    }
 }
 
 
@@ -772,6 +894,15 @@ void BMSimpleFDN_free(BMSimpleFDN *This){
     
     free(This->buffer1);
     This->buffer1 = NULL;
+    
+    free(This->blockBuffers[0]);
+    free(This->blockBuffers);
+    This->blockBuffers = NULL;
+    
+    free(This->sampleChannels);
+    This->sampleChannels = NULL;
+    
+    BMMixingMatrix_free(&This->mixingMatrix);
 }
 
 
@@ -10,15 +10,19 @@
 #define BMSimpleFDN_h
 
 #include <stdio.h>
+#include "BMMixingMatrix.h"
 
 enum delayTimeMethod {DTM_VELVETNOISE, DTM_RANDOM, DTM_RELATIVEPRIME, DTM_LOGVELVETNOISE, DTM_UNIQUESUMS, DTM_RANDOMPRIMES, DTM_SCALEDPRIMES, DTM_PSEUDORANDOM, DTM_RANDOMFIXEDTOTAL};
 
 typedef struct BMSimpleFDN {
     float** delays;
     size_t *delayLengths, *rwIndices;
-    float *attenuationCoefficients, *buffer1, *buffer2, *buffer3, *outputTapSigns;
-    size_t numDelays;
-    float sampleRate, RT60DecayTime, maxDelayS, minDelayS;
+    float *attenuationCoefficients, *buffer1, *outputTapSigns;
+    float** blockBuffers;
+    float** sampleChannels;
+    BMMixingMatrix mixingMatrix;
+    size_t numDelays, blockSize;
+    float sampleRate, RT60DecayTime, maxDelayS, minDelayS, outputGain;
 } BMSimpleFDN;
 
 
@@ -42,6 +46,24 @@ void BMSimpleFDN_init(BMSimpleFDN *This,
                       float RT60DecayTimeSeconds);
 
 
+/*!
+ *BMSimpleFDN_setMixingMatrix
+ *
+ * @abstract choose the feedback mixing matrix. The default is BMMM_HADAMARD. This allocates memory so don't call it on the audio thread.
+ */
+void BMSimpleFDN_setMixingMatrix(BMSimpleFDN *This, enum BMMixingMatrixType type);
+
+
+/*!
+ *BMSimpleFDN_processBuffer
+ *
+ * @abstract processes in blocks no longer than the shortest delay. Within such a block no sample written to a delay is read again, so each delay is read for the whole block, the feedback is mixed for the whole block in one call to the mixing matrix chosen with BMSimpleFDN_setMixingMatrix, and the result is written back. The output is the same as calling BMSimpleFDN_processSample for each sample.
+ *
+ * @param This        pointer to an initialised struct
+ * @param input       array of length numSamples
+ * @param output      array of length numSamples
+ * @param numSamples  any length is supported
+ */
 void BMSimpleFDN_processBuffer(BMSimpleFDN *This,
                                const float* input,
                                float* output,
@@ -8,7 +8,11 @@
 
 #include "BMSmoothDelay.h"
 #include "Constants.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMSmoothDelay_prepareLGIBuffer(BMSmoothDelay* This,size_t bufferSize);
 void BMSmoothDelay_updateDelaySpeed(BMSmoothDelay* This,float speed);
@@ -0,0 +1,165 @@
+//
+//  BMSparseTapKernel.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMSparseTapKernel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// BMSTK_BLOCK_SIZE is four vectors of BMSTK_LANES
+#define BMSTK_LANES 8
+
+// unaligned vector of 8 floats. The compiler splits it into two registers
+// on targets with 128 bit vectors.
+typedef float BMSTKVec __attribute__((vector_size(sizeof(float)*BMSTK_LANES),aligned(4),__may_alias__));
+
+#define BMSTK_INLINE static inline __attribute__((always_inline))
+
+
+
+
+BMSTK_INLINE BMSTKVec BMSTKVec_load(const float *p){
+	return *(const BMSTKVec *)p;
+}
+
+BMSTK_INLINE void BMSTKVec_store(float *p, BMSTKVec v){
+	*(BMSTKVec *)p = v;
+}
+
+
+
+
+void BMSparseTapKernel_init(BMSparseTapKernel *This, size_t maxTaps){
+	This->maxTaps = maxTaps;
+	This->numTaps = 0;
+	This->offsets = malloc(sizeof(size_t) * maxTaps);
+	This->gains = malloc(sizeof(float) * maxTaps);
+}
+
+
+
+
+void BMSparseTapKernel_free(BMSparseTapKernel *This){
+	free(This->offsets);
+	This->offsets = NULL;
+	free(This->gains);
+	This->gains = NULL;
+}
+
+
+
+
+void BMSparseTapKernel_setTaps(BMSparseTapKernel *This, const size_t *offsets, const float *gains, size_t numTaps){
+	assert(numTaps <= This->maxTaps);
+
+	// Insertion sort the non-zero taps by offset, so that the reads move
+	// through the input buffer in order. This doesn't allocate memory and
+	// it is fast enough for the few hundred taps we typically have.
+	size_t n = 0;
+	for(size_t i=0; i<numTaps; i++){
+		if(gains[i] == 0.0f) continue;
+		size_t j = n++;
+		while(j > 0 && This->offsets[j-1] > offsets[i]){
+			This->gains[j] = This->gains[j-1];
+			This->offsets[j] = This->offsets[j-1];
+			j--;
+		}
+		This->gains[j] = gains[i];
+		This->offsets[j] = offsets[i];
+	}
+	This->numTaps = n;
+}
+
+
+
+
+/*!
+ *BMSparseTapKernel_processBlocks
+ *
+ * @abstract process numBlocks blocks of BMSTK_BLOCK_SIZE samples
+ */
+BM_SIMD_DISPATCH
+static void BMSparseTapKernel_processBlocks(const BMSparseTapKernel *This, const float *input, float *output, size_t numBlocks){
+	const size_t *offsets = This->offsets;
+	const float *gains = This->gains;
+
+	for(size_t b=0; b<numBlocks; b++){
+		const float *x = input + b*BMSTK_BLOCK_SIZE;
+
+		// The output block, in registers. Two taps at a time go into
+		// separate accumulators, so the additions don't all wait on each
+		// other. The second set of accumulators is added to the first at
+		// the end.
+		BMSTKVec acc0 = {0}, acc1 = {0}, acc2 = {0}, acc3 = {0};
+		BMSTKVec accB0 = {0}, accB1 = {0}, accB2 = {0}, accB3 = {0};
+		size_t t = 0;
+		for(; t+1<This->numTaps; t+=2){
+			const float *xt = x + offsets[t];
+			const float *xu = x + offsets[t+1];
+			float g = gains[t], h = gains[t+1];
+			acc0 += g * BMSTKVec_load(xt);
+			acc1 += g * BMSTKVec_load(xt + BMSTK_LANES);
+			acc2 += g * BMSTKVec_load(xt + 2*BMSTK_LANES);
+			acc3 += g * BMSTKVec_load(xt + 3*BMSTK_LANES);
+			accB0 += h * BMSTKVec_load(xu);
+			accB1 += h * BMSTKVec_load(xu + BMSTK_LANES);
+			accB2 += h * BMSTKVec_load(xu + 2*BMSTK_LANES);
+			accB3 += h * BMSTKVec_load(xu + 3*BMSTK_LANES);
+		}
+		if(t < This->numTaps){
+			const float *xt = x + offsets[t];
+			float g = gains[t];
+			acc0 += g * BMSTKVec_load(xt);
+			acc1 += g * BMSTKVec_load(xt + BMSTK_LANES);
+			acc2 += g * BMSTKVec_load(xt + 2*BMSTK_LANES);
+			acc3 += g * BMSTKVec_load(xt + 3*BMSTK_LANES);
+		}
+
+		float *y = output + b*BMSTK_BLOCK_SIZE;
+		BMSTKVec_store(y, acc0 + accB0);
+		BMSTKVec_store(y + BMSTK_LANES, acc1 + accB1);
+		BMSTKVec_store(y + 2*BMSTK_LANES, acc2 + accB2);
+		BMSTKVec_store(y + 3*BMSTK_LANES, acc3 + accB3);
+	}
+}
+
+
+
+
+void BMSparseTapKernel_process(const BMSparseTapKernel *This, const float *input, float *output, size_t numSamples){
+	size_t numBlocks = numSamples / BMSTK_BLOCK_SIZE;
+	BMSparseTapKernel_processBlocks(This, input, output, numBlocks);
+
+	// the samples at the end that don't fill a block
+	size_t processed = numBlocks * BMSTK_BLOCK_SIZE;
+	size_t remaining = numSamples - processed;
+	if(remaining == 0) return;
+	input += processed;
+	output += processed;
+	memset(output, 0, sizeof(float) * remaining);
+	for(size_t t=0; t<This->numTaps; t++)
+		for(size_t n=0; n<remaining; n++)
+			output[n] += This->gains[t] * input[This->offsets[t] + n];
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+//
+//  BMSparseTapKernel.h
+//  AudioFiltersXcodeProject
+//
+//  Computes the output of a multi-tap delay from a buffer of past input.
+//
+//  The simple way to do this is to make one pass over the output buffer for
+//  each tap, adding the delayed input multiplied by the tap gain. That reads
+//  and writes the whole output buffer once per tap. This kernel instead
+//  works on the output in short blocks of BMSTK_BLOCK_SIZE samples, which
+//  stay in registers while all of the taps are added. Each tap then costs
+//  only one load and one multiply-add per vector of output.
+//
+//  The taps are sorted by delay time so that consecutive taps read nearby
+//  regions of the delay buffer.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMSparseTapKernel_h
+#define BMSparseTapKernel_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of output samples computed in registers before moving on
+#define BMSTK_BLOCK_SIZE 32
+
+
+typedef struct BMSparseTapKernel {
+	// read offsets of the taps in the input buffer and the tap gains,
+	// sorted by offset
+	size_t *offsets;
+	float *gains;
+	size_t numTaps, maxTaps;
+} BMSparseTapKernel;
+
+
+
+/*!
+ *BMSparseTapKernel_init
+ *
+ * @param This     pointer to an uninitialised struct
+ * @param maxTaps  maximum number of taps
+ */
+void BMSparseTapKernel_init(BMSparseTapKernel *This, size_t maxTaps);
+
+
+/*!
+ *BMSparseTapKernel_free
+ */
+void BMSparseTapKernel_free(BMSparseTapKernel *This);
+
+
+/*!
+ *BMSparseTapKernel_setTaps
+ *
+ * @abstract sort the taps by offset. This does not allocate memory so it can be called on the audio thread.
+ *
+ * @param This       pointer to an initialised struct
+ * @param offsets    offset of each tap in the input buffer given to BMSparseTapKernel_process. For a delay line with the newest sample at index maxDelay, the offset of a tap with delay d is maxDelay - d.
+ * @param gains      gain of each tap. Taps with zero gain are skipped.
+ * @param numTaps    number of taps, <= maxTaps
+ */
+void BMSparseTapKernel_setTaps(BMSparseTapKernel *This, const size_t *offsets, const float *gains, size_t numTaps);
+
+
+/*!
+ *BMSparseTapKernel_process
+ *
+ * @abstract output[n] = sum over taps j of gains[j] * input[offsets[j] + n]
+ *
+ * @param This        pointer to an initialised struct
+ * @param input       input buffer, long enough to read numSamples samples from each tap offset
+ * @param output      output array of length numSamples. This must not overlap the input.
+ * @param numSamples  number of samples to compute
+ */
+void BMSparseTapKernel_process(const BMSparseTapKernel *This, const float *input, float *output, size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMSparseTapKernel_h */
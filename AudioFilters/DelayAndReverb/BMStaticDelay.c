@@ -9,7 +9,11 @@
 //
 
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMStaticDelay.h"
 #include <stdlib.h>
 
@@ -10,7 +10,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 void BMStereoLagTime_init(BMStereoLagTime* This,size_t maxDelaySamples,float duration,size_t sampleRate){
@@ -23,7 +23,11 @@ extern "C" {
 #ifndef BMVelvetNoise_h
 #define BMVelvetNoise_h
     
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
     
 /*!
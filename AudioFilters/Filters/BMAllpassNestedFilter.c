@@ -8,7 +8,11 @@
 
 #include "BMAllpassNestedFilter.h"
 #include "Constants.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMAllpassFilterData_init(BMAllpassFilterData* This,size_t delaySamples,float dc1, float dc2);
 void BMAllpassFilterData_destroy(BMAllpassFilterData* This);
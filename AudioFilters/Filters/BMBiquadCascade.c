@@ -0,0 +1,365 @@
+//
+//  BMBiquadCascade.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMBiquadCascade.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+
+// one vector holds one group of BMBQC_LANES channels. The compiler splits
+// it into two registers on targets with 128 bit vectors.
+typedef float BMBQCVec __attribute__((vector_size(sizeof(float)*BMBQC_LANES),aligned(4),__may_alias__));
+
+#define BMBQC_INLINE static inline __attribute__((always_inline))
+
+#define BMBQC_NUM_COEFFICIENTS 5
+#define BMBQC_DF1_NUM_STATES 4
+#define BMBQC_TDF2_NUM_STATES 2
+
+
+
+
+BMBQC_INLINE BMBQCVec BMBQCVec_load(const float *p){
+	return *(const BMBQCVec *)p;
+}
+
+BMBQC_INLINE void BMBQCVec_store(float *p, BMBQCVec v){
+	*(BMBQCVec *)p = v;
+}
+
+
+
+
+static size_t BMBiquadCascade_numStates(const BMBiquadCascade *This){
+	return This->form == BMBQC_DIRECT_FORM_1 ? BMBQC_DF1_NUM_STATES : BMBQC_TDF2_NUM_STATES;
+}
+
+
+
+
+void BMBiquadCascade_init(BMBiquadCascade *This, size_t numLevels, size_t numChannels, enum BMBiquadCascadeForm form){
+	assert(numLevels > 0 && numChannels > 0);
+
+	This->numLevels = numLevels;
+	This->numChannels = numChannels;
+	This->numGroups = (numChannels + BMBQC_LANES - 1) / BMBQC_LANES;
+	This->numChannelsPadded = This->numGroups * BMBQC_LANES;
+	This->form = form;
+	This->rampLength = BMBQC_DEFAULT_RAMP_LENGTH;
+	This->rampSamplesRemaining = 0;
+
+	size_t coefficientsLength = numLevels * BMBQC_NUM_COEFFICIENTS * This->numChannelsPadded;
+	This->coefficients = malloc(sizeof(float) * coefficientsLength);
+	This->coefficientDeltas = calloc(coefficientsLength, sizeof(float));
+	This->targets = malloc(sizeof(float) * coefficientsLength);
+
+	This->state = malloc(sizeof(float) * numLevels * BMBiquadCascade_numStates(This) * This->numChannelsPadded);
+
+	// the padding channels at the end of the last group are never written
+	// by the interleaving code so we zero them here
+	This->interleaved = calloc(BMBQC_CHUNK_SIZE * This->numChannelsPadded, sizeof(float));
+
+	This->activeLevels = malloc(sizeof(bool) * numLevels);
+	for(size_t i=0; i<numLevels; i++)
+		This->activeLevels[i] = true;
+
+	// set all levels to bypass, including the padding channels
+	memset(This->coefficients, 0, sizeof(float) * coefficientsLength);
+	for(size_t level=0; level<numLevels; level++){
+		float *b0 = This->coefficients + level * BMBQC_NUM_COEFFICIENTS * This->numChannelsPadded;
+		for(size_t c=0; c<This->numChannelsPadded; c++)
+			b0[c] = 1.0f;
+	}
+	memcpy(This->targets, This->coefficients, sizeof(float) * coefficientsLength);
+
+	BMBiquadCascade_clearState(This);
+}
+
+
+
+
+void BMBiquadCascade_free(BMBiquadCascade *This){
+	free(This->coefficients);
+	This->coefficients = NULL;
+	free(This->coefficientDeltas);
+	This->coefficientDeltas = NULL;
+	free(This->targets);
+	This->targets = NULL;
+	free(This->state);
+	This->state = NULL;
+	free(This->interleaved);
+	This->interleaved = NULL;
+	free(This->activeLevels);
+	This->activeLevels = NULL;
+}
+
+
+
+
+void BMBiquadCascade_clearState(BMBiquadCascade *This){
+	memset(This->state, 0, sizeof(float) * This->numLevels * BMBiquadCascade_numStates(This) * This->numChannelsPadded);
+}
+
+
+
+
+/*!
+ *BMBiquadCascade_deinterleaveCoefficients
+ *
+ * @abstract copy coefficients from the vDSP_biquadm order, [level][channel][coefficient], to the order we use internally, [level][coefficient][channel]
+ */
+static void BMBiquadCascade_deinterleaveCoefficients(BMBiquadCascade *This, const double *input, float *output){
+	for(size_t level=0; level<This->numLevels; level++){
+		const double *in = input + level * This->numChannels * BMBQC_NUM_COEFFICIENTS;
+		float *out = output + level * This->numChannelsPadded * BMBQC_NUM_COEFFICIENTS;
+		for(size_t c=0; c<This->numChannels; c++)
+			for(size_t k=0; k<BMBQC_NUM_COEFFICIENTS; k++)
+				out[k*This->numChannelsPadded + c] = (float)in[c*BMBQC_NUM_COEFFICIENTS + k];
+	}
+}
+
+
+
+
+void BMBiquadCascade_setCoefficients(BMBiquadCascade *This, const double *coefficients){
+	BMBiquadCascade_deinterleaveCoefficients(This, coefficients, This->targets);
+
+	size_t coefficientsLength = This->numLevels * BMBQC_NUM_COEFFICIENTS * This->numChannelsPadded;
+	memcpy(This->coefficients, This->targets, sizeof(float) * coefficientsLength);
+	This->rampSamplesRemaining = 0;
+}
+
+
+
+
+void BMBiquadCascade_setTargets(BMBiquadCascade *This, const double *targets){
+	BMBiquadCascade_deinterleaveCoefficients(This, targets, This->targets);
+
+	// if a ramp is already in progress, the new one starts from wherever
+	// the previous one got to
+	size_t coefficientsLength = This->numLevels * BMBQC_NUM_COEFFICIENTS * This->numChannelsPadded;
+	float rampLengthInverse = 1.0f / (float)This->rampLength;
+	for(size_t i=0; i<coefficientsLength; i++)
+		This->coefficientDeltas[i] = (This->targets[i] - This->coefficients[i]) * rampLengthInverse;
+	This->rampSamplesRemaining = This->rampLength;
+}
+
+
+
+
+void BMBiquadCascade_setRampLength(BMBiquadCascade *This, size_t rampLength){
+	assert(rampLength > 0);
+	This->rampLength = rampLength;
+}
+
+
+
+
+void BMBiquadCascade_setActiveLevels(BMBiquadCascade *This, const bool *activeLevels){
+	memcpy(This->activeLevels, activeLevels, sizeof(bool) * This->numLevels);
+}
+
+
+
+
+#pragma mark - kernels
+
+/*
+ * In the kernels below, io points to the first channel of one group in the
+ * interleaved buffer, coefficients points to b0 for the same group and
+ * level and state points to the first state variable for the same group and
+ * level. Coefficient k is at coefficients + k*stride and similarly for state
+ * variables. The filter state stays in registers for the whole chunk.
+ */
+
+BMBQC_INLINE void BMBiquadCascade_kernelTDF2(float *io, float *coefficients, float *state, size_t stride, size_t numSamples, bool ramp, const float *deltas){
+	BMBQCVec b0 = BMBQCVec_load(coefficients + 0*stride);
+	BMBQCVec b1 = BMBQCVec_load(coefficients + 1*stride);
+	BMBQCVec b2 = BMBQCVec_load(coefficients + 2*stride);
+	BMBQCVec a1 = BMBQCVec_load(coefficients + 3*stride);
+	BMBQCVec a2 = BMBQCVec_load(coefficients + 4*stride);
+	BMBQCVec s1 = BMBQCVec_load(state + 0*stride);
+	BMBQCVec s2 = BMBQCVec_load(state + 1*stride);
+
+	if(ramp){
+		BMBQCVec db0 = BMBQCVec_load(deltas + 0*stride);
+		BMBQCVec db1 = BMBQCVec_load(deltas + 1*stride);
+		BMBQCVec db2 = BMBQCVec_load(deltas + 2*stride);
+		BMBQCVec da1 = BMBQCVec_load(deltas + 3*stride);
+		BMBQCVec da2 = BMBQCVec_load(deltas + 4*stride);
+		for(size_t i=0; i<numSamples; i++){
+			b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+			BMBQCVec x = BMBQCVec_load(io + i*stride);
+			BMBQCVec y = b0*x + s1;
+			s1 = b1*x - a1*y + s2;
+			s2 = b2*x - a2*y;
+			BMBQCVec_store(io + i*stride, y);
+		}
+		BMBQCVec_store(coefficients + 0*stride, b0);
+		BMBQCVec_store(coefficients + 1*stride, b1);
+		BMBQCVec_store(coefficients + 2*stride, b2);
+		BMBQCVec_store(coefficients + 3*stride, a1);
+		BMBQCVec_store(coefficients + 4*stride, a2);
+	} else {
+		for(size_t i=0; i<numSamples; i++){
+			BMBQCVec x = BMBQCVec_load(io + i*stride);
+			BMBQCVec y = b0*x + s1;
+			s1 = b1*x - a1*y + s2;
+			s2 = b2*x - a2*y;
+			BMBQCVec_store(io + i*stride, y);
+		}
+	}
+
+	BMBQCVec_store(state + 0*stride, s1);
+	BMBQCVec_store(state + 1*stride, s2);
+}
+
+
+
+
+BMBQC_INLINE void BMBiquadCascade_kernelDF1(float *io, float *coefficients, float *state, size_t stride, size_t numSamples, bool ramp, const float *deltas){
+	BMBQCVec b0 = BMBQCVec_load(coefficients + 0*stride);
+	BMBQCVec b1 = BMBQCVec_load(coefficients + 1*stride);
+	BMBQCVec b2 = BMBQCVec_load(coefficients + 2*stride);
+	BMBQCVec a1 = BMBQCVec_load(coefficients + 3*stride);
+	BMBQCVec a2 = BMBQCVec_load(coefficients + 4*stride);
+	BMBQCVec x1 = BMBQCVec_load(state + 0*stride);
+	BMBQCVec x2 = BMBQCVec_load(state + 1*stride);
+	BMBQCVec y1 = BMBQCVec_load(state + 2*stride);
+	BMBQCVec y2 = BMBQCVec_load(state + 3*stride);
+
+	if(ramp){
+		BMBQCVec db0 = BMBQCVec_load(deltas + 0*stride);
+		BMBQCVec db1 = BMBQCVec_load(deltas + 1*stride);
+		BMBQCVec db2 = BMBQCVec_load(deltas + 2*stride);
+		BMBQCVec da1 = BMBQCVec_load(deltas + 3*stride);
+		BMBQCVec da2 = BMBQCVec_load(deltas + 4*stride);
+		for(size_t i=0; i<numSamples; i++){
+			b0 += db0; b1 += db1; b2 += db2; a1 += da1; a2 += da2;
+			BMBQCVec x = BMBQCVec_load(io + i*stride);
+			BMBQCVec y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+			x2 = x1; x1 = x;
+			y2 = y1; y1 = y;
+			BMBQCVec_store(io + i*stride, y);
+		}
+		BMBQCVec_store(coefficients + 0*stride, b0);
+		BMBQCVec_store(coefficients + 1*stride, b1);
+		BMBQCVec_store(coefficients + 2*stride, b2);
+		BMBQCVec_store(coefficients + 3*stride, a1);
+		BMBQCVec_store(coefficients + 4*stride, a2);
+	} else {
+		for(size_t i=0; i<numSamples; i++){
+			BMBQCVec x = BMBQCVec_load(io + i*stride);
+			BMBQCVec y = b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+			x2 = x1; x1 = x;
+			y2 = y1; y1 = y;
+			BMBQCVec_store(io + i*stride, y);
+		}
+	}
+
+	BMBQCVec_store(state + 0*stride, x1);
+	BMBQCVec_store(state + 1*stride, x2);
+	BMBQCVec_store(state + 2*stride, y1);
+	BMBQCVec_store(state + 3*stride, y2);
+}
+
+
+
+
+/*!
+ *BMBiquadCascade_processInterleaved
+ *
+ * @abstract process numSamples <= BMBQC_CHUNK_SIZE samples in This->interleaved, level by level for each group of channels
+ */
+BM_SIMD_DISPATCH
+static void BMBiquadCascade_processInterleaved(BMBiquadCascade *This, size_t numSamples, bool ramp){
+	size_t stride = This->numChannelsPadded;
+	size_t numStates = BMBiquadCascade_numStates(This);
+
+	for(size_t g=0; g<This->numGroups; g++){
+		float *io = This->interleaved + g*BMBQC_LANES;
+		for(size_t level=0; level<This->numLevels; level++){
+			if(!This->activeLevels[level]) continue;
+
+			size_t coefficientOffset = level*BMBQC_NUM_COEFFICIENTS*stride + g*BMBQC_LANES;
+			float *coefficients = This->coefficients + coefficientOffset;
+			const float *deltas = This->coefficientDeltas + coefficientOffset;
+			float *state = This->state + level*numStates*stride + g*BMBQC_LANES;
+
+			if(This->form == BMBQC_TRANSPOSED_DIRECT_FORM_2)
+				BMBiquadCascade_kernelTDF2(io, coefficients, state, stride, numSamples, ramp, deltas);
+			else
+				BMBiquadCascade_kernelDF1(io, coefficients, state, stride, numSamples, ramp, deltas);
+		}
+	}
+}
+
+
+
+
+void BMBiquadCascade_process(BMBiquadCascade *This,
+							 const float * const *inputs,
+							 float * const *outputs,
+							 size_t numSamples){
+	size_t stride = This->numChannelsPadded;
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, (size_t)BMBQC_CHUNK_SIZE);
+
+		// don't let a chunk run past the end of a coefficient ramp
+		bool ramp = This->rampSamplesRemaining > 0;
+		if(ramp)
+			samplesProcessing = BM_MIN(samplesProcessing, This->rampSamplesRemaining);
+
+		// interleave
+		for(size_t c=0; c<This->numChannels; c++){
+			const float *in = inputs[c] + samplesProcessed;
+			float *out = This->interleaved + c;
+			for(size_t i=0; i<samplesProcessing; i++)
+				out[i*stride] = in[i];
+		}
+
+		BMBiquadCascade_processInterleaved(This, samplesProcessing, ramp);
+
+		// when the ramp finishes, set the coefficients exactly to their
+		// targets so that rounding error doesn't accumulate
+		if(ramp){
+			This->rampSamplesRemaining -= samplesProcessing;
+			if(This->rampSamplesRemaining == 0)
+				memcpy(This->coefficients, This->targets, sizeof(float) * This->numLevels * BMBQC_NUM_COEFFICIENTS * stride);
+		}
+
+		// deinterleave
+		for(size_t c=0; c<This->numChannels; c++){
+			const float *in = This->interleaved + c;
+			float *out = outputs[c] + samplesProcessed;
+			for(size_t i=0; i<samplesProcessing; i++)
+				out[i] = in[i*stride];
+		}
+
+		samplesProcessed += samplesProcessing;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
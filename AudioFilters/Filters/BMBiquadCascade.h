@@ -0,0 +1,152 @@
+//
+//  BMBiquadCascade.h
+//  AudioFiltersXcodeProject
+//
+//  A multichannel cascade of biquad filters. This does the same job as
+//  vDSP_biquadm but it is written so that the compiler can vectorise it
+//  across channels: the channels are processed in groups of
+//  BMBQC_LANES, with the filter state and coefficients stored interleaved
+//  by channel so that each group fits in one vector register (or two on
+//  SSE2 and NEON, which have 4 lanes).
+//
+//  Coefficient changes can be applied immediately or with a linear ramp.
+//  The ramp runs inside the processing kernel so the filter setup never
+//  has to be recreated.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMBiquadCascade_h
+#define BMBiquadCascade_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of channels processed together in one vector
+#define BMBQC_LANES 8
+
+// the input is interleaved into chunks of this many samples
+#define BMBQC_CHUNK_SIZE 64
+
+// default length of a coefficient ramp in samples
+#define BMBQC_DEFAULT_RAMP_LENGTH 256
+
+enum BMBiquadCascadeForm {
+	BMBQC_DIRECT_FORM_1,
+	BMBQC_TRANSPOSED_DIRECT_FORM_2
+};
+
+typedef struct BMBiquadCascade {
+	// [level][coefficient][channel], padded to a multiple of BMBQC_LANES
+	// channels, in the order b0, b1, b2, a1, a2
+	float *coefficients;
+	float *coefficientDeltas;
+	float *targets;
+
+	// [level][state variable][channel]. DF1 uses 4 state variables
+	// (x1, x2, y1, y2) and TDF2 uses 2 (s1, s2)
+	float *state;
+
+	// interleaved buffer, [sample][channel]
+	float *interleaved;
+
+	bool *activeLevels;
+	size_t numLevels, numChannels, numChannelsPadded, numGroups;
+	size_t rampLength, rampSamplesRemaining;
+	enum BMBiquadCascadeForm form;
+} BMBiquadCascade;
+
+
+
+/*!
+ *BMBiquadCascade_init
+ *
+ * @abstract allocates memory and sets all levels to bypass
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param numLevels   number of biquad sections in series
+ * @param numChannels number of audio channels
+ * @param form        filter structure
+ */
+void BMBiquadCascade_init(BMBiquadCascade *This, size_t numLevels, size_t numChannels, enum BMBiquadCascadeForm form);
+
+
+/*!
+ *BMBiquadCascade_free
+ */
+void BMBiquadCascade_free(BMBiquadCascade *This);
+
+
+/*!
+ *BMBiquadCascade_setCoefficients
+ *
+ * @abstract change the filter coefficients immediately
+ *
+ * @param This   pointer to an initialised struct
+ * @param coefficients  array of length 5 * numLevels * numChannels, in the same order as vDSP_biquadm: [level][channel][b0,b1,b2,a1,a2]
+ */
+void BMBiquadCascade_setCoefficients(BMBiquadCascade *This, const double *coefficients);
+
+
+/*!
+ *BMBiquadCascade_setTargets
+ *
+ * @abstract ramp the filter coefficients linearly from their current values to the targets over This->rampLength samples
+ *
+ * @param This   pointer to an initialised struct
+ * @param targets  array of length 5 * numLevels * numChannels, in the same order as vDSP_biquadm: [level][channel][b0,b1,b2,a1,a2]
+ */
+void BMBiquadCascade_setTargets(BMBiquadCascade *This, const double *targets);
+
+
+/*!
+ *BMBiquadCascade_setRampLength
+ *
+ * @param This  pointer to an initialised struct
+ * @param rampLength  number of samples over which BMBiquadCascade_setTargets will ramp the coefficients. Must be > 0.
+ */
+void BMBiquadCascade_setRampLength(BMBiquadCascade *This, size_t rampLength);
+
+
+/*!
+ *BMBiquadCascade_setActiveLevels
+ *
+ * @abstract inactive levels are skipped when processing
+ *
+ * @param activeLevels array of length numLevels
+ */
+void BMBiquadCascade_setActiveLevels(BMBiquadCascade *This, const bool *activeLevels);
+
+
+/*!
+ *BMBiquadCascade_clearState
+ *
+ * @abstract set the filter memory to zero
+ */
+void BMBiquadCascade_clearState(BMBiquadCascade *This);
+
+
+/*!
+ *BMBiquadCascade_process
+ *
+ * @param This     pointer to an initialised struct
+ * @param inputs   array of numChannels input buffers of length numSamples
+ * @param outputs  array of numChannels output buffers of length numSamples. (in-place processing is supported)
+ * @param numSamples number of samples to process in each channel
+ */
+void BMBiquadCascade_process(BMBiquadCascade *This,
+							 const float * const *inputs,
+							 float * const *outputs,
+							 size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMBiquadCascade_h */
@@ -12,7 +12,11 @@
 extern "C" {
 #endif
     
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMCrossover.h"
 #include <assert.h>
     
@@ -19,7 +19,11 @@
 //  changes and still react immediately to large changes.
 
 #include "BMDynamicSmoothingFilter.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 #define BM_DSF_SENSITIVITY 0.125f
@@ -16,7 +16,11 @@ extern "C" {
 #include <assert.h>
 #include "BMFIRFilter.h"
 #include "BMSymmetricConv.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
     
     
     /*
@@ -41,22 +45,35 @@ extern "C" {
                           float* coefficients,
                           size_t length){
         
+        // set length variables
+        This->length = length;
+        
+        // copy the filter coefficients
+        This->coefficients = malloc(sizeof(float)*length);
+        memcpy(This->coefficients, coefficients, sizeof(float)*length);
+        
+        // long kernels are convolved in the frequency domain, so we don't
+        // need the buffers for direct convolution
+        This->usePartitionedConv = length > BMFIR_PARTITIONED_CONV_THRESHOLD;
+        if(This->usePartitionedConv){
+            This->symmetricFilterKernel = false;
+            BMPartitionedConv_initZeroLatency(&This->partitionedConv,
+                                              coefficients,
+                                              length,
+                                              BMPC_DEFAULT_MIN_BLOCK_SIZE,
+                                              BMPC_DEFAULT_MAX_BLOCK_SIZE);
+            return;
+        }
+        
         // if the filter kernel is symmetric, we can reduce the number of
         // multiplications in the convolution by about 50%. We check if
         // it is symmetric or not
         This->symmetricFilterKernel = BMFIRFilter_isSymmetric(coefficients, length);
         
-        // set length variables
-        This->length = length;
-        
         // init a circular buffer
         TPCircularBufferInit(&This->inputBuffer, sizeof(float)*((int)This->length - 1 + BM_BUFFER_CHUNK_SIZE));
         TPCircularBufferClear(&This->inputBuffer);
         
-        // copy the filter coefficients
-        This->coefficients = malloc(sizeof(float)*length);
-        memcpy(This->coefficients, coefficients, sizeof(float)*length);
-        
         /*
          * write zeros into the circular buffer to prepare for the first
          * iteration of the filter
@@ -86,6 +103,11 @@ extern "C" {
                              float* output,
                              size_t numSamples){
         
+        if(This->usePartitionedConv){
+            BMPartitionedConv_process(&This->partitionedConv, input, output, numSamples);
+            return;
+        }
+        
         // chunk processing loop
         while (numSamples > 0){
             
@@ -143,11 +165,16 @@ extern "C" {
     
     
     void BMFIRFilter_free(BMFIRFilter *This){
-        TPCircularBufferCleanup(&This->inputBuffer);
-        
         free(This->coefficients);
         This->coefficients = NULL;
         
+        if(This->usePartitionedConv){
+            BMPartitionedConv_free(&This->partitionedConv);
+            return;
+        }
+        
+        TPCircularBufferCleanup(&This->inputBuffer);
+        
         if(This->symmetricFilterKernel){
             free(This->convolverTempBuffer);
             This->convolverTempBuffer = NULL;
@@ -18,7 +18,15 @@ extern "C" {
 #include <stdio.h>
 #include "Constants.h"
 #include "TPCircularBuffer.h"
+#include "BMPartitionedConv.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+    
+    // kernels longer than this are convolved in the frequency domain
+#define BMFIR_PARTITIONED_CONV_THRESHOLD 1024
     
     typedef struct BMFIRFilter {
         TPCircularBuffer inputBuffer;
@@ -26,10 +34,18 @@ extern "C" {
         float* coefficients;
         size_t length;
         bool symmetricFilterKernel;
+        
+        BMPartitionedConv partitionedConv;
+        bool usePartitionedConv;
     } BMFIRFilter;
     
     
     /*
+     * Kernels longer than BMFIR_PARTITIONED_CONV_THRESHOLD use zero-latency
+     * partitioned FFT convolution (see BMPartitionedConv.h) so that the cost
+     * per sample doesn't grow with the length of the kernel. Shorter kernels
+     * use direct convolution.
+     *
      * @param coefficients   filter kernel
      * @param length         length of coefficients
      */
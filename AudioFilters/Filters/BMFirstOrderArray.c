@@ -179,8 +179,10 @@ extern "C" {
 	
 	void BMFirstOrderArray4x4_setHighDecayFDN(BMFirstOrderArray4x4 *This, size_t *delayTimesSamples, float fc, float unfilteredRT60, float filteredRT60, size_t numChannels){
 		   
-		   // allocate memory to store the gain for each filter
-		   float* gains = malloc(sizeof(float)*numChannels);
+		   // the gain for each filter. This is on the stack so that it's
+		   // safe to call on the audio thread.
+		   assert(numChannels <= 16);
+		   float gains [16];
 		   
 		   // find the gain setting to produce the specified decay time
 		   BMFirstOrderArray4x4_shelfFilterGainHelper(delayTimesSamples, gains, unfilteredRT60, filteredRT60, numChannels, This->sampleRate);
@@ -188,8 +190,6 @@ extern "C" {
 		   // set the filters
 		   BMFirstOrderArray4x4_setHighShelf(This, gains, fc, numChannels);
 		   
-		   // release the temporary memory
-		   free(gains);
 	   }
     
     
@@ -200,17 +200,15 @@ extern "C" {
 	
 	void BMFirstOrderArray4x4_setLowDecayFDN(BMFirstOrderArray4x4 *This, size_t *delayTimesSamples, float fc, float unfilteredRT60, float filteredRT60, size_t numChannels){
             
-            // allocate memory to store the gain for each filter
-            float* gains = malloc(sizeof(float)*numChannels);
+            // the gain for each filter
+            assert(numChannels <= 16);
+            float gains [16];
             
             // find the gain setting to produce the specified decay time
             BMFirstOrderArray4x4_shelfFilterGainHelper(delayTimesSamples, gains, unfilteredRT60, filteredRT60, numChannels, This->sampleRate);
             
             // set the filters
             BMFirstOrderArray4x4_setLowShelf(This, gains, fc, numChannels);
-            
-            // release the temporary memory
-            free(gains);
     }
     
     
@@ -26,7 +26,11 @@
 #define BMFirstOrderArray_h
 
 #include <stdio.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <assert.h>
 #include <simd/simd.h>
 
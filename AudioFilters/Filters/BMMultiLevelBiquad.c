@@ -38,7 +38,7 @@ void BMMultiLevelBiquad_create(BMMultiLevelBiquad *This);
 
 
 // this is a thread-safe way to update filter coefficients
-void BMMultiLevelBiquad_enqueueUpdate(BMMultiLevelBiquad *This);
+void BMMultiLevelBiquad_queueUpdate(BMMultiLevelBiquad *This);
 
 
 // this function updates the filter immediately and is safe to call
@@ -58,7 +58,7 @@ bool BMMultiLevelBiquad_OSSupportsRealtimeUpdate(void);
 
 
 
-void BMMultiLevelBiquad_processBufferStereo(BMMultiLevelBiquad *This, const float* inL, const float* inR, float* outL, float* outR, size_t numSamples){
+static void BMMultiLevelBiquad_processSegmentStereo(BMMultiLevelBiquad *This, const float* inL, const float* inR, float* outL, float* outR, size_t numSamples){
     // this function is only for two channel filtering
     assert(This->numChannels == 2);
     
@@ -75,7 +75,12 @@ void BMMultiLevelBiquad_processBufferStereo(BMMultiLevelBiquad *This, const floa
     float* twoChannelOutput [2] = {outL, outR};
     
     // apply a multilevel biquad filter to both channels
-    vDSP_biquadm(This->multiChannelFilterSetup, (const float* _Nonnull * _Nonnull)twoChannelInput, 1, twoChannelOutput, 1, numSamples);
+    if(This->useSVF)
+        BMSVFCascade_process(&This->svf, twoChannelInput, twoChannelOutput, numSamples);
+    else if(This->useNativeCascade)
+        BMBiquadCascade_process(&This->cascade, twoChannelInput, twoChannelOutput, numSamples);
+    else
+        vDSP_biquadm(This->multiChannelFilterSetup, (const float* _Nonnull * _Nonnull)twoChannelInput, 1, twoChannelOutput, 1, numSamples);
     
     BMSmoothGain_processBuffer(&This->gain, outL, outR, outL, outR, numSamples);
 }
@@ -85,10 +90,10 @@ void BMMultiLevelBiquad_processBufferStereo(BMMultiLevelBiquad *This, const floa
 
 
 
-void BMMultiLevelBiquad_processBuffer4(BMMultiLevelBiquad *This,
-                                       const float* in1, const float* in2, const float* in3, const float* in4,
-                                       float* out1, float* out2, float* out3, float* out4,
-                                       size_t numSamples){
+static void BMMultiLevelBiquad_processSegment4(BMMultiLevelBiquad *This,
+                                              const float* in1, const float* in2, const float* in3, const float* in4,
+                                              float* out1, float* out2, float* out3, float* out4,
+                                              size_t numSamples){
     // this function is only for four channel filtering
     assert(This->numChannels == 4);
     
@@ -105,8 +110,13 @@ void BMMultiLevelBiquad_processBuffer4(BMMultiLevelBiquad *This,
     float* fourChannelOutput [4] = {out1, out2, out3, out4};
     
     
-    // apply a multilevel biquad filter to both channels
-    vDSP_biquadm(This->multiChannelFilterSetup, (const float* _Nonnull * _Nonnull)fourChannelInput, 1, fourChannelOutput, 1, numSamples);
+    // apply a multilevel biquad filter to all four channels
+    if(This->useSVF)
+        BMSVFCascade_process(&This->svf, fourChannelInput, fourChannelOutput, numSamples);
+    else if(This->useNativeCascade)
+        BMBiquadCascade_process(&This->cascade, fourChannelInput, fourChannelOutput, numSamples);
+    else
+        vDSP_biquadm(This->multiChannelFilterSetup, (const float* _Nonnull * _Nonnull)fourChannelInput, 1, fourChannelOutput, 1, numSamples);
     
     // apply a gain adjustment
     const float *inputs [4] = {out1, out2, out3, out4};
@@ -118,7 +128,32 @@ void BMMultiLevelBiquad_processBuffer4(BMMultiLevelBiquad *This,
 
 
 
-void BMMultiLevelBiquad_processBufferMono(BMMultiLevelBiquad *This, const float* input, float* output, size_t numSamples){
+static void BMMultiLevelBiquad_processSegmentMultiChannel(BMMultiLevelBiquad *This,
+                                                         const float* const* inputs,
+                                                         float* const* outputs,
+                                                         size_t numSamples){
+    // update filter coefficients if necessary
+    if (This->needsUpdate) BMMultiLevelBiquad_updateNow(This);
+    
+    //Levels
+    BMMultiLevelBiquad_updateLevels(This);
+    
+    if(This->useSVF)
+        BMSVFCascade_process(&This->svf, inputs, outputs, numSamples);
+    else if(This->useNativeCascade)
+        BMBiquadCascade_process(&This->cascade, inputs, outputs, numSamples);
+    else
+        vDSP_biquadm(This->multiChannelFilterSetup, (const float* _Nonnull * _Nonnull)inputs, 1, (float* _Nonnull * _Nonnull)outputs, 1, numSamples);
+    
+    // apply a gain adjustment
+    BMSmoothGain_processBuffers(&This->gain, (const float**)outputs, (float**)outputs, This->numChannels, numSamples);
+}
+
+
+
+
+
+static void BMMultiLevelBiquad_processSegmentMono(BMMultiLevelBiquad *This, const float* input, float* output, size_t numSamples){
     
     // this function is only for single channel filtering
     assert(This->numChannels == 1);
@@ -130,8 +165,20 @@ void BMMultiLevelBiquad_processBufferMono(BMMultiLevelBiquad *This, const float*
     //Levels
     BMMultiLevelBiquad_updateLevels(This);
     
+    // if using state variable processing
+    if(This->useSVF){
+        const float* inputP [1] = {input};
+        float* outputP [1] = {output};
+        BMSVFCascade_process(&This->svf, inputP, outputP, numSamples);
+    }
+    
+    // if using block state-space processing
+    else if(This->useStateSpace){
+        BMStateSpaceBiquad_process(&This->stateSpace, input, output, numSamples);
+    }
+    
     // if using the multiChannel filter for single channel processing
-    if(This->useBiquadm){
+    else if(This->useBiquadm){
         // biquadm requires arrays of pointers as input and output
         const float* inputP [1] = {input};
         float* outputP [1] = {output};
@@ -152,6 +199,169 @@ void BMMultiLevelBiquad_processBufferMono(BMMultiLevelBiquad *This, const float*
 
 
 
+static void BMMultiLevelBiquad_applyParameterEvent(void *object, const BMParameterEvent *event){
+    BMMultiLevelBiquad *This = (BMMultiLevelBiquad*)object;
+    const float *v = event->values;
+    size_t level = event->index;
+    assert(event->parameter == BMMLB_GAIN || level < This->numLevels);
+    
+    // the setters only compute coefficients and queue an update, which the
+    // segment processing functions apply before processing
+    switch(event->parameter){
+        case BMMLB_BELL:
+            BMMultiLevelBiquad_setBell(This, v[0], v[1], v[2], level);
+            break;
+        case BMMLB_BELL_Q:
+            BMMultiLevelBiquad_setBellQ(This, v[0], v[1], v[2], level);
+            break;
+        case BMMLB_HIGH_SHELF:
+            BMMultiLevelBiquad_setHighShelf(This, v[0], v[1], level);
+            break;
+        case BMMLB_LOW_SHELF:
+            BMMultiLevelBiquad_setLowShelf(This, v[0], v[1], level);
+            break;
+        case BMMLB_LOWPASS_12DB:
+            BMMultiLevelBiquad_setLowPass12db(This, v[0], level);
+            break;
+        case BMMLB_LOWPASS_Q_12DB:
+            BMMultiLevelBiquad_setLowPassQ12db(This, v[0], v[1], level);
+            break;
+        case BMMLB_HIGHPASS_12DB:
+            BMMultiLevelBiquad_setHighPass12db(This, v[0], level);
+            break;
+        case BMMLB_HIGHPASS_Q_12DB:
+            BMMultiLevelBiquad_setHighPassQ12db(This, v[0], v[1], level);
+            break;
+        case BMMLB_LOWPASS_6DB:
+            BMMultiLevelBiquad_setLowPass6db(This, v[0], level);
+            break;
+        case BMMLB_HIGHPASS_6DB:
+            BMMultiLevelBiquad_setHighPass6db(This, v[0], level);
+            break;
+        case BMMLB_BYPASS:
+            BMMultiLevelBiquad_setBypass(This, level);
+            break;
+        case BMMLB_GAIN:
+            BMMultiLevelBiquad_setGain(This, v[0]);
+            break;
+        default:
+            assert(false);
+    }
+}
+
+
+
+
+
+bool BMMultiLevelBiquad_pushParameterEvent(BMMultiLevelBiquad *This, const BMParameterEvent *event){
+    return BMParameterQueue_push(&This->parameterQueue, event);
+}
+
+
+
+
+bool BMMultiLevelBiquad_pushParameterSnapshot(BMMultiLevelBiquad *This, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime){
+    return BMParameterQueue_pushSnapshot(&This->parameterQueue, events, numEvents, sampleTime);
+}
+
+
+
+
+
+/*
+ * Each of the processing functions below splits the buffer into segments
+ * at the times of the queued parameter events and applies the events due
+ * at the start of each segment. When no events are waiting there is only
+ * one segment.
+ */
+void BMMultiLevelBiquad_processBufferStereo(BMMultiLevelBiquad *This, const float* inL, const float* inR, float* outL, float* outR, size_t numSamples){
+    size_t samplesProcessed = 0;
+    while(samplesProcessed < numSamples){
+        size_t samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                                numSamples - samplesProcessed,
+                                                                BMMultiLevelBiquad_applyParameterEvent,
+                                                                This);
+        BMMultiLevelBiquad_processSegmentStereo(This,
+                                                inL + samplesProcessed, inR + samplesProcessed,
+                                                outL + samplesProcessed, outR + samplesProcessed,
+                                                samplesProcessing);
+        samplesProcessed += samplesProcessing;
+    }
+}
+
+
+
+
+
+void BMMultiLevelBiquad_processBuffer4(BMMultiLevelBiquad *This,
+                                       const float* in1, const float* in2, const float* in3, const float* in4,
+                                       float* out1, float* out2, float* out3, float* out4,
+                                       size_t numSamples){
+    size_t samplesProcessed = 0;
+    while(samplesProcessed < numSamples){
+        size_t samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                                numSamples - samplesProcessed,
+                                                                BMMultiLevelBiquad_applyParameterEvent,
+                                                                This);
+        size_t i = samplesProcessed;
+        BMMultiLevelBiquad_processSegment4(This,
+                                           in1 + i, in2 + i, in3 + i, in4 + i,
+                                           out1 + i, out2 + i, out3 + i, out4 + i,
+                                           samplesProcessing);
+        samplesProcessed += samplesProcessing;
+    }
+}
+
+
+
+
+
+void BMMultiLevelBiquad_processBufferMultiChannel(BMMultiLevelBiquad *This,
+                                                  const float* const* inputs,
+                                                  float* const* outputs,
+                                                  size_t numSamples){
+    size_t samplesProcessed = 0;
+    while(samplesProcessed < numSamples){
+        size_t samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                                numSamples - samplesProcessed,
+                                                                BMMultiLevelBiquad_applyParameterEvent,
+                                                                This);
+        
+        // skip the pointer arithmetic in the usual case where there is only one segment
+        if(samplesProcessing == numSamples){
+            BMMultiLevelBiquad_processSegmentMultiChannel(This, inputs, outputs, numSamples);
+        } else {
+            for(size_t j=0; j<This->numChannels; j++){
+                This->segmentInputs[j] = inputs[j] + samplesProcessed;
+                This->segmentOutputs[j] = outputs[j] + samplesProcessed;
+            }
+            BMMultiLevelBiquad_processSegmentMultiChannel(This, This->segmentInputs, This->segmentOutputs, samplesProcessing);
+        }
+        
+        samplesProcessed += samplesProcessing;
+    }
+}
+
+
+
+
+
+void BMMultiLevelBiquad_processBufferMono(BMMultiLevelBiquad *This, const float* input, float* output, size_t numSamples){
+    size_t samplesProcessed = 0;
+    while(samplesProcessed < numSamples){
+        size_t samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                                numSamples - samplesProcessed,
+                                                                BMMultiLevelBiquad_applyParameterEvent,
+                                                                This);
+        BMMultiLevelBiquad_processSegmentMono(This, input + samplesProcessed, output + samplesProcessed, samplesProcessing);
+        samplesProcessed += samplesProcessing;
+    }
+}
+
+
+
+
+
 // Find out if the OS supports vDSP_biquadm updates in realtime
 bool BMMultiLevelBiquad_OSSupportsRealtimeUpdate(){
     
@@ -183,6 +393,13 @@ void BMMultiLevelBiquad_init(BMMultiLevelBiquad *This,
     This->coefficients_d = NULL;
     // This->coefficients_f = NULL;
     This->monoDelays = NULL;
+    This->segmentInputs = NULL;
+    This->segmentOutputs = NULL;
+    This->useNativeCascade = false;
+    This->useStateSpace = false;
+    This->hasStateSpace = false;
+    This->useSVF = false;
+    This->hasSVF = false;
     
     This->needsUpdate = false;
     This->sampleRate = sampleRate;
@@ -213,6 +430,10 @@ void BMMultiLevelBiquad_init(BMMultiLevelBiquad *This,
     // both double and float to support realtime updates
     // This->coefficients_f = malloc(numLevels*5*This->numChannels*sizeof(float));
     
+    // pointers for splitting buffers at parameter event times
+    This->segmentInputs = malloc(sizeof(const float*) * This->numChannels);
+    This->segmentOutputs = malloc(sizeof(float*) * This->numChannels);
+    
     // Allocate 2*numLevels + 2 floats for mono delay memory
     if(!This->useBiquadm)
         This->monoDelays = calloc((2*numLevels + 2),sizeof(float));
@@ -228,6 +449,8 @@ void BMMultiLevelBiquad_init(BMMultiLevelBiquad *This,
     BMSmoothGain_init(&This->gain2, sampleRate);
     BMMultiLevelBiquad_setGain(This,0.0);
     
+    BMParameterQueue_init(&This->parameterQueue, BMPARAMETERQUEUE_DEFAULT_CAPACITY);
+    
     // setup filter struct
     BMMultiLevelBiquad_create(This);
 }
@@ -259,6 +482,12 @@ void BMMultiLevelBiquad_init4(BMMultiLevelBiquad *This,
     // free(This->coefficients_f);
     // This->coefficients_f = malloc(numLevels*5*This->numChannels*sizeof(float));
     
+    // reallocate the pointers for splitting buffers at parameter event times
+    free(This->segmentInputs);
+    free(This->segmentOutputs);
+    This->segmentInputs = malloc(sizeof(const float*) * This->numChannels);
+    This->segmentOutputs = malloc(sizeof(float*) * This->numChannels);
+    
     
     // start with all levels on bypass
     for (size_t i=0; i<numLevels; i++) {
@@ -275,6 +504,115 @@ void BMMultiLevelBiquad_init4(BMMultiLevelBiquad *This,
 
 
 
+void BMMultiLevelBiquad_initMultiChannel(BMMultiLevelBiquad *This,
+                                         size_t numLevels,
+                                         size_t numChannels,
+                                         float sampleRate,
+                                         bool smoothUpdate){
+    assert(numChannels > 0);
+    
+    // for a single channel, the mono init does the job
+    if(numChannels == 1){
+        BMMultiLevelBiquad_init(This, numLevels, sampleRate, false, true, smoothUpdate);
+        return;
+    }
+    
+    // init as stereo to make use of the code that is in the existing init function
+    BMMultiLevelBiquad_init(This, numLevels, sampleRate, true, false, smoothUpdate);
+    
+    // change the number of channels and reallocate the coefficient array
+    This->numChannels = numChannels;
+    free(This->coefficients_d);
+    This->coefficients_d = malloc(numLevels*5*This->numChannels*sizeof(double));
+    
+    // reallocate the pointers for splitting buffers at parameter event times
+    free(This->segmentInputs);
+    free(This->segmentOutputs);
+    This->segmentInputs = malloc(sizeof(const float*) * This->numChannels);
+    This->segmentOutputs = malloc(sizeof(float*) * This->numChannels);
+    
+    // start with all levels on bypass
+    for (size_t i=0; i<numLevels; i++) {
+        BMMultiLevelBiquad_setBypass(This, i);
+    }
+    
+    // update the filter struct
+    BMMultiLevelBiquad_recreate(This);
+}
+
+
+
+
+
+void BMMultiLevelBiquad_setStateSpaceProcessing(BMMultiLevelBiquad *This, bool enabled){
+    // this is only for single channel filtering
+    assert(This->numChannels == 1);
+    
+    if(enabled != This->useStateSpace){
+        // most filters never use state-space processing, so we don't
+        // allocate it until it's needed
+        if(!This->hasStateSpace){
+            BMStateSpaceBiquad_init(&This->stateSpace, This->numLevels);
+            BMStateSpaceBiquad_setCoefficients(&This->stateSpace, This->coefficients_d);
+            BMStateSpaceBiquad_setActiveLevels(&This->stateSpace, This->activeLevels);
+            This->hasStateSpace = true;
+        }
+        
+        BMStateSpaceBiquad_clearState(&This->stateSpace);
+        This->useStateSpace = enabled;
+        
+        // the filter we are switching to may not have the latest coefficients
+        BMMultiLevelBiquad_queueUpdate(This);
+    }
+}
+
+
+
+
+
+void BMMultiLevelBiquad_setSVFProcessing(BMMultiLevelBiquad *This, bool enabled){
+    if(enabled != This->useSVF){
+        // start the state variable filter from the current coefficients,
+        // without a ramp
+        if(enabled){
+            // the cascade isn't allocated until it's needed
+            if(!This->hasSVF){
+                BMSVFCascade_init(&This->svf, This->numLevels, This->numChannels);
+                BMSVFCascade_setActiveLevels(&This->svf, This->activeLevels);
+                This->hasSVF = true;
+            }
+            BMSVFCascade_clearState(&This->svf);
+            BMSVFCascade_setCoefficients(&This->svf, This->coefficients_d);
+            This->useSVF = true;
+        }
+        
+        // the filter we are switching to may not have the latest coefficients
+        else {
+            This->useSVF = false;
+            if(This->useNativeCascade) BMBiquadCascade_clearState(&This->cascade);
+            if(This->hasStateSpace) BMStateSpaceBiquad_clearState(&This->stateSpace);
+            BMMultiLevelBiquad_queueUpdate(This);
+        }
+    }
+}
+
+
+
+
+
+bool BMMultiLevelBiquad_addAutomationPoint(BMMultiLevelBiquad *This, size_t sampleOffset){
+    assert(This->useSVF);
+    
+    // the automation point carries the change, so the setters that were
+    // called to design it don't need to update the filter
+    This->needsUpdate = false;
+    
+    return BMSVFCascade_addBreakpoint(&This->svf, This->coefficients_d, sampleOffset);
+}
+
+
+
+
 
 void BMMultiLevelBiquad_setGain(BMMultiLevelBiquad *This, float gain_db){
     BMSmoothGain_setGainDb(&This->gain, gain_db);
@@ -297,8 +635,28 @@ void BMMultiLevelBiquad_queueUpdate(BMMultiLevelBiquad *This){
 
 inline void BMMultiLevelBiquad_updateNow(BMMultiLevelBiquad *This){
     
+    // state variable mode ramps in its own parameter space, which stays
+    // stable however fast the coefficients change
+    if(This->useSVF){
+        if(This->useSmoothUpdate)
+            BMSVFCascade_setTargets(&This->svf, This->coefficients_d, BMBQC_DEFAULT_RAMP_LENGTH);
+        else
+            BMSVFCascade_setCoefficients(&This->svf, This->coefficients_d);
+    }
+    // state-space mode recomputes its block matrices without smoothing
+    else if(This->useStateSpace){
+        BMStateSpaceBiquad_setCoefficients(&This->stateSpace, This->coefficients_d);
+    }
+    // the native cascade always updates in realtime. When smooth update is
+    // on, the coefficients ramp linearly inside the processing kernel.
+    else if(This->useNativeCascade){
+        if(This->useSmoothUpdate)
+            BMBiquadCascade_setTargets(&This->cascade, This->coefficients_d);
+        else
+            BMBiquadCascade_setCoefficients(&This->cascade, This->coefficients_d);
+    }
     // using realtime updates
-    if(This->useRealTimeUpdate){
+    else if(This->useRealTimeUpdate){
 //        // convert the coefficients to floating point
 //        for(size_t i=0; i<This->numLevels*This->numChannels*5; i++){
 //            This->coefficients_f[i] = This->coefficients_d[i];
@@ -322,7 +680,15 @@ inline void BMMultiLevelBiquad_updateNow(BMMultiLevelBiquad *This){
 
 void BMMultiLevelBiquad_create(BMMultiLevelBiquad *This){
     
-    if(This->useBiquadm){
+    // use the native cascade for all filters with more than one channel
+    This->useNativeCascade = This->numChannels > 1;
+    
+    if(This->useNativeCascade){
+        BMBiquadCascade_init(&This->cascade, This->numLevels, This->numChannels, BMBQC_TRANSPOSED_DIRECT_FORM_2);
+        BMBiquadCascade_setCoefficients(&This->cascade, This->coefficients_d);
+    }
+    
+    else if(This->useBiquadm){
         This->multiChannelFilterSetup =
         vDSP_biquadm_CreateSetup(This->coefficients_d, This->numLevels, This->numChannels);
     }
@@ -338,7 +704,18 @@ void BMMultiLevelBiquad_create(BMMultiLevelBiquad *This){
 
 inline void BMMultiLevelBiquad_recreate(BMMultiLevelBiquad *This){
     
-    if(This->useBiquadm){
+    if(This->useNativeCascade){
+        // the number of channels changes after init in init4 and
+        // initMultiChannel
+        if(This->cascade.numChannels != This->numChannels){
+            BMBiquadCascade_free(&This->cascade);
+            BMBiquadCascade_init(&This->cascade, This->numLevels, This->numChannels, BMBQC_TRANSPOSED_DIRECT_FORM_2);
+            BMBiquadCascade_setActiveLevels(&This->cascade, This->activeLevels);
+        }
+        BMBiquadCascade_setCoefficients(&This->cascade, This->coefficients_d);
+    }
+    
+    else if(This->useBiquadm){
         vDSP_biquadm_DestroySetup(This->multiChannelFilterSetup);
         This->multiChannelFilterSetup =
         vDSP_biquadm_CreateSetup(This->coefficients_d, This->numLevels, This->numChannels);
@@ -375,8 +752,23 @@ void BMMultiLevelBiquad_destroy(BMMultiLevelBiquad *This){
     This->coefficients_d = NULL;
     // This->coefficients_f = NULL;
     This->monoDelays = NULL;
-    
-    if(This->numChannels > 1)
+    free(This->segmentInputs);
+    This->segmentInputs = NULL;
+    free(This->segmentOutputs);
+    This->segmentOutputs = NULL;
+    
+    BMParameterQueue_free(&This->parameterQueue);
+    
+    if(This->hasStateSpace)
+        BMStateSpaceBiquad_free(&This->stateSpace);
+    This->hasStateSpace = false;
+    if(This->hasSVF)
+        BMSVFCascade_free(&This->svf);
+    This->hasSVF = false;
+    
+    if(This->useNativeCascade)
+        BMBiquadCascade_free(&This->cascade);
+    else if(This->useBiquadm)
         vDSP_biquadm_DestroySetup(This->multiChannelFilterSetup);
     else
         vDSP_biquad_DestroySetup(This->singleChannelFilterSetup);
@@ -395,9 +787,15 @@ inline void BMMultiLevelBiquad_updateLevels(BMMultiLevelBiquad *This){
 	assert(This->useBiquadm);
 	
     if(This->needUpdateActiveLevels){
-        printf("disabling inactive filter levels\n");
         This->needUpdateActiveLevels = false;
-		vDSP_biquadm_SetActiveFilters(This->multiChannelFilterSetup, This->activeLevels);
+        if(This->hasStateSpace)
+            BMStateSpaceBiquad_setActiveLevels(&This->stateSpace, This->activeLevels);
+        if(This->hasSVF)
+            BMSVFCascade_setActiveLevels(&This->svf, This->activeLevels);
+        if(This->useNativeCascade)
+            BMBiquadCascade_setActiveLevels(&This->cascade, This->activeLevels);
+        else
+            vDSP_biquadm_SetActiveFilters(This->multiChannelFilterSetup, This->activeLevels);
     }
 }
 
@@ -1339,6 +1737,64 @@ void BMMultiLevelBiquad_setLinkwitzRileyHP4thOrder(BMMultiLevelBiquad *This, dou
 
 
 
+void BMMultiLevelBiquad_setKWeighting(BMMultiLevelBiquad *This, size_t firstLevel){
+    assert(firstLevel + 1 < This->numLevels);
+    
+    // the filter parameters are those that reproduce the coefficients
+    // given in BS.1770-4 at 48 kHz
+    double shelfFc = 1681.974450955533;
+    double shelfGainDb = 3.999843853973347;
+    double shelfQ = 0.7071752369554196;
+    double highpassFc = 38.13547087602444;
+    double highpassQ = 0.5003270373238773;
+    
+    // for all channels, set coefficients
+    for(size_t i=0; i < This->numChannels; i++){
+        
+        // high shelf in the first level
+        double* b0 = This->coefficients_d + firstLevel*This->numChannels*5 + i*5;
+        double* b1 = b0 + 1;
+        double* b2 = b1 + 1;
+        double* a1 = b2 + 1;
+        double* a2 = a1 + 1;
+        
+        double gamma = tan(M_PI * shelfFc / This->sampleRate);
+        double gamma_sq = gamma * gamma;
+        double Vh = pow(10.0, shelfGainDb / 20.0);
+        double Vb = pow(Vh, 0.4996667741545416);
+        double one_over_denominator = 1.0 / (1.0 + gamma / shelfQ + gamma_sq);
+        
+        *b0 = (Vh + Vb * gamma / shelfQ + gamma_sq) * one_over_denominator;
+        *b1 = 2.0 * (gamma_sq - Vh) * one_over_denominator;
+        *b2 = (Vh - Vb * gamma / shelfQ + gamma_sq) * one_over_denominator;
+        *a1 = 2.0 * (gamma_sq - 1.0) * one_over_denominator;
+        *a2 = (1.0 - gamma / shelfQ + gamma_sq) * one_over_denominator;
+        
+        // highpass in the second level. The numerator is not normalised,
+        // as in the recommendation.
+        b0 = This->coefficients_d + (firstLevel+1)*This->numChannels*5 + i*5;
+        b1 = b0 + 1;
+        b2 = b1 + 1;
+        a1 = b2 + 1;
+        a2 = a1 + 1;
+        
+        gamma = tan(M_PI * highpassFc / This->sampleRate);
+        gamma_sq = gamma * gamma;
+        one_over_denominator = 1.0 / (1.0 + gamma / highpassQ + gamma_sq);
+        
+        *b0 = 1.0;
+        *b1 = -2.0;
+        *b2 = 1.0;
+        *a1 = 2.0 * (gamma_sq - 1.0) * one_over_denominator;
+        *a2 = (1.0 - gamma / highpassQ + gamma_sq) * one_over_denominator;
+    }
+    
+    BMMultiLevelBiquad_queueUpdate(This);
+}
+
+
+
+
 void BMMultiLevelBiquad_setLowPass6db(BMMultiLevelBiquad *This, double fc, size_t level){
     assert(level < This->numLevels);
     
@@ -12,13 +12,39 @@
 #define BMMultiLevelBiquad_h
 
 #include <stdio.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMSmoothGain.h"
+#include "BMBiquadCascade.h"
+#include "BMStateSpaceBiquad.h"
+#include "BMSVFCascade.h"
+#include "BMParameterQueue.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Parameters for BMMultiLevelBiquad_pushParameterEvent. The event's index is
+// the filter level and its values are the arguments of the setter with the
+// same name, in the same order.
+enum BMMultiLevelBiquadParameter {
+    BMMLB_BELL,             // fc, bandwidth, gain_db
+    BMMLB_BELL_Q,           // fc, Q, gain_db
+    BMMLB_HIGH_SHELF,       // fc, gain_db
+    BMMLB_LOW_SHELF,        // fc, gain_db
+    BMMLB_LOWPASS_12DB,     // fc
+    BMMLB_LOWPASS_Q_12DB,   // fc, q
+    BMMLB_HIGHPASS_12DB,    // fc
+    BMMLB_HIGHPASS_Q_12DB,  // fc, q
+    BMMLB_LOWPASS_6DB,      // fc
+    BMMLB_HIGHPASS_6DB,     // fc
+    BMMLB_BYPASS,           // no values
+    BMMLB_GAIN              // gain_db. The index is ignored.
+};
+
 typedef struct BMMultiLevelBiquad {
     // dynamic memory
     vDSP_biquadm_Setup multiChannelFilterSetup;
@@ -36,6 +62,27 @@ typedef struct BMMultiLevelBiquad {
     bool needsUpdate, useRealTimeUpdate, useBiquadm,useSmoothUpdate,needUpdateActiveLevels;
     bool *activeLevels;
     BMSmoothGain gain, gain2;
+    
+    // multichannel filters use BMBiquadCascade instead of vDSP_biquadm
+    BMBiquadCascade cascade;
+    bool useNativeCascade;
+    
+    // optional block processing for mono filters, allocated the first
+    // time it is enabled
+    BMStateSpaceBiquad stateSpace;
+    bool useStateSpace, hasStateSpace;
+    
+    // optional state variable processing for automation, allocated the
+    // first time it is enabled
+    BMSVFCascade svf;
+    bool useSVF, hasSVF;
+    
+    // timestamped setting changes from the control thread
+    BMParameterQueue parameterQueue;
+    
+    // buffer pointers offset to the start of each segment between events
+    const float** segmentInputs;
+    float** segmentOutputs;
 } BMMultiLevelBiquad;
 
 
@@ -55,11 +102,63 @@ void BMMultiLevelBiquad_processBuffer4(BMMultiLevelBiquad* This,
                                        float* out1, float* out2, float* out3, float* out4,
                                        size_t numSamples);
 
+/*!
+ *BMMultiLevelBiquad_processBufferMultiChannel
+ *
+ * @abstract process any number of channels. Use this for filters initialised with BMMultiLevelBiquad_initMultiChannel
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of This->numChannels input buffers
+ * @param outputs     array of This->numChannels output buffers (in-place processing is supported)
+ * @param numSamples  length of each buffer
+ */
+void BMMultiLevelBiquad_processBufferMultiChannel(BMMultiLevelBiquad* This,
+                                                  const float* const* inputs,
+                                                  float* const* outputs,
+                                                  size_t numSamples);
+
 /*!
  *BMMultiLevelBiquad_processBufferMono
  */
 void BMMultiLevelBiquad_processBufferMono(BMMultiLevelBiquad* This, const float* input, float* output, size_t numSamples);
 
+/*!
+ *BMMultiLevelBiquad_setStateSpaceProcessing
+ *
+ * @abstract turn block state-space processing on or off for a mono filter
+ *
+ * @discussion BMMultiLevelBiquad_processBufferMono normally runs the serial biquad recurrence, which can't make use of SIMD instructions when there is only one channel. In state-space mode it computes BMSSB_BLOCK_SIZE samples at a time instead (see BMStateSpaceBiquad.h). This is faster for high order filters on long buffers, for example in offline rendering. Coefficient updates are not smoothed in this mode. The filter state resets when the mode changes. The first time this is enabled it allocates memory so don't call it on the audio thread.
+ *
+ * @param This     pointer to a filter initialised with isStereo = false
+ * @param enabled  true to use state-space processing
+ */
+void BMMultiLevelBiquad_setStateSpaceProcessing(BMMultiLevelBiquad* This, bool enabled);
+
+/*!
+ *BMMultiLevelBiquad_setSVFProcessing
+ *
+ * @abstract turn state variable processing on or off
+ *
+ * @discussion In this mode each level is converted to a trapezoidal state variable filter (see BMSVFCascade.h). Coefficient changes are interpolated per sample in a parameter space where every intermediate filter is stable, so fast sweeps can't blow up. Smooth updates ramp over BMBQC_DEFAULT_RAMP_LENGTH samples. Use BMMultiLevelBiquad_addAutomationPoint for sample accurate automation curves. This takes precedence over state-space processing. The filter state resets when the mode changes. The first time this is enabled it allocates memory so don't call it on the audio thread.
+ *
+ * @param This     pointer to an initialised struct
+ * @param enabled  true to use state variable processing
+ */
+void BMMultiLevelBiquad_setSVFProcessing(BMMultiLevelBiquad* This, bool enabled);
+
+/*!
+ *BMMultiLevelBiquad_addAutomationPoint
+ *
+ * @abstract add the current filter setting to the automation curve, to be reached sampleOffset samples after the start of the next buffer
+ *
+ * @discussion Call the setters to design the filter for a point on the curve, then call this to set the time. Repeat for each point, in order of time. The filter ramps per sample from one point to the next during processing and holds the last point. Offsets may go beyond the end of the next buffer, so one curve can span several buffers. This replaces the update that the setters would otherwise apply at the start of the next buffer. Calling a setter without adding a point cancels the points that have not been reached yet. Requires BMMultiLevelBiquad_setSVFProcessing(This, true).
+ *
+ * @param This          pointer to an initialised struct
+ * @param sampleOffset  number of samples from the start of the next buffer processed to the sample on which the filter reaches this setting
+ * @returns false if BMSVFC_MAX_BREAKPOINTS points are already waiting. The point is not added in that case.
+ */
+bool BMMultiLevelBiquad_addAutomationPoint(BMMultiLevelBiquad* This, size_t sampleOffset);
+
 /*!
  *BMMultiLevelBiquad_init
  * @Abstract init must be called once before using the filter.  To change the number of levels in the fitler, call destroy first, then call this function with the new number of levels
@@ -96,6 +195,23 @@ void BMMultiLevelBiquad_init4(BMMultiLevelBiquad* This,
                               bool smoothUpdate);
 
 
+/*!
+ *BMMultiLevelBiquad_initMultiChannel
+ * @Abstract init a filter with any number of channels. Filters with 8 or 16 channels are processed most efficiently. The filter design functions set the same coefficients on all channels. To set them separately, use BMMultiLevelBiquad_setCoefficientZ.
+ *
+ * @param This           pointer to an initialized filter struct
+ * @param numLevels     the number of biquad filters in the cascade
+ * @param numChannels   number of audio channels
+ * @param sampleRate    audio sample rate
+ * @param smoothUpdate  when true, coefficient changes ramp over BMBQC_DEFAULT_RAMP_LENGTH samples
+ */
+void BMMultiLevelBiquad_initMultiChannel(BMMultiLevelBiquad* This,
+                                         size_t numLevels,
+                                         size_t numChannels,
+                                         float sampleRate,
+                                         bool smoothUpdate);
+
+
 /*!
  *BMMultiLevelBiquad_free
  *
@@ -334,6 +450,16 @@ void BMMultiLevelBiquad_setLinkwitzRileyLP4thOrder(BMMultiLevelBiquad* This, dou
 void BMMultiLevelBiquad_setLinkwitzRileyHP4thOrder(BMMultiLevelBiquad* This, double fc, size_t firstLevel);
 
 
+/*!
+ *BMMultiLevelBiquad_setKWeighting
+ *
+ * @abstract the K-weighting filter from ITU-R BS.1770-4: a high shelf of about +4 dB above 1.5 kHz followed by a highpass at 38 Hz. The coefficients are computed for the sample rate of the filter. This filter requires two consecutive levels.
+ *
+ * @param firstLevel  the first of two levels to use
+ */
+void BMMultiLevelBiquad_setKWeighting(BMMultiLevelBiquad* This, size_t firstLevel);
+
+
 // c1, c2 are coefficients for a pair of first order allpass filters in series
 void BMMultilevelBiquad_setAllpass2ndOrder(BMMultiLevelBiquad* This, double c1, double c2, size_t level);
 
@@ -360,6 +486,36 @@ void BMMultiLevelBiquad_setBypass(BMMultiLevelBiquad* This, size_t level);
 void BMMultiLevelBiquad_setGain(BMMultiLevelBiquad* This, float gain_db);
 
 void BMMultiLevelBiquad_setGainInstant(BMMultiLevelBiquad *This, float gain_db);
+
+
+/*!
+ *BMMultiLevelBiquad_pushParameterEvent
+ *
+ * @abstract schedule a setting change from a control thread while the audio thread is processing
+ *
+ * @discussion The setters above change the filter immediately, so they are only safe to call from the audio thread or while it is stopped. This queues the change without locking instead. The processing functions apply it on the sample given by event->sampleTime, splitting the buffer at that point. See BMParameterQueue.h for how timestamps work. Call this from one control thread only.
+ *
+ * @param This   pointer to an initialised struct
+ * @param event  event->parameter is one of enum BMMultiLevelBiquadParameter
+ * @returns false if too many events are waiting. The event is dropped in that case.
+ */
+bool BMMultiLevelBiquad_pushParameterEvent(BMMultiLevelBiquad* This, const BMParameterEvent *event);
+
+/*!
+ *BMMultiLevelBiquad_pushParameterSnapshot
+ *
+ * @abstract schedule several setting changes that take effect on the same sample, for example every level of an EQ curve
+ *
+ * @discussion The audio thread applies all of the events in the same buffer or none of them, so it never processes a filter with some levels updated and others not. See BMParameterQueue_pushSnapshot. Call this from one control thread only.
+ *
+ * @param This        pointer to an initialised struct
+ * @param events      the parameter of each event is one of enum BMMultiLevelBiquadParameter. Their sampleTime is ignored.
+ * @param numEvents   number of events
+ * @param sampleTime  the sample on which the changes take effect
+ * @returns false if there isn't room for all the events. None of them are queued in that case.
+ */
+bool BMMultiLevelBiquad_pushParameterSnapshot(BMMultiLevelBiquad* This, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime);
+
 /*!
  * BMMultiLevelBiquad_tfMagVector
  *
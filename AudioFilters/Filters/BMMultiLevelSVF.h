@@ -10,7 +10,11 @@
 #define BMMultiLevelSVF_h
 
 #include <stdio.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 typedef struct BMMultiLevelSVF{
     float** a;
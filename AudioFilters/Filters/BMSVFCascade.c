@@ -0,0 +1,378 @@
+//
+//  BMSVFCascade.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMSVFCascade.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMSVFC_NUM_STATES 2
+
+// keeps g finite for sections with a pole at z = 1 or z = -1, which are
+// on the edge of stability
+#define BMSVFC_MIN_DENOMINATOR 1.0e-12
+
+
+
+
+static size_t BMSVFCascade_numParams(const BMSVFCascade *This){
+	return This->numLevels * This->numChannels * BMSVFC_NUM_PARAMS;
+}
+
+
+
+
+/*
+ * Convert the biquad
+ *
+ *     H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+ *
+ * to a trapezoidal state variable filter with output
+ *
+ *     y = m0 v0 + m1 v1 + m2 v2,
+ *
+ * where v0 is the input, v1 the bandpass and v2 the lowpass output. The
+ * denominator of the state variable filter, normalised by 1 + g k + g^2, is
+ *
+ *     1 + 2(g^2 - 1)/(1 + g k + g^2) z^-1 + (1 - g k + g^2)/(1 + g k + g^2) z^-2.
+ *
+ * Evaluating both denominators at z = 1 and z = -1 gives g and k. Doing the
+ * same with the numerators, where the bandpass and lowpass terms vanish at
+ * one or the other, gives the mix coefficients.
+ */
+static void BMSVFCascade_biquadToSVF(const double *biquad, float *svf){
+	double b0 = biquad[0], b1 = biquad[1], b2 = biquad[2];
+	double a1 = biquad[3], a2 = biquad[4];
+
+	// both of these are positive for every stable filter
+	double p = BM_MAX(1.0 + a1 + a2, BMSVFC_MIN_DENOMINATOR);
+	double q = BM_MAX(1.0 - a1 + a2, BMSVFC_MIN_DENOMINATOR);
+
+	double g = sqrt(p / q);
+	double k = 2.0 * (1.0 - a2) / (g * q);
+
+	double m0 = (b0 - b1 + b2) / q;
+	double m2 = (b0 + b1 + b2) / p - m0;
+	double m1 = (2.0 * (b0 - b2) / q - g * k * m0) / g;
+
+	svf[0] = g;
+	svf[1] = k;
+	svf[2] = m0;
+	svf[3] = m1;
+	svf[4] = m2;
+}
+
+
+
+
+static void BMSVFCascade_convert(BMSVFCascade *This, const double *coefficients, float *params){
+	size_t numSections = This->numLevels * This->numChannels;
+	for(size_t i=0; i<numSections; i++)
+		BMSVFCascade_biquadToSVF(coefficients + i*5, params + i*BMSVFC_NUM_PARAMS);
+}
+
+
+
+
+void BMSVFCascade_init(BMSVFCascade *This, size_t numLevels, size_t numChannels){
+	assert(numLevels > 0 && numChannels > 0);
+
+	This->numLevels = numLevels;
+	This->numChannels = numChannels;
+
+	size_t numParams = BMSVFCascade_numParams(This);
+	This->params = malloc(sizeof(float) * numParams);
+	This->paramIncrements = calloc(numParams, sizeof(float));
+	This->breakpointParams = malloc(sizeof(float) * numParams * BMSVFC_MAX_BREAKPOINTS);
+	This->state = calloc(numLevels * numChannels * BMSVFC_NUM_STATES, sizeof(float));
+
+	This->activeLevels = malloc(sizeof(bool) * numLevels);
+	for(size_t i=0; i<numLevels; i++)
+		This->activeLevels[i] = true;
+
+	This->firstBreakpoint = This->numBreakpoints = 0;
+	This->time = 0;
+	This->rampEndTime = 0;
+	This->ramping = false;
+
+	// start with all levels on bypass
+	double bypass [5] = {1.0, 0.0, 0.0, 0.0, 0.0};
+	for(size_t i=0; i<numLevels*numChannels; i++)
+		BMSVFCascade_biquadToSVF(bypass, This->params + i*BMSVFC_NUM_PARAMS);
+}
+
+
+
+
+void BMSVFCascade_free(BMSVFCascade *This){
+	free(This->params);
+	This->params = NULL;
+	free(This->paramIncrements);
+	This->paramIncrements = NULL;
+	free(This->breakpointParams);
+	This->breakpointParams = NULL;
+	free(This->state);
+	This->state = NULL;
+	free(This->activeLevels);
+	This->activeLevels = NULL;
+}
+
+
+
+
+static void BMSVFCascade_clearBreakpoints(BMSVFCascade *This){
+	This->firstBreakpoint = This->numBreakpoints = 0;
+	This->ramping = false;
+}
+
+
+
+
+void BMSVFCascade_setCoefficients(BMSVFCascade *This, const double *coefficients){
+	BMSVFCascade_clearBreakpoints(This);
+	BMSVFCascade_convert(This, coefficients, This->params);
+}
+
+
+
+
+bool BMSVFCascade_addBreakpoint(BMSVFCascade *This, const double *coefficients, size_t sampleOffset){
+	if(This->numBreakpoints == BMSVFC_MAX_BREAKPOINTS)
+		return false;
+
+	uint64_t time = This->time + sampleOffset;
+
+	// keep the breakpoints in order
+	if(This->numBreakpoints > 0){
+		size_t last = (This->firstBreakpoint + This->numBreakpoints - 1) % BMSVFC_MAX_BREAKPOINTS;
+		time = BM_MAX(time, This->breakpointTimes[last]);
+	}
+
+	size_t i = (This->firstBreakpoint + This->numBreakpoints) % BMSVFC_MAX_BREAKPOINTS;
+	This->breakpointTimes[i] = time;
+	BMSVFCascade_convert(This, coefficients, This->breakpointParams + i*BMSVFCascade_numParams(This));
+	This->numBreakpoints++;
+
+	return true;
+}
+
+
+
+
+void BMSVFCascade_setTargets(BMSVFCascade *This, const double *coefficients, size_t rampLength){
+	BMSVFCascade_clearBreakpoints(This);
+	BMSVFCascade_addBreakpoint(This, coefficients, rampLength);
+}
+
+
+
+
+void BMSVFCascade_setActiveLevels(BMSVFCascade *This, const bool *activeLevels){
+	memcpy(This->activeLevels, activeLevels, sizeof(bool) * This->numLevels);
+}
+
+
+
+
+void BMSVFCascade_clearState(BMSVFCascade *This){
+	memset(This->state, 0, sizeof(float) * This->numLevels * This->numChannels * BMSVFC_NUM_STATES);
+}
+
+
+
+
+/*
+ * Skip breakpoints that are already due and start a ramp to the first one
+ * that isn't, if there is one.
+ */
+static void BMSVFCascade_startRamp(BMSVFCascade *This){
+	size_t numParams = BMSVFCascade_numParams(This);
+
+	while(This->numBreakpoints > 0){
+		size_t i = This->firstBreakpoint;
+		const float *target = This->breakpointParams + i*numParams;
+
+		// jump to breakpoints that are due now
+		if(This->breakpointTimes[i] <= This->time){
+			memcpy(This->params, target, sizeof(float) * numParams);
+			This->firstBreakpoint = (i + 1) % BMSVFC_MAX_BREAKPOINTS;
+			This->numBreakpoints--;
+			continue;
+		}
+
+		// ramp to the first breakpoint in the future
+		float rampLength = (float)(This->breakpointTimes[i] - This->time);
+		for(size_t j=0; j<numParams; j++)
+			This->paramIncrements[j] = (target[j] - This->params[j]) / rampLength;
+		This->rampEndTime = This->breakpointTimes[i];
+		This->ramping = true;
+		return;
+	}
+}
+
+
+
+
+/*
+ * Copy the breakpoint that ends the current ramp to the parameters, so
+ * that rounding errors in the ramp don't accumulate.
+ */
+static void BMSVFCascade_finishRamp(BMSVFCascade *This){
+	size_t numParams = BMSVFCascade_numParams(This);
+	size_t i = This->firstBreakpoint;
+	memcpy(This->params, This->breakpointParams + i*numParams, sizeof(float) * numParams);
+	This->firstBreakpoint = (i + 1) % BMSVFC_MAX_BREAKPOINTS;
+	This->numBreakpoints--;
+	This->ramping = false;
+}
+
+
+
+
+static void BMSVFCascade_processSection(float *state,
+										const float *params,
+										const float *input,
+										float *output,
+										size_t numSamples){
+	float g = params[0], k = params[1];
+	float m0 = params[2], m1 = params[3], m2 = params[4];
+	float a1 = 1.0f / (1.0f + g*(g + k));
+	float a2 = g*a1;
+	float a3 = g*a2;
+	float ic1eq = state[0], ic2eq = state[1];
+
+	for(size_t i=0; i<numSamples; i++){
+		float v0 = input[i];
+		float v3 = v0 - ic2eq;
+		float v1 = a1*ic1eq + a2*v3;
+		float v2 = ic2eq + a2*ic1eq + a3*v3;
+		ic1eq = 2.0f*v1 - ic1eq;
+		ic2eq = 2.0f*v2 - ic2eq;
+		output[i] = m0*v0 + m1*v1 + m2*v2;
+	}
+
+	state[0] = ic1eq;
+	state[1] = ic2eq;
+}
+
+
+
+
+// the same as BMSVFCascade_processSection, with the parameters moving by
+// one increment before each sample
+static void BMSVFCascade_processSectionRamp(float *state,
+											float *params,
+											const float *increments,
+											const float *input,
+											float *output,
+											size_t numSamples){
+	float g = params[0], k = params[1];
+	float m0 = params[2], m1 = params[3], m2 = params[4];
+	float dg = increments[0], dk = increments[1];
+	float dm0 = increments[2], dm1 = increments[3], dm2 = increments[4];
+	float ic1eq = state[0], ic2eq = state[1];
+
+	for(size_t i=0; i<numSamples; i++){
+		g += dg;
+		k += dk;
+		m0 += dm0;
+		m1 += dm1;
+		m2 += dm2;
+
+		float a1 = 1.0f / (1.0f + g*(g + k));
+		float a2 = g*a1;
+		float a3 = g*a2;
+
+		float v0 = input[i];
+		float v3 = v0 - ic2eq;
+		float v1 = a1*ic1eq + a2*v3;
+		float v2 = ic2eq + a2*ic1eq + a3*v3;
+		ic1eq = 2.0f*v1 - ic1eq;
+		ic2eq = 2.0f*v2 - ic2eq;
+		output[i] = m0*v0 + m1*v1 + m2*v2;
+	}
+
+	params[0] = g;
+	params[1] = k;
+	params[2] = m0;
+	params[3] = m1;
+	params[4] = m2;
+	state[0] = ic1eq;
+	state[1] = ic2eq;
+}
+
+
+
+
+void BMSVFCascade_process(BMSVFCascade *This,
+						  const float * const *inputs,
+						  float * const *outputs,
+						  size_t numSamples){
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		if(!This->ramping && This->numBreakpoints > 0)
+			BMSVFCascade_startRamp(This);
+
+		// process up to the end of the ramp or the end of the buffer
+		size_t samplesProcessing = numSamples - samplesProcessed;
+		if(This->ramping)
+			samplesProcessing = (size_t)BM_MIN((uint64_t)samplesProcessing, This->rampEndTime - This->time);
+
+		for(size_t c=0; c<This->numChannels; c++){
+			const float *input = inputs[c] + samplesProcessed;
+			float *output = outputs[c] + samplesProcessed;
+
+			// the first active level reads the input and the rest work in place
+			const float *levelInput = input;
+
+			for(size_t level=0; level<This->numLevels; level++){
+				size_t section = level*This->numChannels + c;
+				float *state = This->state + section*BMSVFC_NUM_STATES;
+				float *params = This->params + section*BMSVFC_NUM_PARAMS;
+				const float *increments = This->paramIncrements + section*BMSVFC_NUM_PARAMS;
+
+				if(!This->activeLevels[level]){
+					// keep inactive levels on the automation curve so they
+					// don't jump if they are switched back on mid-ramp
+					if(This->ramping)
+						for(size_t j=0; j<BMSVFC_NUM_PARAMS; j++)
+							params[j] += increments[j] * (float)samplesProcessing;
+					continue;
+				}
+
+				if(This->ramping)
+					BMSVFCascade_processSectionRamp(state, params, increments,
+													levelInput, output, samplesProcessing);
+				else
+					BMSVFCascade_processSection(state, params, levelInput, output, samplesProcessing);
+				levelInput = output;
+			}
+
+			// every level is inactive
+			if(levelInput != output)
+				memmove(output, levelInput, sizeof(float) * samplesProcessing);
+		}
+
+		This->time += samplesProcessing;
+		samplesProcessed += samplesProcessing;
+
+		if(This->ramping && This->time == This->rampEndTime)
+			BMSVFCascade_finishRamp(This);
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
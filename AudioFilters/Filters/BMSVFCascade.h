@@ -0,0 +1,164 @@
+//
+//  BMSVFCascade.h
+//  AudioFiltersXcodeProject
+//
+//  A multichannel cascade of trapezoidal state variable filters that takes
+//  biquad coefficients and can move them along an automation curve with
+//  per-sample interpolation.
+//
+//  Any stable biquad section can be written as a state variable filter
+//  with cutoff parameter g > 0, damping k > 0 and output mix m0, m1, m2
+//  (see BMMultiLevelSVF.c for the processing equations). We convert each
+//  section to that form and interpolate g, k and the mix linearly. Every
+//  point on a line between two sets with g > 0 and k > 0 also has g > 0
+//  and k > 0, so the filter is stable at every sample of the ramp. The
+//  state variable structure also stays stable when those parameters change
+//  quickly, which the direct form biquad does not. Interpolating biquad
+//  coefficients directly can pass through unstable filters and blow up
+//  on fast sweeps.
+//
+//  Automation is a list of breakpoints. Each breakpoint is a full set of
+//  coefficients and the sample on which the filter should reach them. The
+//  filter ramps from its current setting to the first breakpoint, then from
+//  there to the next, and holds the last one.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMSVFCascade_h
+#define BMSVFCascade_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// maximum number of breakpoints waiting at one time
+#define BMSVFC_MAX_BREAKPOINTS 32
+
+// parameters per section: g, k, m0, m1, m2
+#define BMSVFC_NUM_PARAMS 5
+
+typedef struct BMSVFCascade {
+	// [level][channel][g, k, m0, m1, m2]
+	float *params;
+	float *paramIncrements;
+
+	// [level][channel][ic1eq, ic2eq]
+	float *state;
+
+	// ring buffer of breakpoints. Parameters are stored in the same layout
+	// as params, one set per breakpoint.
+	float *breakpointParams;
+	uint64_t breakpointTimes [BMSVFC_MAX_BREAKPOINTS];
+	size_t firstBreakpoint, numBreakpoints;
+
+	// samples processed since init
+	uint64_t time;
+
+	// the time at which the current ramp reaches the first breakpoint
+	uint64_t rampEndTime;
+	bool ramping;
+
+	bool *activeLevels;
+	size_t numLevels, numChannels;
+} BMSVFCascade;
+
+
+
+/*!
+ *BMSVFCascade_init
+ *
+ * @abstract allocates memory and sets all levels to bypass
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param numLevels   number of filter sections in series
+ * @param numChannels number of audio channels
+ */
+void BMSVFCascade_init(BMSVFCascade *This, size_t numLevels, size_t numChannels);
+
+
+/*!
+ *BMSVFCascade_free
+ */
+void BMSVFCascade_free(BMSVFCascade *This);
+
+
+/*!
+ *BMSVFCascade_setCoefficients
+ *
+ * @abstract change the filter immediately and cancel any automation that hasn't finished
+ *
+ * @param This          pointer to an initialised struct
+ * @param coefficients  array of length 5 * numLevels * numChannels, in the same order as vDSP_biquadm: [level][channel][b0,b1,b2,a1,a2]
+ */
+void BMSVFCascade_setCoefficients(BMSVFCascade *This, const double *coefficients);
+
+
+/*!
+ *BMSVFCascade_setTargets
+ *
+ * @abstract cancel any automation that hasn't finished and ramp from the current setting to coefficients over rampLength samples
+ *
+ * @param This          pointer to an initialised struct
+ * @param coefficients  array in the same format as BMSVFCascade_setCoefficients
+ * @param rampLength    length of the ramp in samples. 0 changes the filter immediately.
+ */
+void BMSVFCascade_setTargets(BMSVFCascade *This, const double *coefficients, size_t rampLength);
+
+
+/*!
+ *BMSVFCascade_addBreakpoint
+ *
+ * @abstract add a point to the end of the automation curve
+ *
+ * @param This          pointer to an initialised struct
+ * @param coefficients  array in the same format as BMSVFCascade_setCoefficients
+ * @param sampleOffset  the filter reaches coefficients this many samples after the start of the next call to BMSVFCascade_process. Offsets may extend beyond the end of that buffer. An offset earlier than that of the previous breakpoint is moved up to it.
+ *
+ * @returns false if BMSVFC_MAX_BREAKPOINTS breakpoints are already waiting. The breakpoint is not added in that case.
+ */
+bool BMSVFCascade_addBreakpoint(BMSVFCascade *This, const double *coefficients, size_t sampleOffset);
+
+
+/*!
+ *BMSVFCascade_setActiveLevels
+ *
+ * @abstract inactive levels are skipped when processing. Their parameters still follow the automation.
+ *
+ * @param activeLevels array of length numLevels
+ */
+void BMSVFCascade_setActiveLevels(BMSVFCascade *This, const bool *activeLevels);
+
+
+/*!
+ *BMSVFCascade_clearState
+ *
+ * @abstract set the filter memory to zero
+ */
+void BMSVFCascade_clearState(BMSVFCascade *This);
+
+
+/*!
+ *BMSVFCascade_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of numChannels input buffers of length numSamples
+ * @param outputs     array of numChannels output buffers of length numSamples. (in-place processing is supported)
+ * @param numSamples  number of samples to process in each channel
+ */
+void BMSVFCascade_process(BMSVFCascade *This,
+						  const float * const *inputs,
+						  float * const *outputs,
+						  size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMSVFCascade_h */
@@ -8,7 +8,11 @@
 //
 
 #include "BMSlidingWindowSum.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 
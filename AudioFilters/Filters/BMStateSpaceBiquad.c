@@ -0,0 +1,289 @@
+//
+//  BMStateSpaceBiquad.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMStateSpaceBiquad.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+
+// one vector holds one block of samples
+typedef float BMSSBVec __attribute__((vector_size(sizeof(float)*BMSSB_BLOCK_SIZE),aligned(4),__may_alias__));
+
+// one vector holds the two state variables
+typedef float BMSSBVec2 __attribute__((vector_size(sizeof(float)*2),aligned(4),__may_alias__));
+
+#define BMSSB_INLINE static inline __attribute__((always_inline))
+
+#define BMSSB_H_SIZE (BMSSB_BLOCK_SIZE*BMSSB_BLOCK_SIZE)
+#define BMSSB_O_SIZE (2*BMSSB_BLOCK_SIZE)
+#define BMSSB_K_SIZE (2*BMSSB_BLOCK_SIZE)
+
+
+
+
+BMSSB_INLINE BMSSBVec BMSSBVec_load(const float *p){
+	return *(const BMSSBVec *)p;
+}
+
+BMSSB_INLINE void BMSSBVec_store(float *p, BMSSBVec v){
+	*(BMSSBVec *)p = v;
+}
+
+BMSSB_INLINE BMSSBVec2 BMSSBVec2_load(const float *p){
+	return *(const BMSSBVec2 *)p;
+}
+
+
+
+
+void BMStateSpaceBiquad_init(BMStateSpaceBiquad *This, size_t numLevels){
+	assert(numLevels > 0);
+
+	This->numLevels = numLevels;
+	This->H = malloc(sizeof(float) * numLevels * BMSSB_H_SIZE);
+	This->O = malloc(sizeof(float) * numLevels * BMSSB_O_SIZE);
+	This->K = malloc(sizeof(float) * numLevels * BMSSB_K_SIZE);
+	This->AN = malloc(sizeof(float) * numLevels * 4);
+	This->coefficients = malloc(sizeof(float) * numLevels * 5);
+	This->state = malloc(sizeof(float) * numLevels * 2);
+	This->activeLevels = malloc(sizeof(bool) * numLevels);
+
+	// start with all levels on bypass
+	double *bypass = malloc(sizeof(double) * numLevels * 5);
+	for(size_t level=0; level<numLevels; level++){
+		bypass[level*5 + 0] = 1.0;
+		bypass[level*5 + 1] = bypass[level*5 + 2] = bypass[level*5 + 3] = bypass[level*5 + 4] = 0.0;
+		This->activeLevels[level] = true;
+	}
+	BMStateSpaceBiquad_setCoefficients(This, bypass);
+	free(bypass);
+
+	BMStateSpaceBiquad_clearState(This);
+}
+
+
+
+
+void BMStateSpaceBiquad_free(BMStateSpaceBiquad *This){
+	free(This->H);
+	This->H = NULL;
+	free(This->O);
+	This->O = NULL;
+	free(This->K);
+	This->K = NULL;
+	free(This->AN);
+	This->AN = NULL;
+	free(This->coefficients);
+	This->coefficients = NULL;
+	free(This->state);
+	This->state = NULL;
+	free(This->activeLevels);
+	This->activeLevels = NULL;
+}
+
+
+
+
+void BMStateSpaceBiquad_clearState(BMStateSpaceBiquad *This){
+	memset(This->state, 0, sizeof(float) * This->numLevels * 2);
+}
+
+
+
+
+void BMStateSpaceBiquad_setActiveLevels(BMStateSpaceBiquad *This, const bool *activeLevels){
+	memcpy(This->activeLevels, activeLevels, sizeof(bool) * This->numLevels);
+}
+
+
+
+
+void BMStateSpaceBiquad_setCoefficients(BMStateSpaceBiquad *This, const double *coefficients){
+	for(size_t level=0; level<This->numLevels; level++){
+		const double *c = coefficients + level*5;
+		double b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+		for(size_t j=0; j<5; j++)
+			This->coefficients[level*5 + j] = (float)c[j];
+
+		// state space form of the transposed direct form II biquad:
+		//
+		//   y = s1 + b0 x
+		//   s1' = -a1 s1 + s2 + (b1 - a1 b0) x
+		//   s2' = -a2 s1      + (b2 - a2 b0) x
+		double A [2][2] = {{-a1, 1.0}, {-a2, 0.0}};
+		double B [2] = {b1 - a1*b0, b2 - a2*b0};
+
+		// impulse response: h[0] = D, h[n] = C A^(n-1) B. Since C = [1 0]
+		// we only need the first element of A^(n-1) B.
+		double h [BMSSB_BLOCK_SIZE];
+		h[0] = b0;
+		double v [2] = {B[0], B[1]};
+		for(size_t n=1; n<BMSSB_BLOCK_SIZE; n++){
+			h[n] = v[0];
+			double v0 = A[0][0]*v[0] + A[0][1]*v[1];
+			double v1 = A[1][0]*v[0] + A[1][1]*v[1];
+			v[0] = v0; v[1] = v1;
+		}
+
+		// H[k][n] = h[n-k] for n >= k
+		float *H = This->H + level*BMSSB_H_SIZE;
+		for(size_t k=0; k<BMSSB_BLOCK_SIZE; k++)
+			for(size_t n=0; n<BMSSB_BLOCK_SIZE; n++)
+				H[k*BMSSB_BLOCK_SIZE + n] = n >= k ? (float)h[n-k] : 0.0f;
+
+		// O[j][n] = (C A^n)[j]. Propagate the row vector C A^n.
+		float *O = This->O + level*BMSSB_O_SIZE;
+		double r [2] = {1.0, 0.0};
+		for(size_t n=0; n<BMSSB_BLOCK_SIZE; n++){
+			O[0*BMSSB_BLOCK_SIZE + n] = (float)r[0];
+			O[1*BMSSB_BLOCK_SIZE + n] = (float)r[1];
+			double r0 = r[0]*A[0][0] + r[1]*A[1][0];
+			double r1 = r[0]*A[0][1] + r[1]*A[1][1];
+			r[0] = r0; r[1] = r1;
+		}
+
+		// K[j][k] = (A^(N-1-k) B)[j] and A^N. Propagate from k = N-1 down.
+		float *K = This->K + level*BMSSB_K_SIZE;
+		double AP [2][2] = {{1.0, 0.0}, {0.0, 1.0}};
+		for(size_t i=0; i<BMSSB_BLOCK_SIZE; i++){
+			size_t k = BMSSB_BLOCK_SIZE - 1 - i;
+			K[k*2 + 0] = (float)(AP[0][0]*B[0] + AP[0][1]*B[1]);
+			K[k*2 + 1] = (float)(AP[1][0]*B[0] + AP[1][1]*B[1]);
+			double P [2][2];
+			for(size_t row=0; row<2; row++)
+				for(size_t col=0; col<2; col++)
+					P[row][col] = A[row][0]*AP[0][col] + A[row][1]*AP[1][col];
+			memcpy(AP, P, sizeof(P));
+		}
+		// store A^N by columns so that A^N s is a sum of two column vectors
+		float *AN = This->AN + level*4;
+		AN[0] = (float)AP[0][0]; AN[1] = (float)AP[1][0];
+		AN[2] = (float)AP[0][1]; AN[3] = (float)AP[1][1];
+	}
+}
+
+
+
+
+/*!
+ *BMStateSpaceBiquad_processBlocks
+ *
+ * @abstract process numBlocks blocks of BMSSB_BLOCK_SIZE samples through all active levels
+ *
+ * @discussion We process one level at a time over the whole buffer. That way the only dependency between blocks is the 2x2 state update, so the processor can work on several blocks at once.
+ */
+BM_SIMD_DISPATCH
+static void BMStateSpaceBiquad_processBlocks(BMStateSpaceBiquad *This, const float *input, float *output, size_t numBlocks){
+	if(input != output)
+		memcpy(output, input, sizeof(float) * numBlocks * BMSSB_BLOCK_SIZE);
+
+	for(size_t level=0; level<This->numLevels; level++){
+		if(!This->activeLevels[level]) continue;
+
+		const float *H = This->H + level*BMSSB_H_SIZE;
+		const float *O = This->O + level*BMSSB_O_SIZE;
+		const float *K = This->K + level*BMSSB_K_SIZE;
+		const float *AN = This->AN + level*4;
+		float s0 = This->state[level*2];
+		float s1 = This->state[level*2 + 1];
+
+		for(size_t b=0; b<numBlocks; b++){
+			BMSSBVec x = BMSSBVec_load(output + b*BMSSB_BLOCK_SIZE);
+
+			// y = O s + H x, as a sum of the columns of O and H scaled by
+			// elements of s and x. We use two accumulators to shorten the
+			// chain of dependent additions.
+			BMSSBVec y0 = s0*BMSSBVec_load(O);
+			BMSSBVec y1 = s1*BMSSBVec_load(O + BMSSB_BLOCK_SIZE);
+			for(size_t k=0; k<BMSSB_BLOCK_SIZE; k+=2){
+				y0 += x[k] * BMSSBVec_load(H + k*BMSSB_BLOCK_SIZE);
+				y1 += x[k+1] * BMSSBVec_load(H + (k+1)*BMSSB_BLOCK_SIZE);
+			}
+
+			// s' = A^N s + K x. K x doesn't depend on the state so we
+			// compute it first and add A^N s at the end.
+			BMSSBVec2 Kx0 = x[0] * BMSSBVec2_load(K);
+			BMSSBVec2 Kx1 = x[1] * BMSSBVec2_load(K + 2);
+			for(size_t k=2; k<BMSSB_BLOCK_SIZE; k+=2){
+				Kx0 += x[k] * BMSSBVec2_load(K + k*2);
+				Kx1 += x[k+1] * BMSSBVec2_load(K + (k+1)*2);
+			}
+			BMSSBVec2 sNext = (Kx0 + Kx1) + s0*BMSSBVec2_load(AN) + s1*BMSSBVec2_load(AN + 2);
+			s0 = sNext[0];
+			s1 = sNext[1];
+
+			BMSSBVec_store(output + b*BMSSB_BLOCK_SIZE, y0 + y1);
+		}
+
+		This->state[level*2] = s0;
+		This->state[level*2 + 1] = s1;
+	}
+}
+
+
+
+
+/*!
+ *BMStateSpaceBiquad_processSerial
+ *
+ * @abstract process sample by sample with the usual TDF2 recurrence. This uses the same state variables as the block processing.
+ */
+static void BMStateSpaceBiquad_processSerial(BMStateSpaceBiquad *This, const float *input, float *output, size_t numSamples){
+	if(input != output)
+		memcpy(output, input, sizeof(float) * numSamples);
+
+	for(size_t level=0; level<This->numLevels; level++){
+		if(!This->activeLevels[level]) continue;
+
+		const float *c = This->coefficients + level*5;
+		float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+		float s1 = This->state[level*2];
+		float s2 = This->state[level*2 + 1];
+		for(size_t i=0; i<numSamples; i++){
+			float x = output[i];
+			float y = b0*x + s1;
+			s1 = b1*x - a1*y + s2;
+			s2 = b2*x - a2*y;
+			output[i] = y;
+		}
+		This->state[level*2] = s1;
+		This->state[level*2 + 1] = s2;
+	}
+}
+
+
+
+
+void BMStateSpaceBiquad_process(BMStateSpaceBiquad *This, const float *input, float *output, size_t numSamples){
+	size_t numBlocks = numSamples / BMSSB_BLOCK_SIZE;
+	size_t blockSamples = numBlocks * BMSSB_BLOCK_SIZE;
+
+	BMStateSpaceBiquad_processBlocks(This, input, output, numBlocks);
+
+	// process the remaining samples one at a time
+	if(blockSamples < numSamples)
+		BMStateSpaceBiquad_processSerial(This, input + blockSamples, output + blockSamples, numSamples - blockSamples);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,125 @@
+//
+//  BMStateSpaceBiquad.h
+//  AudioFiltersXcodeProject
+//
+//  A single channel cascade of biquad filters that processes
+//  BMSSB_BLOCK_SIZE samples per step.
+//
+//  A biquad filter in transposed direct form II has a state vector s of
+//  length 2. Writing the filter in state space form,
+//
+//      y[n] = C s[n] + D x[n]
+//      s[n+1] = A s[n] + B x[n],
+//
+//  we can compute a whole block of N outputs from the state at the start of
+//  the block and the N inputs,
+//
+//      y = O s + H x
+//      s' = A^N s + K x,
+//
+//  where H is the lower triangular matrix of impulse response samples, O is
+//  the response of the output to the initial state, and K is the response
+//  of the state to the inputs. The outputs within a block no longer depend
+//  on each other so they can be computed with SIMD instructions. Only the
+//  2x2 state update is serial, once per block instead of once per sample.
+//
+//  This uses more arithmetic per sample than the serial recurrence but it
+//  runs faster on processors with wide vector units. It is most useful for
+//  high order mono filters, such as BMMultiLevelBiquad_setHighOrderBWLP and
+//  BMMultiLevelBiquad_setLegendreLP, in offline rendering.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMStateSpaceBiquad_h
+#define BMStateSpaceBiquad_h
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of samples computed in each step
+#define BMSSB_BLOCK_SIZE 8
+
+typedef struct BMStateSpaceBiquad {
+	// block matrices for each level. See the comment at the top of the file.
+	float *H; // [level][input sample k][output sample n]
+	float *O; // [level][state variable][output sample n]
+	float *K; // [level][input sample k][state variable]
+	float *AN; // [level][column][row] of A^N
+
+	// biquad coefficients for each level, [level][b0,b1,b2,a1,a2], used
+	// to process the samples at the end of a buffer that don't fill a block
+	float *coefficients;
+
+	// [level][s1,s2]
+	float *state;
+
+	bool *activeLevels;
+	size_t numLevels;
+} BMStateSpaceBiquad;
+
+
+
+/*!
+ *BMStateSpaceBiquad_init
+ *
+ * @abstract allocate memory and set all levels to bypass
+ *
+ * @param This       pointer to an uninitialised struct
+ * @param numLevels  number of biquad filters in series
+ */
+void BMStateSpaceBiquad_init(BMStateSpaceBiquad *This, size_t numLevels);
+
+
+/*!
+ *BMStateSpaceBiquad_free
+ */
+void BMStateSpaceBiquad_free(BMStateSpaceBiquad *This);
+
+
+/*!
+ *BMStateSpaceBiquad_setCoefficients
+ *
+ * @abstract compute the block matrices for new filter coefficients. This does not reset the filter state.
+ *
+ * @param This          pointer to an initialised struct
+ * @param coefficients  array of length 5*numLevels in the order [level][b0,b1,b2,a1,a2], the same as vDSP_biquad
+ */
+void BMStateSpaceBiquad_setCoefficients(BMStateSpaceBiquad *This, const double *coefficients);
+
+
+/*!
+ *BMStateSpaceBiquad_setActiveLevels
+ *
+ * @param activeLevels array of length numLevels. Inactive levels are skipped.
+ */
+void BMStateSpaceBiquad_setActiveLevels(BMStateSpaceBiquad *This, const bool *activeLevels);
+
+
+/*!
+ *BMStateSpaceBiquad_clearState
+ */
+void BMStateSpaceBiquad_clearState(BMStateSpaceBiquad *This);
+
+
+/*!
+ *BMStateSpaceBiquad_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param input       input array of length numSamples
+ * @param output      output array of length numSamples (in-place processing is supported)
+ * @param numSamples  number of samples to process
+ */
+void BMStateSpaceBiquad_process(BMStateSpaceBiquad *This, const float *input, float *output, size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMStateSpaceBiquad_h */
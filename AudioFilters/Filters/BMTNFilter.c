@@ -12,7 +12,11 @@
 //
 
 #include "BMTNFilter.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <stdlib.h>
 
 #ifdef __cplusplus
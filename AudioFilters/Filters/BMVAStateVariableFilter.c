@@ -11,7 +11,11 @@
 #include "DspUtilities.h"
 #include "Constants.h"
 #include <assert.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMVAStateVariableFilter_processBufferLPBPHP(BMVAStateVariableFilter *This,simd_float2* input,  const size_t numSamples);
 void BMVAStateVariableFilter_processBufferUBP(BMVAStateVariableFilter *This,simd_float2* input,  const size_t numSamples);
@@ -11,7 +11,11 @@ extern "C" {
 #endif
 
 #include "BMVariableFilter.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 //    void BMReleaseFilter_setCutoff(BMReleaseFilter *This, float fc){
 //        This->fc = fc;
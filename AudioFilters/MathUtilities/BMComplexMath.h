@@ -11,7 +11,11 @@
 #ifndef ComplexMath_h
 #define ComplexMath_h
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 #ifdef __cplusplus
@@ -0,0 +1,1672 @@
+//
+//  BMCrossPlatformVDSP.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef __APPLE__
+
+#include "BMCrossPlatformVDSP.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <float.h>
+#include "Constants.h"
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+
+// 256 bit vectors with relaxed alignment so that we can load and store at
+// arbitrary float addresses
+typedef float BMvFloat32_8 __attribute__((vector_size(32),aligned(4),__may_alias__));
+typedef int BMvSInt32_8 __attribute__((vector_size(32),aligned(4),__may_alias__));
+typedef unsigned BMvUInt32_8 __attribute__((vector_size(32),aligned(4),__may_alias__));
+
+#define BM_VDSP_VL 8
+
+// The vector helpers must be inlined into each dispatched version of the
+// kernels that call them so that they are compiled for the same target.
+#define BM_VDSP_INLINE static inline __attribute__((always_inline))
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_splat(float a){
+	BMvFloat32_8 v = {a,a,a,a,a,a,a,a};
+	return v;
+}
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_select(BMvSInt32_8 mask, BMvFloat32_8 a, BMvFloat32_8 b){
+	// mask lanes are -1 where true and 0 where false
+	BMvSInt32_8 r = (mask & (BMvSInt32_8)a) | (~mask & (BMvSInt32_8)b);
+	return (BMvFloat32_8)r;
+}
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_abs(BMvFloat32_8 a){
+	return (BMvFloat32_8)((BMvUInt32_8)a & 0x7FFFFFFF);
+}
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_max(BMvFloat32_8 a, BMvFloat32_8 b){
+	return BMv_select(a > b, a, b);
+}
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_min(BMvFloat32_8 a, BMvFloat32_8 b){
+	return BMv_select(a < b, a, b);
+}
+
+BM_VDSP_INLINE BMvFloat32_8 BMv_floor(BMvFloat32_8 a){
+	// valid for |a| < 2^31
+	BMvFloat32_8 t = __builtin_convertvector(__builtin_convertvector(a, BMvSInt32_8), BMvFloat32_8);
+	return BMv_select(t > a, t - 1.0f, t);
+}
+
+BM_VDSP_INLINE float BMv_hsum(BMvFloat32_8 a){
+	return (a[0] + a[4]) + (a[1] + a[5]) + (a[2] + a[6]) + (a[3] + a[7]);
+}
+
+
+
+
+/* arithmetic on vectors and scalars */
+
+BM_SIMD_DISPATCH
+void vDSP_vsmul(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	float b = *B;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) * b;
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] * b;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	float b = *B;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) + b;
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] + b;
+}
+
+
+
+void vDSP_vsaddi(const int *A, vDSP_Stride IA, const int *B, int *C, vDSP_Stride IC, vDSP_Length N){
+	int b = *B;
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = A[n*IA] + b;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_svdiv(const float *A, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	float a = *A;
+	vDSP_Length n = 0;
+	if(IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = a / *(const BMvFloat32_8 *)(B+n);
+	}
+	for(; n < N; n++) C[n*IC] = a / B[n*IB];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsmsa(const float *A, vDSP_Stride IA, const float *B, const float *C, float *D, vDSP_Stride ID, vDSP_Length N){
+	float b = *B, c = *C;
+	vDSP_Length n = 0;
+	if(IA == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = *(const BMvFloat32_8 *)(A+n) * b + c;
+	}
+	for(; n < N; n++) D[n*ID] = A[n*IA] * b + c;
+}
+
+
+
+
+/* arithmetic on pairs of vectors */
+
+BM_SIMD_DISPATCH
+void vDSP_vadd(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) + *(const BMvFloat32_8 *)(B+n);
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] + B[n*IB];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsub(const float *B, vDSP_Stride IB, const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) - *(const BMvFloat32_8 *)(B+n);
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] - B[n*IB];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmul(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) * *(const BMvFloat32_8 *)(B+n);
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] * B[n*IB];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vdiv(const float *B, vDSP_Stride IB, const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = *(const BMvFloat32_8 *)(A+n) / *(const BMvFloat32_8 *)(B+n);
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] / B[n*IB];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsma(const float *A, vDSP_Stride IA, const float *B, const float *C, vDSP_Stride IC, float *D, vDSP_Stride ID, vDSP_Length N){
+	float b = *B;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = *(const BMvFloat32_8 *)(A+n) * b + *(const BMvFloat32_8 *)(C+n);
+	}
+	for(; n < N; n++) D[n*ID] = A[n*IA] * b + C[n*IC];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsmsma(const float *A, vDSP_Stride IA, const float *B, const float *C, vDSP_Stride IC, const float *D, float *E, vDSP_Stride IE, vDSP_Length N){
+	float b = *B, d = *D;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1 && IE == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(E+n) = *(const BMvFloat32_8 *)(A+n) * b + *(const BMvFloat32_8 *)(C+n) * d;
+	}
+	for(; n < N; n++) E[n*IE] = A[n*IA] * b + C[n*IC] * d;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vma(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, vDSP_Stride IC, float *D, vDSP_Stride ID, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = *(const BMvFloat32_8 *)(A+n) * *(const BMvFloat32_8 *)(B+n) + *(const BMvFloat32_8 *)(C+n);
+	}
+	for(; n < N; n++) D[n*ID] = A[n*IA] * B[n*IB] + C[n*IC];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmsa(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N){
+	float c = *C;
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = *(const BMvFloat32_8 *)(A+n) * *(const BMvFloat32_8 *)(B+n) + c;
+	}
+	for(; n < N; n++) D[n*ID] = A[n*IA] * B[n*IB] + c;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmma(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, vDSP_Stride IC, const float *D, vDSP_Stride ID, float *E, vDSP_Stride IE, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1 && ID == 1 && IE == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(E+n) = *(const BMvFloat32_8 *)(A+n) * *(const BMvFloat32_8 *)(B+n)
+			                       + *(const BMvFloat32_8 *)(C+n) * *(const BMvFloat32_8 *)(D+n);
+	}
+	for(; n < N; n++) E[n*IE] = A[n*IA] * B[n*IB] + C[n*IC] * D[n*ID];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vasm(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N){
+	float c = *C;
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = (*(const BMvFloat32_8 *)(A+n) + *(const BMvFloat32_8 *)(B+n)) * c;
+	}
+	for(; n < N; n++) D[n*ID] = (A[n*IA] + B[n*IB]) * c;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsbsm(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N){
+	float c = *C;
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && ID == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = (*(const BMvFloat32_8 *)(A+n) - *(const BMvFloat32_8 *)(B+n)) * c;
+	}
+	for(; n < N; n++) D[n*ID] = (A[n*IA] - B[n*IB]) * c;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmax(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = BMv_max(*(const BMvFloat32_8 *)(A+n), *(const BMvFloat32_8 *)(B+n));
+	}
+	for(; n < N; n++){
+		float a = A[n*IA], b = B[n*IB];
+		C[n*IC] = a > b ? a : b;
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmin(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = BMv_min(*(const BMvFloat32_8 *)(A+n), *(const BMvFloat32_8 *)(B+n));
+	}
+	for(; n < N; n++){
+		float a = A[n*IA], b = B[n*IB];
+		C[n*IC] = a < b ? a : b;
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vmaxmg(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = BMv_max(BMv_abs(*(const BMvFloat32_8 *)(A+n)), BMv_abs(*(const BMvFloat32_8 *)(B+n)));
+	}
+	for(; n < N; n++){
+		float a = fabsf(A[n*IA]), b = fabsf(B[n*IB]);
+		C[n*IC] = a > b ? a : b;
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vminmg(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = BMv_min(BMv_abs(*(const BMvFloat32_8 *)(A+n)), BMv_abs(*(const BMvFloat32_8 *)(B+n)));
+	}
+	for(; n < N; n++){
+		float a = fabsf(A[n*IA]), b = fabsf(B[n*IB]);
+		C[n*IC] = a < b ? a : b;
+	}
+}
+
+
+
+void vDSP_vdist(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++){
+		float a = A[n*IA], b = B[n*IB];
+		C[n*IC] = sqrtf(a*a + b*b);
+	}
+}
+
+
+
+
+/* unary operations */
+
+BM_SIMD_DISPATCH
+void vDSP_vabs(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = BMv_abs(*(const BMvFloat32_8 *)(A+n));
+	}
+	for(; n < N; n++) C[n*IC] = fabsf(A[n*IA]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vneg(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = -*(const BMvFloat32_8 *)(A+n);
+	}
+	for(; n < N; n++) C[n*IC] = -A[n*IA];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vsq(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 a = *(const BMvFloat32_8 *)(A+n);
+			*(BMvFloat32_8 *)(C+n) = a * a;
+		}
+	}
+	for(; n < N; n++) C[n*IC] = A[n*IA] * A[n*IA];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vclip(const float *A, vDSP_Stride IA, const float *B, const float *C, float *D, vDSP_Stride ID, vDSP_Length N){
+	float lo = *B, hi = *C;
+	vDSP_Length n = 0;
+	if(IA == 1 && ID == 1){
+		BMvFloat32_8 lov = BMv_splat(lo), hiv = BMv_splat(hi);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(D+n) = BMv_min(BMv_max(*(const BMvFloat32_8 *)(A+n), lov), hiv);
+	}
+	for(; n < N; n++){
+		float a = A[n*IA];
+		a = a < lo ? lo : a;
+		D[n*ID] = a > hi ? hi : a;
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vthr(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	float b = *B;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		BMvFloat32_8 bv = BMv_splat(b);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 a = *(const BMvFloat32_8 *)(A+n);
+			*(BMvFloat32_8 *)(C+n) = BMv_select(a >= bv, a, bv);
+		}
+	}
+	for(; n < N; n++){
+		float a = A[n*IA];
+		C[n*IC] = a >= b ? a : b;
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vthres(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	float b = *B;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		BMvFloat32_8 bv = BMv_splat(b), zero = BMv_splat(0.0f);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 a = *(const BMvFloat32_8 *)(A+n);
+			*(BMvFloat32_8 *)(C+n) = BMv_select(a >= bv, a, zero);
+		}
+	}
+	for(; n < N; n++){
+		float a = A[n*IA];
+		C[n*IC] = a >= b ? a : 0.0f;
+	}
+}
+
+
+
+// forward declaration of the vector log2 kernel defined with vForce below
+BM_VDSP_INLINE BMvFloat32_8 BMv_log2(BMvFloat32_8 x);
+
+BM_SIMD_DISPATCH
+void vDSP_vdbcon(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N, unsigned int F){
+	// alpha * log10(a/b) = alpha * log10(2) * (log2(a) - log2(b))
+	float scale = (F ? 20.0f : 10.0f) * 0.30102999566398119521f;
+	float log2B = log2f(*B);
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = (BMv_log2(*(const BMvFloat32_8 *)(A+n)) - log2B) * scale;
+	}
+	for(; n < N; n++) C[n*IC] = (log2f(A[n*IA]) - log2B) * scale;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vpoly(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P){
+	vDSP_Length n = 0;
+	if(IB == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			// Horner's method
+			BMvFloat32_8 b = *(const BMvFloat32_8 *)(B+n);
+			BMvFloat32_8 y = BMv_splat(A[0]);
+			for(vDSP_Length p=1; p<=P; p++)
+				y = y * b + A[p*IA];
+			*(BMvFloat32_8 *)(C+n) = y;
+		}
+	}
+	for(; n < N; n++){
+		float b = B[n*IB];
+		float y = A[0];
+		for(vDSP_Length p=1; p<=P; p++)
+			y = y * b + A[p*IA];
+		C[n*IC] = y;
+	}
+}
+
+
+
+void vDSP_vrvrs(float *C, vDSP_Stride IC, vDSP_Length N){
+	if(N < 2) return;
+	vDSP_Length i = 0, j = N-1;
+	while(i < j){
+		float t = C[i*IC];
+		C[i*IC] = C[j*IC];
+		C[j*IC] = t;
+		i++; j--;
+	}
+}
+
+
+
+
+/* fill, ramp and generate */
+
+BM_SIMD_DISPATCH
+void vDSP_vfill(const float *A, float *C, vDSP_Stride IC, vDSP_Length N){
+	float a = *A;
+	vDSP_Length n = 0;
+	if(IC == 1){
+		BMvFloat32_8 av = BMv_splat(a);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(C+n) = av;
+	}
+	for(; n < N; n++) C[n*IC] = a;
+}
+
+
+
+void vDSP_vclr(float *C, vDSP_Stride IC, vDSP_Length N){
+	if(IC == 1){
+		memset(C, 0, sizeof(float)*N);
+		return;
+	}
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = 0.0f;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vramp(const float *A, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	// compute each element from its index rather than by accumulation so
+	// that rounding errors do not build up on long ramps
+	float a = *A, b = *B;
+	vDSP_Length n = 0;
+	if(IC == 1){
+		BMvFloat32_8 idx = {0,1,2,3,4,5,6,7};
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			*(BMvFloat32_8 *)(C+n) = a + (idx + (float)n) * b;
+		}
+	}
+	for(; n < N; n++) C[n*IC] = a + (float)n * b;
+}
+
+
+
+void vDSP_vgen(const float *A, const float *B, float *C, vDSP_Stride IC, vDSP_Length N){
+	if(N == 0) return;
+	if(N == 1){
+		C[0] = *A;
+		return;
+	}
+	float step = (*B - *A) / (float)(N-1);
+	vDSP_vramp(A, &step, C, IC, N);
+	// make sure the last element is exactly equal to *B
+	C[(N-1)*IC] = *B;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vrampmul(const float *I, vDSP_Stride IS, float *Start, const float *Step, float *O, vDSP_Stride OS, vDSP_Length N){
+	float start = *Start, step = *Step;
+	vDSP_Length n = 0;
+	if(IS == 1 && OS == 1){
+		BMvFloat32_8 idx = {0,1,2,3,4,5,6,7};
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvFloat32_8 *)(O+n) = *(const BMvFloat32_8 *)(I+n) * (start + (idx + (float)n) * step);
+	}
+	for(; n < N; n++) O[n*OS] = I[n*IS] * (start + (float)n * step);
+	*Start = start + (float)N * step;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vrampmul2(const float *I0, const float *I1, vDSP_Stride IS, float *Start, const float *Step, float *O0, float *O1, vDSP_Stride OS, vDSP_Length N){
+	float start = *Start, step = *Step;
+	vDSP_Length n = 0;
+	if(IS == 1 && OS == 1){
+		BMvFloat32_8 idx = {0,1,2,3,4,5,6,7};
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 g = start + (idx + (float)n) * step;
+			*(BMvFloat32_8 *)(O0+n) = *(const BMvFloat32_8 *)(I0+n) * g;
+			*(BMvFloat32_8 *)(O1+n) = *(const BMvFloat32_8 *)(I1+n) * g;
+		}
+	}
+	for(; n < N; n++){
+		float g = start + (float)n * step;
+		O0[n*OS] = I0[n*IS] * g;
+		O1[n*OS] = I1[n*IS] * g;
+	}
+	*Start = start + (float)N * step;
+}
+
+
+
+
+/* reductions */
+
+BM_SIMD_DISPATCH
+void vDSP_sve(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float sum = 0.0f;
+	if(IA == 1){
+		BMvFloat32_8 acc = BMv_splat(0.0f);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			acc += *(const BMvFloat32_8 *)(A+n);
+		sum = BMv_hsum(acc);
+	}
+	for(; n < N; n++) sum += A[n*IA];
+	*C = sum;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_svesq(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float sum = 0.0f;
+	if(IA == 1){
+		BMvFloat32_8 acc = BMv_splat(0.0f);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 a = *(const BMvFloat32_8 *)(A+n);
+			acc += a * a;
+		}
+		sum = BMv_hsum(acc);
+	}
+	for(; n < N; n++) sum += A[n*IA] * A[n*IA];
+	*C = sum;
+}
+
+
+
+void vDSP_meanv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	float sum;
+	vDSP_sve(A, IA, &sum, N);
+	*C = N > 0 ? sum / (float)N : 0.0f;
+}
+
+
+
+void vDSP_measqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	float sum;
+	vDSP_svesq(A, IA, &sum, N);
+	*C = N > 0 ? sum / (float)N : 0.0f;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float m = -INFINITY;
+	if(IA == 1 && N >= BM_VDSP_VL){
+		BMvFloat32_8 acc = BMv_splat(-INFINITY);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			acc = BMv_max(acc, *(const BMvFloat32_8 *)(A+n));
+		for(size_t i=0; i<BM_VDSP_VL; i++) m = acc[i] > m ? acc[i] : m;
+	}
+	for(; n < N; n++) m = A[n*IA] > m ? A[n*IA] : m;
+	*C = m;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_minv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float m = INFINITY;
+	if(IA == 1 && N >= BM_VDSP_VL){
+		BMvFloat32_8 acc = BMv_splat(INFINITY);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			acc = BMv_min(acc, *(const BMvFloat32_8 *)(A+n));
+		for(size_t i=0; i<BM_VDSP_VL; i++) m = acc[i] < m ? acc[i] : m;
+	}
+	for(; n < N; n++) m = A[n*IA] < m ? A[n*IA] : m;
+	*C = m;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_maxmgv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float m = 0.0f;
+	if(IA == 1){
+		BMvFloat32_8 acc = BMv_splat(0.0f);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			acc = BMv_max(acc, BMv_abs(*(const BMvFloat32_8 *)(A+n)));
+		for(size_t i=0; i<BM_VDSP_VL; i++) m = acc[i] > m ? acc[i] : m;
+	}
+	for(; n < N; n++) m = fabsf(A[n*IA]) > m ? fabsf(A[n*IA]) : m;
+	*C = m;
+}
+
+
+
+void vDSP_maxmgvi(const float *A, vDSP_Stride IA, float *C, vDSP_Length *I, vDSP_Length N){
+	float m = -INFINITY;
+	vDSP_Length idx = 0;
+	for(vDSP_Length n = 0; n < N; n++){
+		float a = fabsf(A[n*IA]);
+		if(a > m){
+			m = a;
+			idx = n*IA;
+		}
+	}
+	*C = m;
+	*I = idx;
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_dotpr(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Length N){
+	vDSP_Length n = 0;
+	float sum = 0.0f;
+	if(IA == 1 && IB == 1){
+		BMvFloat32_8 acc = BMv_splat(0.0f);
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			acc += *(const BMvFloat32_8 *)(A+n) * *(const BMvFloat32_8 *)(B+n);
+		sum = BMv_hsum(acc);
+	}
+	for(; n < N; n++) sum += A[n*IA] * B[n*IB];
+	*C = sum;
+}
+
+
+
+void vDSP_vrsum(const float *A, vDSP_Stride IA, const float *S, float *C, vDSP_Stride IC, vDSP_Length N){
+	// vDSP ignores A[0] and sets C[0] = 0
+	if(N == 0) return;
+	float s = *S;
+	float sum = 0.0f;
+	C[0] = 0.0f;
+	for(vDSP_Length n = 1; n < N; n++){
+		sum += A[n*IA];
+		C[n*IC] = s * sum;
+	}
+}
+
+
+
+void vDSP_vswsum(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P){
+	if(N == 0) return;
+	// the first window is summed in double precision and the remaining
+	// windows are updated incrementally
+	double sum = 0.0;
+	for(vDSP_Length p = 0; p < P; p++) sum += A[p*IA];
+	C[0] = (float)sum;
+	for(vDSP_Length n = 1; n < N; n++){
+		sum += A[(n+P-1)*IA] - A[(n-1)*IA];
+		C[n*IC] = (float)sum;
+	}
+}
+
+
+
+
+/* type conversion, gather, interpolation and transpose */
+
+BM_SIMD_DISPATCH
+void vDSP_vfix32(const float *A, vDSP_Stride IA, int *C, vDSP_Stride IC, vDSP_Length N){
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL)
+			*(BMvSInt32_8 *)(C+n) = __builtin_convertvector(*(const BMvFloat32_8 *)(A+n), BMvSInt32_8);
+	}
+	for(; n < N; n++) C[n*IC] = (int)A[n*IA];
+}
+
+
+
+void vDSP_vfixru8(const float *A, vDSP_Stride IA, unsigned char *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++){
+		float a = A[n*IA] + 0.5f;
+		a = a < 0.0f ? 0.0f : a;
+		a = a > 255.0f ? 255.0f : a;
+		C[n*IC] = (unsigned char)a;
+	}
+}
+
+
+
+void vDSP_vflt16(const short *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = (float)A[n*IA];
+}
+
+
+
+void vDSP_vfltu8(const unsigned char *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = (float)A[n*IA];
+}
+
+
+
+void vDSP_vfltu32(const unsigned int *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = (float)A[n*IA];
+}
+
+
+
+void vDSP_vgathr(const float *A, const vDSP_Length *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N){
+	for(vDSP_Length n = 0; n < N; n++) C[n*IC] = A[B[n*IB]-1];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_vqint(const float *A, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length M){
+	(void)M;
+	for(vDSP_Length n = 0; n < N; n++){
+		float b = B[n*IB];
+		long beta = (long)b;
+		float alpha = b - (float)beta;
+		float am1 = A[beta-1], a0 = A[beta], ap1 = A[beta+1];
+		C[n*IC] = a0 + 0.5f * alpha * ((ap1 - am1) + alpha*(ap1 + am1 - 2.0f*a0));
+	}
+}
+
+
+
+void vDSP_mtrans(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length M, vDSP_Length N){
+	// process in tiles to keep both the reads and the writes cache friendly
+	const vDSP_Length tile = 32;
+	for(vDSP_Length m0 = 0; m0 < M; m0 += tile){
+		vDSP_Length m1 = m0 + tile < M ? m0 + tile : M;
+		for(vDSP_Length n0 = 0; n0 < N; n0 += tile){
+			vDSP_Length n1 = n0 + tile < N ? n0 + tile : N;
+			for(vDSP_Length m = m0; m < m1; m++)
+				for(vDSP_Length n = n0; n < n1; n++)
+					C[(m*N + n)*IC] = A[(n*M + m)*IA];
+		}
+	}
+}
+
+
+
+
+/* convolution and decimation */
+
+BM_SIMD_DISPATCH
+void vDSP_conv(const float *A, vDSP_Stride IA, const float *F, vDSP_Stride IF, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P){
+	vDSP_Length n = 0;
+
+	// vectorise across output samples. Each lane accumulates one output.
+	if(IA == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 acc = BMv_splat(0.0f);
+			const float *a = A + n;
+			for(vDSP_Length p = 0; p < P; p++)
+				acc += *(const BMvFloat32_8 *)(a+p) * F[(vDSP_Stride)p*IF];
+			for(size_t i=0; i<BM_VDSP_VL; i++) C[(n+i)*IC] = acc[i];
+		}
+	}
+
+	for(; n < N; n++){
+		float sum = 0.0f;
+		for(vDSP_Length p = 0; p < P; p++)
+			sum += A[(n+p)*IA] * F[(vDSP_Stride)p*IF];
+		C[n*IC] = sum;
+	}
+}
+
+
+
+void vDSP_desamp(const float *A, vDSP_Stride DF, const float *F, float *C, vDSP_Length N, vDSP_Length P){
+	for(vDSP_Length n = 0; n < N; n++){
+		float sum;
+		vDSP_dotpr(A + n*DF, 1, F, 1, &sum, P);
+		C[n] = sum;
+	}
+}
+
+
+
+
+/* windows */
+
+static vDSP_Length BMWindowOutputLength(vDSP_Length N, int Flag){
+	return (Flag & vDSP_HALF_WINDOW) ? (N + 1) / 2 : N;
+}
+
+
+
+void vDSP_hamm_window(float *C, vDSP_Length N, int Flag){
+	vDSP_Length L = BMWindowOutputLength(N, Flag);
+	for(vDSP_Length n = 0; n < L; n++)
+		C[n] = 0.54 - 0.46 * cos(2.0 * M_PI * (double)n / (double)N);
+}
+
+
+
+void vDSP_hann_window(float *C, vDSP_Length N, int Flag){
+	vDSP_Length L = BMWindowOutputLength(N, Flag);
+	double scale = (Flag & vDSP_HANN_NORM) ? 0.8164965809277260327 : 0.5;
+	for(vDSP_Length n = 0; n < L; n++)
+		C[n] = scale * (1.0 - cos(2.0 * M_PI * (double)n / (double)N));
+}
+
+
+
+void vDSP_blkman_window(float *C, vDSP_Length N, int Flag){
+	vDSP_Length L = BMWindowOutputLength(N, Flag);
+	for(vDSP_Length n = 0; n < L; n++){
+		double x = 2.0 * M_PI * (double)n / (double)N;
+		C[n] = 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+	}
+}
+
+
+
+
+/* complex vectors */
+
+void vDSP_ctoz(const DSPComplex *C, vDSP_Stride IC, const DSPSplitComplex *Z, vDSP_Stride IZ, vDSP_Length N){
+	// IC is a stride in floats, so IC=2 means contiguous complex numbers
+	const float *c = (const float *)C;
+	float *re = Z->realp, *im = Z->imagp;
+	for(vDSP_Length n = 0; n < N; n++){
+		re[n*IZ] = c[n*IC];
+		im[n*IZ] = c[n*IC + 1];
+	}
+}
+
+
+
+void vDSP_ztoc(const DSPSplitComplex *Z, vDSP_Stride IZ, DSPComplex *C, vDSP_Stride IC, vDSP_Length N){
+	float *c = (float *)C;
+	const float *re = Z->realp, *im = Z->imagp;
+	for(vDSP_Length n = 0; n < N; n++){
+		c[n*IC] = re[n*IZ];
+		c[n*IC + 1] = im[n*IZ];
+	}
+}
+
+
+
+BM_SIMD_DISPATCH
+void vDSP_zvabs(const DSPSplitComplex *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N){
+	const float *re = A->realp, *im = A->imagp;
+	vDSP_Length n = 0;
+	if(IA == 1 && IC == 1){
+		for(; n + BM_VDSP_VL <= N; n += BM_VDSP_VL){
+			BMvFloat32_8 r = *(const BMvFloat32_8 *)(re+n);
+			BMvFloat32_8 i = *(const BMvFloat32_8 *)(im+n);
+			BMvFloat32_8 m = r*r + i*i;
+			for(size_t k=0; k<BM_VDSP_VL; k++) C[n+k] = sqrtf(m[k]);
+		}
+	}
+	for(; n < N; n++){
+		float r = re[n*IA], i = im[n*IA];
+		C[n*IC] = sqrtf(r*r + i*i);
+	}
+}
+
+
+
+
+/* FFT */
+
+/*
+ * The twiddle factors are stored separately for each stage of the radix-2
+ * FFT so that the innermost loop of every butterfly reads them from
+ * contiguous memory. The twiddles for the stage that combines transforms
+ * of length h into transforms of length 2h begin at index h-1.
+ */
+struct OpaqueFFTSetup {
+	vDSP_Length log2nMax;
+	float *twr;
+	float *twi;
+	// bit-reversal permutation indices for each transform size
+	uint32_t **bitReverse;
+};
+
+
+
+FFTSetup vDSP_create_fftsetup(vDSP_Length Log2n, FFTRadix Radix){
+	// only radix 2 is supported
+	if(Radix != kFFTRadix2) return NULL;
+
+	FFTSetup setup = malloc(sizeof(struct OpaqueFFTSetup));
+	setup->log2nMax = Log2n;
+
+	size_t nMax = (size_t)1 << Log2n;
+	setup->twr = malloc(sizeof(float)*nMax);
+	setup->twi = malloc(sizeof(float)*nMax);
+	for(size_t h = 1; h < nMax; h *= 2)
+		for(size_t j = 0; j < h; j++){
+			double theta = -M_PI * (double)j / (double)h;
+			setup->twr[h - 1 + j] = cos(theta);
+			setup->twi[h - 1 + j] = sin(theta);
+		}
+
+	setup->bitReverse = malloc(sizeof(uint32_t*)*(Log2n+1));
+	for(size_t L = 0; L <= Log2n; L++){
+		size_t n = (size_t)1 << L;
+		setup->bitReverse[L] = malloc(sizeof(uint32_t)*n);
+		for(size_t i = 0; i < n; i++){
+			uint32_t r = 0;
+			for(size_t b = 0; b < L; b++)
+				if(i & ((size_t)1 << b)) r |= 1u << (L - 1 - b);
+			setup->bitReverse[L][i] = r;
+		}
+	}
+
+	return setup;
+}
+
+
+
+void vDSP_destroy_fftsetup(FFTSetup setup){
+	if(!setup) return;
+	for(size_t L = 0; L <= setup->log2nMax; L++)
+		free(setup->bitReverse[L]);
+	free(setup->bitReverse);
+	free(setup->twr);
+	free(setup->twi);
+	free(setup);
+}
+
+
+
+/*
+ * Unscaled complex FFT of length 2^L on unit-stride split complex data.
+ * sign = -1 for forward, +1 for inverse.
+ */
+BM_SIMD_DISPATCH
+static void BMFFT_complexRadix2(FFTSetup setup, float *re, float *im, vDSP_Length L, int sign){
+	size_t n = (size_t)1 << L;
+
+	// bit reversal permutation
+	const uint32_t *br = setup->bitReverse[L];
+	for(size_t i = 0; i < n; i++){
+		size_t j = br[i];
+		if(j > i){
+			float t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+	}
+
+	// butterflies
+	float s = sign < 0 ? 1.0f : -1.0f;
+	for(size_t h = 1; h < n; h *= 2){
+		const float *wr = setup->twr + h - 1;
+		const float *wi = setup->twi + h - 1;
+		for(size_t k = 0; k < n; k += 2*h){
+			float *ar = re + k, *ai = im + k;
+			float *br_ = re + k + h, *bi = im + k + h;
+			for(size_t j = 0; j < h; j++){
+				float c = wr[j], d = s * wi[j];
+				float tr = br_[j]*c - bi[j]*d;
+				float ti = br_[j]*d + bi[j]*c;
+				br_[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+}
+
+
+
+void vDSP_fft_zip(FFTSetup setup, const DSPSplitComplex *C, vDSP_Stride IC, vDSP_Length Log2N, FFTDirection Direction){
+	assert(Log2N <= setup->log2nMax);
+	size_t n = (size_t)1 << Log2N;
+
+	if(IC == 1){
+		BMFFT_complexRadix2(setup, C->realp, C->imagp, Log2N, Direction == kFFTDirection_Forward ? -1 : 1);
+		return;
+	}
+
+	// strided data is copied to temporary storage
+	float *re = malloc(sizeof(float)*n*2);
+	float *im = re + n;
+	for(size_t i=0; i<n; i++){
+		re[i] = C->realp[i*IC];
+		im[i] = C->imagp[i*IC];
+	}
+	BMFFT_complexRadix2(setup, re, im, Log2N, Direction == kFFTDirection_Forward ? -1 : 1);
+	for(size_t i=0; i<n; i++){
+		C->realp[i*IC] = re[i];
+		C->imagp[i*IC] = im[i];
+	}
+	free(re);
+}
+
+
+
+/*
+ * Real FFT of length n = 2^L computed via a complex FFT of length n/2 on
+ * the even and odd samples, packed as z[k] = x[2k] + i x[2k+1].
+ */
+static void BMFFT_realRadix2(FFTSetup setup, float *re, float *im, vDSP_Length L, FFTDirection Direction){
+	assert(L >= 1 && L <= setup->log2nMax);
+	size_t n = (size_t)1 << L;
+	size_t h = n / 2;
+
+	// twiddles exp(-i pi k / h) for this transform length
+	const float *wr = setup->twr + h - 1;
+	const float *wi = setup->twi + h - 1;
+
+	if(Direction == kFFTDirection_Forward){
+		BMFFT_complexRadix2(setup, re, im, L-1, -1);
+
+		// DC and Nyquist
+		float z0r = re[0], z0i = im[0];
+		re[0] = 2.0f * (z0r + z0i);
+		im[0] = 2.0f * (z0r - z0i);
+
+		// the remaining terms are computed in symmetric pairs k, h-k
+		for(size_t k = 1; k <= h/2; k++){
+			size_t m = h - k;
+			float ar = re[k], ai = im[k];
+			float br = re[m], bi = im[m];
+
+			// E = Z[k] + conj(Z[m]), D = Z[k] - conj(Z[m])
+			float er = ar + br, ei = ai - bi;
+			float dr = ar - br, di = ai + bi;
+
+			// X[k] = E - i W^k D, where W^k = c + i s
+			float c = wr[k], s = wi[k];
+			float tr = dr*c - di*s, ti = dr*s + di*c;
+			re[k] = er + ti;
+			im[k] = ei - tr;
+
+			if(m != k){
+				// X[m] = conj(E) - i W^m conj(-D), with W^m = -conj(W^k)
+				re[m] = er - ti;
+				im[m] = -ei - tr;
+			}
+		}
+	}
+
+	else {
+		// DC and Nyquist
+		float y0r = re[0], y0i = im[0];
+		re[0] = y0r + y0i;
+		im[0] = y0r - y0i;
+
+		for(size_t k = 1; k <= h/2; k++){
+			size_t m = h - k;
+			float ar = re[k], ai = im[k];
+			float br = re[m], bi = im[m];
+
+			// E = Y[k] + conj(Y[m]), D = Y[k] - conj(Y[m])
+			float er = ar + br, ei = ai - bi;
+			float dr = ar - br, di = ai + bi;
+
+			// O = conj(W^k) D; Z[k] = E + i O
+			float c = wr[k], s = wi[k];
+			float or_ = dr*c + di*s, oi = di*c - dr*s;
+			re[k] = er - oi;
+			im[k] = ei + or_;
+
+			if(m != k){
+				// Z[m] = conj(E) + i conj(W^m) (-conj(D)), with conj(W^m) = -W^k
+				re[m] = er + oi;
+				im[m] = -ei + or_;
+			}
+		}
+
+		BMFFT_complexRadix2(setup, re, im, L-1, 1);
+	}
+}
+
+
+
+void vDSP_fft_zrip(FFTSetup setup, const DSPSplitComplex *C, vDSP_Stride IC, vDSP_Length Log2N, FFTDirection Direction){
+	size_t h = (size_t)1 << (Log2N - 1);
+
+	if(IC == 1){
+		BMFFT_realRadix2(setup, C->realp, C->imagp, Log2N, Direction);
+		return;
+	}
+
+	float *re = malloc(sizeof(float)*h*2);
+	float *im = re + h;
+	for(size_t i=0; i<h; i++){
+		re[i] = C->realp[i*IC];
+		im[i] = C->imagp[i*IC];
+	}
+	BMFFT_realRadix2(setup, re, im, Log2N, Direction);
+	for(size_t i=0; i<h; i++){
+		C->realp[i*IC] = re[i];
+		C->imagp[i*IC] = im[i];
+	}
+	free(re);
+}
+
+
+
+void vDSP_fft_zropt(FFTSetup setup, const DSPSplitComplex *A, vDSP_Stride IA, const DSPSplitComplex *C, vDSP_Stride IC, const DSPSplitComplex *Buffer, vDSP_Length Log2N, FFTDirection Direction){
+	(void)Buffer;
+	size_t h = (size_t)1 << (Log2N - 1);
+
+	// copy the input to the output and then transform in place
+	for(size_t i=0; i<h; i++){
+		C->realp[i*IC] = A->realp[i*IA];
+		C->imagp[i*IC] = A->imagp[i*IA];
+	}
+	vDSP_fft_zrip(setup, C, IC, Log2N, Direction);
+}
+
+
+
+
+/* biquad filters */
+
+struct vDSP_biquad_SetupStruct {
+	vDSP_Length numSections;
+	float *coefficients;
+};
+
+
+
+vDSP_biquad_Setup vDSP_biquad_CreateSetup(const double *Coefficients, vDSP_Length M){
+	vDSP_biquad_Setup setup = malloc(sizeof(struct vDSP_biquad_SetupStruct));
+	setup->numSections = M;
+	setup->coefficients = malloc(sizeof(float)*5*M);
+	for(size_t i=0; i<5*M; i++) setup->coefficients[i] = Coefficients[i];
+	return setup;
+}
+
+
+
+void vDSP_biquad_DestroySetup(vDSP_biquad_Setup setup){
+	if(!setup) return;
+	free(setup->coefficients);
+	free(setup);
+}
+
+
+
+/*
+ * Direct form 1. The delay memory holds x[n-1], x[n-2] for the input and
+ * then y[n-1], y[n-2] for each section. The output of each section is the
+ * input of the next so the sections share delay memory.
+ */
+void vDSP_biquad(const struct vDSP_biquad_SetupStruct *Setup, float *Delay, const float *X, vDSP_Stride IX, float *Y, vDSP_Stride IY, vDSP_Length N){
+	vDSP_Length M = Setup->numSections;
+
+	// copy input to output and filter in place, one section at a time
+	if(X != Y || IX != IY)
+		for(vDSP_Length n = 0; n < N; n++) Y[n*IY] = X[n*IX];
+
+	// the input history of each section is the output history of the
+	// previous section as it was at the start of the buffer
+	float x1 = Delay[0], x2 = Delay[1];
+	for(vDSP_Length s = 0; s < M; s++){
+		const float *c = Setup->coefficients + 5*s;
+		float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+		float y1 = Delay[2*s+2], y2 = Delay[2*s+3];
+		float nextX1 = y1, nextX2 = y2;
+		for(vDSP_Length n = 0; n < N; n++){
+			float x0 = Y[n*IY];
+			float y0 = b0*x0 + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+			x2 = x1; x1 = x0;
+			y2 = y1; y1 = y0;
+			Y[n*IY] = y0;
+		}
+		Delay[2*s] = x1; Delay[2*s+1] = x2;
+		Delay[2*s+2] = y1; Delay[2*s+3] = y2;
+		x1 = nextX1; x2 = nextX2;
+	}
+}
+
+
+
+/*
+ * Coefficients and state are stored by section, then by channel.
+ * The state of each filter is x[n-1], x[n-2], y[n-1], y[n-2].
+ */
+struct vDSP_biquadm_SetupStruct {
+	vDSP_Length numSections, numChannels;
+	float *coefficients;
+	float *targets;
+	float *state;
+	bool *activeSections;
+	float interpRate, interpThreshold;
+	bool interpolating;
+};
+
+
+
+vDSP_biquadm_Setup vDSP_biquadm_CreateSetup(const double *coeffs, vDSP_Length M, vDSP_Length N){
+	vDSP_biquadm_Setup setup = malloc(sizeof(struct vDSP_biquadm_SetupStruct));
+	setup->numSections = M;
+	setup->numChannels = N;
+	setup->coefficients = malloc(sizeof(float)*5*M*N);
+	setup->targets = malloc(sizeof(float)*5*M*N);
+	setup->state = calloc(4*M*N, sizeof(float));
+	setup->activeSections = malloc(sizeof(bool)*M);
+	for(size_t i=0; i<5*M*N; i++)
+		setup->coefficients[i] = setup->targets[i] = coeffs[i];
+	for(size_t i=0; i<M; i++)
+		setup->activeSections[i] = true;
+	setup->interpRate = 0.0f;
+	setup->interpThreshold = 0.0f;
+	setup->interpolating = false;
+	return setup;
+}
+
+
+
+void vDSP_biquadm_DestroySetup(vDSP_biquadm_Setup setup){
+	if(!setup) return;
+	free(setup->coefficients);
+	free(setup->targets);
+	free(setup->state);
+	free(setup->activeSections);
+	free(setup);
+}
+
+
+
+void vDSP_biquadm_SetCoefficientsDouble(vDSP_biquadm_Setup setup, const double *coeffs, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn){
+	for(size_t s=0; s<nsec; s++)
+		for(size_t c=0; c<nchn; c++){
+			size_t dst = ((start_sec + s)*setup->numChannels + start_chn + c)*5;
+			size_t src = (s*nchn + c)*5;
+			for(size_t i=0; i<5; i++)
+				setup->coefficients[dst+i] = setup->targets[dst+i] = coeffs[src+i];
+		}
+	setup->interpolating = false;
+}
+
+
+
+void vDSP_biquadm_SetCoefficientsSingle(vDSP_biquadm_Setup setup, const float *coeffs, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn){
+	for(size_t s=0; s<nsec; s++)
+		for(size_t c=0; c<nchn; c++){
+			size_t dst = ((start_sec + s)*setup->numChannels + start_chn + c)*5;
+			size_t src = (s*nchn + c)*5;
+			for(size_t i=0; i<5; i++)
+				setup->coefficients[dst+i] = setup->targets[dst+i] = coeffs[src+i];
+		}
+	setup->interpolating = false;
+}
+
+
+
+void vDSP_biquadm_SetTargetsDouble(vDSP_biquadm_Setup setup, const double *targets, float interp_rate, float interp_threshold, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn){
+	for(size_t s=0; s<nsec; s++)
+		for(size_t c=0; c<nchn; c++){
+			size_t dst = ((start_sec + s)*setup->numChannels + start_chn + c)*5;
+			size_t src = (s*nchn + c)*5;
+			for(size_t i=0; i<5; i++)
+				setup->targets[dst+i] = targets[src+i];
+		}
+	setup->interpRate = interp_rate;
+	setup->interpThreshold = interp_threshold;
+	setup->interpolating = true;
+}
+
+
+
+void vDSP_biquadm_SetActiveFilters(vDSP_biquadm_Setup setup, const bool *filter_states){
+	for(size_t s=0; s<setup->numSections; s++)
+		setup->activeSections[s] = filter_states[s];
+}
+
+
+
+/*
+ * Moves the coefficients one step towards their targets. Returns true if
+ * the coefficients are still moving.
+ */
+static bool BMBiquadm_interpolateStep(vDSP_biquadm_Setup setup){
+	size_t count = 5 * setup->numSections * setup->numChannels;
+	float rate = setup->interpRate;
+	float maxDiff = 0.0f;
+	for(size_t i=0; i<count; i++){
+		float diff = setup->targets[i] - setup->coefficients[i];
+		setup->coefficients[i] += (1.0f - rate) * diff;
+		maxDiff = fabsf(diff) > maxDiff ? fabsf(diff) : maxDiff;
+	}
+	if(maxDiff < setup->interpThreshold){
+		memcpy(setup->coefficients, setup->targets, sizeof(float)*count);
+		return false;
+	}
+	return true;
+}
+
+
+
+static void BMBiquadm_processSection(const float *c, float *state, float *y, vDSP_Stride IY, vDSP_Length N){
+	float b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+	float x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+	for(vDSP_Length n = 0; n < N; n++){
+		float x0 = y[n*IY];
+		float y0 = b0*x0 + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+		x2 = x1; x1 = x0;
+		y2 = y1; y1 = y0;
+		y[n*IY] = y0;
+	}
+	state[0] = x1; state[1] = x2; state[2] = y1; state[3] = y2;
+}
+
+
+
+// interpolation is applied in sub-blocks of this length
+#define BM_BIQUADM_INTERP_BLOCK 16
+
+void vDSP_biquadm(vDSP_biquadm_Setup setup, const float * _Nonnull * _Nonnull x, vDSP_Stride IX, float * _Nonnull * _Nonnull y, vDSP_Stride IY, vDSP_Length N){
+	size_t M = setup->numSections, C = setup->numChannels;
+
+	// copy inputs to outputs, then filter in place
+	for(size_t ch=0; ch<C; ch++)
+		if(x[ch] != y[ch] || IX != IY)
+			for(vDSP_Length n=0; n<N; n++) y[ch][n*IY] = x[ch][n*IX];
+
+	vDSP_Length done = 0;
+	while(done < N){
+		// when the coefficients are moving we process in short sub-blocks
+		// and step the interpolation between them
+		vDSP_Length len = setup->interpolating ? (N - done < BM_BIQUADM_INTERP_BLOCK ? N - done : BM_BIQUADM_INTERP_BLOCK) : N - done;
+		for(size_t s=0; s<M; s++){
+			if(!setup->activeSections[s]) continue;
+			for(size_t ch=0; ch<C; ch++){
+				size_t f = s*C + ch;
+				BMBiquadm_processSection(setup->coefficients + 5*f, setup->state + 4*f, y[ch] + done*IY, IY, len);
+			}
+		}
+		if(setup->interpolating)
+			for(size_t i=0; i<len; i++)
+				if(!(setup->interpolating = BMBiquadm_interpolateStep(setup))) break;
+		done += len;
+	}
+}
+
+
+
+
+/* vForce */
+
+/*
+ * 2^x for 8 floats. The argument is split into an integer part, which is
+ * applied directly to the exponent bits, and a fractional part in
+ * [-0.5,0.5], which is evaluated with a degree 6 polynomial.
+ */
+BM_VDSP_INLINE BMvFloat32_8 BMv_exp2(BMvFloat32_8 x){
+	BMvSInt32_8 underflow = x < -126.0f;
+	BMvSInt32_8 isnan_ = x != x;
+	x = BMv_min(BMv_max(x, BMv_splat(-126.0f)), BMv_splat(128.0f));
+
+	BMvFloat32_8 fi = BMv_floor(x + 0.5f);
+	BMvFloat32_8 f = x - fi;
+
+	// Taylor series of exp(f * ln 2)
+	BMvFloat32_8 p = BMv_splat(1.5403530393381609954e-4f);
+	p = p * f + 1.3333558146428443423e-3f;
+	p = p * f + 9.6181291076284771619e-3f;
+	p = p * f + 5.5504108664821579953e-2f;
+	p = p * f + 2.4022650695910071233e-1f;
+	p = p * f + 6.9314718055994530942e-1f;
+	p = p * f + 1.0f;
+
+	BMvSInt32_8 e = (__builtin_convertvector(fi, BMvSInt32_8) + 127) << 23;
+	BMvFloat32_8 y = p * (BMvFloat32_8)e;
+	y = BMv_select(underflow, BMv_splat(0.0f), y);
+	return BMv_select(isnan_, x, y);
+}
+
+
+
+/*
+ * natural exponential for 8 floats using Cody-Waite range reduction so that
+ * the reduction error does not grow with |x|
+ */
+BM_VDSP_INLINE BMvFloat32_8 BMv_exp(BMvFloat32_8 x){
+	BMvSInt32_8 underflow = x < -87.33654f;
+	BMvSInt32_8 overflow = x > 88.72283f;
+	BMvSInt32_8 isnan_ = x != x;
+	x = BMv_min(BMv_max(x, BMv_splat(-87.33654f)), BMv_splat(88.72283f));
+
+	BMvFloat32_8 fi = BMv_floor(x * 1.44269504088896341f + 0.5f);
+	BMvFloat32_8 r = x - fi * 0.693359375f;
+	r = r - fi * -2.12194440e-4f;
+
+	// degree 6 polynomial for exp(r) on [-ln2/2, ln2/2]
+	BMvFloat32_8 p = BMv_splat(1.9875691500e-4f);
+	p = p * r + 1.3981999507e-3f;
+	p = p * r + 8.3334519073e-3f;
+	p = p * r + 4.1665795894e-2f;
+	p = p * r + 1.6666665459e-1f;
+	p = p * r + 5.0000001201e-1f;
+	p = p * r * r + r + 1.0f;
+
+	BMvSInt32_8 e = (__builtin_convertvector(fi, BMvSInt32_8) + 127) << 23;
+	BMvFloat32_8 y = p * (BMvFloat32_8)e;
+	y = BMv_select(underflow, BMv_splat(0.0f), y);
+	y = BMv_select(overflow, BMv_splat(INFINITY), y);
+	return BMv_select(isnan_, x, y);
+}
+
+
+
+/*
+ * log2(x) for 8 floats. The mantissa is reduced to [sqrt(1/2), sqrt(2)] and
+ * log(m) is evaluated with the series for atanh((m-1)/(m+1)).
+ */
+BM_VDSP_INLINE BMvFloat32_8 BMv_log2(BMvFloat32_8 x){
+	BMvSInt32_8 xi = (BMvSInt32_8)x;
+	BMvSInt32_8 zero = x == 0.0f;
+	BMvSInt32_8 negative = x < 0.0f;
+	BMvSInt32_8 special = (xi & 0x7F800000) == 0x7F800000; // inf or nan
+
+	// normalise denormals
+	BMvSInt32_8 denormal = (xi & 0x7F800000) == 0;
+	BMvFloat32_8 xn = BMv_select(denormal, x * 8388608.0f, x);
+	xi = (BMvSInt32_8)xn;
+	BMvSInt32_8 ei = ((xi >> 23) & 0xFF) - 127;
+	ei -= denormal & 23;
+	BMvFloat32_8 m = (BMvFloat32_8)((xi & 0x007FFFFF) | 0x3F800000);
+
+	// move m into [sqrt(1/2), sqrt(2)]
+	BMvSInt32_8 big = m > 1.41421356237309505f;
+	m = BMv_select(big, m * 0.5f, m);
+	ei -= big; // big is -1 where true
+
+	BMvFloat32_8 t = (m - 1.0f) / (m + 1.0f);
+	BMvFloat32_8 t2 = t * t;
+	BMvFloat32_8 p = BMv_splat(2.0f/9.0f);
+	p = p * t2 + 2.0f/7.0f;
+	p = p * t2 + 2.0f/5.0f;
+	p = p * t2 + 2.0f/3.0f;
+	p = p * t2 + 2.0f;
+	BMvFloat32_8 lnm = p * t;
+
+	BMvFloat32_8 y = __builtin_convertvector(ei, BMvFloat32_8) + lnm * 1.44269504088896341f;
+	y = BMv_select(zero, BMv_splat(-INFINITY), y);
+	y = BMv_select(special, x, y);
+	y = BMv_select(negative, BMv_splat(NAN), y);
+	return y;
+}
+
+
+
+/*
+ * tanh(x) for 8 floats. A Taylor polynomial is used near zero, where the
+ * exponential formula loses precision to cancellation.
+ */
+BM_VDSP_INLINE BMvFloat32_8 BMv_tanh(BMvFloat32_8 x){
+	BMvFloat32_8 ax = BMv_abs(x);
+	BMvSInt32_8 small = ax < 0.3f;
+
+	// small argument
+	BMvFloat32_8 x2 = x * x;
+	BMvFloat32_8 p = BMv_splat(-1382.0f/155925.0f);
+	p = p * x2 + 62.0f/2835.0f;
+	p = p * x2 + -17.0f/315.0f;
+	p = p * x2 + 2.0f/15.0f;
+	p = p * x2 + -1.0f/3.0f;
+	BMvFloat32_8 ySmall = x + x * x2 * p;
+
+	// large argument: 1 - 2/(exp(2|x|)+1), with the sign restored
+	BMvFloat32_8 e = BMv_exp(BMv_min(ax * 2.0f, BMv_splat(88.0f)));
+	BMvFloat32_8 yLarge = 1.0f - 2.0f / (e + 1.0f);
+	yLarge = (BMvFloat32_8)((BMvSInt32_8)yLarge | ((BMvSInt32_8)x & (int)0x80000000));
+
+	return BMv_select(small, ySmall, yLarge);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvexpf(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = BMv_exp(*(const BMvFloat32_8 *)(x+i));
+	for(; i < N; i++) y[i] = expf(x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvexp2f(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = BMv_exp2(*(const BMvFloat32_8 *)(x+i));
+	for(; i < N; i++) y[i] = exp2f(x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvlog2f(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = BMv_log2(*(const BMvFloat32_8 *)(x+i));
+	for(; i < N; i++) y[i] = log2f(x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvtanhf(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = BMv_tanh(*(const BMvFloat32_8 *)(x+i));
+	for(; i < N; i++) y[i] = tanhf(x[i]);
+}
+
+
+
+void vvtanf(float *y, const float *x, const int *n){
+	for(int i = 0; i < *n; i++) y[i] = tanf(x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvsqrtf(float *y, const float *x, const int *n){
+	for(int i = 0; i < *n; i++) y[i] = __builtin_sqrtf(x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvrecf(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = 1.0f / *(const BMvFloat32_8 *)(x+i);
+	for(; i < N; i++) y[i] = 1.0f / x[i];
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvfabsf(float *y, const float *x, const int *n){
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL)
+		*(BMvFloat32_8 *)(y+i) = BMv_abs(*(const BMvFloat32_8 *)(x+i));
+	for(; i < N; i++) y[i] = fabsf(x[i]);
+}
+
+
+
+void vvfloorf(float *y, const float *x, const int *n){
+	for(int i = 0; i < *n; i++) y[i] = floorf(x[i]);
+}
+
+
+
+void vvceilf(float *y, const float *x, const int *n){
+	for(int i = 0; i < *n; i++) y[i] = ceilf(x[i]);
+}
+
+
+
+void vvfmodf(float *z, const float *y, const float *x, const int *n){
+	for(int i = 0; i < *n; i++) z[i] = fmodf(y[i], x[i]);
+}
+
+
+
+BM_SIMD_DISPATCH
+void vvpowsf(float *z, const float *y, const float *x, const int *n){
+	// x^y = 2^(y log2(x)) for x > 0; other cases go to the C library
+	float e = *y;
+	int i = 0, N = *n;
+	for(; i + BM_VDSP_VL <= N; i += BM_VDSP_VL){
+		BMvFloat32_8 xv = *(const BMvFloat32_8 *)(x+i);
+		BMvSInt32_8 positive = xv > 0.0f;
+		if((positive[0] & positive[1] & positive[2] & positive[3] &
+		    positive[4] & positive[5] & positive[6] & positive[7]) == 0){
+			for(int k=0; k<BM_VDSP_VL; k++) z[i+k] = powf(x[i+k], e);
+			continue;
+		}
+		*(BMvFloat32_8 *)(z+i) = BMv_exp2(BMv_log2(xv) * e);
+	}
+	for(; i < N; i++) z[i] = powf(x[i], e);
+}
+
+#endif /* __APPLE__ */
@@ -0,0 +1,367 @@
+//
+//  BMCrossPlatformVDSP.h
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+//  This is a portable implementation of the subset of Apple's vDSP and
+//  vForce APIs that this toolbox uses. It is intended for builds on
+//  platforms where the Accelerate framework is not available. On Apple
+//  platforms, include <Accelerate/Accelerate.h> instead:
+//
+//      #ifdef __APPLE__
+//      #include <Accelerate/Accelerate.h>
+//      #else
+//      #include "BMCrossPlatformVDSP.h"
+//      #endif
+//
+//  The function signatures and the numerical conventions (strides, scaling
+//  of the real FFT, 1-based indices in vDSP_vgathr, etc.) follow Apple's
+//  documentation so that calling code does not need to change.
+//
+//  Unit-stride calls are processed with 8-lane vector kernels written with
+//  GCC / Clang vector extensions. These lower to SSE2 or NEON by default.
+//  On x86_64 Linux, the kernels are also compiled for AVX2 and the fastest
+//  version is selected at load time according to the capabilities of the
+//  CPU (see BM_SIMD_DISPATCH in Constants.h). Calls with
+//  non-unit strides fall back to scalar loops.
+//
+
+#ifndef BMCrossPlatformVDSP_h
+#define BMCrossPlatformVDSP_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Clang nullability qualifiers are used in some casts in calling code
+#ifndef __clang__
+#ifndef _Nonnull
+#define _Nonnull
+#endif
+#ifndef _Nullable
+#define _Nullable
+#endif
+#endif
+
+#ifndef __MACTYPES__
+typedef float Float32;
+typedef double Float64;
+#endif
+
+typedef unsigned long vDSP_Length;
+typedef long vDSP_Stride;
+
+typedef struct DSPComplex {
+	float real;
+	float imag;
+} DSPComplex;
+
+typedef struct DSPSplitComplex {
+	float *realp;
+	float *imagp;
+} DSPSplitComplex;
+
+typedef struct DSPDoubleComplex {
+	double real;
+	double imag;
+} DSPDoubleComplex;
+
+typedef struct DSPDoubleSplitComplex {
+	double *realp;
+	double *imagp;
+} DSPDoubleSplitComplex;
+
+typedef int FFTDirection;
+typedef int FFTRadix;
+enum {
+	kFFTDirection_Forward = +1,
+	kFFTDirection_Inverse = -1
+};
+enum {
+	kFFTRadix2 = 0,
+	kFFTRadix3 = 1,
+	kFFTRadix5 = 2
+};
+enum {
+	FFT_FORWARD = kFFTDirection_Forward,
+	FFT_INVERSE = kFFTDirection_Inverse
+};
+enum {
+	FFT_RADIX2 = kFFTRadix2,
+	FFT_RADIX3 = kFFTRadix3,
+	FFT_RADIX5 = kFFTRadix5
+};
+
+enum {
+	vDSP_HALF_WINDOW = 1,
+	vDSP_HANN_DENORM = 0,
+	vDSP_HANN_NORM = 2
+};
+
+typedef struct OpaqueFFTSetup *FFTSetup;
+typedef struct vDSP_biquad_SetupStruct *vDSP_biquad_Setup;
+typedef struct vDSP_biquadm_SetupStruct *vDSP_biquadm_Setup;
+
+
+
+
+/* arithmetic on vectors and scalars */
+
+// C = A * B
+void vDSP_vsmul(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A + B
+void vDSP_vsadd(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A + B (integer)
+void vDSP_vsaddi(const int *A, vDSP_Stride IA, const int *B, int *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A / B
+void vDSP_svdiv(const float *A, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// D = A * B + C
+void vDSP_vsmsa(const float *A, vDSP_Stride IA, const float *B, const float *C, float *D, vDSP_Stride ID, vDSP_Length N);
+
+
+
+
+/* arithmetic on pairs of vectors */
+
+// C = A + B
+void vDSP_vadd(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A - B (note the order of the arguments)
+void vDSP_vsub(const float *B, vDSP_Stride IB, const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A * B
+void vDSP_vmul(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A / B (note the order of the arguments)
+void vDSP_vdiv(const float *B, vDSP_Stride IB, const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// D = A * B + C
+void vDSP_vsma(const float *A, vDSP_Stride IA, const float *B, const float *C, vDSP_Stride IC, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// E = A * B + C * D
+void vDSP_vsmsma(const float *A, vDSP_Stride IA, const float *B, const float *C, vDSP_Stride IC, const float *D, float *E, vDSP_Stride IE, vDSP_Length N);
+
+// D = A * B + C
+void vDSP_vma(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, vDSP_Stride IC, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// D = A * B + C
+void vDSP_vmsa(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// E = A * B + C * D
+void vDSP_vmma(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, vDSP_Stride IC, const float *D, vDSP_Stride ID, float *E, vDSP_Stride IE, vDSP_Length N);
+
+// D = (A + B) * C
+void vDSP_vasm(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// D = (A - B) * C
+void vDSP_vsbsm(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, const float *C, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// C = max(A,B)
+void vDSP_vmax(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = min(A,B)
+void vDSP_vmin(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = max(|A|,|B|)
+void vDSP_vmaxmg(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = min(|A|,|B|)
+void vDSP_vminmg(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = sqrt(A^2 + B^2)
+void vDSP_vdist(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+
+
+
+/* unary operations */
+
+void vDSP_vabs(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vneg(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vsq(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = clamp(A, *B, *C)
+void vDSP_vclip(const float *A, vDSP_Stride IA, const float *B, const float *C, float *D, vDSP_Stride ID, vDSP_Length N);
+
+// C = A >= *B ? A : *B
+void vDSP_vthr(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = A >= *B ? A : 0
+void vDSP_vthres(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C = (F ? 20 : 10) * log10(A / *B)
+void vDSP_vdbcon(const float *A, vDSP_Stride IA, const float *B, float *C, vDSP_Stride IC, vDSP_Length N, unsigned int F);
+
+// C[n] = sum_{p=0}^{P} A[p] * B[n]^(P-p)
+void vDSP_vpoly(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P);
+
+// reverse the order of C in place
+void vDSP_vrvrs(float *C, vDSP_Stride IC, vDSP_Length N);
+
+
+
+
+/* fill, ramp and generate */
+
+void vDSP_vfill(const float *A, float *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vclr(float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C[n] = *A + n * *B
+void vDSP_vramp(const float *A, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C[n] = *A + n * (*B - *A) / (N - 1)
+void vDSP_vgen(const float *A, const float *B, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// O[n] = *Start * I[n]; *Start += *Step
+void vDSP_vrampmul(const float *I, vDSP_Stride IS, float *Start, const float *Step, float *O, vDSP_Stride OS, vDSP_Length N);
+
+// stereo version of vDSP_vrampmul
+void vDSP_vrampmul2(const float *I0, const float *I1, vDSP_Stride IS, float *Start, const float *Step, float *O0, float *O1, vDSP_Stride OS, vDSP_Length N);
+
+
+
+
+/* reductions */
+
+void vDSP_sve(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_svesq(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_meanv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_measqv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_maxv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_minv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_maxmgv(const float *A, vDSP_Stride IA, float *C, vDSP_Length N);
+void vDSP_maxmgvi(const float *A, vDSP_Stride IA, float *C, vDSP_Length *I, vDSP_Length N);
+void vDSP_dotpr(const float *A, vDSP_Stride IA, const float *B, vDSP_Stride IB, float *C, vDSP_Length N);
+
+// C[n] = *S * sum_{k=1}^{n} A[k]
+void vDSP_vrsum(const float *A, vDSP_Stride IA, const float *S, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C[n] = sum_{p=0}^{P-1} A[n+p]
+void vDSP_vswsum(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P);
+
+
+
+
+/* type conversion, gather, interpolation and transpose */
+
+void vDSP_vfix32(const float *A, vDSP_Stride IA, int *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vfixru8(const float *A, vDSP_Stride IA, unsigned char *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vflt16(const short *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vfltu8(const unsigned char *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_vfltu32(const unsigned int *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// C[n] = A[B[n]-1] (the indices in B count from 1)
+void vDSP_vgathr(const float *A, const vDSP_Length *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N);
+
+// quadratic interpolation of A at fractional indices B
+void vDSP_vqint(const float *A, const float *B, vDSP_Stride IB, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length M);
+
+// C (M rows by N columns) is the transpose of A (N rows by M columns)
+void vDSP_mtrans(const float *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length M, vDSP_Length N);
+
+
+
+
+/* convolution and decimation */
+
+// C[n] = sum_{p=0}^{P-1} A[n+p] * F[p]; set IF = -1 and point F at the last
+// element of the filter to get convolution instead of correlation
+void vDSP_conv(const float *A, vDSP_Stride IA, const float *F, vDSP_Stride IF, float *C, vDSP_Stride IC, vDSP_Length N, vDSP_Length P);
+
+// C[n] = sum_{p=0}^{P-1} A[n*DF + p] * F[p]
+void vDSP_desamp(const float *A, vDSP_Stride DF, const float *F, float *C, vDSP_Length N, vDSP_Length P);
+
+
+
+
+/* windows */
+
+void vDSP_hamm_window(float *C, vDSP_Length N, int Flag);
+void vDSP_hann_window(float *C, vDSP_Length N, int Flag);
+void vDSP_blkman_window(float *C, vDSP_Length N, int Flag);
+
+
+
+
+/* complex vectors and FFT */
+
+void vDSP_ctoz(const DSPComplex *C, vDSP_Stride IC, const DSPSplitComplex *Z, vDSP_Stride IZ, vDSP_Length N);
+void vDSP_ztoc(const DSPSplitComplex *Z, vDSP_Stride IZ, DSPComplex *C, vDSP_Stride IC, vDSP_Length N);
+void vDSP_zvabs(const DSPSplitComplex *A, vDSP_Stride IA, float *C, vDSP_Stride IC, vDSP_Length N);
+
+FFTSetup vDSP_create_fftsetup(vDSP_Length Log2n, FFTRadix Radix);
+void vDSP_destroy_fftsetup(FFTSetup setup);
+
+// in-place complex FFT. Unscaled in both directions.
+void vDSP_fft_zip(FFTSetup setup, const DSPSplitComplex *C, vDSP_Stride IC, vDSP_Length Log2N, FFTDirection Direction);
+
+// in-place real FFT on packed data. The forward transform is scaled by 2
+// and the nyquist term is stored in imagp[0]. A forward transform followed
+// by an inverse transform scales the signal by 2*N.
+void vDSP_fft_zrip(FFTSetup setup, const DSPSplitComplex *C, vDSP_Stride IC, vDSP_Length Log2N, FFTDirection Direction);
+
+// out-of-place real FFT. Buffer is unused but kept for API compatibility.
+void vDSP_fft_zropt(FFTSetup setup, const DSPSplitComplex *A, vDSP_Stride IA, const DSPSplitComplex *C, vDSP_Stride IC, const DSPSplitComplex *Buffer, vDSP_Length Log2N, FFTDirection Direction);
+
+
+
+
+/* biquad filters */
+
+// 5 coefficients per section: b0, b1, b2, a1, a2
+vDSP_biquad_Setup vDSP_biquad_CreateSetup(const double *Coefficients, vDSP_Length M);
+void vDSP_biquad_DestroySetup(vDSP_biquad_Setup setup);
+
+// Delay must have length 2*M + 2
+void vDSP_biquad(const struct vDSP_biquad_SetupStruct *Setup, float *Delay, const float *X, vDSP_Stride IX, float *Y, vDSP_Stride IY, vDSP_Length N);
+
+// coefficients are ordered by section, then by channel, 5 per filter
+vDSP_biquadm_Setup vDSP_biquadm_CreateSetup(const double *coeffs, vDSP_Length M, vDSP_Length N);
+void vDSP_biquadm_DestroySetup(vDSP_biquadm_Setup setup);
+void vDSP_biquadm(vDSP_biquadm_Setup setup, const float * _Nonnull * _Nonnull x, vDSP_Stride IX, float * _Nonnull * _Nonnull y, vDSP_Stride IY, vDSP_Length N);
+void vDSP_biquadm_SetCoefficientsDouble(vDSP_biquadm_Setup setup, const double *coeffs, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn);
+void vDSP_biquadm_SetCoefficientsSingle(vDSP_biquadm_Setup setup, const float *coeffs, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn);
+void vDSP_biquadm_SetTargetsDouble(vDSP_biquadm_Setup setup, const double *targets, float interp_rate, float interp_threshold, vDSP_Length start_sec, vDSP_Length start_chn, vDSP_Length nsec, vDSP_Length nchn);
+void vDSP_biquadm_SetActiveFilters(vDSP_biquadm_Setup setup, const bool *filter_states);
+
+
+
+
+/* vForce */
+
+void vvexpf(float *y, const float *x, const int *n);
+void vvexp2f(float *y, const float *x, const int *n);
+void vvlog2f(float *y, const float *x, const int *n);
+void vvtanhf(float *y, const float *x, const int *n);
+void vvtanf(float *y, const float *x, const int *n);
+void vvsqrtf(float *y, const float *x, const int *n);
+void vvrecf(float *y, const float *x, const int *n);
+void vvfabsf(float *y, const float *x, const int *n);
+void vvfloorf(float *y, const float *x, const int *n);
+void vvceilf(float *y, const float *x, const int *n);
+
+// z = fmod(y, x)
+void vvfmodf(float *z, const float *y, const float *x, const int *n);
+
+// z = x ^ (*y)
+void vvpowsf(float *z, const float *y, const float *x, const int *n);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMCrossPlatformVDSP_h */
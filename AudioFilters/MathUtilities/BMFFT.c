@@ -8,19 +8,31 @@
 
 #include "BMFFT.h"
 #include "BMIntegerMath.h"
+#include <stdlib.h>
+#include <assert.h>
 
 
 
 
 void BMFFT_init(BMFFT *This, size_t maxInputLength){
 
-    assert(isPowerOfTwo(maxInputLength));
+    assert(isPowerOfTwo(maxInputLength) || BMFFTPlan_isSupportedLength(maxInputLength));
     
     This->maxInputLength = maxInputLength;
     size_t maxOutputLength = maxInputLength / 2;
     
-    // find out how many levels of fft recursion the FFT setup will require
-    This->recursionLevels = log2i((int)maxInputLength);
+    // find out how many levels of fft recursion the FFT setup will require.
+    // If maxInputLength is not a power of two, the vDSP setup is for the
+    // largest power of two below it.
+    size_t maxPowerOfTwoLength = maxInputLength;
+    while(!isPowerOfTwo(maxPowerOfTwoLength))
+        maxPowerOfTwoLength &= maxPowerOfTwoLength - 1;
+    This->recursionLevels = log2i((uint32_t)maxPowerOfTwoLength);
+    
+    // the plan is set at the end of this function if maxInputLength is not
+    // a power of two
+    This->plan = NULL;
+    This->batchBuffer = NULL;
     
     // allocate memory for buffers
     //input
@@ -47,6 +59,36 @@ void BMFFT_init(BMFFT *This, size_t maxInputLength){
     This->window = malloc(sizeof(float)*maxInputLength);
     vDSP_hamm_window(This->window, maxInputLength, 0);
     This->windowCurrentLength = maxInputLength;
+    
+    // acquire the mixed radix plan here so that it is ready before the
+    // first call on the audio thread
+    if(!isPowerOfTwo(maxInputLength))
+        BMFFT_setPlanLength(This, maxInputLength);
+}
+
+
+
+
+void BMFFT_setPlanLength(BMFFT *This, size_t length){
+    assert(BMFFTPlan_isSupportedLength(length));
+    assert(length <= This->maxInputLength);
+    
+    if(This->plan && This->plan->length == length)
+        return;
+    
+    if(This->plan) BMFFTPlan_release(This->plan);
+    This->plan = BMFFTPlan_acquire(length);
+    
+    // allocate the batch buffers for the longest plan this struct can use
+    // so that they never need to be reallocated
+    if(!This->batchBuffer){
+        size_t batchLength = BMFFTPLAN_BATCH_SIZE * (This->maxInputLength / 2);
+        This->batchBuffer = malloc(sizeof(float) * 4 * batchLength);
+        This->batchTemp1.realp = This->batchBuffer;
+        This->batchTemp1.imagp = This->batchBuffer + batchLength;
+        This->batchTemp2.realp = This->batchBuffer + 2*batchLength;
+        This->batchTemp2.imagp = This->batchBuffer + 3*batchLength;
+    }
 }
 
 
@@ -56,6 +98,10 @@ void BMFFT_init(BMFFT *This, size_t maxInputLength){
 
 void BMFFT_free(BMFFT *This){
     vDSP_destroy_fftsetup(This->setup);
+    if(This->plan){
+        BMFFTPlan_release(This->plan);
+        This->plan = NULL;
+    }
     
     free(This->fft_input_buffer_i);
     free(This->fft_input_buffer_r);
@@ -64,6 +110,7 @@ void BMFFT_free(BMFFT *This){
     free(This->fft_buffer_buffer_i);
     free(This->fft_buffer_buffer_r);
     free(This->window);
+    free(This->batchBuffer);
     
     This->fft_input_buffer_i = NULL;
     This->fft_input_buffer_r = NULL;
@@ -72,6 +119,20 @@ void BMFFT_free(BMFFT *This){
     This->fft_buffer_buffer_i = NULL;
     This->fft_buffer_buffer_r = NULL;
     This->window = NULL;
+    This->batchBuffer = NULL;
+}
+
+
+
+
+/*!
+ *BMFFT_getPlan
+ *
+ * @returns the mixed radix plan for length. This runs on the audio thread so it doesn't acquire plans; call BMFFT_setPlanLength first.
+ */
+static const BMFFTPlan* BMFFT_getPlan(BMFFT *This, size_t length){
+    assert(This->plan && This->plan->length == length);
+    return This->plan;
 }
 
 
@@ -83,9 +144,14 @@ void BMFFT_FFTComplexOutput(BMFFT *This,
                       size_t inputLength){
     // require the input length to meet the requirements of the FFT setup struct
     assert(inputLength <= This->maxInputLength);
-    assert(isPowerOfTwo(inputLength));
     assert(inputLength > 0);
     
+    // use a mixed radix plan for lengths that are not powers of two
+    if(!isPowerOfTwo(inputLength)){
+        BMFFTPlan_forward(BMFFT_getPlan(This, inputLength), input, output, &This->fft_buffer);
+        return;
+    }
+    
     // copy the input to the packed complex array that the fft algo uses
     size_t outputLength = inputLength / 2;
     vDSP_ctoz((DSPComplex *) input, 2, &This->fft_input, 1, outputLength);
@@ -99,6 +165,61 @@ void BMFFT_FFTComplexOutput(BMFFT *This,
 
 
 
+void BMFFT_IFFTComplexInput(BMFFT *This,
+                            const DSPSplitComplex *input,
+                            float* output,
+                            size_t outputLength){
+    // require the output length to meet the requirements of the FFT setup struct
+    assert(outputLength <= This->maxInputLength);
+    assert(outputLength > 0);
+    
+    // use a mixed radix plan for lengths that are not powers of two
+    if(!isPowerOfTwo(outputLength)){
+        BMFFTPlan_inverse(BMFFT_getPlan(This, outputLength), input, output, &This->fft_input, &This->fft_buffer);
+        return;
+    }
+    
+    // calculate the inverse fft into the input buffer, which we use here as
+    // temp storage
+    size_t recursionLevels = log2i((uint32_t)outputLength);
+    vDSP_fft_zropt(This->setup, input, 1, &This->fft_input, 1, &This->fft_buffer, recursionLevels, FFT_INVERSE);
+    
+    // copy the result from packed complex format to the real output
+    size_t complexLength = outputLength / 2;
+    vDSP_ztoc(&This->fft_input, 1, (DSPComplex *) output, 2, complexLength);
+    
+    // the forward and inverse transforms together scale by 2 * outputLength.
+    // Undo that scaling here.
+    float scale = 1.0f / (2.0f * (float)outputLength);
+    vDSP_vsmul(output, 1, &scale, output, 1, outputLength);
+}
+
+
+
+
+
+void BMFFT_FFTComplexOutputBatch(BMFFT *This,
+                                 const float* input,
+                                 size_t inputStride,
+                                 DSPSplitComplex *outputs,
+                                 size_t numFrames,
+                                 size_t inputLength){
+    assert(inputLength <= This->maxInputLength);
+    assert(inputLength > 0);
+    
+    if(!isPowerOfTwo(inputLength)){
+        BMFFTPlan_forwardBatch(BMFFT_getPlan(This, inputLength), input, inputStride, outputs, numFrames, &This->batchTemp1, &This->batchTemp2);
+        return;
+    }
+    
+    for(size_t i=0; i<numFrames; i++)
+        BMFFT_FFTComplexOutput(This, input + i*inputStride, &outputs[i], inputLength);
+}
+
+
+
+
+
 void BMFFT_absFFTCombinedDCNQ(BMFFT *This,
                               const float* input,
                               float* output,
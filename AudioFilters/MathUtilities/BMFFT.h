@@ -10,7 +10,12 @@
 #define BMFFT_h
 
 #include <stdio.h>
+#ifdef __APPLE__
 #import <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+#include "BMFFTPlan.h"
 
 enum BMFFTWindowType {BMFFT_NONE,BMFFT_BLACKMANHARRIS,BMFFT_HAMMING,BMFFT_KAISER,BMFFT_HANN};
 
@@ -31,6 +36,13 @@ typedef struct BMFFT {
 	
 	size_t recursionLevels;
 	
+	// mixed radix plan for the length set by BMFFT_setPlanLength, or NULL
+	const BMFFTPlan *plan;
+	
+	// temp buffers for BMFFTPlan_forwardBatch, allocated with the first plan
+	float* batchBuffer;
+	DSPSplitComplex batchTemp1, batchTemp2;
+	
 	float* window;
 	size_t windowCurrentLength;
 	
@@ -40,9 +52,23 @@ typedef struct BMFFT {
 
 /*!
  *BMFFT_init
+ *
+ * @param This pointer to an uninitialised struct
+ * @param maxInputLength the longest FFT this struct will compute. Powers of two use the vDSP FFT. Other lengths supported by BMFFTPlan use a mixed radix plan from the shared plan cache. If maxInputLength is not a power of two its plan is acquired here.
  */
 void BMFFT_init(BMFFT *This, size_t maxInputLength);
 
+
+/*!
+ *BMFFT_setPlanLength
+ *
+ * @abstract get the mixed radix plan for a length that is not a power of two, so that the FFT functions can use it. Each struct holds one plan at a time; calling this with a new length releases the previous plan. This takes a lock and may allocate memory so don't call it on the audio thread.
+ *
+ * @param This pointer to an initialised struct
+ * @param length a length for which BMFFTPlan_isSupportedLength is true, such that length <= This->maxInputLength
+ */
+void BMFFT_setPlanLength(BMFFT *This, size_t length);
+
 /*!
  *BMFFT_free
  */
@@ -57,7 +83,7 @@ void BMFFT_free(BMFFT *This);
  * @param This pointer to an uninitialised struct
  * @param input real valued input array of length inputLength
  * @param output a complex-valued array of length inputLength / 2
- * @param inputLength a power of 2 such that 0 < inputLength <= This->maxInputLength
+ * @param inputLength a power of 2 such that 0 < inputLength <= This->maxInputLength, or the length of the plan set by BMFFT_init or BMFFT_setPlanLength
  */
 void BMFFT_FFTComplexOutput(BMFFT *This,
 							const float* input,
@@ -66,6 +92,44 @@ void BMFFT_FFTComplexOutput(BMFFT *This,
 
 
 
+/*!
+ *BMFFT_IFFTComplexInput
+ *
+ * calculates real-valued output from complex input. This is the inverse of BMFFT_FFTComplexOutput, including scaling, so the input should be formatted in the same way as the output of that function, with the Nyquist term stored in input[0].imag.
+ *
+ * @param This pointer to an initialised struct
+ * @param input a complex-valued array of length outputLength / 2. This is not modified.
+ * @param output real valued output array of length outputLength
+ * @param outputLength a power of 2 such that 0 < outputLength <= This->maxInputLength, or the length of the plan set by BMFFT_init or BMFFT_setPlanLength
+ */
+void BMFFT_IFFTComplexInput(BMFFT *This,
+							const DSPSplitComplex *input,
+							float* output,
+							size_t outputLength);
+
+
+
+/*!
+ *BMFFT_FFTComplexOutputBatch
+ *
+ * calculates the FFTs of numFrames frames of the same length, with the output formatted as in BMFFT_FFTComplexOutput. Mixed radix lengths use BMFFTPlan_forwardBatch, which transforms several frames together. Powers of two call the vDSP FFT once per frame.
+ *
+ * @param This pointer to an initialised struct
+ * @param input the first input frame. Each frame has length inputLength.
+ * @param inputStride distance between the starts of consecutive frames, in samples. This may be less than inputLength for overlapping frames.
+ * @param outputs array of numFrames complex outputs, each of length inputLength / 2
+ * @param numFrames number of frames
+ * @param inputLength length of each frame, as in BMFFT_FFTComplexOutput
+ */
+void BMFFT_FFTComplexOutputBatch(BMFFT *This,
+								 const float* input,
+								 size_t inputStride,
+								 DSPSplitComplex *outputs,
+								 size_t numFrames,
+								 size_t inputLength);
+
+
+
 /*!
  *BMFFT_absFFTCombinedDCNQ
  *
@@ -0,0 +1,530 @@
+//
+//  BMFFTPlan.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMFFTPlan.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// The plan cache is a linked list because a program rarely uses more than
+// a few different FFT lengths.
+static BMFFTPlan *BMFFTPlanCache = NULL;
+static pthread_mutex_t BMFFTPlanCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+
+#pragma mark - lengths
+
+bool BMFFTPlan_isSupportedLength(size_t length){
+	if(length < 2 || length % 2 != 0) return false;
+
+	size_t n = length / 2;
+	while(n % 2 == 0) n /= 2;
+	while(n % 3 == 0) n /= 3;
+	while(n % 5 == 0) n /= 5;
+	return n == 1;
+}
+
+
+
+
+size_t BMFFTPlan_nextSupportedLength(size_t length){
+	size_t n = BM_MAX(length + (length % 2), (size_t)2);
+	while(!BMFFTPlan_isSupportedLength(n)) n += 2;
+	return n;
+}
+
+
+
+
+size_t BMFFTPlan_nearestSupportedLength(float length){
+	if(length <= 2.0f) return 2;
+
+	size_t upper = BMFFTPlan_nextSupportedLength((size_t)ceilf(length));
+	size_t lower = (size_t)floorf(length);
+	lower -= lower % 2;
+	while(!BMFFTPlan_isSupportedLength(lower)) lower -= 2;
+
+	return length - (float)lower < (float)upper - length ? lower : upper;
+}
+
+
+
+
+#pragma mark - plan setup
+
+static void BMFFTPlan_init(BMFFTPlan *This, size_t length){
+	assert(BMFFTPlan_isSupportedLength(length));
+
+	This->length = length;
+	This->complexLength = length / 2;
+	This->referenceCount = 0;
+	This->next = NULL;
+
+	// factor the complex length, using radix 4 where possible because it
+	// takes fewer operations per sample than radix 2
+	size_t n = This->complexLength;
+	This->numPasses = 0;
+	while(n % 4 == 0){ This->radix[This->numPasses++] = 4; n /= 4; }
+	if(n % 2 == 0){ This->radix[This->numPasses++] = 2; n /= 2; }
+	while(n % 3 == 0){ This->radix[This->numPasses++] = 3; n /= 3; }
+	while(n % 5 == 0){ This->radix[This->numPasses++] = 5; n /= 5; }
+	assert(n == 1 && This->numPasses <= BMFFTPLAN_MAX_PASSES);
+
+	// count the twiddle factors so we can allocate them all at once
+	size_t numTwiddles = This->complexLength;
+	n = This->complexLength;
+	for(size_t i=0; i<This->numPasses; i++){
+		size_t m = n / This->radix[i];
+		numTwiddles += m * (This->radix[i] - 1);
+		n = m;
+	}
+	This->memory = malloc(sizeof(float) * 2 * numTwiddles);
+	float *m = This->memory;
+
+	// twiddle factors for each pass
+	n = This->complexLength;
+	for(size_t i=0; i<This->numPasses; i++){
+		size_t r = This->radix[i];
+		size_t subLength = n / r;
+		This->twiddles[i].realp = m;
+		This->twiddles[i].imagp = m + subLength * (r - 1);
+		m += 2 * subLength * (r - 1);
+		for(size_t p=0; p<subLength; p++)
+			for(size_t k=1; k<r; k++){
+				double theta = -2.0 * M_PI * (double)(p*k) / (double)n;
+				This->twiddles[i].realp[p*(r-1) + k-1] = (float)cos(theta);
+				This->twiddles[i].imagp[p*(r-1) + k-1] = (float)sin(theta);
+			}
+		n = subLength;
+	}
+
+	// twiddle factors for the real transform
+	This->realTwiddles.realp = m;
+	This->realTwiddles.imagp = m + This->complexLength;
+	for(size_t k=0; k<This->complexLength; k++){
+		double theta = -2.0 * M_PI * (double)k / (double)length;
+		This->realTwiddles.realp[k] = (float)cos(theta);
+		This->realTwiddles.imagp[k] = (float)sin(theta);
+	}
+}
+
+
+
+
+const BMFFTPlan* BMFFTPlan_acquire(size_t length){
+	pthread_mutex_lock(&BMFFTPlanCacheLock);
+
+	// look for an existing plan
+	BMFFTPlan *plan = BMFFTPlanCache;
+	while(plan && plan->length != length)
+		plan = plan->next;
+
+	// create a new one if necessary
+	if(!plan){
+		plan = malloc(sizeof(BMFFTPlan));
+		BMFFTPlan_init(plan, length);
+		plan->next = BMFFTPlanCache;
+		BMFFTPlanCache = plan;
+	}
+
+	plan->referenceCount++;
+
+	pthread_mutex_unlock(&BMFFTPlanCacheLock);
+	return plan;
+}
+
+
+
+
+void BMFFTPlan_release(const BMFFTPlan *plan){
+	pthread_mutex_lock(&BMFFTPlanCacheLock);
+
+	// find the plan in the cache
+	BMFFTPlan **p = &BMFFTPlanCache;
+	while(*p && *p != plan)
+		p = &(*p)->next;
+	assert(*p && "plan was not acquired from the cache");
+
+	// free it if no one else is using it
+	BMFFTPlan *found = *p;
+	found->referenceCount--;
+	if(found->referenceCount == 0){
+		*p = found->next;
+		free(found->memory);
+		free(found);
+	}
+
+	pthread_mutex_unlock(&BMFFTPlanCacheLock);
+}
+
+
+
+
+#pragma mark - complex transform
+
+/*
+ * Each pass takes a sequence of s interleaved sub-transforms of length
+ * n = r*m and does one radix r step of decimation in frequency on each,
+ * leaving r*s interleaved sub-transforms of length m. The outputs are
+ * written in the order that puts the final result in natural order, so
+ * there is no bit reversal.
+ *
+ * Input element j of butterfly (p,q) is x[q + s*(p + j*m)] and output k
+ * goes to y[q + s*(r*p + k)], multiplied by the twiddle factor w[p][k-1].
+ * Since q is the inner loop the loads and stores are contiguous when s
+ * is large.
+ */
+
+static void BMFFTPlan_pass2(size_t m, size_t s,
+							const float* restrict xr, const float* restrict xi,
+							float* restrict yr, float* restrict yi,
+							const float* restrict wr, const float* restrict wi){
+	for(size_t p=0; p<m; p++){
+		float w1r = wr[p], w1i = wi[p];
+		const float *x0r = xr + s*p, *x0i = xi + s*p;
+		const float *x1r = x0r + s*m, *x1i = x0i + s*m;
+		float *y0r = yr + s*2*p, *y0i = yi + s*2*p;
+		float *y1r = y0r + s, *y1i = y0i + s;
+		for(size_t q=0; q<s; q++){
+			float c1r = x0r[q] - x1r[q], c1i = x0i[q] - x1i[q];
+			y0r[q] = x0r[q] + x1r[q];
+			y0i[q] = x0i[q] + x1i[q];
+			y1r[q] = c1r*w1r - c1i*w1i;
+			y1i[q] = c1r*w1i + c1i*w1r;
+		}
+	}
+}
+
+
+
+
+static void BMFFTPlan_pass3(size_t m, size_t s,
+							const float* restrict xr, const float* restrict xi,
+							float* restrict yr, float* restrict yi,
+							const float* restrict wr, const float* restrict wi){
+	const float sin60 = 0.866025403784438646763723170752936183f;
+	for(size_t p=0; p<m; p++){
+		float w1r = wr[2*p], w1i = wi[2*p];
+		float w2r = wr[2*p+1], w2i = wi[2*p+1];
+		const float *x0r = xr + s*p, *x0i = xi + s*p;
+		const float *x1r = x0r + s*m, *x1i = x0i + s*m;
+		const float *x2r = x1r + s*m, *x2i = x1i + s*m;
+		float *y0r = yr + s*3*p, *y0i = yi + s*3*p;
+		float *y1r = y0r + s, *y1i = y0i + s;
+		float *y2r = y1r + s, *y2i = y1i + s;
+		for(size_t q=0; q<s; q++){
+			float t1r = x1r[q] + x2r[q], t1i = x1i[q] + x2i[q];
+			float t2r = x0r[q] - 0.5f*t1r, t2i = x0i[q] - 0.5f*t1i;
+			// -i sin(60) (x1 - x2)
+			float t3r = sin60 * (x1i[q] - x2i[q]);
+			float t3i = -sin60 * (x1r[q] - x2r[q]);
+			float c1r = t2r + t3r, c1i = t2i + t3i;
+			float c2r = t2r - t3r, c2i = t2i - t3i;
+			y0r[q] = x0r[q] + t1r;
+			y0i[q] = x0i[q] + t1i;
+			y1r[q] = c1r*w1r - c1i*w1i;
+			y1i[q] = c1r*w1i + c1i*w1r;
+			y2r[q] = c2r*w2r - c2i*w2i;
+			y2i[q] = c2r*w2i + c2i*w2r;
+		}
+	}
+}
+
+
+
+
+static void BMFFTPlan_pass4(size_t m, size_t s,
+							const float* restrict xr, const float* restrict xi,
+							float* restrict yr, float* restrict yi,
+							const float* restrict wr, const float* restrict wi){
+	for(size_t p=0; p<m; p++){
+		float w1r = wr[3*p], w1i = wi[3*p];
+		float w2r = wr[3*p+1], w2i = wi[3*p+1];
+		float w3r = wr[3*p+2], w3i = wi[3*p+2];
+		const float *x0r = xr + s*p, *x0i = xi + s*p;
+		const float *x1r = x0r + s*m, *x1i = x0i + s*m;
+		const float *x2r = x1r + s*m, *x2i = x1i + s*m;
+		const float *x3r = x2r + s*m, *x3i = x2i + s*m;
+		float *y0r = yr + s*4*p, *y0i = yi + s*4*p;
+		float *y1r = y0r + s, *y1i = y0i + s;
+		float *y2r = y1r + s, *y2i = y1i + s;
+		float *y3r = y2r + s, *y3i = y2i + s;
+		for(size_t q=0; q<s; q++){
+			float t0r = x0r[q] + x2r[q], t0i = x0i[q] + x2i[q];
+			float t1r = x0r[q] - x2r[q], t1i = x0i[q] - x2i[q];
+			float t2r = x1r[q] + x3r[q], t2i = x1i[q] + x3i[q];
+			// -i (x1 - x3)
+			float t3r = x1i[q] - x3i[q], t3i = x3r[q] - x1r[q];
+			float c1r = t1r + t3r, c1i = t1i + t3i;
+			float c2r = t0r - t2r, c2i = t0i - t2i;
+			float c3r = t1r - t3r, c3i = t1i - t3i;
+			y0r[q] = t0r + t2r;
+			y0i[q] = t0i + t2i;
+			y1r[q] = c1r*w1r - c1i*w1i;
+			y1i[q] = c1r*w1i + c1i*w1r;
+			y2r[q] = c2r*w2r - c2i*w2i;
+			y2i[q] = c2r*w2i + c2i*w2r;
+			y3r[q] = c3r*w3r - c3i*w3i;
+			y3i[q] = c3r*w3i + c3i*w3r;
+		}
+	}
+}
+
+
+
+
+static void BMFFTPlan_pass5(size_t m, size_t s,
+							const float* restrict xr, const float* restrict xi,
+							float* restrict yr, float* restrict yi,
+							const float* restrict wr, const float* restrict wi){
+	const float cos72 = 0.309016994374947424102293417182819059f;
+	const float cos144 = -0.809016994374947424102293417182819059f;
+	const float sin72 = 0.951056516295153572116439333379382143f;
+	const float sin144 = 0.587785252292473129168705954639072769f;
+	for(size_t p=0; p<m; p++){
+		float w1r = wr[4*p], w1i = wi[4*p];
+		float w2r = wr[4*p+1], w2i = wi[4*p+1];
+		float w3r = wr[4*p+2], w3i = wi[4*p+2];
+		float w4r = wr[4*p+3], w4i = wi[4*p+3];
+		const float *x0r = xr + s*p, *x0i = xi + s*p;
+		const float *x1r = x0r + s*m, *x1i = x0i + s*m;
+		const float *x2r = x1r + s*m, *x2i = x1i + s*m;
+		const float *x3r = x2r + s*m, *x3i = x2i + s*m;
+		const float *x4r = x3r + s*m, *x4i = x3i + s*m;
+		float *y0r = yr + s*5*p, *y0i = yi + s*5*p;
+		float *y1r = y0r + s, *y1i = y0i + s;
+		float *y2r = y1r + s, *y2i = y1i + s;
+		float *y3r = y2r + s, *y3i = y2i + s;
+		float *y4r = y3r + s, *y4i = y3i + s;
+		for(size_t q=0; q<s; q++){
+			float b1r = x1r[q] + x4r[q], b1i = x1i[q] + x4i[q];
+			float b2r = x2r[q] + x3r[q], b2i = x2i[q] + x3i[q];
+			float d1r = x1r[q] - x4r[q], d1i = x1i[q] - x4i[q];
+			float d2r = x2r[q] - x3r[q], d2i = x2i[q] - x3i[q];
+
+			// real parts of the outputs, before the imaginary terms
+			float a1r = x0r[q] + cos72*b1r + cos144*b2r;
+			float a1i = x0i[q] + cos72*b1i + cos144*b2i;
+			float a2r = x0r[q] + cos144*b1r + cos72*b2r;
+			float a2i = x0i[q] + cos144*b1i + cos72*b2i;
+
+			// e1 = sin72 d1 + sin144 d2, e2 = sin144 d1 - sin72 d2. Outputs
+			// 1 and 2 subtract i e, outputs 4 and 3 add it.
+			float e1r = sin72*d1r + sin144*d2r, e1i = sin72*d1i + sin144*d2i;
+			float e2r = sin144*d1r - sin72*d2r, e2i = sin144*d1i - sin72*d2i;
+
+			float c1r = a1r + e1i, c1i = a1i - e1r;
+			float c4r = a1r - e1i, c4i = a1i + e1r;
+			float c2r = a2r + e2i, c2i = a2i - e2r;
+			float c3r = a2r - e2i, c3i = a2i + e2r;
+
+			y0r[q] = x0r[q] + b1r + b2r;
+			y0i[q] = x0i[q] + b1i + b2i;
+			y1r[q] = c1r*w1r - c1i*w1i;
+			y1i[q] = c1r*w1i + c1i*w1r;
+			y2r[q] = c2r*w2r - c2i*w2i;
+			y2i[q] = c2r*w2i + c2i*w2r;
+			y3r[q] = c3r*w3r - c3i*w3i;
+			y3i[q] = c3r*w3i + c3i*w3r;
+			y4r[q] = c4r*w4r - c4i*w4i;
+			y4i[q] = c4r*w4i + c4i*w4r;
+		}
+	}
+}
+
+
+
+
+/*!
+ *BMFFTPlan_complexFFT
+ *
+ * @abstract unscaled forward complex FFT of length complexLength, alternating between a and b
+ *
+ * @param numTransforms number of transforms interleaved in a. Element k of transform q is at index q + k*numTransforms. The passes already treat their input as interleaved sub-transforms so this costs nothing extra and it makes the inner loops longer.
+ *
+ * @returns a or b, whichever holds the result
+ */
+static DSPSplitComplex* BMFFTPlan_complexFFT(const BMFFTPlan *This, size_t numTransforms, DSPSplitComplex *a, DSPSplitComplex *b){
+	DSPSplitComplex *x = a, *y = b;
+	size_t n = This->complexLength;
+	size_t s = numTransforms;
+	for(size_t i=0; i<This->numPasses; i++){
+		size_t r = This->radix[i];
+		size_t m = n / r;
+		const float *wr = This->twiddles[i].realp;
+		const float *wi = This->twiddles[i].imagp;
+		switch(r){
+			case 2: BMFFTPlan_pass2(m, s, x->realp, x->imagp, y->realp, y->imagp, wr, wi); break;
+			case 3: BMFFTPlan_pass3(m, s, x->realp, x->imagp, y->realp, y->imagp, wr, wi); break;
+			case 4: BMFFTPlan_pass4(m, s, x->realp, x->imagp, y->realp, y->imagp, wr, wi); break;
+			case 5: BMFFTPlan_pass5(m, s, x->realp, x->imagp, y->realp, y->imagp, wr, wi); break;
+		}
+		n = m;
+		s *= r;
+		DSPSplitComplex *t = x; x = y; y = t;
+	}
+	return x;
+}
+
+
+
+
+#pragma mark - real transform
+
+/*!
+ *BMFFTPlan_separateReal
+ *
+ * @abstract convert the complex FFT Z of the packed real input to the FFT of the real input, in the output format of BMFFT_FFTComplexOutput
+ *
+ * @param zr      real part of the complex FFT Z, of length complexLength. Z may be the same as output.
+ * @param zi      imaginary part of Z
+ * @param stride  distance between consecutive elements of Z
+ * @param output  complex output array of length complexLength
+ */
+static void BMFFTPlan_separateReal(const BMFFTPlan *This,
+								   const float *zr, const float *zi,
+								   size_t stride,
+								   DSPSplitComplex *output){
+	size_t M = This->complexLength;
+
+	// Separate the transforms of the even and odd samples and combine them
+	// to get the transform of the real input. Each pair of outputs k and
+	// M-k depends only on Z[k] and Z[M-k] so this works whether or not Z
+	// is the same as the output.
+	//
+	//     2X[k] = P - iQW^k,
+	//
+	// where P = Z[k] + conj(Z[M-k]) and Q = Z[k] - conj(Z[M-k]). The
+	// factor of 2 matches the scaling of the vDSP FFT.
+	const float *wr = This->realTwiddles.realp;
+	const float *wi = This->realTwiddles.imagp;
+	float z0r = zr[0], z0i = zi[0];
+	for(size_t k=1; k<=M/2; k++){
+		float ar = zr[k*stride], ai = zi[k*stride];
+		float br = zr[(M-k)*stride], bi = zi[(M-k)*stride];
+		float pr = ar + br, pi = ai - bi;
+		float qr0 = ar - br, qi0 = ai + bi;
+		float qr = qr0*wr[k] - qi0*wi[k];
+		float qi = qr0*wi[k] + qi0*wr[k];
+		output->realp[k] = pr + qi;
+		output->imagp[k] = pi - qr;
+		output->realp[M-k] = pr - qi;
+		output->imagp[M-k] = -pi - qr;
+	}
+
+	// DC and Nyquist
+	output->realp[0] = 2.0f * (z0r + z0i);
+	output->imagp[0] = 2.0f * (z0r - z0i);
+}
+
+
+
+
+void BMFFTPlan_forward(const BMFFTPlan *This,
+					   const float *input,
+					   DSPSplitComplex *output,
+					   DSPSplitComplex *temp){
+	size_t M = This->complexLength;
+
+	// pack the even samples into the real part and the odd samples into the
+	// imaginary part and take the complex FFT of length M
+	vDSP_ctoz((const DSPComplex *)input, 2, output, 1, M);
+	DSPSplitComplex *Z = BMFFTPlan_complexFFT(This, 1, output, temp);
+
+	BMFFTPlan_separateReal(This, Z->realp, Z->imagp, 1, output);
+}
+
+
+
+
+void BMFFTPlan_inverse(const BMFFTPlan *This,
+					   const DSPSplitComplex *input,
+					   float *output,
+					   DSPSplitComplex *temp1,
+					   DSPSplitComplex *temp2){
+	size_t M = This->complexLength;
+
+	// combine the spectra of the even and odd samples into the spectrum of
+	// the complex sequence x[2n] + i x[2n+1], scaled by 4.
+	//
+	//     4Z[k] = P + iQW^-k
+	const float *wr = This->realTwiddles.realp;
+	const float *wi = This->realTwiddles.imagp;
+	for(size_t k=1; k<=M/2; k++){
+		float ar = input->realp[k], ai = input->imagp[k];
+		float br = input->realp[M-k], bi = input->imagp[M-k];
+		float pr = ar + br, pi = ai - bi;
+		float qr0 = ar - br, qi0 = ai + bi;
+		float qr = qr0*wr[k] + qi0*wi[k];
+		float qi = -qr0*wi[k] + qi0*wr[k];
+		temp1->realp[k] = pr - qi;
+		temp1->imagp[k] = pi + qr;
+		temp1->realp[M-k] = pr + qi;
+		temp1->imagp[M-k] = -pi + qr;
+	}
+	temp1->realp[0] = input->realp[0] + input->imagp[0];
+	temp1->imagp[0] = input->realp[0] - input->imagp[0];
+
+	// The inverse FFT is the forward FFT with the real and imaginary parts
+	// swapped at the input and output. Swapping the pointers does that
+	// without moving any data, and the result comes out unswapped.
+	DSPSplitComplex swapped1 = {temp1->imagp, temp1->realp};
+	DSPSplitComplex swapped2 = {temp2->imagp, temp2->realp};
+	DSPSplitComplex *z = BMFFTPlan_complexFFT(This, 1, &swapped1, &swapped2) == &swapped1 ? temp1 : temp2;
+
+	// unpack and undo the scaling of 2 * length
+	vDSP_ztoc(z, 1, (DSPComplex *)output, 2, M);
+	float scale = 1.0f / (2.0f * (float)This->length);
+	vDSP_vsmul(output, 1, &scale, output, 1, This->length);
+}
+
+
+
+
+void BMFFTPlan_forwardBatch(const BMFFTPlan *This,
+							const float *input,
+							size_t inputStride,
+							DSPSplitComplex *outputs,
+							size_t numFrames,
+							DSPSplitComplex *temp1,
+							DSPSplitComplex *temp2){
+	size_t M = This->complexLength;
+
+	for(size_t i=0; i<numFrames; i += BMFFTPLAN_BATCH_SIZE){
+		size_t numFramesThisBatch = BM_MIN(BMFFTPLAN_BATCH_SIZE, numFrames - i);
+
+		// pack the frames of this batch into temp1, interleaved so that
+		// sample k of frame f is at index f + k*numFramesThisBatch
+		for(size_t f=0; f<numFramesThisBatch; f++){
+			DSPSplitComplex packed = {temp1->realp + f, temp1->imagp + f};
+			vDSP_ctoz((const DSPComplex *)(input + (i+f)*inputStride), 2, &packed, numFramesThisBatch, M);
+		}
+
+		// transform all the frames in one pass through the twiddle factors
+		DSPSplitComplex *Z = BMFFTPlan_complexFFT(This, numFramesThisBatch, temp1, temp2);
+
+		// separate each frame into its own output
+		for(size_t f=0; f<numFramesThisBatch; f++)
+			BMFFTPlan_separateReal(This, Z->realp + f, Z->imagp + f, numFramesThisBatch, &outputs[i+f]);
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,180 @@
+//
+//  BMFFTPlan.h
+//  AudioFiltersXcodeProject
+//
+//  Real FFT plans for lengths that are not powers of two.
+//
+//  A plan computes the real FFT of length N, where N is even and N/2 has no
+//  prime factors other than 2, 3 and 5. For example 384, 480, 600, 768,
+//  960, 1000 and 1536 are all supported. The real transform is computed
+//  with a complex transform of length N/2 using mixed radix 4, 2, 3 and 5
+//  passes in Stockham order, so no bit reversal step is needed.
+//
+//  The input and output are formatted exactly as in BMFFT_FFTComplexOutput
+//  and BMFFT_IFFTComplexInput, including the scaling, so the output of a
+//  plan of length 1024 is the same as that of the vDSP FFT.
+//
+//  Plans are read-only after they are created so one plan can be used by
+//  any number of threads at once. Each thread must provide its own temp
+//  buffers. Use BMFFTPlan_acquire to get a plan from the cache shared by
+//  the whole process, so that objects that use the same FFT length share
+//  the twiddle factors instead of computing and storing them again.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMFFTPlan_h
+#define BMFFTPlan_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// maximum number of radix passes. 2^32 has 16 factors of 4.
+#define BMFFTPLAN_MAX_PASSES 32
+
+// number of frames BMFFTPlan_forwardBatch transforms together
+#define BMFFTPLAN_BATCH_SIZE 4
+
+typedef struct BMFFTPlan {
+	// length of the real input
+	size_t length;
+
+	// length of the complex transform, length/2
+	size_t complexLength;
+
+	// radix of each pass
+	size_t radix [BMFFTPLAN_MAX_PASSES];
+	size_t numPasses;
+
+	// twiddle factors for each pass, [p][k-1] for 0 <= p < m, 1 <= k < radix
+	// where m is the length of the sub-transforms after the pass
+	DSPSplitComplex twiddles [BMFFTPLAN_MAX_PASSES];
+
+	// twiddle factors for converting between the complex and real
+	// transforms, exp(-2 pi i k / length) for 0 <= k < complexLength
+	DSPSplitComplex realTwiddles;
+
+	float *memory;
+
+	// used by the plan cache
+	size_t referenceCount;
+	struct BMFFTPlan *next;
+} BMFFTPlan;
+
+
+
+/*!
+ *BMFFTPlan_isSupportedLength
+ *
+ * @returns true if length is even and length/2 has no prime factors other than 2, 3 and 5
+ */
+bool BMFFTPlan_isSupportedLength(size_t length);
+
+
+/*!
+ *BMFFTPlan_nextSupportedLength
+ *
+ * @returns the smallest supported length >= length
+ */
+size_t BMFFTPlan_nextSupportedLength(size_t length);
+
+
+/*!
+ *BMFFTPlan_nearestSupportedLength
+ *
+ * @returns the supported length closest to length
+ */
+size_t BMFFTPlan_nearestSupportedLength(float length);
+
+
+/*!
+ *BMFFTPlan_acquire
+ *
+ * @abstract get a plan from the shared cache, creating it if it isn't there yet. This takes a lock and may allocate memory so don't call it on the audio thread. Call BMFFTPlan_release when you no longer need the plan.
+ *
+ * @param length a supported FFT length
+ */
+const BMFFTPlan* BMFFTPlan_acquire(size_t length);
+
+
+/*!
+ *BMFFTPlan_release
+ *
+ * @abstract release a plan obtained from BMFFTPlan_acquire. The plan is freed when it is no longer used.
+ */
+void BMFFTPlan_release(const BMFFTPlan *plan);
+
+
+/*!
+ *BMFFTPlan_forward
+ *
+ * @abstract real to complex FFT in the output format of BMFFT_FFTComplexOutput
+ *
+ * @param This    pointer to a plan
+ * @param input   real valued input array of length This->length
+ * @param output  complex output array of length This->length/2. The Nyquist term is stored in output->imagp[0].
+ * @param temp    temp buffer of length This->length/2
+ */
+void BMFFTPlan_forward(const BMFFTPlan *This,
+					   const float *input,
+					   DSPSplitComplex *output,
+					   DSPSplitComplex *temp);
+
+
+/*!
+ *BMFFTPlan_inverse
+ *
+ * @abstract complex to real inverse FFT. This is the exact inverse of BMFFTPlan_forward, including scaling, like BMFFT_IFFTComplexInput.
+ *
+ * @param This    pointer to a plan
+ * @param input   complex input array of length This->length/2. This is not modified.
+ * @param output  real valued output array of length This->length
+ * @param temp1   temp buffer of length This->length/2
+ * @param temp2   temp buffer of length This->length/2
+ */
+void BMFFTPlan_inverse(const BMFFTPlan *This,
+					   const DSPSplitComplex *input,
+					   float *output,
+					   DSPSplitComplex *temp1,
+					   DSPSplitComplex *temp2);
+
+
+/*!
+ *BMFFTPlan_forwardBatch
+ *
+ * @abstract compute the forward transform of numFrames frames of the same length, such as the columns of a spectrogram. The result is the same as calling BMFFTPlan_forward for each frame.
+ *
+ * @discussion The frames are transformed BMFFTPLAN_BATCH_SIZE at a time, interleaved so that every radix pass works on all the frames of a batch together. This loads each twiddle factor once per batch instead of once per frame and gives the early passes, which work on only one long sub-transform per frame, inner loops long enough to vectorise.
+ *
+ * @param This         pointer to a plan
+ * @param input        the first input frame. The frames are This->length samples long.
+ * @param inputStride  distance between the starts of consecutive input frames, in samples. This may be less than This->length for overlapping frames.
+ * @param outputs      array of numFrames complex outputs, each of length This->length/2
+ * @param numFrames    number of frames
+ * @param temp1        temp buffer of length BMFFTPLAN_BATCH_SIZE * This->length/2
+ * @param temp2        temp buffer of length BMFFTPLAN_BATCH_SIZE * This->length/2
+ */
+void BMFFTPlan_forwardBatch(const BMFFTPlan *This,
+							const float *input,
+							size_t inputStride,
+							DSPSplitComplex *outputs,
+							size_t numFrames,
+							DSPSplitComplex *temp1,
+							DSPSplitComplex *temp2);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMFFTPlan_h */
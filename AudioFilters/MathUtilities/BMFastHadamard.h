@@ -22,7 +22,11 @@ extern "C" {
 #include <stdbool.h>
 #include <string.h>
 #include <simd/simd.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 // forward declarations
 static void BMFastHadamard16(const float* input, float* output, float* temp16);
@@ -96,6 +100,68 @@ static __inline__ __attribute__((always_inline)) void BMFastHadamardTransformBuf
 
 
 
+/*!
+ * Fast Hadamard Transform of a block of samples, in place
+ *
+ *   Each channel is one element of the vector being transformed, so channel
+ *   buffers[i] holds the ith element at each of numSamples instants. Unlike
+ *   BMFastHadamardTransformBuffer this does not copy between stages and does
+ *   not normalise the output; the result is the same as calling
+ *   BMFastHadamardTransform on each instant. Stages are done two at a time
+ *   so that each pass over the buffers does twice as much arithmetic.
+ *
+ * @param buffers      numChannels arrays of length numSamples
+ * @param numChannels  must be a power of 2
+ * @param numSamples   length of each array
+ */
+static __inline__ __attribute__((always_inline)) void BMFastHadamardTransformBufferInPlace(float** buffers,
+																						   size_t numChannels,
+																						   size_t numSamples){
+	assert(BMPowerOfTwoQ(numChannels));
+
+	size_t h = 1;
+
+	// if the number of stages is odd, do one stage on its own
+	size_t numStages = 0;
+	while((1ul << numStages) < numChannels) numStages++;
+	if(numStages % 2 == 1){
+		for(size_t j=0; j<numChannels; j+=2){
+			float* a = buffers[j];
+			float* b = buffers[j+1];
+			for(size_t k=0; k<numSamples; k++){
+				float sum = a[k] + b[k];
+				float difference = a[k] - b[k];
+				a[k] = sum;
+				b[k] = difference;
+			}
+		}
+		h = 2;
+	}
+
+	// the remaining stages, two at a time
+	for(; h<numChannels; h*=4)
+		for(size_t i=0; i<numChannels; i+=4*h)
+			for(size_t j=i; j<i+h; j++){
+				float* a = buffers[j];
+				float* b = buffers[j+h];
+				float* c = buffers[j+2*h];
+				float* d = buffers[j+3*h];
+				for(size_t k=0; k<numSamples; k++){
+					float ab = a[k] + b[k];
+					float aMinusB = a[k] - b[k];
+					float cd = c[k] + d[k];
+					float cMinusD = c[k] - d[k];
+					a[k] = ab + cd;
+					b[k] = aMinusB + cMinusD;
+					c[k] = ab - cd;
+					d[k] = aMinusB - cMinusD;
+				}
+			}
+}
+
+
+
+
 /*!
  * Fast Hadamard Transform
  *   works in place
@@ -8,7 +8,11 @@
 
 #include "BMLagrangeInterpolation.h"
 #include <stdlib.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 float calculateH(float fractionalDelay, float n,float order);
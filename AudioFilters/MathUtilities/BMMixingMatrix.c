@@ -0,0 +1,272 @@
+//
+//  BMMixingMatrix.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMMixingMatrix.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "BMFastHadamard.h"
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static size_t BMMixingMatrix_bitReverse(size_t x, size_t numBits){
+	size_t result = 0;
+	for(size_t i=0; i<numBits; i++){
+		result = (result << 1) | (x & 1);
+		x >>= 1;
+	}
+	return result;
+}
+
+
+
+
+static void BMMixingMatrix_initCirculant(BMMixingMatrix *This){
+	size_t N = This->numChannels;
+	size_t numBits = 0;
+	while(((size_t)1 << numBits) < N) numBits++;
+
+	// twiddle factors for the forward transform, W^k = E^(-2 Pi I k / N)
+	This->twiddlesReal = malloc(sizeof(float) * N / 2);
+	This->twiddlesImag = malloc(sizeof(float) * N / 2);
+	for(size_t k=0; k<N/2; k++){
+		double angle = -2.0 * M_PI * (double)k / (double)N;
+		This->twiddlesReal[k] = cos(angle);
+		This->twiddlesImag[k] = sin(angle);
+	}
+
+	// Eigenvalues of magnitude 1 with conjugate symmetry, so that the matrix
+	// is real and orthogonal. The phases are spread out by the golden ratio.
+	double *phases = malloc(sizeof(double) * N);
+	double goldenRatio = (sqrt(5.0) - 1.0) / 2.0;
+	phases[0] = 0.0;
+	phases[N/2] = M_PI;
+	for(size_t k=1; k<N/2; k++){
+		double x = (double)k * goldenRatio;
+		phases[k] = 2.0 * M_PI * (x - floor(x));
+		phases[N-k] = -phases[k];
+	}
+
+	// store them in bit reversed order to match the output of the forward
+	// transform, with the 1/N scaling of the inverse transform
+	This->eigenvaluesReal = malloc(sizeof(float) * N);
+	This->eigenvaluesImag = malloc(sizeof(float) * N);
+	for(size_t p=0; p<N; p++){
+		size_t k = BMMixingMatrix_bitReverse(p, numBits);
+		This->eigenvaluesReal[p] = cos(phases[k]) / (double)N;
+		This->eigenvaluesImag[p] = sin(phases[k]) / (double)N;
+	}
+	free(phases);
+
+	// imaginary parts of the channels during the transform
+	This->imag = malloc(sizeof(float*) * N);
+	This->imag[0] = malloc(sizeof(float) * N * This->maxBlockSize);
+	for(size_t i=1; i<N; i++)
+		This->imag[i] = This->imag[i-1] + This->maxBlockSize;
+}
+
+
+
+
+void BMMixingMatrix_init(BMMixingMatrix *This,
+						 enum BMMixingMatrixType type,
+						 size_t numChannels,
+						 size_t maxBlockSize){
+	assert(numChannels >= 2 && numChannels <= BMMIXINGMATRIX_MAX_CHANNELS);
+	assert(type == BMMM_HOUSEHOLDER || BMPowerOfTwoQ(numChannels));
+
+	This->type = type;
+	This->numChannels = numChannels;
+	This->maxBlockSize = maxBlockSize;
+	This->sum = NULL;
+	This->eigenvaluesReal = This->eigenvaluesImag = NULL;
+	This->twiddlesReal = This->twiddlesImag = NULL;
+	This->imag = NULL;
+
+	if(type == BMMM_HOUSEHOLDER)
+		This->sum = malloc(sizeof(float) * maxBlockSize);
+	if(type == BMMM_CIRCULANT)
+		BMMixingMatrix_initCirculant(This);
+}
+
+
+
+
+void BMMixingMatrix_free(BMMixingMatrix *This){
+	free(This->sum);
+	This->sum = NULL;
+	free(This->eigenvaluesReal);
+	This->eigenvaluesReal = NULL;
+	free(This->eigenvaluesImag);
+	This->eigenvaluesImag = NULL;
+	free(This->twiddlesReal);
+	This->twiddlesReal = NULL;
+	free(This->twiddlesImag);
+	This->twiddlesImag = NULL;
+	if(This->imag){
+		free(This->imag[0]);
+		free(This->imag);
+		This->imag = NULL;
+	}
+}
+
+
+
+
+static void BMMixingMatrix_hadamard(BMMixingMatrix *This, float **buffers, size_t numSamples){
+	BMFastHadamardTransformBufferInPlace(buffers, This->numChannels, numSamples);
+
+	float scale = 1.0f / sqrtf((float)This->numChannels);
+	for(size_t i=0; i<This->numChannels; i++)
+		vDSP_vsmul(buffers[i], 1, &scale, buffers[i], 1, numSamples);
+}
+
+
+
+
+static void BMMixingMatrix_householder(BMMixingMatrix *This, float **buffers, size_t numSamples){
+	float *sum = This->sum;
+
+	// sum the channels
+	memcpy(sum, buffers[0], sizeof(float) * numSamples);
+	for(size_t i=1; i<This->numChannels; i++)
+		vDSP_vadd(sum, 1, buffers[i], 1, sum, 1, numSamples);
+
+	// subtract 2/N times the sum from each channel
+	float scale = -2.0f / (float)This->numChannels;
+	for(size_t i=0; i<This->numChannels; i++)
+		vDSP_vsma(sum, 1, &scale, buffers[i], 1, buffers[i], 1, numSamples);
+}
+
+
+
+
+/*
+ * The circulant matrix is diagonal in the Fourier basis. We take the FFT
+ * across the channels with decimation in frequency, which leaves the
+ * spectrum in bit reversed order, multiply by the eigenvalues, and take the
+ * inverse with decimation in time, which takes bit reversed input. There is
+ * no need to reorder anything in between.
+ */
+static void BMMixingMatrix_circulant(BMMixingMatrix *This, float **re, size_t numSamples){
+	size_t N = This->numChannels;
+	float **im = This->imag;
+	const float *wRe = This->twiddlesReal;
+	const float *wIm = This->twiddlesImag;
+
+	// forward transform, first stage. The input is real.
+	size_t half = N/2;
+	for(size_t j=0; j<half; j++){
+		float *ar = re[j], *ai = im[j], *br = re[j+half], *bi = im[j+half];
+		float wr = wRe[j], wi = wIm[j];
+		for(size_t k=0; k<numSamples; k++){
+			float dr = ar[k] - br[k];
+			ar[k] = ar[k] + br[k];
+			ai[k] = 0.0f;
+			br[k] = dr * wr;
+			bi[k] = dr * wi;
+		}
+	}
+
+	// forward transform, remaining stages
+	for(size_t m=N/2; m>=2; m/=2){
+		half = m/2;
+		size_t twiddleStride = N/m;
+		for(size_t start=0; start<N; start+=m)
+			for(size_t j=0; j<half; j++){
+				float *ar = re[start+j], *ai = im[start+j];
+				float *br = re[start+j+half], *bi = im[start+j+half];
+				float wr = wRe[j*twiddleStride], wi = wIm[j*twiddleStride];
+				for(size_t k=0; k<numSamples; k++){
+					float dr = ar[k] - br[k];
+					float di = ai[k] - bi[k];
+					ar[k] = ar[k] + br[k];
+					ai[k] = ai[k] + bi[k];
+					br[k] = dr * wr - di * wi;
+					bi[k] = dr * wi + di * wr;
+				}
+			}
+	}
+
+	// multiply by the eigenvalues
+	for(size_t p=0; p<N; p++){
+		float *xr = re[p], *xi = im[p];
+		float lr = This->eigenvaluesReal[p], li = This->eigenvaluesImag[p];
+		for(size_t k=0; k<numSamples; k++){
+			float r = xr[k] * lr - xi[k] * li;
+			float i = xr[k] * li + xi[k] * lr;
+			xr[k] = r;
+			xi[k] = i;
+		}
+	}
+
+	// inverse transform, all stages but the last
+	for(size_t m=2; m<N; m*=2){
+		half = m/2;
+		size_t twiddleStride = N/m;
+		for(size_t start=0; start<N; start+=m)
+			for(size_t j=0; j<half; j++){
+				float *ar = re[start+j], *ai = im[start+j];
+				float *br = re[start+j+half], *bi = im[start+j+half];
+				float wr = wRe[j*twiddleStride], wi = wIm[j*twiddleStride];
+				for(size_t k=0; k<numSamples; k++){
+					// b times the conjugate of w
+					float tr = br[k] * wr + bi[k] * wi;
+					float ti = bi[k] * wr - br[k] * wi;
+					br[k] = ar[k] - tr;
+					bi[k] = ai[k] - ti;
+					ar[k] = ar[k] + tr;
+					ai[k] = ai[k] + ti;
+				}
+			}
+	}
+
+	// inverse transform, last stage. The output is real.
+	half = N/2;
+	for(size_t j=0; j<half; j++){
+		float *ar = re[j], *br = re[j+half], *bi = im[j+half];
+		float wr = wRe[j], wi = wIm[j];
+		for(size_t k=0; k<numSamples; k++){
+			float tr = br[k] * wr + bi[k] * wi;
+			br[k] = ar[k] - tr;
+			ar[k] = ar[k] + tr;
+		}
+	}
+}
+
+
+
+
+void BMMixingMatrix_processInPlace(BMMixingMatrix *This, float **buffers, size_t numSamples){
+	assert(numSamples <= This->maxBlockSize);
+
+	switch(This->type){
+		case BMMM_HADAMARD:
+			BMMixingMatrix_hadamard(This, buffers, numSamples);
+			break;
+		case BMMM_HOUSEHOLDER:
+			BMMixingMatrix_householder(This, buffers, numSamples);
+			break;
+		case BMMM_CIRCULANT:
+			BMMixingMatrix_circulant(This, buffers, numSamples);
+			break;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
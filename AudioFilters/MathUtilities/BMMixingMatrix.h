@@ -0,0 +1,96 @@
+//
+//  BMMixingMatrix.h
+//  AudioFiltersXcodeProject
+//
+//  Orthogonal mixing matrices for feedback delay networks, applied to a
+//  block of samples at a time. Each channel is one delay line and the matrix
+//  mixes the channels at every instant in the block. All inner loops run
+//  over samples, so they vectorise regardless of the number of channels.
+//
+//  BMMM_HADAMARD     Fast Hadamard transform, scaled by 1/sqrt(N).
+//                    O(N log N) per sample. N must be a power of two.
+//
+//  BMMM_HOUSEHOLDER  I - (2/N) * ones(N,N). Every output is its input minus
+//                    a fraction of the sum of all inputs. O(N) per sample.
+//
+//  BMMM_CIRCULANT    A circulant matrix with eigenvalues of magnitude 1,
+//                    applied with a radix-2 FFT across the channels. The
+//                    eigenvalue phases are spread evenly by the golden ratio
+//                    so that every output depends on every input with
+//                    similar weight. O(N log N) per sample. N must be a
+//                    power of two.
+//
+//  Every matrix is orthogonal, so a network that uses it loses no energy in
+//  the mixing and the decay time depends only on the attenuation applied to
+//  each delay.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMMixingMatrix_h
+#define BMMixingMatrix_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMMIXINGMATRIX_MAX_CHANNELS 256
+
+enum BMMixingMatrixType {BMMM_HADAMARD, BMMM_HOUSEHOLDER, BMMM_CIRCULANT};
+
+typedef struct BMMixingMatrix {
+	enum BMMixingMatrixType type;
+	size_t numChannels, maxBlockSize;
+
+	// householder
+	float *sum;
+
+	// circulant. Eigenvalues are stored in the bit-reversed order of the FFT
+	// output and include the 1/N scaling of the inverse transform.
+	float *eigenvaluesReal, *eigenvaluesImag;
+	float *twiddlesReal, *twiddlesImag;
+	float **imag;
+} BMMixingMatrix;
+
+
+/*!
+ *BMMixingMatrix_init
+ *
+ * @abstract allocates memory, so don't call it on the audio thread
+ *
+ * @param This          pointer to an uninitialised struct
+ * @param type          which matrix to use
+ * @param numChannels   up to BMMIXINGMATRIX_MAX_CHANNELS. A power of two for BMMM_HADAMARD and BMMM_CIRCULANT.
+ * @param maxBlockSize  the longest block that will be passed to BMMixingMatrix_processInPlace
+ */
+void BMMixingMatrix_init(BMMixingMatrix *This,
+						 enum BMMixingMatrixType type,
+						 size_t numChannels,
+						 size_t maxBlockSize);
+
+
+/*!
+ *BMMixingMatrix_free
+ */
+void BMMixingMatrix_free(BMMixingMatrix *This);
+
+
+/*!
+ *BMMixingMatrix_processInPlace
+ *
+ * @abstract replaces the vector (buffers[0][k], ..., buffers[numChannels-1][k]) with the matrix times that vector, for each k < numSamples
+ *
+ * @param buffers     numChannels arrays of length numSamples
+ * @param numSamples  <= maxBlockSize
+ */
+void BMMixingMatrix_processInPlace(BMMixingMatrix *This, float **buffers, size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMMixingMatrix_h */
@@ -7,7 +7,11 @@
 //
 
 #include <math.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 #define BM_DB_TO_GAIN(db) pow(10.0,db/20.0)
 #define BM_GAIN_TO_DB(gain) log10f(gain)*20.0
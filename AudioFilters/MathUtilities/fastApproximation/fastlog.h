@@ -48,7 +48,11 @@
 
 #include <stdint.h>
 #include "sse.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMVectorOps.h"
 
 static inline float 
@@ -17,7 +17,11 @@ extern "C" {
 #include "BMLevelMeter.h"
 #include "BMRMSPower.h"
 #include "Constants.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
     
 #define BM_LEVEL_METER_DEFAULT_BUFFER_LENGTH 256
 #define BM_LEVEL_METER_DEFAULT_FAST_RELEASE_TIME 0.25
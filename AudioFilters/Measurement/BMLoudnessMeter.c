@@ -0,0 +1,365 @@
+//
+//  BMLoudnessMeter.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMLoudnessMeter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMLM_MAX_CHANNELS 24
+#define BMLM_BLOCK_TIME 0.1
+#define BMLM_ABSOLUTE_GATE_LUFS -70.0
+#define BMLM_INTEGRATED_RELATIVE_GATE_LU -10.0
+#define BMLM_LRA_RELATIVE_GATE_LU -20.0
+#define BMLM_LRA_LOW_PERCENTILE 0.10
+#define BMLM_LRA_HIGH_PERCENTILE 0.95
+#define BMLM_BIN_WIDTH ((BMLM_HISTOGRAM_MAX_LUFS - BMLM_HISTOGRAM_MIN_LUFS) / (double)BMLM_HISTOGRAM_BINS)
+
+
+
+
+static inline double BMLoudnessMeter_energyToLUFS(double energy){
+	return -0.691 + 10.0 * log10(energy);
+}
+
+
+
+static inline size_t BMLoudnessHistogram_binIndex(double lufs){
+	double index = floor((lufs - BMLM_HISTOGRAM_MIN_LUFS) / BMLM_BIN_WIDTH);
+	if(index < 0.0) return 0;
+	if(index >= (double)BMLM_HISTOGRAM_BINS) return BMLM_HISTOGRAM_BINS - 1;
+	return (size_t)index;
+}
+
+
+
+static void BMLoudnessHistogram_init(BMLoudnessHistogram *This){
+	This->counts = calloc(BMLM_HISTOGRAM_BINS, sizeof(uint64_t));
+	This->energies = calloc(BMLM_HISTOGRAM_BINS, sizeof(double));
+	This->totalCount = 0;
+	This->totalEnergy = 0.0;
+}
+
+
+
+static void BMLoudnessHistogram_free(BMLoudnessHistogram *This){
+	free(This->counts);
+	This->counts = NULL;
+	free(This->energies);
+	This->energies = NULL;
+}
+
+
+
+static void BMLoudnessHistogram_clear(BMLoudnessHistogram *This){
+	memset(This->counts, 0, sizeof(uint64_t) * BMLM_HISTOGRAM_BINS);
+	memset(This->energies, 0, sizeof(double) * BMLM_HISTOGRAM_BINS);
+	This->totalCount = 0;
+	This->totalEnergy = 0.0;
+}
+
+
+
+/*
+ * Add a block if it is above the absolute gate
+ */
+static void BMLoudnessHistogram_add(BMLoudnessHistogram *This, double energy){
+	double lufs = BMLoudnessMeter_energyToLUFS(energy);
+	if(lufs <= BMLM_ABSOLUTE_GATE_LUFS) return;
+
+	size_t i = BMLoudnessHistogram_binIndex(lufs);
+	This->counts[i]++;
+	This->energies[i] += energy;
+	This->totalCount++;
+	This->totalEnergy += energy;
+}
+
+
+
+/*
+ * Returns the index of the first bin above the gate relative to the mean
+ * energy of all blocks in the histogram
+ */
+static size_t BMLoudnessHistogram_relativeGateIndex(BMLoudnessHistogram *This, double relativeGate){
+	double meanLUFS = BMLoudnessMeter_energyToLUFS(This->totalEnergy / (double)This->totalCount);
+	return BMLoudnessHistogram_binIndex(meanLUFS + relativeGate);
+}
+
+
+
+
+void BMLoudnessMeter_init(BMLoudnessMeter *This, size_t numChannels, float sampleRate){
+	assert(numChannels > 0 && numChannels <= BMLM_MAX_CHANNELS);
+
+	This->numChannels = numChannels;
+	This->blockLength = (size_t)round(BMLM_BLOCK_TIME * sampleRate);
+
+	// two levels of filtering for the K-weighting curve
+	bool smoothUpdate = false;
+	BMMultiLevelBiquad_initMultiChannel(&This->kWeighting, 2, numChannels, sampleRate, smoothUpdate);
+	BMMultiLevelBiquad_setKWeighting(&This->kWeighting, 0);
+
+	BMTruePeakDetector_init(&This->truePeakDetector, numChannels);
+	BMLoudnessHistogram_init(&This->gatingBlocks);
+	BMLoudnessHistogram_init(&This->shortTermValues);
+
+	// one chunk for each channel of the K-weighted signal and one for the
+	// true peak detector
+	This->buffer = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE * (numChannels + 1));
+	This->channelWeights = malloc(sizeof(float) * numChannels);
+	for(size_t i=0; i<numChannels; i++)
+		This->channelWeights[i] = 1.0f;
+
+	BMLoudnessMeter_reset(This);
+}
+
+
+
+
+void BMLoudnessMeter_free(BMLoudnessMeter *This){
+	BMMultiLevelBiquad_free(&This->kWeighting);
+	BMTruePeakDetector_free(&This->truePeakDetector);
+	BMLoudnessHistogram_free(&This->gatingBlocks);
+	BMLoudnessHistogram_free(&This->shortTermValues);
+	free(This->buffer);
+	This->buffer = NULL;
+	free(This->channelWeights);
+	This->channelWeights = NULL;
+}
+
+
+
+
+void BMLoudnessMeter_reset(BMLoudnessMeter *This){
+	memset(This->blockEnergies, 0, sizeof(double) * BMLM_SHORT_TERM_BLOCKS);
+	This->blockSum = This->momentarySum = This->shortTermSum = 0.0;
+	This->blockIndex = This->blocksCompleted = This->blockSamples = 0;
+	This->maxMomentary = This->maxShortTerm = -INFINITY;
+	This->maxTruePeak = 0.0f;
+	BMLoudnessHistogram_clear(&This->gatingBlocks);
+	BMLoudnessHistogram_clear(&This->shortTermValues);
+	BMTruePeakDetector_reset(&This->truePeakDetector);
+}
+
+
+
+
+void BMLoudnessMeter_setChannelWeight(BMLoudnessMeter *This, size_t channel, float weight){
+	assert(channel < This->numChannels && weight >= 0.0f);
+
+	This->channelWeights[channel] = weight;
+}
+
+
+
+
+/*
+ * Called at the end of each 100 ms block
+ */
+static void BMLoudnessMeter_endBlock(BMLoudnessMeter *This){
+	double blockEnergy = This->blockSum / (double)This->blockLength;
+	This->blockSum = 0.0;
+	This->blockSamples = 0;
+
+	// update the running sums with the new block and the blocks that leave
+	// the momentary and short-term windows
+	size_t i = This->blockIndex;
+	size_t momentaryExit = (i + BMLM_SHORT_TERM_BLOCKS - BMLM_MOMENTARY_BLOCKS) % BMLM_SHORT_TERM_BLOCKS;
+	This->momentarySum += blockEnergy - This->blockEnergies[momentaryExit];
+	This->shortTermSum += blockEnergy - This->blockEnergies[i];
+	This->blockEnergies[i] = blockEnergy;
+	This->blockIndex = (i + 1) % BMLM_SHORT_TERM_BLOCKS;
+	This->blocksCompleted++;
+
+	// recompute the sums once per cycle of the ring so that rounding errors
+	// do not accumulate
+	if(This->blockIndex == 0){
+		This->momentarySum = This->shortTermSum = 0.0;
+		for(size_t j=0; j<BMLM_SHORT_TERM_BLOCKS; j++){
+			This->shortTermSum += This->blockEnergies[j];
+			if(j >= BMLM_SHORT_TERM_BLOCKS - BMLM_MOMENTARY_BLOCKS)
+				This->momentarySum += This->blockEnergies[j];
+		}
+	}
+
+	// each 400 ms window, overlapping by 75%, is a gating block for the
+	// integrated loudness
+	if(This->blocksCompleted >= BMLM_MOMENTARY_BLOCKS){
+		double energy = This->momentarySum / (double)BMLM_MOMENTARY_BLOCKS;
+		BMLoudnessHistogram_add(&This->gatingBlocks, energy);
+		This->maxMomentary = BM_MAX(This->maxMomentary, (float)BMLoudnessMeter_energyToLUFS(energy));
+	}
+
+	// the short-term loudness every 100 ms is the input to the loudness range
+	if(This->blocksCompleted >= BMLM_SHORT_TERM_BLOCKS){
+		double energy = This->shortTermSum / (double)BMLM_SHORT_TERM_BLOCKS;
+		BMLoudnessHistogram_add(&This->shortTermValues, energy);
+		This->maxShortTerm = BM_MAX(This->maxShortTerm, (float)BMLoudnessMeter_energyToLUFS(energy));
+	}
+}
+
+
+
+
+void BMLoudnessMeter_process(BMLoudnessMeter *This, const float **inputs, size_t numSamples){
+	size_t numChannels = This->numChannels;
+	float *truePeakBuffer = This->buffer + numChannels * BM_BUFFER_CHUNK_SIZE;
+
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		// don't process past the end of the current block
+		size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, BM_BUFFER_CHUNK_SIZE);
+		samplesProcessing = BM_MIN(samplesProcessing, This->blockLength - This->blockSamples);
+
+		const float *in [BMLM_MAX_CHANNELS];
+		float *out [BMLM_MAX_CHANNELS];
+		for(size_t i=0; i<numChannels; i++){
+			in[i] = inputs[i] + samplesProcessed;
+			out[i] = This->buffer + i*BM_BUFFER_CHUNK_SIZE;
+		}
+
+		// K-weighting
+		if(numChannels == 1)
+			BMMultiLevelBiquad_processBufferMono(&This->kWeighting, in[0], out[0], samplesProcessing);
+		else
+			BMMultiLevelBiquad_processBufferMultiChannel(&This->kWeighting, in, out, samplesProcessing);
+
+		// add the weighted energy of all channels to the block sum
+		for(size_t i=0; i<numChannels; i++){
+			float sumOfSquares;
+			vDSP_svesq(out[i], 1, &sumOfSquares, samplesProcessing);
+			This->blockSum += (double)This->channelWeights[i] * (double)sumOfSquares;
+		}
+
+		// true peak
+		float truePeak;
+		BMTruePeakDetector_process(&This->truePeakDetector, in, truePeakBuffer, samplesProcessing);
+		vDSP_maxv(truePeakBuffer, 1, &truePeak, samplesProcessing);
+		This->maxTruePeak = BM_MAX(This->maxTruePeak, truePeak);
+
+		This->blockSamples += samplesProcessing;
+		if(This->blockSamples == This->blockLength)
+			BMLoudnessMeter_endBlock(This);
+
+		samplesProcessed += samplesProcessing;
+	}
+}
+
+
+
+
+float BMLoudnessMeter_getMomentaryLoudness(BMLoudnessMeter *This){
+	return BMLoudnessMeter_energyToLUFS(This->momentarySum / (double)BMLM_MOMENTARY_BLOCKS);
+}
+
+
+
+
+float BMLoudnessMeter_getShortTermLoudness(BMLoudnessMeter *This){
+	return BMLoudnessMeter_energyToLUFS(This->shortTermSum / (double)BMLM_SHORT_TERM_BLOCKS);
+}
+
+
+
+
+float BMLoudnessMeter_getIntegratedLoudness(BMLoudnessMeter *This){
+	BMLoudnessHistogram *h = &This->gatingBlocks;
+	if(h->totalCount == 0)
+		return -INFINITY;
+
+	// the mean energy of the blocks above the relative gate
+	size_t gateIndex = BMLoudnessHistogram_relativeGateIndex(h, BMLM_INTEGRATED_RELATIVE_GATE_LU);
+	uint64_t count = 0;
+	double energy = 0.0;
+	for(size_t i=gateIndex; i<BMLM_HISTOGRAM_BINS; i++){
+		count += h->counts[i];
+		energy += h->energies[i];
+	}
+
+	return BMLoudnessMeter_energyToLUFS(energy / (double)count);
+}
+
+
+
+
+/*
+ * Returns the loudness of the value with the given rank among the values
+ * in the histogram from bin startIndex up. The loudness is the mean of the
+ * bin that contains the value.
+ */
+static double BMLoudnessHistogram_valueAtRank(BMLoudnessHistogram *This, size_t startIndex, uint64_t rank){
+	uint64_t cumulativeCount = 0;
+	for(size_t i=startIndex; i<BMLM_HISTOGRAM_BINS; i++){
+		cumulativeCount += This->counts[i];
+		if(cumulativeCount > rank)
+			return BMLoudnessMeter_energyToLUFS(This->energies[i] / (double)This->counts[i]);
+	}
+	return BMLM_HISTOGRAM_MAX_LUFS;
+}
+
+
+
+
+float BMLoudnessMeter_getLoudnessRange(BMLoudnessMeter *This){
+	BMLoudnessHistogram *h = &This->shortTermValues;
+	if(h->totalCount == 0)
+		return 0.0f;
+
+	// count the short-term values above the relative gate
+	size_t gateIndex = BMLoudnessHistogram_relativeGateIndex(h, BMLM_LRA_RELATIVE_GATE_LU);
+	uint64_t count = 0;
+	for(size_t i=gateIndex; i<BMLM_HISTOGRAM_BINS; i++)
+		count += h->counts[i];
+	if(count == 0)
+		return 0.0f;
+
+	// LRA is the difference between the 10th and 95th percentiles
+	uint64_t lowRank = (uint64_t)round((double)(count - 1) * BMLM_LRA_LOW_PERCENTILE);
+	uint64_t highRank = (uint64_t)round((double)(count - 1) * BMLM_LRA_HIGH_PERCENTILE);
+	double low = BMLoudnessHistogram_valueAtRank(h, gateIndex, lowRank);
+	double high = BMLoudnessHistogram_valueAtRank(h, gateIndex, highRank);
+
+	return high - low;
+}
+
+
+
+
+float BMLoudnessMeter_getMaxMomentaryLoudness(BMLoudnessMeter *This){
+	return This->maxMomentary;
+}
+
+
+
+
+float BMLoudnessMeter_getMaxShortTermLoudness(BMLoudnessMeter *This){
+	return This->maxShortTerm;
+}
+
+
+
+
+float BMLoudnessMeter_getMaxTruePeak(BMLoudnessMeter *This){
+	return 20.0f * log10f(This->maxTruePeak);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
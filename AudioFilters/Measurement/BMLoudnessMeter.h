@@ -0,0 +1,164 @@
+//
+//  BMLoudnessMeter.h
+//  AudioFiltersXcodeProject
+//
+//  Loudness metering according to ITU-R BS.1770-4 and EBU R128: momentary
+//  (400 ms), short-term (3 s) and gated integrated loudness in LUFS,
+//  loudness range (LRA, EBU Tech 3342) in LU and maximum true peak in dBTP.
+//
+//  The input is K-weighted with BMMultiLevelBiquad_setKWeighting and the
+//  weighted energy is summed in 100 ms blocks. The energies of the last 30
+//  blocks are kept in a ring, with running sums for the momentary and
+//  short-term windows. Each completed 400 ms gating block and each 3 s
+//  short-term value is added to a histogram with 0.1 LU bins, which keeps
+//  the count and the total energy of the blocks in each bin. The integrated
+//  loudness and the loudness range are computed from the histograms, so
+//  memory and the cost of a query do not grow with the length of the
+//  programme. The integrated loudness is exact except for the blocks in
+//  the bin at the relative gate, which is included as a whole.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMLoudnessMeter_h
+#define BMLoudnessMeter_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BMMultiLevelBiquad.h"
+#include "BMTruePeakDetector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMLM_MOMENTARY_BLOCKS 4
+#define BMLM_SHORT_TERM_BLOCKS 30
+#define BMLM_HISTOGRAM_MIN_LUFS -70.0
+#define BMLM_HISTOGRAM_MAX_LUFS 30.0
+#define BMLM_HISTOGRAM_BINS 1000
+
+typedef struct BMLoudnessHistogram {
+	uint64_t *counts;
+	double *energies;
+	uint64_t totalCount;
+	double totalEnergy;
+} BMLoudnessHistogram;
+
+typedef struct BMLoudnessMeter {
+	BMMultiLevelBiquad kWeighting;
+	BMTruePeakDetector truePeakDetector;
+	BMLoudnessHistogram gatingBlocks, shortTermValues;
+	float *buffer, *channelWeights;
+	double blockEnergies [BMLM_SHORT_TERM_BLOCKS];
+	double blockSum, momentarySum, shortTermSum;
+	size_t blockIndex, blocksCompleted, blockLength, blockSamples;
+	float maxMomentary, maxShortTerm, maxTruePeak;
+	size_t numChannels;
+} BMLoudnessMeter;
+
+
+
+/*!
+ *BMLoudnessMeter_init
+ *
+ * @abstract all channels start with weight 1. For 5.1 input, set the weights of the surround channels to 1.41 and the LFE channel to 0 with BMLoudnessMeter_setChannelWeight.
+ *
+ * @param This         pointer to an uninitialised struct
+ * @param numChannels  number of input channels
+ * @param sampleRate   audio sampling rate
+ */
+void BMLoudnessMeter_init(BMLoudnessMeter *This, size_t numChannels, float sampleRate);
+
+
+/*!
+ *BMLoudnessMeter_free
+ */
+void BMLoudnessMeter_free(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_reset
+ *
+ * @abstract clear all measurements to start metering a new programme
+ */
+void BMLoudnessMeter_reset(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_setChannelWeight
+ *
+ * @param channel  channel index
+ * @param weight   linear power weight of the channel in the loudness sum
+ */
+void BMLoudnessMeter_setChannelWeight(BMLoudnessMeter *This, size_t channel, float weight);
+
+
+/*!
+ *BMLoudnessMeter_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of numChannels input buffers
+ * @param numSamples  length of each buffer; any length is supported
+ */
+void BMLoudnessMeter_process(BMLoudnessMeter *This, const float **inputs, size_t numSamples);
+
+
+/*!
+ *BMLoudnessMeter_getMomentaryLoudness
+ *
+ * @returns loudness of the last 400 ms in LUFS, updated every 100 ms
+ */
+float BMLoudnessMeter_getMomentaryLoudness(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getShortTermLoudness
+ *
+ * @returns loudness of the last 3 s in LUFS, updated every 100 ms
+ */
+float BMLoudnessMeter_getShortTermLoudness(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getIntegratedLoudness
+ *
+ * @returns gated loudness since init or reset in LUFS, or -INFINITY if no gating block is above the absolute gate
+ */
+float BMLoudnessMeter_getIntegratedLoudness(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getLoudnessRange
+ *
+ * @returns loudness range since init or reset in LU
+ */
+float BMLoudnessMeter_getLoudnessRange(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getMaxMomentaryLoudness
+ */
+float BMLoudnessMeter_getMaxMomentaryLoudness(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getMaxShortTermLoudness
+ */
+float BMLoudnessMeter_getMaxShortTermLoudness(BMLoudnessMeter *This);
+
+
+/*!
+ *BMLoudnessMeter_getMaxTruePeak
+ *
+ * @returns the highest true peak across all channels since init or reset, in dBTP
+ */
+float BMLoudnessMeter_getMaxTruePeak(BMLoudnessMeter *This);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMLoudnessMeter_h */
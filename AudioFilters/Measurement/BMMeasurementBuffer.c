@@ -9,7 +9,11 @@
 #include "BMMeasurementBuffer.h"
 #include "Constants.h"
 #include <stdlib.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 void BMMeasurementBuffer_init(BMMeasurementBuffer *This, size_t lengthInSamples){
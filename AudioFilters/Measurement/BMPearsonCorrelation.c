@@ -7,7 +7,11 @@
 //
 
 #include "BMPearsonCorrelation.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 
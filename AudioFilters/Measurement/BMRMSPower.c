@@ -9,7 +9,11 @@
 //
 
 #include "BMRMSPower.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 float BMRMSPower_process(const float* input,size_t processSample){
     float sumSquare = 0;
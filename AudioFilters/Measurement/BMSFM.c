@@ -10,7 +10,11 @@
 
 #include "BMSFM.h"
 #include "Constants.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 
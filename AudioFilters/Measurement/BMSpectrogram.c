@@ -10,7 +10,9 @@
 #include "BMIntegerMath.h"
 #include "Constants.h"
 #include "BMUnitConversion.h"
-#include <sys/qos.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 #define BMSG_BYTES_PER_PIXEL 4
 #define BMSG_FLOATS_PER_COLOUR 3
@@ -44,19 +46,15 @@ void BMSpectrogram_init(BMSpectrogram *This,
 		This->b2[i] = malloc(sizeof(float)*maxImageHeight);
 		This->t1[i] = malloc(sizeof(float)*maxImageHeight*BMSG_FLOATS_PER_COLOUR);
 		This->t2[i] = malloc(sizeof(float)*maxImageHeight);
+		This->w[i] = malloc(sizeof(float)*maxFFTSize);
 	}
 	This->b3 = malloc(sizeof(float)*maxImageHeight);
 	This->b4 = malloc(sizeof(size_t)*maxImageHeight);
 	This->b5 = malloc(sizeof(size_t)*maxImageHeight);
 	This->colours = malloc(sizeof(simd_float3)*maxImageHeight);
 	
-	if(BMSG_NUM_THREADS > 1){
-		// get the global concurrent dispatch queue with highest priority
-		This->globalQueue = dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE,0);
-		
-		// create a new dispatch group
-		This->dispatchGroup = dispatch_group_create();
-	}
+	// the thread pool has one thread for each set of buffers above
+	BMThreadPool_init(&This->threadPool, BMSG_NUM_THREADS);
 }
 
 void BMSpectrogram_free(BMSpectrogram *This){
@@ -66,16 +64,16 @@ void BMSpectrogram_free(BMSpectrogram *This){
 		free(This->b2[i]);
 		free(This->t1[i]);
 		free(This->t2[i]);
+		free(This->w[i]);
 		This->b1[i] = NULL;
 		This->b2[i] = NULL;
 		This->t1[i] = NULL;
 		This->t2[i] = NULL;
+		This->w[i] = NULL;
 		BMSpectrum_free(&This->spectrum[i]);
 	}
 	
-	if(BMSG_NUM_THREADS > 1){
-		dispatch_release(This->dispatchGroup);
-	}
+	BMThreadPool_free(&This->threadPool);
 	
 	free(This->b3);
 	free(This->b4);
@@ -111,7 +109,13 @@ void BMSpectrogram_updateImageHeight(BMSpectrogram *This,
 		This->prevMaxF = maxF;
 		This->prevImageHeight = imageHeight;
 		This->prevFFTSize = fftSize;
-		
+
+		// the columns are computed on the thread pool, so get the mixed
+		// radix plans for the new fft size here
+		if(!isPowerOfTwo(fftSize))
+			for(size_t i=0; i<BMSG_NUM_THREADS; i++)
+				BMFFT_setPlanLength(&This->spectrum[i].fft, fftSize);
+
 		// find the floating point fft bin indices to be used for interpolated
 		// copy of the fft output to bark scale frequency spectrogram output
 		BMSpectrum_barkScaleFFTBinIndices(interpolatedIndices, fftSize, minF,maxF, This->sampleRate, imageHeight);
@@ -261,8 +265,8 @@ void BMSpectrogram_toDbScaleAndClip(const float* input, float* output, size_t ff
 float BMSpectrogram_getPaddingLeft(size_t fftSize){
 	if(4 > fftSize)
 		printf("[BMSpectrogram] WARNING: fftSize must be >=4\n");
-	if(!isPowerOfTwo((size_t)fftSize))
-		printf("[BMSpectrogram] WARNING: fftSize must be a power of two\n");
+	if(!isPowerOfTwo((size_t)fftSize) && !BMFFTPlan_isSupportedLength((size_t)fftSize))
+		printf("[BMSpectrogram] WARNING: fftSize must be a power of two or a length supported by BMFFTPlan\n");
 	return (fftSize/2) - 1;
 }
 
@@ -270,14 +274,34 @@ float BMSpectrogram_getPaddingLeft(size_t fftSize){
 float BMSpectrogram_getPaddingRight(size_t fftSize){
 	if(4 > fftSize)
 		printf("[BMSpectrogram] WARNING: fftSize must be >=4\n");
-	if(!isPowerOfTwo((size_t)fftSize))
-		printf("[BMSpectrogram] WARNING: fftSize must be a power of two\n");
+	if(!isPowerOfTwo((size_t)fftSize) && !BMFFTPlan_isSupportedLength((size_t)fftSize))
+		printf("[BMSpectrogram] WARNING: fftSize must be a power of two or a length supported by BMFFTPlan\n");
 	return fftSize/2;
 }
 
 
 
 
+static void BMSpectrogram_renderColumn(const float *window,
+									   uint8_t *output,
+									   SInt32 pixelHeight,
+									   SInt32 fftSize,
+									   SInt32 fftOutputSize,
+									   size_t fftBinInterpolationPadding,
+									   float minFrequency,
+									   float maxFrequency,
+									   size_t upsampledPixels,
+									   BMSpectrum *spectrum,
+									   float *b1,
+									   float *b2,
+									   float *t1,
+									   float *t2,
+									   const float *b3,
+									   const size_t *b4,
+									   const size_t *b5);
+
+
+
 void BMSpectrogram_genColumn(SInt32 i,
 							 uint8_t *imageOutput,
 							 float fftStride,
@@ -307,9 +331,43 @@ void BMSpectrogram_genColumn(SInt32 i,
 	if(i==pixelWidth-1)
 		fftCurrentWindowStart = fftEndIndex - fftSize + 1;
 	
+	BMSpectrogram_renderColumn(inputAudio + fftCurrentWindowStart,
+							   &imageOutput[i*BMSG_BYTES_PER_PIXEL*pixelHeight],
+							   pixelHeight,
+							   fftSize,
+							   fftOutputSize,
+							   fftBinInterpolationPadding,
+							   minFrequency,
+							   maxFrequency,
+							   upsampledPixels,
+							   spectrum,
+							   b1, b2, t1, t2, b3, b4, b5);
+}
+
+
+
+
+/*
+ * Compute the spectrum of fftSize samples starting at window and write one
+ * column of intensities in [0,1] to output, top row first
+ */
+static void BMSpectrogram_columnIntensity(const float *window,
+										  float *output,
+										  SInt32 pixelHeight,
+										  SInt32 fftSize,
+										  SInt32 fftOutputSize,
+										  size_t fftBinInterpolationPadding,
+										  float minFrequency,
+										  float maxFrequency,
+										  size_t upsampledPixels,
+										  BMSpectrum *spectrum,
+										  float *b1,
+										  const float *b3,
+										  const size_t *b4,
+										  const size_t *b5){
 	// take abs(fft(windowFunctin*windowSamples))
 	b1[fftOutputSize-1] = BMSpectrum_processDataBasic(spectrum,
-													  inputAudio + fftCurrentWindowStart,
+													  window,
 													  b1,
 													  true,
 													  fftSize);
@@ -322,7 +380,7 @@ void BMSpectrogram_genColumn(SInt32 i,
 	
 	// interpolate the output from linear scale frequency to Bark Scale
 	BMSpectrogram_fftBinsToBarkScale(b1,
-									 b2,
+									 output,
 									 fftSize,
 									 pixelHeight,
 									 minFrequency,
@@ -336,18 +394,85 @@ void BMSpectrogram_genColumn(SInt32 i,
 	// clamp the outputs to [0,1]
 	float lowerLimit = 0;
 	float upperLimit = 1;
-	vDSP_vclip(b2, 1, &lowerLimit, &upperLimit, b2, 1, pixelHeight);
+	vDSP_vclip(output, 1, &lowerLimit, &upperLimit, output, 1, pixelHeight);
 	
 	// reverse
-	vDSP_vrvrs(b2, 1, pixelHeight);
+	vDSP_vrvrs(output, 1, pixelHeight);
+}
+
+
+
+
+/*
+ * Compute the spectrum of fftSize samples starting at window and write one
+ * column of RGBA pixels to output
+ */
+static void BMSpectrogram_renderColumn(const float *window,
+									   uint8_t *output,
+									   SInt32 pixelHeight,
+									   SInt32 fftSize,
+									   SInt32 fftOutputSize,
+									   size_t fftBinInterpolationPadding,
+									   float minFrequency,
+									   float maxFrequency,
+									   size_t upsampledPixels,
+									   BMSpectrum *spectrum,
+									   float *b1,
+									   float *b2,
+									   float *t1,
+									   float *t2,
+									   const float *b3,
+									   const size_t *b4,
+									   const size_t *b5){
+	BMSpectrogram_columnIntensity(window,
+								  b2,
+								  pixelHeight,
+								  fftSize,
+								  fftOutputSize,
+								  fftBinInterpolationPadding,
+								  minFrequency,
+								  maxFrequency,
+								  upsampledPixels,
+								  spectrum,
+								  b1, b3, b4, b5);
 	
 	// convert to RGBA colours and write to output
-	BMSpectrogram_toRGBAColour(b2, t1, t2, &imageOutput[i*BMSG_BYTES_PER_PIXEL*pixelHeight],pixelWidth, pixelHeight);
+	BMSpectrogram_toRGBAColour(b2, t1, t2, output, 1, pixelHeight);
+}
+
+
+
+
+void BMSpectrogram_genColumnIntensity(BMSpectrogram *This,
+									  const float *window,
+									  float *output,
+									  SInt32 fftSize,
+									  SInt32 pixelHeight,
+									  float minFrequency,
+									  float maxFrequency,
+									  size_t threadIndex){
+	assert(threadIndex < BMSG_NUM_THREADS);
+	BMSpectrogram_columnIntensity(window,
+								  output,
+								  pixelHeight,
+								  fftSize,
+								  1 + fftSize/2,
+								  This->fftBinInterpolationPadding,
+								  minFrequency,
+								  maxFrequency,
+								  This->upsampledPixels,
+								  &This->spectrum[threadIndex],
+								  This->b1[threadIndex],
+								  This->b3,
+								  This->b4,
+								  This->b5);
 }
 
 
 
 
+
+
 void BMSpectrogram_shiftColumns(BMSpectrogramCache *cache, int width, int height, int shift){
 	if(abs(shift) < width && shift != 0) {
 		int32_t bytesOffset = shift * height * BMSG_BYTES_PER_PIXEL;
@@ -396,6 +521,50 @@ void BMSpectrogram_transposeImage(const uint8_t *imageInput, uint8_t *imageOutpu
 
 
 
+/*
+ * The arguments of BMSpectrogram_process for the worker threads
+ */
+typedef struct BMSpectrogramProcessContext {
+	BMSpectrogram *This;
+	const float *inputAudio;
+	uint8_t *imageOutput;
+	float fftStride, minFrequency, maxFrequency;
+	SInt32 fftStartIndex, fftEndIndex, fftSize, fftOutputSize, pixelWidth, pixelHeight;
+} BMSpectrogramProcessContext;
+
+
+
+
+static void BMSpectrogram_processColumn(void *context, size_t i, size_t threadIndex){
+	BMSpectrogramProcessContext *c = (BMSpectrogramProcessContext*)context;
+	BMSpectrogram *This = c->This;
+	BMSpectrogram_genColumn((SInt32)i,
+							c->imageOutput,
+							c->fftStride,
+							c->fftStartIndex,
+							c->pixelWidth,
+							c->pixelHeight,
+							c->fftEndIndex,
+							c->fftSize,
+							c->fftOutputSize,
+							This->fftBinInterpolationPadding,
+							c->minFrequency,
+							c->maxFrequency,
+							This->upsampledPixels,
+							&This->spectrum[threadIndex],
+							c->inputAudio,
+							This->b1[threadIndex],
+							This->b2[threadIndex],
+							This->t1[threadIndex],
+							This->t2[threadIndex],
+							This->b3,
+							This->b4,
+							This->b5);
+}
+
+
+
+
 void BMSpectrogram_process(BMSpectrogram *This,
 						   const float* inputAudio,
 						   SInt32 inputLength,
@@ -408,7 +577,7 @@ void BMSpectrogram_process(BMSpectrogram *This,
 						   float minFrequency,
 						   float maxFrequency){
 	assert(4 <= fftSize && fftSize <= This->maxFFTSize);
-	assert(isPowerOfTwo((size_t)fftSize));
+	assert(isPowerOfTwo((size_t)fftSize) || BMFFTPlan_isSupportedLength((size_t)fftSize));
 	assert(2 <= pixelHeight && pixelHeight < This->maxImageHeight);
 	
 	// we will need this later
@@ -433,82 +602,241 @@ void BMSpectrogram_process(BMSpectrogram *This,
 	// if the configuration has changed, update some stuff
 	BMSpectrogram_updateImageHeight(This, fftSize, pixelHeight, minFrequency, maxFrequency);
 	
-	if(BMSG_NUM_THREADS > 1){
-		// create threads for parallel processing of spectrogram
-		SInt32 blockStartIndex = 0;
-		for(size_t j=0; j<BMSG_NUM_THREADS; j++){
-			// divide into BMSG_NUM_THREADS blocks with roughly equal size.
-			SInt32 nextBlockStartIndex = (pixelWidth * (SInt32)(j + 1)) / BMSG_NUM_THREADS;
-			
-			// ensure that the last block doesn't exceed the width of the image
-			if(nextBlockStartIndex > pixelWidth)
-				nextBlockStartIndex = pixelWidth;
-			
-			// add a block to the group and start processing
-			dispatch_group_async(This->dispatchGroup, This->globalQueue, ^{
-				for(SInt32 i=blockStartIndex; i<nextBlockStartIndex; i++){
-					BMSpectrogram_genColumn(i,
-											imageOutput,
-											fftStride,
-											fftStartIndex,
-											pixelWidth,
-											pixelHeight,
-											fftEndIndex,
-											fftSize,
-											fftOutputSize,
-											This->fftBinInterpolationPadding,
-											minFrequency,
-											maxFrequency,
-											This->upsampledPixels,
-											&This->spectrum[j],
-											inputAudio,
-											This->b1[j],
-											This->b2[j],
-											This->t1[j],
-											This->t2[j],
-											This->b3,
-											This->b4,
-											This->b5);
-				}
-			});
-			
-			// advance to the next block
-			blockStartIndex = nextBlockStartIndex;
-		}
-		// if there is only one thread then don't use the dispatch queue
+	// generate the columns in parallel
+	BMSpectrogramProcessContext context = {
+		.This = This,
+		.inputAudio = inputAudio,
+		.imageOutput = imageOutput,
+		.fftStride = fftStride,
+		.minFrequency = minFrequency,
+		.maxFrequency = maxFrequency,
+		.fftStartIndex = fftStartIndex,
+		.fftEndIndex = fftEndIndex,
+		.fftSize = fftSize,
+		.fftOutputSize = fftOutputSize,
+		.pixelWidth = pixelWidth,
+		.pixelHeight = pixelHeight
+	};
+	BMThreadPool_parallelFor(&This->threadPool, pixelWidth, BMSpectrogram_processColumn, &context);
+}
+
+
+
+
+void BMSpectrogramCache_init(BMSpectrogramCache *cache, size_t capacity, size_t maxImageHeight){
+	assert(capacity > 0);
+	cache->columnCapacity = capacity;
+	cache->maxColumnHeight = maxImageHeight;
+	cache->columns = malloc(sizeof(uint8_t)*BMSG_BYTES_PER_PIXEL*maxImageHeight*capacity);
+	cache->columnIndices = malloc(sizeof(int64_t)*capacity);
+	cache->jobColumns = NULL;
+	cache->jobPixels = NULL;
+	cache->jobCapacity = 0;
+	BMSpectrogramCache_clear(cache);
+}
+
+
+
+
+void BMSpectrogramCache_free(BMSpectrogramCache *cache){
+	free(cache->columns);
+	free(cache->columnIndices);
+	free(cache->jobColumns);
+	free(cache->jobPixels);
+	cache->columns = NULL;
+	cache->columnIndices = NULL;
+	cache->jobColumns = NULL;
+	cache->jobPixels = NULL;
+	cache->jobCapacity = 0;
+}
+
+
+
+
+void BMSpectrogramCache_clear(BMSpectrogramCache *cache){
+	for(size_t i=0; i<cache->columnCapacity; i++)
+		cache->columnIndices[i] = -1;
+	cache->columnHop = cache->columnFFTSize = cache->columnHeight = 0;
+	cache->columnMinF = cache->columnMaxF = 0.0f;
+}
+
+
+
+
+/*
+ * The arguments of BMSpectrogram_processStreaming for the worker threads
+ */
+typedef struct BMSpectrogramStreamingContext {
+	BMSpectrogram *This;
+	BMSpectrogramCache *cache;
+	const float *inputAudio;
+	int64_t inputStartTime, inputEndTime;
+	uint8_t *imageOutput;
+	float minFrequency, maxFrequency;
+	SInt32 fftSize, fftOutputSize, pixelHeight;
+} BMSpectrogramStreamingContext;
+
+
+
+
+static void BMSpectrogram_processStreamingColumn(void *context, size_t job, size_t threadIndex){
+	BMSpectrogramStreamingContext *c = (BMSpectrogramStreamingContext*)context;
+	BMSpectrogram *This = c->This;
+	BMSpectrogramCache *cache = c->cache;
+	
+	// the fft window of column k covers [k*hop-(fftSize/2)+1, k*hop+(fftSize/2)]
+	int64_t windowStart = cache->jobColumns[job] * (int64_t)cache->columnHop - (c->fftSize/2) + 1;
+	int64_t windowEnd = windowStart + c->fftSize;
+	
+	// if the window is entirely within the input, read it in place. Otherwise
+	// copy the part we have and fill the rest with zeros.
+	const float *window;
+	if(windowStart >= c->inputStartTime && windowEnd <= c->inputEndTime){
+		window = c->inputAudio + (windowStart - c->inputStartTime);
 	} else {
-		for(SInt32 i=0; i<pixelWidth; i++){
-			BMSpectrogram_genColumn(i,
-									imageOutput,
-									fftStride,
-									fftStartIndex,
-									pixelWidth,
-									pixelHeight,
-									fftEndIndex,
-									fftSize,
-									fftOutputSize,
-									This->fftBinInterpolationPadding,
-									minFrequency,
-									maxFrequency,
-									This->upsampledPixels,
-									&This->spectrum[0],
-									inputAudio,
-									This->b1[0],
-									This->b2[0],
-									This->t1[0],
-									This->t2[0],
-									This->b3,
-									This->b4,
-									This->b5);
+		float *w = This->w[threadIndex];
+		memset(w, 0, sizeof(float)*c->fftSize);
+		int64_t copyStart = SG_MAX(windowStart, c->inputStartTime);
+		int64_t copyEnd = SG_MIN(windowEnd, c->inputEndTime);
+		if(copyEnd > copyStart)
+			memcpy(w + (copyStart - windowStart),
+				   c->inputAudio + (copyStart - c->inputStartTime),
+				   sizeof(float)*(copyEnd - copyStart));
+		window = w;
+	}
+	
+	BMSpectrogram_renderColumn(window,
+							   &c->imageOutput[(size_t)cache->jobPixels[job]*BMSG_BYTES_PER_PIXEL*c->pixelHeight],
+							   c->pixelHeight,
+							   c->fftSize,
+							   c->fftOutputSize,
+							   This->fftBinInterpolationPadding,
+							   c->minFrequency,
+							   c->maxFrequency,
+							   This->upsampledPixels,
+							   &This->spectrum[threadIndex],
+							   This->b1[threadIndex],
+							   This->b2[threadIndex],
+							   This->t1[threadIndex],
+							   This->t2[threadIndex],
+							   This->b3,
+							   This->b4,
+							   This->b5);
+}
+
+
+
+
+size_t BMSpectrogram_processStreaming(BMSpectrogram *This,
+									  BMSpectrogramCache *cache,
+									  const float* inputAudio,
+									  int64_t inputStartTime,
+									  size_t inputLength,
+									  int64_t startTime,
+									  int64_t endTime,
+									  size_t hopSize,
+									  SInt32 fftSize,
+									  uint8_t *imageOutput,
+									  SInt32 pixelWidth,
+									  SInt32 pixelHeight,
+									  float minFrequency,
+									  float maxFrequency){
+	assert(startTime >= 0 && endTime >= startTime);
+	assert(hopSize > 0 && pixelWidth > 0);
+	assert((size_t)fftSize <= This->maxFFTSize);
+	assert((size_t)pixelHeight <= This->maxImageHeight && (size_t)pixelHeight <= cache->maxColumnHeight);
+	
+	// cached columns drawn with other settings can't be reused
+	if(hopSize != cache->columnHop ||
+	   fftSize != cache->columnFFTSize ||
+	   pixelHeight != cache->columnHeight ||
+	   minFrequency != cache->columnMinF ||
+	   maxFrequency != cache->columnMaxF){
+		BMSpectrogramCache_clear(cache);
+		cache->columnHop = hopSize;
+		cache->columnFFTSize = fftSize;
+		cache->columnHeight = pixelHeight;
+		cache->columnMinF = minFrequency;
+		cache->columnMaxF = maxFrequency;
+	}
+	
+	// if the configuration has changed, update some stuff
+	BMSpectrogram_updateImageHeight(This, fftSize, pixelHeight, minFrequency, maxFrequency);
+	
+	// make sure there is space to list a job for every pixel
+	if(cache->jobCapacity < (size_t)pixelWidth){
+		cache->jobColumns = realloc(cache->jobColumns, sizeof(int64_t)*pixelWidth);
+		cache->jobPixels = realloc(cache->jobPixels, sizeof(SInt32)*pixelWidth);
+		cache->jobCapacity = pixelWidth;
+	}
+	
+	// find the grid column for each pixel. Copy it from the cache if we have
+	// it and list it as a job if we don't. When zoomed in, consecutive pixels
+	// show the same column; those are filled in after the jobs are done.
+	size_t columnBytes = (size_t)BMSG_BYTES_PER_PIXEL*pixelHeight;
+	double samplesPerPixel = pixelWidth > 1 ? (double)(endTime - startTime) / (double)(pixelWidth-1) : 0.0;
+	size_t numJobs = 0;
+	int64_t prevColumn = -1;
+	for(SInt32 j=0; j<pixelWidth; j++){
+		int64_t k = llround(((double)startTime + (double)j*samplesPerPixel) / (double)hopSize);
+		if(k == prevColumn)
+			continue;
+		prevColumn = k;
+		
+		size_t slot = (size_t)(k % (int64_t)cache->columnCapacity);
+		if(cache->columnIndices[slot] == k){
+			memcpy(imageOutput + j*columnBytes, cache->columns + slot*columnBytes, columnBytes);
+		} else {
+			cache->jobColumns[numJobs] = k;
+			cache->jobPixels[numJobs] = j;
+			numJobs++;
 		}
 	}
 	
-	if(BMSG_NUM_THREADS > 1){
-		// Don't continue execution of this thread until all blocks have executed.
-		dispatch_group_wait(This->dispatchGroup, DISPATCH_TIME_FOREVER);
+	// compute the missing columns in parallel
+	BMSpectrogramStreamingContext context = {
+		.This = This,
+		.cache = cache,
+		.inputAudio = inputAudio,
+		.inputStartTime = inputStartTime,
+		.inputEndTime = inputStartTime + (int64_t)inputLength,
+		.imageOutput = imageOutput,
+		.minFrequency = minFrequency,
+		.maxFrequency = maxFrequency,
+		.fftSize = fftSize,
+		.fftOutputSize = 1 + fftSize/2,
+		.pixelHeight = pixelHeight
+	};
+	BMThreadPool_parallelFor(&This->threadPool, numJobs, BMSpectrogram_processStreamingColumn, &context);
+	
+	// store the new columns in the cache if their windows were complete.
+	// Samples before time zero count as complete because they are always zero.
+	for(size_t i=0; i<numJobs; i++){
+		int64_t k = cache->jobColumns[i];
+		int64_t windowStart = k * (int64_t)hopSize - (fftSize/2) + 1;
+		int64_t windowEnd = windowStart + fftSize;
+		if(SG_MAX(windowStart, 0) >= inputStartTime && windowEnd <= context.inputEndTime){
+			size_t slot = (size_t)(k % (int64_t)cache->columnCapacity);
+			memcpy(cache->columns + slot*columnBytes, imageOutput + cache->jobPixels[i]*columnBytes, columnBytes);
+			cache->columnIndices[slot] = k;
+		}
 	}
+	
+	// fill in the pixels that show the same column as the pixel to the left
+	prevColumn = -1;
+	for(SInt32 j=0; j<pixelWidth; j++){
+		int64_t k = llround(((double)startTime + (double)j*samplesPerPixel) / (double)hopSize);
+		if(k == prevColumn)
+			memcpy(imageOutput + j*columnBytes, imageOutput + (j-1)*columnBytes, columnBytes);
+		prevColumn = k;
+	}
+	
+	return numJobs;
 }
 
+
+
+
 size_t nearestPowerOfTwo(float x){
 	float lower = pow(2.0f,floor(log2(x)));
 	float upper = pow(2.0f,ceil(log2(x)));
@@ -529,8 +857,10 @@ size_t BMSpectrogram_GetFFTSizeFor(BMSpectrogram *This, size_t pixelWidth, size_
 	// estimate the ideal fft size
 	float fftSizeFloat = k * (float)sampleWidth / (float)pixelWidth;
 	
-	// round to the nearest size we can use (power of two)
-	size_t fftSize = nearestPowerOfTwo(fftSizeFloat);
+	// round to the nearest size we can use. Mixed radix lengths are much
+	// closer together than powers of two so this doesn't waste as much work
+	// on an FFT that is longer than necessary.
+	size_t fftSize = BMFFTPlan_nearestSupportedLength(fftSizeFloat);
 	
 	// don't allow it to be longer than the max or shorter
 	// than the min
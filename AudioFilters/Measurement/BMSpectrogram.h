@@ -11,11 +11,12 @@
 
 #include <stdio.h>
 #include "BMSpectrum.h"
+#include <stdint.h>
 #include <simd/simd.h>
-#include <dispatch/dispatch.h>
 #include "TPCircularBuffer.h"
+#include "BMThreadPool.h"
 
-#define BMSG_NUM_THREADS 1
+#define BMSG_NUM_THREADS 4
 
 typedef struct BMSpectrogram {
     BMSpectrum spectrum [BMSG_NUM_THREADS];
@@ -23,13 +24,13 @@ typedef struct BMSpectrogram {
 	float *b2 [BMSG_NUM_THREADS];
 	float *t1 [BMSG_NUM_THREADS];
 	float *t2 [BMSG_NUM_THREADS];
+	float *w [BMSG_NUM_THREADS];
 	float *b3;
     size_t *b4, *b5;
 	simd_float3 *colours;
     float prevMinF, prevMaxF, sampleRate;
     size_t prevImageHeight, prevFFTSize, maxImageHeight, maxFFTSize, fftBinInterpolationPadding, upsampledPixels;
-	dispatch_queue_global_t globalQueue;
-	dispatch_group_t dispatchGroup;
+	BMThreadPool threadPool;
 } BMSpectrogram;
 
 typedef struct {
@@ -42,6 +43,16 @@ typedef struct {
 	TPCircularBuffer cBuffer;
 	//	int32_t nextStartColumnIndex;
 	int32_t firstColumnTime, lastColumnTime;
+	
+	// ring of columns for BMSpectrogram_processStreaming. Column k is
+	// centred at sample k*columnHop and is stored in slot k % columnCapacity.
+	uint8_t *columns;
+	int64_t *columnIndices;
+	size_t columnCapacity, maxColumnHeight, columnHop, columnFFTSize, columnHeight;
+	float columnMinF, columnMaxF;
+	int64_t *jobColumns;
+	SInt32 *jobPixels;
+	size_t jobCapacity;
 } BMSpectrogramCache;
 
 
@@ -101,7 +112,7 @@ float BMSpectrogram_getPaddingRight(size_t fftSize);
  * @param inputLength length of input audio array, including padding
  * @param startSampleIndex first sample of audio in inputAudio that you want to draw on the screen
  * @param endSampleIndex last sample of audio in inputAudio that you want to draw on the screen
- * @param fftSize length of fft. must be an integer power of two. each fft output represents one row of pixels in the image. overlap and stride are computed from fftSize and pixelWidth
+ * @param fftSize length of fft. must be an integer power of two or a length for which BMFFTPlan_isSupportedLength is true. each fft output represents one row of pixels in the image. overlap and stride are computed from fftSize and pixelWidth
  * @param imageOutput an array of RGBA pixels with 32 bits per pixel, in column major order, having height = pixelHeight and width = pixelWidth
  * @param pixelWidth width of image output in pixels. one pixel for each fft output
  * @param pixelHeight height of image outptu in pixels. the output is in bark scale frequency, interpolated fromt the FFT output so the pixelHeight does not correspond to the fft length or the frequency resolution.
@@ -120,6 +131,134 @@ void BMSpectrogram_process(BMSpectrogram *This,
 
 
 
+/*!
+ *BMSpectrogramCache_init
+ *
+ * @abstract init the column ring used by BMSpectrogram_processStreaming. This does not init the circular buffer used by BMSpectrogram_prepareAlignment.
+ *
+ * @param cache           pointer to a cache struct
+ * @param capacity        number of columns stored. Columns are reused on scroll and zoom as long as they are still in the ring. A few times the width of the image is a good size.
+ * @param maxImageHeight  the largest pixelHeight that will be used with this cache
+ */
+void BMSpectrogramCache_init(BMSpectrogramCache *cache, size_t capacity, size_t maxImageHeight);
+
+
+/*!
+ *BMSpectrogramCache_free
+ */
+void BMSpectrogramCache_free(BMSpectrogramCache *cache);
+
+
+/*!
+ *BMSpectrogramCache_clear
+ *
+ * @abstract remove all columns from the ring, for example when the audio changes
+ */
+void BMSpectrogramCache_clear(BMSpectrogramCache *cache);
+
+
+
+/*!
+ *BMSpectrogram_processStreaming
+ *
+ * This draws the same kind of image as BMSpectrogram_process, but the FFT
+ * columns are on a fixed grid: column k is centred at sample k*hopSize of the
+ * recording. Each pixel column of the output shows the grid column nearest to
+ * it. Columns are stored in the cache and only columns that are not in the
+ * cache are computed, so scrolling, zooming and redrawing as new audio
+ * arrives cost only the new columns.
+ *
+ * Samples of the recording before time zero are taken to be zero, so no
+ * padding is required. A column whose FFT window reaches past the end of the
+ * available audio is drawn with zeros in place of the missing samples and is
+ * not stored in the cache, so that it is computed again when the audio
+ * arrives.
+ *
+ * When the fftSize, hopSize, pixelHeight or frequency range change, the cache
+ * is cleared.
+ *
+ * @param This            pointer to an initialised struct
+ * @param cache           a cache initialised with BMSpectrogramCache_init
+ * @param inputAudio      available audio. inputAudio[0] is sample inputStartTime of the recording.
+ * @param inputStartTime  time of inputAudio[0] in samples since the start of the recording
+ * @param inputLength     length of inputAudio
+ * @param startTime       time of the first sample to draw, >= 0
+ * @param endTime         time of the last sample to draw
+ * @param hopSize         distance between columns in samples
+ * @param fftSize         as in BMSpectrogram_process
+ * @param imageOutput     an array of RGBA pixels in column major order, having height = pixelHeight and width = pixelWidth
+ * @param pixelWidth      width of image output in pixels
+ * @param pixelHeight     height of image output in pixels
+ *
+ * @returns the number of FFT columns computed
+ */
+size_t BMSpectrogram_processStreaming(BMSpectrogram *This,
+									  BMSpectrogramCache *cache,
+									  const float* inputAudio,
+									  int64_t inputStartTime,
+									  size_t inputLength,
+									  int64_t startTime,
+									  int64_t endTime,
+									  size_t hopSize,
+									  SInt32 fftSize,
+									  uint8_t *imageOutput,
+									  SInt32 pixelWidth,
+									  SInt32 pixelHeight,
+									  float minFrequency,
+									  float maxFrequency);
+
+
+
+/*!
+ *BMSpectrogram_updateImageHeight
+ *
+ * @abstract prepare the frequency scale for the given settings. BMSpectrogram_process calls this automatically. Call it before BMSpectrogram_genColumnIntensity when the settings change.
+ */
+void BMSpectrogram_updateImageHeight(BMSpectrogram *This,
+									 size_t fftSize,
+									 size_t imageHeight,
+									 float minF,
+									 float maxF);
+
+
+
+/*!
+ *BMSpectrogram_genColumnIntensity
+ *
+ * @abstract compute one column of the spectrogram as intensities in [0,1], top row first, without converting to colour. Calls with different threadIndex values may run at the same time.
+ *
+ * @param This          pointer to an initialised struct, prepared with BMSpectrogram_updateImageHeight
+ * @param window        fftSize samples of input audio
+ * @param output        pixelHeight floats
+ * @param threadIndex   selects the scratch buffers, in [0, BMSG_NUM_THREADS)
+ */
+void BMSpectrogram_genColumnIntensity(BMSpectrogram *This,
+									  const float *window,
+									  float *output,
+									  SInt32 fftSize,
+									  SInt32 pixelHeight,
+									  float minFrequency,
+									  float maxFrequency,
+									  size_t threadIndex);
+
+
+
+/*!
+ *BMSpectrogram_toRGBAColour
+ *
+ * @abstract convert a column of intensities in [0,1] to RGBA pixels
+ *
+ * @param input        pixelHeight intensities. This is not modified.
+ * @param temp1        scratch space for 3*pixelHeight floats
+ * @param temp2        scratch space for pixelHeight floats
+ * @param output       4*pixelHeight bytes
+ * @param pixelWidth   unused
+ * @param pixelHeight  number of pixels
+ */
+void BMSpectrogram_toRGBAColour(float* input, float *temp1, float *temp2, uint8_t *output, size_t pixelWidth, size_t pixelHeight);
+
+
+
 /*!
  *BMSpectrogram_transposeImage
  *
@@ -0,0 +1,368 @@
+//
+//  BMSpectrogramTiles.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMSpectrogramTiles.h"
+#include "Constants.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __APPLE__
+	#include <Accelerate/Accelerate.h>
+#else
+	#include "BMCrossPlatformVDSP.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * State of the tile generator. tiles[L] holds the tile of level L that is
+ * currently being filled.
+ */
+typedef struct BMSpectrogramTileGenerator {
+	BMSpectrogram *spectrogram;
+	BMSpectrogramTileHeader header;
+	FILE *file;
+	const float *inputAudio;
+	size_t inputLength;
+	uint8_t *tiles [BMSGT_MAX_LEVELS];
+	float *intensity [BMSG_NUM_THREADS];
+	int64_t firstColumn;
+	int error;
+} BMSpectrogramTileGenerator;
+
+
+
+
+static void BMSpectrogramTiles_genColumn(void *context, size_t i, size_t threadIndex){
+	BMSpectrogramTileGenerator *g = (BMSpectrogramTileGenerator*)context;
+	BMSpectrogram *sg = g->spectrogram;
+	SInt32 fftSize = g->header.fftSize;
+	SInt32 tileHeight = g->header.tileHeight;
+
+	// the fft window of column k covers [k*hop-(fftSize/2)+1, k*hop+(fftSize/2)]
+	int64_t k = g->firstColumn + (int64_t)i;
+	int64_t windowStart = k * (int64_t)g->header.hopSize - (fftSize/2) + 1;
+	int64_t windowEnd = windowStart + fftSize;
+
+	// read the window in place if it's inside the input. Otherwise copy the
+	// part we have and fill the rest with zeros.
+	const float *window;
+	if(windowStart >= 0 && windowEnd <= (int64_t)g->inputLength){
+		window = g->inputAudio + windowStart;
+	} else {
+		float *w = sg->w[threadIndex];
+		memset(w, 0, sizeof(float)*fftSize);
+		int64_t copyStart = windowStart > 0 ? windowStart : 0;
+		int64_t copyEnd = windowEnd < (int64_t)g->inputLength ? windowEnd : (int64_t)g->inputLength;
+		if(copyEnd > copyStart)
+			memcpy(w + (copyStart - windowStart),
+				   g->inputAudio + copyStart,
+				   sizeof(float)*(copyEnd - copyStart));
+		window = w;
+	}
+
+	float *intensity = g->intensity[threadIndex];
+	BMSpectrogram_genColumnIntensity(sg,
+									 window,
+									 intensity,
+									 fftSize,
+									 tileHeight,
+									 g->header.minFrequency,
+									 g->header.maxFrequency,
+									 threadIndex);
+
+	// scale to [0,255] and write to the current tile of level 0
+	float scale = 255.0f;
+	vDSP_vsmul(intensity, 1, &scale, intensity, 1, tileHeight);
+	vDSP_vfixru8(intensity, 1, g->tiles[0] + i*tileHeight, 1, tileHeight);
+}
+
+
+
+
+static size_t BMSpectrogramTiles_numTiles(const BMSpectrogramTileHeader *h, size_t level){
+	return (size_t)((h->levelNumColumns[level] + h->tileWidth - 1) / h->tileWidth);
+}
+
+
+
+
+/*
+ * Write the current tile of the given level to the file and add it to the
+ * next level up. The tile buffer is cleared for the next tile.
+ */
+static void BMSpectrogramTiles_finishTile(BMSpectrogramTileGenerator *g, size_t level, size_t tileIndex){
+	BMSpectrogramTileHeader *h = &g->header;
+	uint8_t *tile = g->tiles[level];
+
+	uint64_t offset = BMSGT_DATA_OFFSET + (h->levelFirstTile[level] + tileIndex) * h->tileBytes;
+	if(fseeko(g->file, (off_t)offset, SEEK_SET) != 0 ||
+	   fwrite(tile, 1, h->tileBytes, g->file) != h->tileBytes)
+		g->error = -1;
+
+	if(level + 1 < h->numLevels){
+		// each pair of columns becomes one column of the next level, in the
+		// left or right half of its tile
+		size_t halfWidth = h->tileWidth / 2;
+		uint8_t *next = g->tiles[level+1] + (tileIndex % 2) * halfWidth * h->tileHeight;
+		for(size_t c=0; c<halfWidth; c++){
+			const uint8_t *a = tile + (2*c) * h->tileHeight;
+			const uint8_t *b = a + h->tileHeight;
+			uint8_t *out = next + c * h->tileHeight;
+			for(size_t j=0; j<h->tileHeight; j++)
+				out[j] = a[j] > b[j] ? a[j] : b[j];
+		}
+
+		// the next tile up is complete when we have filled its right half or
+		// when this is the last tile of this level
+		if(tileIndex % 2 == 1 || tileIndex == BMSpectrogramTiles_numTiles(h, level) - 1)
+			BMSpectrogramTiles_finishTile(g, level+1, tileIndex / 2);
+	}
+
+	memset(tile, 0, h->tileBytes);
+}
+
+
+
+
+int BMSpectrogramTiles_generate(BMSpectrogram *This,
+								const char *filePath,
+								const float *inputAudio,
+								size_t inputLength,
+								size_t hopSize,
+								SInt32 fftSize,
+								SInt32 tileWidth,
+								SInt32 tileHeight,
+								float minFrequency,
+								float maxFrequency){
+	assert(hopSize > 0);
+	assert(tileWidth >= 2 && tileWidth % 2 == 0);
+	assert((size_t)fftSize <= This->maxFFTSize);
+	assert((size_t)tileHeight <= This->maxImageHeight);
+
+	BMSpectrogramTileGenerator g;
+	memset(&g, 0, sizeof(BMSpectrogramTileGenerator));
+	g.spectrogram = This;
+	g.inputAudio = inputAudio;
+	g.inputLength = inputLength;
+
+	// fill the header. Column k is centred at sample k*hopSize, so we need
+	// one column for every hop that starts inside the input.
+	BMSpectrogramTileHeader *h = &g.header;
+	memcpy(h->magic, BMSGT_MAGIC, sizeof(h->magic));
+	h->version = BMSGT_VERSION;
+	h->tileWidth = tileWidth;
+	h->tileHeight = tileHeight;
+	h->fftSize = fftSize;
+	h->hopSize = hopSize;
+	h->inputLength = inputLength;
+	h->tileBytes = (uint64_t)tileWidth * tileHeight;
+	h->sampleRate = This->sampleRate;
+	h->minFrequency = minFrequency;
+	h->maxFrequency = maxFrequency;
+
+	// halve the number of columns at each level until one tile is enough
+	uint64_t numColumns = inputLength > 0 ? 1 + (inputLength - 1) / hopSize : 1;
+	uint64_t firstTile = 0;
+	size_t numLevels = 0;
+	while(true){
+		assert(numLevels < BMSGT_MAX_LEVELS);
+		h->levelNumColumns[numLevels] = numColumns;
+		h->levelFirstTile[numLevels] = firstTile;
+		firstTile += (numColumns + tileWidth - 1) / tileWidth;
+		numLevels++;
+		if(numColumns <= (uint64_t)tileWidth)
+			break;
+		numColumns = (numColumns + 1) / 2;
+	}
+	h->numLevels = (uint32_t)numLevels;
+
+	g.file = fopen(filePath, "wb");
+	if(g.file == NULL){
+		perror("[BMSpectrogramTiles] fopen failed");
+		return -1;
+	}
+
+	// write the header, padded with zeros
+	uint8_t *headerBlock = calloc(BMSGT_DATA_OFFSET, 1);
+	assert(sizeof(BMSpectrogramTileHeader) <= BMSGT_DATA_OFFSET);
+	memcpy(headerBlock, h, sizeof(BMSpectrogramTileHeader));
+	if(fwrite(headerBlock, 1, BMSGT_DATA_OFFSET, g.file) != BMSGT_DATA_OFFSET)
+		g.error = -1;
+	free(headerBlock);
+
+	for(size_t i=0; i<numLevels; i++)
+		g.tiles[i] = calloc(h->tileBytes, 1);
+	for(size_t i=0; i<BMSG_NUM_THREADS; i++)
+		g.intensity[i] = malloc(sizeof(float)*tileHeight);
+
+	// compute level 0 one tile at a time. Finishing each tile fills in the
+	// levels above it.
+	BMSpectrogram_updateImageHeight(This, fftSize, tileHeight, minFrequency, maxFrequency);
+	size_t numTiles = BMSpectrogramTiles_numTiles(h, 0);
+	for(size_t t=0; t<numTiles && g.error == 0; t++){
+		g.firstColumn = (int64_t)t * tileWidth;
+		size_t columns = BM_MIN((uint64_t)tileWidth, h->levelNumColumns[0] - (uint64_t)g.firstColumn);
+		BMThreadPool_parallelFor(&This->threadPool, columns, BMSpectrogramTiles_genColumn, &g);
+		BMSpectrogramTiles_finishTile(&g, 0, t);
+	}
+
+	for(size_t i=0; i<numLevels; i++)
+		free(g.tiles[i]);
+	for(size_t i=0; i<BMSG_NUM_THREADS; i++)
+		free(g.intensity[i]);
+
+	if(fclose(g.file) != 0)
+		g.error = -1;
+
+	if(g.error != 0)
+		printf("[BMSpectrogramTiles] WARNING: failed to write %s\n", filePath);
+
+	return g.error;
+}
+
+
+
+
+int BMSpectrogramTileFile_open(BMSpectrogramTileFile *This, const char *filePath){
+	memset(This, 0, sizeof(BMSpectrogramTileFile));
+
+	int fd = open(filePath, O_RDONLY);
+	if(fd < 0)
+		return -1;
+
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) != 0 || (uint64_t)fileStat.st_size < BMSGT_DATA_OFFSET){
+		close(fd);
+		return -1;
+	}
+
+	void *data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	// the mapping keeps the file open after the file descriptor is closed
+	close(fd);
+	if(data == MAP_FAILED)
+		return -1;
+
+	This->data = (const uint8_t*)data;
+	This->dataLength = (size_t)fileStat.st_size;
+	memcpy(&This->header, data, sizeof(BMSpectrogramTileHeader));
+
+	// check that this is a tile file and that it has all of its tiles
+	BMSpectrogramTileHeader *h = &This->header;
+	size_t lastLevel = h->numLevels - 1;
+	if(memcmp(h->magic, BMSGT_MAGIC, sizeof(h->magic)) != 0 ||
+	   h->version != BMSGT_VERSION ||
+	   h->numLevels == 0 || h->numLevels > BMSGT_MAX_LEVELS ||
+	   h->tileBytes != (uint64_t)h->tileWidth * h->tileHeight ||
+	   BMSGT_DATA_OFFSET + (h->levelFirstTile[lastLevel] + 1) * h->tileBytes > This->dataLength){
+		munmap(data, This->dataLength);
+		This->data = NULL;
+		return -1;
+	}
+
+	This->intensity = malloc(sizeof(float)*h->tileHeight);
+	This->temp1 = malloc(sizeof(float)*h->tileHeight*3);
+	This->temp2 = malloc(sizeof(float)*h->tileHeight);
+
+	return 0;
+}
+
+
+
+
+void BMSpectrogramTileFile_close(BMSpectrogramTileFile *This){
+	if(This->data)
+		munmap((void*)This->data, This->dataLength);
+	This->data = NULL;
+	This->dataLength = 0;
+
+	free(This->intensity);
+	free(This->temp1);
+	free(This->temp2);
+	This->intensity = NULL;
+	This->temp1 = NULL;
+	This->temp2 = NULL;
+}
+
+
+
+
+size_t BMSpectrogramTileFile_getNumTiles(BMSpectrogramTileFile *This, size_t level){
+	if(level >= This->header.numLevels)
+		return 0;
+	return BMSpectrogramTiles_numTiles(&This->header, level);
+}
+
+
+
+
+const uint8_t* BMSpectrogramTileFile_getTile(BMSpectrogramTileFile *This, size_t level, size_t tileIndex){
+	if(tileIndex >= BMSpectrogramTileFile_getNumTiles(This, level))
+		return NULL;
+	BMSpectrogramTileHeader *h = &This->header;
+	return This->data + BMSGT_DATA_OFFSET + (h->levelFirstTile[level] + tileIndex) * h->tileBytes;
+}
+
+
+
+
+int BMSpectrogramTileFile_getTileRGBA(BMSpectrogramTileFile *This, size_t level, size_t tileIndex, uint8_t *imageOutput){
+	const uint8_t *tile = BMSpectrogramTileFile_getTile(This, level, tileIndex);
+	if(tile == NULL)
+		return -1;
+
+	size_t height = This->header.tileHeight;
+	float scale = 1.0f / 255.0f;
+	for(size_t c=0; c<This->header.tileWidth; c++){
+		vDSP_vfltu8(tile + c*height, 1, This->intensity, 1, height);
+		vDSP_vsmul(This->intensity, 1, &scale, This->intensity, 1, height);
+		BMSpectrogram_toRGBAColour(This->intensity,
+								   This->temp1,
+								   This->temp2,
+								   imageOutput + c*height*4,
+								   1,
+								   height);
+	}
+
+	return 0;
+}
+
+
+
+
+size_t BMSpectrogramTileFile_levelForZoom(BMSpectrogramTileFile *This, double samplesPerPixel){
+	// level L has one column for every hopSize*2^L samples
+	double hopsPerPixel = samplesPerPixel / (double)This->header.hopSize;
+	if(hopsPerPixel < 2.0)
+		return 0;
+	size_t level = (size_t)floor(log2(hopsPerPixel));
+	return BM_MIN(level, (size_t)This->header.numLevels - 1);
+}
+
+
+
+
+double BMSpectrogramTileFile_columnTime(BMSpectrogramTileFile *This, size_t level, size_t column){
+	return ldexp((double)column * (double)This->header.hopSize, (int)level);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
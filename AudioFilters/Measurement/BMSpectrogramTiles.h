@@ -0,0 +1,161 @@
+//
+//  BMSpectrogramTiles.h
+//  AudioFiltersXcodeProject
+//
+//  A zoom pyramid of spectrogram tiles for long recordings, computed once
+//  offline and stored in a file that a viewer maps into memory.
+//
+//  Level 0 has one column for every hopSize samples: column k is the
+//  spectrum centred at sample k*hopSize, computed as in BMSpectrogram. Each
+//  column of level L+1 is the maximum of two neighbouring columns of level
+//  L, so level L has one column for every hopSize*2^L samples. The top
+//  level fits in a single tile.
+//
+//  Each tile is tileWidth columns of tileHeight bytes, in column major order
+//  with the top row (highest frequency) first. A byte is the intensity of
+//  the pixel scaled to [0,255]; use BMSpectrogramTileFile_getTileRGBA to
+//  convert it to the colours of BMSpectrogram_process. Unused columns in the
+//  last tile of a level are zero.
+//
+//  File format: a BMSpectrogramTileHeader, padded to BMSGT_DATA_OFFSET
+//  bytes, followed by the tiles of level 0, then level 1, and so on. The
+//  header records the index of the first tile of each level, so the
+//  location of any tile is a multiplication and an addition. Numbers are in
+//  the byte order of the machine that wrote the file.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMSpectrogramTiles_h
+#define BMSpectrogramTiles_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BMSpectrogram.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMSGT_MAGIC "BMSGTILE"
+#define BMSGT_VERSION 1
+#define BMSGT_MAX_LEVELS 40
+#define BMSGT_DATA_OFFSET 4096
+
+typedef struct BMSpectrogramTileHeader {
+	char magic [8];
+	uint32_t version, numLevels;
+	uint32_t tileWidth, tileHeight;
+	uint32_t fftSize, reserved;
+	uint64_t hopSize, inputLength, tileBytes;
+	float sampleRate, minFrequency, maxFrequency, reserved2;
+	uint64_t levelFirstTile [BMSGT_MAX_LEVELS];
+	uint64_t levelNumColumns [BMSGT_MAX_LEVELS];
+} BMSpectrogramTileHeader;
+
+typedef struct BMSpectrogramTileFile {
+	BMSpectrogramTileHeader header;
+	const uint8_t *data;
+	size_t dataLength;
+	float *intensity, *temp1, *temp2;
+} BMSpectrogramTileFile;
+
+
+
+/*!
+ *BMSpectrogramTiles_generate
+ *
+ * @abstract compute all levels of the pyramid and write them to a file. Memory use does not depend on the length of the input. The columns of level 0 are computed in parallel on the thread pool of the spectrogram.
+ *
+ * @param This          a spectrogram initialised with maxFFTSize >= fftSize and maxImageHeight >= tileHeight. Don't use it from another thread until this returns.
+ * @param filePath      the file to create or overwrite
+ * @param inputAudio    the whole recording. A memory mapped audio file is fine. Samples outside the input are taken to be zero.
+ * @param inputLength   length of inputAudio
+ * @param hopSize       samples between columns in level 0
+ * @param fftSize       as in BMSpectrogram_process
+ * @param tileWidth     columns per tile, even
+ * @param tileHeight    pixels per column
+ * @param minFrequency  frequency at the bottom of the image
+ * @param maxFrequency  frequency at the top of the image
+ *
+ * @returns 0 on success, -1 if the file could not be written
+ */
+int BMSpectrogramTiles_generate(BMSpectrogram *This,
+								const char *filePath,
+								const float *inputAudio,
+								size_t inputLength,
+								size_t hopSize,
+								SInt32 fftSize,
+								SInt32 tileWidth,
+								SInt32 tileHeight,
+								float minFrequency,
+								float maxFrequency);
+
+
+
+/*!
+ *BMSpectrogramTileFile_open
+ *
+ * @abstract map a file written by BMSpectrogramTiles_generate into memory
+ *
+ * @returns 0 on success, -1 if the file can't be opened or is not a tile file
+ */
+int BMSpectrogramTileFile_open(BMSpectrogramTileFile *This, const char *filePath);
+
+
+/*!
+ *BMSpectrogramTileFile_close
+ */
+void BMSpectrogramTileFile_close(BMSpectrogramTileFile *This);
+
+
+/*!
+ *BMSpectrogramTileFile_getNumTiles
+ *
+ * @returns the number of tiles in the given level, or 0 if there is no such level
+ */
+size_t BMSpectrogramTileFile_getNumTiles(BMSpectrogramTileFile *This, size_t level);
+
+
+/*!
+ *BMSpectrogramTileFile_getTile
+ *
+ * @returns a pointer to tileWidth*tileHeight bytes in the mapped file, or NULL if the tile does not exist. The pointer is valid until the file is closed.
+ */
+const uint8_t* BMSpectrogramTileFile_getTile(BMSpectrogramTileFile *This, size_t level, size_t tileIndex);
+
+
+/*!
+ *BMSpectrogramTileFile_getTileRGBA
+ *
+ * @abstract convert a tile to an RGBA image in column major order, as written by BMSpectrogram_process
+ *
+ * @param imageOutput  4*tileWidth*tileHeight bytes
+ *
+ * @returns 0 on success, -1 if the tile does not exist
+ */
+int BMSpectrogramTileFile_getTileRGBA(BMSpectrogramTileFile *This, size_t level, size_t tileIndex, uint8_t *imageOutput);
+
+
+/*!
+ *BMSpectrogramTileFile_levelForZoom
+ *
+ * @returns the coarsest level that has at least one column per pixel when the view shows samplesPerPixel samples in each pixel
+ */
+size_t BMSpectrogramTileFile_levelForZoom(BMSpectrogramTileFile *This, double samplesPerPixel);
+
+
+/*!
+ *BMSpectrogramTileFile_columnTime
+ *
+ * @returns the time in samples at the centre of the first level 0 column in the given column, which is column * 2^level * hopSize
+ */
+double BMSpectrogramTileFile_columnTime(BMSpectrogramTileFile *This, size_t level, size_t column);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMSpectrogramTiles_h */
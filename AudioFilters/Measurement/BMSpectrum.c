@@ -74,7 +74,7 @@ float BMSpectrum_processDataBasic(BMSpectrum* This,
 								  bool applyWindow,
 								  size_t inputLength){
 	assert(inputLength > 0);
-	assert(isPowerOfTwo(inputLength));
+	assert(isPowerOfTwo(inputLength) || BMFFTPlan_isSupportedLength(inputLength));
 	assert(inputLength <= This->maxInputLength);
 	
 	// apply a Kaiser window to the input
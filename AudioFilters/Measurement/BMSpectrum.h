@@ -10,7 +10,11 @@
 #define BMSpectrum_h
 
 #include <stdio.h>
+#ifdef __APPLE__
 #import <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMFFT.h"
 
 typedef struct BMSpectrum {
@@ -7,7 +7,11 @@
 //
 
 #include "BMSpectrumManager.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #import "BMRMSPower.h"
 //#import "MyConstants.h"
 #import "BMSpectrum.h"
@@ -0,0 +1,125 @@
+//
+//  BMTruePeakDetector.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMTruePeakDetector.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMTP_HISTORY_LENGTH (BMTP_TAPS_PER_PHASE - 1)
+#define BMTP_CHANNEL_LENGTH (BMTP_HISTORY_LENGTH + BM_BUFFER_CHUNK_SIZE)
+
+// interpolation filter coefficients from ITU-R BS.1770-4, table 1, one
+// row for each phase
+static const float BMTruePeakDetector_coefficients [BMTP_OVERSAMPLE_FACTOR][BMTP_TAPS_PER_PHASE] = {
+	{  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+	  -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+	   0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+	{ -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+	  -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+	   0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+	{ -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+	  -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+	   0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+	{ -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+	  -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+	   0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+};
+
+
+
+
+void BMTruePeakDetector_init(BMTruePeakDetector *This, size_t numChannels){
+	assert(numChannels > 0);
+
+	This->numChannels = numChannels;
+
+	// for each channel, the last BMTP_HISTORY_LENGTH samples of the
+	// previous buffer followed by one chunk of input
+	This->signal = malloc(sizeof(float) * BMTP_CHANNEL_LENGTH * numChannels);
+	This->phaseBuffer = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+
+	BMTruePeakDetector_reset(This);
+}
+
+
+
+
+void BMTruePeakDetector_free(BMTruePeakDetector *This){
+	free(This->signal);
+	This->signal = NULL;
+	free(This->phaseBuffer);
+	This->phaseBuffer = NULL;
+}
+
+
+
+
+void BMTruePeakDetector_reset(BMTruePeakDetector *This){
+	memset(This->signal, 0, sizeof(float) * BMTP_CHANNEL_LENGTH * This->numChannels);
+}
+
+
+
+
+void BMTruePeakDetector_process(BMTruePeakDetector *This,
+								const float **inputs,
+								float *output,
+								size_t numSamples){
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, BM_BUFFER_CHUNK_SIZE);
+		float *out = output + samplesProcessed;
+
+		for(size_t c=0; c<This->numChannels; c++){
+			float *signal = This->signal + c*BMTP_CHANNEL_LENGTH;
+
+			// append the input to the end of the history
+			memcpy(signal + BMTP_HISTORY_LENGTH, inputs[c] + samplesProcessed, sizeof(float)*samplesProcessing);
+
+			// the original samples at both ends of the interval. signal[i + 5]
+			// is input sample i - 6.
+			const float *x = signal + BMTP_HISTORY_LENGTH - BMTP_LATENCY;
+			if(c == 0)
+				vDSP_vmaxmg(x - 1, 1, x, 1, out, 1, samplesProcessing);
+			else {
+				vDSP_vmaxmg(x - 1, 1, out, 1, out, 1, samplesProcessing);
+				vDSP_vmaxmg(x, 1, out, 1, out, 1, samplesProcessing);
+			}
+
+			// interpolate each phase and take the largest magnitude. Passing
+			// the filter from the end with stride -1 makes vDSP_conv
+			// compute a convolution rather than a correlation.
+			for(size_t p=0; p<BMTP_OVERSAMPLE_FACTOR; p++){
+				const float *h = BMTruePeakDetector_coefficients[p];
+				vDSP_conv(signal, 1, h + BMTP_TAPS_PER_PHASE - 1, -1, This->phaseBuffer, 1, samplesProcessing, BMTP_TAPS_PER_PHASE);
+				vDSP_vmaxmg(This->phaseBuffer, 1, out, 1, out, 1, samplesProcessing);
+			}
+
+			// save the end of the signal for the next buffer
+			memmove(signal, signal + samplesProcessing, sizeof(float)*BMTP_HISTORY_LENGTH);
+		}
+
+		samplesProcessed += samplesProcessing;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
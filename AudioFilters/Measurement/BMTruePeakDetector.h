@@ -0,0 +1,80 @@
+//
+//  BMTruePeakDetector.h
+//  AudioFiltersXcodeProject
+//
+//  Measures the true peak level as defined in ITU-R BS.1770-4 Annex 2: the
+//  signal is upsampled by a factor of four with the 48 tap polyphase
+//  interpolation filter given in the recommendation and the peak is taken
+//  from the interpolated samples. The original samples are included in the
+//  peak so that the true peak is never lower than the sample peak.
+//
+//  The output has one value for each input sample. output[i] is the
+//  largest absolute value of the reconstructed signal in the interval
+//  between input samples i - BMTP_LATENCY - 1 and i - BMTP_LATENCY,
+//  including both ends, and the largest value across all channels.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMTruePeakDetector_h
+#define BMTruePeakDetector_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMTP_OVERSAMPLE_FACTOR 4
+#define BMTP_TAPS_PER_PHASE 12
+#define BMTP_LATENCY 5
+
+typedef struct BMTruePeakDetector {
+	float *signal, *phaseBuffer;
+	size_t numChannels;
+} BMTruePeakDetector;
+
+
+/*!
+ *BMTruePeakDetector_init
+ *
+ * @param This         pointer to an uninitialised struct
+ * @param numChannels  number of input channels
+ */
+void BMTruePeakDetector_init(BMTruePeakDetector *This, size_t numChannels);
+
+
+/*!
+ *BMTruePeakDetector_free
+ */
+void BMTruePeakDetector_free(BMTruePeakDetector *This);
+
+
+/*!
+ *BMTruePeakDetector_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of numChannels input buffers
+ * @param output      the true peak envelope, maximum across all channels, linear scale
+ * @param numSamples  length of the input and output buffers
+ */
+void BMTruePeakDetector_process(BMTruePeakDetector *This,
+								const float **inputs,
+								float *output,
+								size_t numSamples);
+
+
+/*!
+ *BMTruePeakDetector_reset
+ *
+ * @abstract clear the filter state
+ */
+void BMTruePeakDetector_reset(BMTruePeakDetector *This);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMTruePeakDetector_h */
@@ -9,7 +9,11 @@
 #ifndef BMAsymptoticLimiter_h
 #define BMAsymptoticLimiter_h
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <stdio.h>
 
 /*!
@@ -6,7 +6,11 @@
 //  Copyright © 2020 BlueMangoo. All rights reserved.
 //
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMAttackShaper.h"
 #include "Constants.h"
 //#include "fastpow.h"
@@ -382,14 +386,11 @@ void BMAttackShaperSection_generateControlSignal(BMAttackShaperSection *This,
 	vDSP_vdbcon(instantAttackEnvelope, 1, &one, instantAttackEnvelope, 1, numSamples, 0);
 	
 	// release filter to get instant attack envelope
-	for(size_t i=0; i<BMAS_RF_NUMLEVELS; i++)
-		BMReleaseFilter_processBuffer(&This->rf[i], instantAttackEnvelope, instantAttackEnvelope, numSamples);
+	BMEnvelopeFilterChain_process(This->rf, BMAS_RF_NUMLEVELS, NULL, 0, instantAttackEnvelope, instantAttackEnvelope, numSamples);
 	
 	// attack filter to get slow attack envelope
 	float* slowAttackEnvelope = controlSignal;
-	BMAttackFilter_processBuffer(&This->af[0], instantAttackEnvelope, slowAttackEnvelope, numSamples);
-	for(size_t i=1; i<BMAS_AF_NUMLEVELS; i++)
-		BMAttackFilter_processBuffer(&This->af[i], slowAttackEnvelope, slowAttackEnvelope, numSamples);
+	BMEnvelopeFilterChain_process(NULL, 0, This->af, BMAS_AF_NUMLEVELS, instantAttackEnvelope, slowAttackEnvelope, numSamples);
 	
 
 	
@@ -12,6 +12,7 @@
 #include "BMCompressor.h"
 #include <stdlib.h>
 #include <math.h>
+#include <assert.h>
 #include "fastlog.h"
 //#include "fastpow.h"
 #include "BMVectorOps.h"
@@ -19,6 +20,9 @@
 #include "BMUnitConversion.h"
 
 
+void BMCompressor_applyParameterEvent(void *compressor, const BMParameterEvent *event);
+
+
 void BMCompressor_init(BMCompressor *This, float sampleRate){
     float threshold = -10.0f;
     float kneeWidth = 25.0f;
@@ -63,6 +67,8 @@ void BMCompressor_initWithSettings(BMCompressor *This, float sampleRate, float t
     //init buffers
     This->buffer1 = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
     This->buffer2 = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+    
+    BMParameterQueue_init(&This->parameterQueue, BMPARAMETERQUEUE_DEFAULT_CAPACITY);
 }
 
 
@@ -75,6 +81,7 @@ void BMCompressor_Free(BMCompressor *This){
     free(This->buffer2);
     This->buffer2 = NULL;
 	BMEnvelopeFollower_free(&This->envelopeFollower);
+    BMParameterQueue_free(&This->parameterQueue);
 }
 
 
@@ -93,7 +100,11 @@ void BMCompressor_ProcessBufferMonoWithSideChain(BMCompressor *This,
     size_t samplesProcessed = 0;
     size_t samplesProcessing;
     while(samplesProcessed < numSamples){
-        samplesProcessing = MIN(numSamples,BM_BUFFER_CHUNK_SIZE);
+        // end the chunk early if a queued parameter change is due
+        samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                         MIN(numSamples - samplesProcessed, BM_BUFFER_CHUNK_SIZE),
+                                                         BMCompressor_applyParameterEvent,
+                                                         This);
         
         // get a shorter name for the buffer
         float* buffer1 = This->buffer1;
@@ -166,7 +177,11 @@ void BMCompressor_ProcessBufferStereoWithSideChain(BMCompressor *This,
     size_t samplesProcessing;
     
     while(samplesProcessed<numSamples){
-        samplesProcessing = MIN(numSamples,BM_BUFFER_CHUNK_SIZE);
+        // end the chunk early if a queued parameter change is due
+        samplesProcessing = BMParameterQueue_nextSegment(&This->parameterQueue,
+                                                         MIN(numSamples - samplesProcessed, BM_BUFFER_CHUNK_SIZE),
+                                                         BMCompressor_applyParameterEvent,
+                                                         This);
         
         // get a shorter name for the buffer
         float* buffer1 = This->buffer1;
@@ -231,6 +246,39 @@ void BMCompressor_ProcessBufferStereo(BMCompressor *This,
     BMCompressor_ProcessBufferStereoWithSideChain(This, inputL, inputR, inputL, inputR, outputL, outputR, minGainDb, numSamples);
 }
 
+bool BMCompressor_PushParameterEvent(BMCompressor *This, const BMParameterEvent *event){
+    return BMParameterQueue_push(&This->parameterQueue, event);
+}
+
+bool BMCompressor_PushParameterSnapshot(BMCompressor *This, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime){
+    return BMParameterQueue_pushSnapshot(&This->parameterQueue, events, numEvents, sampleTime);
+}
+
+void BMCompressor_applyParameterEvent(void *compressor, const BMParameterEvent *event){
+    BMCompressor *This = (BMCompressor*)compressor;
+    float value = event->values[0];
+    
+    switch(event->parameter){
+        case BMCOMP_THRESHOLD_DB:
+            BMCompressor_SetThresholdInDB(This, value);
+            break;
+        case BMCOMP_KNEE_WIDTH_DB:
+            BMCompressor_SetKneeWidthInDB(This, value);
+            break;
+        case BMCOMP_RATIO:
+            BMCompressor_SetRatio(This, value);
+            break;
+        case BMCOMP_ATTACK_TIME:
+            BMCompressor_SetAttackTime(This, value);
+            break;
+        case BMCOMP_RELEASE_TIME:
+            BMCompressor_SetReleaseTime(This, value);
+            break;
+        default:
+            assert(false);
+    }
+}
+
 void updateThreshold(BMCompressor *This){
     BMQuadraticThreshold_initLower(&This->quadraticThreshold,
                                    This->thresholdInDB,
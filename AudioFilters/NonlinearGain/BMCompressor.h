@@ -16,12 +16,24 @@
 #include "BMMultiLevelBiquad.h"
 #include "BMEnvelopeFollower.h"
 #include "BMQuadraticThreshold.h"
+#include "BMParameterQueue.h"
+
+// Parameters for BMCompressor_PushParameterEvent. The event's values[0] is
+// the argument of the setter with the same name. The index is ignored.
+enum BMCompressorParameter {
+    BMCOMP_THRESHOLD_DB,
+    BMCOMP_KNEE_WIDTH_DB,
+    BMCOMP_RATIO,
+    BMCOMP_ATTACK_TIME,
+    BMCOMP_RELEASE_TIME
+};
 
 typedef struct{
     float thresholdInDB, kneeWidthInDB, releaseTime, attackTime,slope;
     BMEnvelopeFollower envelopeFollower;
     BMQuadraticThreshold quadraticThreshold;
     float *buffer1, *buffer2;
+    BMParameterQueue parameterQueue;
 } BMCompressor;
 
 void BMCompressor_init(BMCompressor* compressor, float sampleRate);
@@ -67,6 +79,28 @@ void BMCompressor_SetReleaseTime(BMCompressor* compressor, float releaseTime);
 void BMCompressor_SetSampleRate(BMCompressor* compressor, float sampleRate);
 void BMCompressor_SetKneeWidthInDB(BMCompressor* compressor, float kneeWidth);
 
+/*!
+ * BMCompressor_PushParameterEvent
+ * @param This    pointer to an initialised struct
+ * @param event   event->parameter is one of enum BMCompressorParameter
+ * @brief schedule a settings change from a control thread while the audio thread is processing
+ * @discussion The setters above take effect immediately and are only safe to call from the audio thread. This queues the change without locking and the processing functions apply it on the sample given by event->sampleTime. See BMParameterQueue.h for how timestamps work. Sample rate changes reallocate memory and can't be queued.
+ * @returns false if too many events are waiting. The event is dropped in that case.
+ */
+bool BMCompressor_PushParameterEvent(BMCompressor* compressor, const BMParameterEvent *event);
+
+/*!
+ * BMCompressor_PushParameterSnapshot
+ * @param This        pointer to an initialised struct
+ * @param events      the parameter of each event is one of enum BMCompressorParameter. Their sampleTime is ignored.
+ * @param numEvents   number of events
+ * @param sampleTime  the sample on which the changes take effect
+ * @brief schedule several settings changes that take effect together on the same sample
+ * @discussion The processing functions apply all of the events in the same buffer or none of them. See BMParameterQueue_pushSnapshot.
+ * @returns false if there isn't room for all the events. None of them are queued in that case.
+ */
+bool BMCompressor_PushParameterSnapshot(BMCompressor* compressor, const BMParameterEvent *events, size_t numEvents, uint64_t sampleTime);
+
 void BMCompressor_Free(BMCompressor *This);
 
 #endif /* BMCompressor_h */
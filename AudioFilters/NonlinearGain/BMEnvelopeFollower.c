@@ -9,8 +9,16 @@
 
 #include <math.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMEnvelopeFollower.h"
+#include "Constants.h"
 
 
 // set all stages of smoothing filters to critically damped
@@ -21,6 +29,21 @@
 #define BMENV_RELEASE_TIME 1.0f / 10.0f
 
 
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// one stage of a filter chain in each lane
+#define BMENV_LANES BMENV_MAX_FUSED_STAGES
+
+typedef float BMEnvVec __attribute__((vector_size(sizeof(float)*BMENV_LANES),aligned(4),__may_alias__));
+typedef int32_t BMEnvMask __attribute__((vector_size(sizeof(int32_t)*BMENV_LANES),aligned(4),__may_alias__));
+
+#define BMENV_INLINE static inline __attribute__((always_inline))
+
+
 
 void BMAttackFilter_setCutoff(BMAttackFilter *This, float fc){
     assert(fc > 0.0f);
@@ -268,6 +291,412 @@ void BMReleaseFilter_processBuffer(BMReleaseFilter *This,
 
 
 
+#pragma mark - fused filter chain
+
+/*
+ * The vectorised filters below process one filter in each lane. Each lane
+ * can do either the attack filter or the release filter logic, selected by
+ * a mask, and the switching between filtering and passing the input
+ * through is also done with masks, so there are no branches. The arithmetic
+ * in each lane is the same as in BMReleaseFilter_processBuffer and
+ * BMAttackFilter_processBuffer, so the results are identical.
+ */
+typedef struct BMEnvelopeLaneState {
+	BMEnvVec ic1, ic2, previousOutputValue, previousOutputGradient;
+	BMEnvMask attackMode;
+} BMEnvelopeLaneState;
+
+typedef struct BMEnvelopeLaneCoefficients {
+	BMEnvVec a1, a2, a3, gInv_2;
+} BMEnvelopeLaneCoefficients;
+
+
+
+
+BMENV_INLINE BMEnvVec BMEnvVec_select(BMEnvMask mask, BMEnvVec a, BMEnvVec b){
+	return (BMEnvVec)(((BMEnvMask)a & mask) | ((BMEnvMask)b & ~mask));
+}
+
+
+
+
+/*
+ * Process one sample in each lane. Lanes where isRelease is true are
+ * release filters and the others are attack filters. Lanes where active is
+ * false keep their state. When the masks are constants the compiler removes
+ * the unused logic.
+ *
+ * @returns the output of each lane
+ */
+BMENV_INLINE BMEnvVec BMEnvelopeLanes_step(BMEnvelopeLaneState *st,
+										   const BMEnvelopeLaneCoefficients *c,
+										   BMEnvVec in,
+										   BMEnvMask isRelease,
+										   BMEnvMask active){
+	const BMEnvVec zero = {0};
+	BMEnvVec prev = st->previousOutputValue;
+	BMEnvMask attack = (BMEnvMask)(in > prev);
+
+	// release filters reset on the first sample in release mode and attack
+	// filters on the first sample in attack mode
+	BMEnvMask resetRelease = isRelease & ~attack & st->attackMode;
+	BMEnvMask resetAttack = ~isRelease & attack & ~st->attackMode;
+	BMEnvVec ic1 = BMEnvVec_select(resetAttack, st->previousOutputGradient * c->gInv_2, st->ic1);
+	ic1 = BMEnvVec_select(resetRelease, zero, ic1);
+	BMEnvVec ic2 = BMEnvVec_select(resetRelease | resetAttack, prev, st->ic2);
+
+	// process the state variable filter
+	BMEnvVec v3 = in - ic2;
+	BMEnvVec v1 = c->a1 * ic1 + c->a2 * v3;
+	BMEnvVec v2 = ic2 + c->a2 * ic1 + c->a3 * v3;
+
+	// release filters filter while the signal is falling, attack filters
+	// while it is rising. Otherwise the input passes through.
+	BMEnvMask filtering = attack ^ isRelease;
+	ic1 = BMEnvVec_select(filtering, 2.0f * v1 - ic1, ic1);
+	ic2 = BMEnvVec_select(filtering, 2.0f * v2 - ic2, ic2);
+	BMEnvVec out = BMEnvVec_select(filtering, v2, in);
+	BMEnvVec gradient = BMEnvVec_select(attack, st->previousOutputGradient, in - prev);
+
+	st->ic1 = BMEnvVec_select(active, ic1, st->ic1);
+	st->ic2 = BMEnvVec_select(active, ic2, st->ic2);
+	st->previousOutputGradient = BMEnvVec_select(active, gradient, st->previousOutputGradient);
+	st->previousOutputValue = BMEnvVec_select(active, out, prev);
+	st->attackMode = (attack & active) | (st->attackMode & ~active);
+
+	return out;
+}
+
+
+
+
+static void BMReleaseFilter_loadLane(const BMReleaseFilter *f, BMEnvelopeLaneState *st, BMEnvelopeLaneCoefficients *c, size_t lane){
+	st->ic1[lane] = f->ic1;
+	st->ic2[lane] = f->ic2;
+	st->previousOutputValue[lane] = f->previousOutputValue;
+	st->previousOutputGradient[lane] = 0.0f;
+	st->attackMode[lane] = f->attackMode ? -1 : 0;
+	c->a1[lane] = f->a1;
+	c->a2[lane] = f->a2;
+	c->a3[lane] = f->a3;
+	c->gInv_2[lane] = 0.0f;
+}
+
+static void BMReleaseFilter_storeLane(BMReleaseFilter *f, const BMEnvelopeLaneState *st, size_t lane){
+	f->ic1 = st->ic1[lane];
+	f->ic2 = st->ic2[lane];
+	f->previousOutputValue = st->previousOutputValue[lane];
+	f->attackMode = st->attackMode[lane] != 0;
+}
+
+static void BMAttackFilter_loadLane(const BMAttackFilter *f, BMEnvelopeLaneState *st, BMEnvelopeLaneCoefficients *c, size_t lane){
+	st->ic1[lane] = f->ic1;
+	st->ic2[lane] = f->ic2;
+	st->previousOutputValue[lane] = f->previousOutputValue;
+	st->previousOutputGradient[lane] = f->previousOutputGradient;
+	st->attackMode[lane] = f->attackMode ? -1 : 0;
+	c->a1[lane] = f->a1;
+	c->a2[lane] = f->a2;
+	c->a3[lane] = f->a3;
+	c->gInv_2[lane] = f->gInv_2;
+}
+
+static void BMAttackFilter_storeLane(BMAttackFilter *f, const BMEnvelopeLaneState *st, size_t lane){
+	f->ic1 = st->ic1[lane];
+	f->ic2 = st->ic2[lane];
+	f->previousOutputValue = st->previousOutputValue[lane];
+	f->previousOutputGradient = st->previousOutputGradient[lane];
+	f->attackMode = st->attackMode[lane] != 0;
+}
+
+
+
+
+/*
+ * shift the lanes of v up by one and put x in lane 0
+ */
+BMENV_INLINE BMEnvVec BMEnvVec_shiftIn(BMEnvVec v, float x){
+	BMEnvVec xv = {x};
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 12)
+	return __builtin_shufflevector(v, xv, 8, 0, 1, 2, 3, 4, 5, 6);
+#else
+	const BMEnvMask shift = {8, 0, 1, 2, 3, 4, 5, 6};
+	return __builtin_shuffle(v, xv, shift);
+#endif
+}
+
+
+
+
+/*
+ * BMEnvelopeFilterChain_process puts one stage of the chain in each lane.
+ * Because each stage needs the output of the previous stage, the stages
+ * work on a diagonal: at step t, lane s processes sample t - s, taking as
+ * input the output of lane s-1 at step t-1. The first and last few steps of
+ * each buffer have some lanes idle; these steps mask the state updates so
+ * that idle lanes keep their state.
+ */
+BM_SIMD_DISPATCH
+static void BMEnvelopeFilterChain_processFused(BMEnvelopeLaneState *st,
+											   const BMEnvelopeLaneCoefficients *c,
+											   const BMEnvMask *isReleaseLanes,
+											   size_t numStages,
+											   const float* input,
+											   float* output,
+											   size_t numSamples){
+	const BMEnvMask allActive = {-1, -1, -1, -1, -1, -1, -1, -1};
+	const BMEnvMask laneIndex = {0, 1, 2, 3, 4, 5, 6, 7};
+	size_t last = numStages - 1;
+	int32_t n = (int32_t)numSamples;
+	BMEnvMask isRelease = *isReleaseLanes;
+	BMEnvVec carry = {0};
+
+	// ramp up: lane s starts at step s
+	for(size_t t=0; t<last; t++){
+		BMEnvMask active = (laneIndex <= (int32_t)t) & (laneIndex > (int32_t)t - n);
+		float x = t < numSamples ? input[t] : 0.0f;
+		carry = BMEnvelopeLanes_step(st, c, BMEnvVec_shiftIn(carry, x), isRelease, active);
+	}
+
+	// all lanes active. Output lags input by numStages - 1 samples, so
+	// writing in place never overwrites input we have not read yet.
+	for(size_t t=last; t<numSamples; t++){
+		carry = BMEnvelopeLanes_step(st, c, BMEnvVec_shiftIn(carry, input[t]), isRelease, allActive);
+		output[t - last] = carry[last];
+	}
+
+	// ramp down: lane s finishes at step numSamples - 1 + s
+	for(size_t t=BM_MAX(numSamples, last); t<numSamples + last; t++){
+		BMEnvMask active = (laneIndex <= (int32_t)t) & (laneIndex > (int32_t)t - n);
+		carry = BMEnvelopeLanes_step(st, c, BMEnvVec_shiftIn(carry, 0.0f), isRelease, active);
+		output[t - last] = carry[last];
+	}
+}
+
+
+
+
+void BMEnvelopeFilterChain_process(BMReleaseFilter *releaseFilters,
+								   size_t numReleaseStages,
+								   BMAttackFilter *attackFilters,
+								   size_t numAttackStages,
+								   const float* input,
+								   float* output,
+								   size_t numSamples){
+	size_t numStages = numReleaseStages + numAttackStages;
+
+	// process long chains one stage at a time
+	if(numStages > BMENV_MAX_FUSED_STAGES || numStages == 0){
+		if(input != output)
+			memcpy(output, input, sizeof(float) * numSamples);
+		for(size_t i=0; i<numReleaseStages; i++)
+			BMReleaseFilter_processBuffer(&releaseFilters[i], output, output, numSamples);
+		for(size_t i=0; i<numAttackStages; i++)
+			BMAttackFilter_processBuffer(&attackFilters[i], output, output, numSamples);
+		return;
+	}
+
+	// copy the filter states and coefficients into the lanes. Unused lanes
+	// get zeros; their output is never read.
+	BMEnvelopeLaneState st;
+	BMEnvelopeLaneCoefficients c;
+	BMEnvMask isRelease = {0};
+	memset(&st, 0, sizeof(st));
+	memset(&c, 0, sizeof(c));
+	for(size_t i=0; i<numReleaseStages; i++){
+		BMReleaseFilter_loadLane(&releaseFilters[i], &st, &c, i);
+		isRelease[i] = -1;
+	}
+	for(size_t i=0; i<numAttackStages; i++)
+		BMAttackFilter_loadLane(&attackFilters[i], &st, &c, numReleaseStages + i);
+
+	BMEnvelopeFilterChain_processFused(&st, &c, &isRelease, numStages, input, output, numSamples);
+
+	// copy the states back
+	for(size_t i=0; i<numReleaseStages; i++)
+		BMReleaseFilter_storeLane(&releaseFilters[i], &st, i);
+	for(size_t i=0; i<numAttackStages; i++)
+		BMAttackFilter_storeLane(&attackFilters[i], &st, numReleaseStages + i);
+}
+
+
+
+
+#pragma mark - multichannel
+
+// samples per channel transposed into lanes at a time
+#define BMENV_MC_BLOCK 64
+
+
+
+
+/*
+ * Process one stage of the filters over a block of samples, with one
+ * channel in each lane
+ */
+BMENV_INLINE void BMEnvelopeFollower_processStageBlock(BMEnvelopeLaneState *st,
+													   const BMEnvelopeLaneCoefficients *c,
+													   BMEnvMask isRelease,
+													   BMEnvVec *block,
+													   size_t numSamples){
+	const BMEnvMask allActive = {-1, -1, -1, -1, -1, -1, -1, -1};
+	BMEnvelopeLaneState s = *st;
+	for(size_t i=0; i<numSamples; i++)
+		block[i] = BMEnvelopeLanes_step(&s, c, block[i], isRelease, allActive);
+	*st = s;
+}
+
+
+
+
+/*
+ * Process two consecutive stages over a block of samples. The second stage
+ * runs one sample behind the first, so the two recursions are independent
+ * within each iteration and the processor can overlap them.
+ */
+BMENV_INLINE void BMEnvelopeFollower_processStagePairBlock(BMEnvelopeLaneState *st1,
+														   const BMEnvelopeLaneCoefficients *c1,
+														   BMEnvMask isRelease1,
+														   BMEnvelopeLaneState *st2,
+														   const BMEnvelopeLaneCoefficients *c2,
+														   BMEnvMask isRelease2,
+														   BMEnvVec *block,
+														   size_t numSamples){
+	const BMEnvMask allActive = {-1, -1, -1, -1, -1, -1, -1, -1};
+	BMEnvelopeLaneState s1 = *st1;
+	BMEnvelopeLaneState s2 = *st2;
+	BMEnvVec y1 = BMEnvelopeLanes_step(&s1, c1, block[0], isRelease1, allActive);
+	for(size_t i=1; i<numSamples; i++){
+		BMEnvVec next = BMEnvelopeLanes_step(&s1, c1, block[i], isRelease1, allActive);
+		block[i-1] = BMEnvelopeLanes_step(&s2, c2, y1, isRelease2, allActive);
+		y1 = next;
+	}
+	block[numSamples-1] = BMEnvelopeLanes_step(&s2, c2, y1, isRelease2, allActive);
+	*st1 = s1;
+	*st2 = s2;
+}
+
+
+
+
+/*
+ * Process a group of up to BMENV_LANES channels. The release stages come
+ * first in the arrays, followed by the attack stages. Each stage, or pair
+ * of stages, runs over the whole block before the next, so the filter
+ * states stay in registers.
+ */
+BM_SIMD_DISPATCH
+static void BMEnvelopeFollower_processGroup(BMEnvelopeLaneState *states,
+											const BMEnvelopeLaneCoefficients *coefficients,
+											size_t numReleaseStages,
+											size_t numStages,
+											const float** inputs,
+											float** outputs,
+											size_t numChannels,
+											size_t numSamples){
+	const BMEnvMask release = {-1, -1, -1, -1, -1, -1, -1, -1};
+	const BMEnvMask attack = {0};
+	BMEnvVec block [BMENV_MC_BLOCK];
+
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, BMENV_MC_BLOCK);
+
+		// transpose the input into lanes
+		memset(block, 0, sizeof(BMEnvVec) * samplesProcessing);
+		for(size_t j=0; j<numChannels; j++){
+			const float *in = inputs[j] + samplesProcessed;
+			for(size_t i=0; i<samplesProcessing; i++)
+				block[i][j] = in[i];
+		}
+
+		size_t k = 0;
+		for(; k+1<numStages; k+=2){
+			BMEnvelopeLaneState *st = &states[k];
+			const BMEnvelopeLaneCoefficients *c = &coefficients[k];
+			if(k+1 < numReleaseStages)
+				BMEnvelopeFollower_processStagePairBlock(st, c, release, st+1, c+1, release, block, samplesProcessing);
+			else if(k < numReleaseStages)
+				BMEnvelopeFollower_processStagePairBlock(st, c, release, st+1, c+1, attack, block, samplesProcessing);
+			else
+				BMEnvelopeFollower_processStagePairBlock(st, c, attack, st+1, c+1, attack, block, samplesProcessing);
+		}
+		if(k < numStages){
+			if(k < numReleaseStages)
+				BMEnvelopeFollower_processStageBlock(&states[k], &coefficients[k], release, block, samplesProcessing);
+			else
+				BMEnvelopeFollower_processStageBlock(&states[k], &coefficients[k], attack, block, samplesProcessing);
+		}
+
+		// transpose back
+		for(size_t j=0; j<numChannels; j++){
+			float *out = outputs[j] + samplesProcessed;
+			for(size_t i=0; i<samplesProcessing; i++)
+				out[i] = block[i][j];
+		}
+
+		samplesProcessed += samplesProcessing;
+	}
+}
+
+
+
+
+void BMEnvelopeFollower_processMultichannel(BMEnvelopeFollower *followers,
+											const float** inputs,
+											float** outputs,
+											size_t numChannels,
+											size_t numSamples){
+	size_t numReleaseStages = followers[0].numReleaseStages;
+	size_t numAttackStages = followers[0].numAttackStages;
+	size_t numStages = numReleaseStages + numAttackStages;
+	for(size_t j=1; j<numChannels; j++){
+		assert(followers[j].numReleaseStages == numReleaseStages &&
+			   followers[j].numAttackStages == numAttackStages);
+	}
+
+	// process long chains one channel at a time
+	if(numStages > BMENV_MAX_FUSED_STAGES){
+		for(size_t j=0; j<numChannels; j++)
+			BMEnvelopeFollower_processBuffer(&followers[j], inputs[j], outputs[j], numSamples);
+		return;
+	}
+
+	BMEnvelopeLaneState states [BMENV_MAX_FUSED_STAGES];
+	BMEnvelopeLaneCoefficients coefficients [BMENV_MAX_FUSED_STAGES];
+
+	for(size_t first=0; first<numChannels; first += BMENV_LANES){
+		size_t numInGroup = BM_MIN(numChannels - first, BMENV_LANES);
+		BMEnvelopeFollower *group = followers + first;
+
+		// copy the filter states and coefficients into the lanes. Unused
+		// lanes get zeros; their output is never read.
+		memset(states, 0, sizeof(states));
+		memset(coefficients, 0, sizeof(coefficients));
+		for(size_t j=0; j<numInGroup; j++){
+			for(size_t k=0; k<numReleaseStages; k++)
+				BMReleaseFilter_loadLane(&group[j].releaseFilters[k], &states[k], &coefficients[k], j);
+			for(size_t k=0; k<numAttackStages; k++)
+				BMAttackFilter_loadLane(&group[j].attackFilters[k], &states[numReleaseStages + k], &coefficients[numReleaseStages + k], j);
+		}
+
+		BMEnvelopeFollower_processGroup(states, coefficients, numReleaseStages, numStages,
+										inputs + first, outputs + first,
+										numInGroup, numSamples);
+
+		// copy the states back
+		for(size_t j=0; j<numInGroup; j++){
+			for(size_t k=0; k<numReleaseStages; k++)
+				BMReleaseFilter_storeLane(&group[j].releaseFilters[k], &states[k], j);
+			for(size_t k=0; k<numAttackStages; k++)
+				BMAttackFilter_storeLane(&group[j].attackFilters[k], &states[numReleaseStages + k], j);
+		}
+	}
+}
+
+
+
+
 
 void BMEnvelopeFollower_init(BMEnvelopeFollower *This, float sampleRate){
     BMEnvelopeFollower_initWithCustomNumStages(This, BMENV_NUM_STAGES, BMENV_NUM_STAGES, sampleRate);
@@ -359,16 +788,9 @@ void BMEnvelopeFollower_setReleaseTime(BMEnvelopeFollower *This, float releaseTi
 
 void BMEnvelopeFollower_processBuffer(BMEnvelopeFollower *This, const float* input, float* output, size_t numSamples){
     
-    // process all the release filters in series
-    BMReleaseFilter_processBuffer(&This->releaseFilters[0], input, output, numSamples);
-    for(size_t i=1; i<This->numReleaseStages; i++)
-        BMReleaseFilter_processBuffer(&This->releaseFilters[i], output, output, numSamples);
-
-    if(This->numAttackStages > 0){
-        // process all the attack filters in series
-        for(size_t i=0; i<This->numAttackStages; i++)
-            BMAttackFilter_processBuffer(&This->attackFilters[i], output, output, numSamples);
-    }
+    // process all the release filters in series, followed by all the
+    // attack filters in series
+    BMEnvelopeFilterChain_process(This->releaseFilters, This->numReleaseStages,
+                                  This->attackFilters, This->numAttackStages,
+                                  input, output, numSamples);
 }
-
-
@@ -16,6 +16,9 @@
 
 #define BMENV_NUM_STAGES 3
 
+// chains with up to this many stages are processed by the fused kernel
+#define BMENV_MAX_FUSED_STAGES 8
+
 
 /*
  * These smoothing filters are based on the dBMAttackFilter_setCutoffs://cytomic.com/files/dsp/SvfLinearTrapOptimised2.pdf
@@ -69,6 +72,23 @@ void BMEnvelopeFollower_processBuffer(BMEnvelopeFollower *This,
                                       float* output,
                                       size_t numSamples);
 
+/*!
+ * BMEnvelopeFollower_processMultichannel
+ *
+ * @abstract process one channel of audio through each of the envelope followers. The output is the same as calling BMEnvelopeFollower_processBuffer on each follower, but the channels are processed together in vector lanes.
+ *
+ * @param followers    array of numChannels envelope followers, all with the same numbers of attack and release stages
+ * @param inputs       array of numChannels input buffers
+ * @param outputs      array of numChannels output buffers. In place processing is supported.
+ * @param numChannels  number of channels
+ * @param numSamples   length of each input and output buffer
+ */
+void BMEnvelopeFollower_processMultichannel(BMEnvelopeFollower *followers,
+                                            const float** inputs,
+                                            float** outputs,
+                                            size_t numChannels,
+                                            size_t numSamples);
+
 /*!
  * BMEnvelopeFollower_init
  */
@@ -161,6 +181,28 @@ void BMReleaseFilter_updateSampleRate(BMReleaseFilter *This, float sampleRate);
 void BMAttackFilter_updateSampleRate(BMAttackFilter *This, float sampleRate);
 
 
+/*!
+ * BMEnvelopeFilterChain_process
+ *
+ * @abstract process a chain of release filters followed by a chain of attack filters. The output is the same as calling BMReleaseFilter_processBuffer on each of the release filters in order and then BMAttackFilter_processBuffer on each of the attack filters, but all stages are computed together in a single pass.
+ *
+ * @param releaseFilters    array of numReleaseStages release filters, processed first
+ * @param numReleaseStages  may be zero
+ * @param attackFilters     array of numAttackStages attack filters
+ * @param numAttackStages   may be zero
+ * @param input             input array of length numSamples
+ * @param output            output array of length numSamples. In place processing is supported.
+ * @param numSamples        length of input and output
+ */
+void BMEnvelopeFilterChain_process(BMReleaseFilter *releaseFilters,
+                                   size_t numReleaseStages,
+                                   BMAttackFilter *attackFilters,
+                                   size_t numAttackStages,
+                                   const float* input,
+                                   float* output,
+                                   size_t numSamples);
+
+
 /*!
  * ARTimeToCutoffFrequency
  * @param time       time in seconds
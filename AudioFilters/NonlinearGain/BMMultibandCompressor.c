@@ -0,0 +1,278 @@
+//
+//  BMMultibandCompressor.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMMultibandCompressor.h"
+#include <stdlib.h>
+#include <float.h>
+#include <assert.h>
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+#include "Constants.h"
+#include "BMUnitConversion.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+void BMMultibandCompressor_init(BMMultibandCompressor *This, size_t numBands, float sampleRate){
+	assert(numBands == 3 || numBands == 4);
+
+	This->numBands = numBands;
+
+	bool fourthOrder = true;
+	bool stereo = true;
+	if(numBands == 3)
+		BMCrossover3way_init(&This->crossover3, 200.0f, 2000.0f, sampleRate, fourthOrder, stereo);
+	else
+		BMCrossover4way_init(&This->crossover4, 120.0f, 1000.0f, 6000.0f, sampleRate, fourthOrder, stereo);
+
+	// the same defaults as BMCompressor_init
+	for(size_t i=0; i<numBands; i++){
+		This->thresholdInDB[i] = -10.0f;
+		This->kneeWidthInDB[i] = 25.0f;
+		This->slope[i] = 1.0f - (1.0f / 4.0f);
+		This->attackTime[i] = 0.010f;
+		This->releaseTime[i] = 0.080f;
+
+		BMEnvelopeFollower_init(&This->envelopeFollowers[i], sampleRate);
+		BMEnvelopeFollower_setAttackTime(&This->envelopeFollowers[i], This->attackTime[i]);
+		BMEnvelopeFollower_setReleaseTime(&This->envelopeFollowers[i], This->releaseTime[i]);
+		BMQuadraticThreshold_initLower(&This->quadraticThresholds[i], This->thresholdInDB[i], This->kneeWidthInDB[i]);
+	}
+
+	// allocate all the buffers in one block
+	size_t numBuffers = 2*numBands + 2*numBands;
+	float *memory = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE * numBuffers);
+	for(size_t i=0; i<numBands; i++){
+		This->bandsL[i] = memory + (2*i) * BM_BUFFER_CHUNK_SIZE;
+		This->bandsR[i] = memory + (2*i + 1) * BM_BUFFER_CHUNK_SIZE;
+	}
+	This->detector = memory + 2*numBands*BM_BUFFER_CHUNK_SIZE;
+	This->buffer = This->detector + numBands*BM_BUFFER_CHUNK_SIZE;
+}
+
+
+
+
+void BMMultibandCompressor_free(BMMultibandCompressor *This){
+	if(This->numBands == 3)
+		BMCrossover3way_free(&This->crossover3);
+	else
+		BMCrossover4way_free(&This->crossover4);
+
+	for(size_t i=0; i<This->numBands; i++)
+		BMEnvelopeFollower_free(&This->envelopeFollowers[i]);
+
+	// bandsL[0] is the start of the block allocated in init
+	free(This->bandsL[0]);
+	for(size_t i=0; i<This->numBands; i++)
+		This->bandsL[i] = This->bandsR[i] = NULL;
+	This->detector = This->buffer = NULL;
+}
+
+
+
+
+/*
+ * Multiply each band by its gain and add the bands together
+ */
+static void BMMultibandCompressor_applyGainAndRecombine(BMMultibandCompressor *This,
+														const float *gain,
+														float *outputL, float *outputR,
+														size_t numSamples){
+	float **L = This->bandsL;
+	float **R = This->bandsR;
+	const float *g0 = gain;
+	const float *g1 = g0 + numSamples;
+	const float *g2 = g1 + numSamples;
+
+	if(This->numBands == 3){
+		for(size_t i=0; i<numSamples; i++){
+			outputL[i] = g0[i]*L[0][i] + g1[i]*L[1][i] + g2[i]*L[2][i];
+			outputR[i] = g0[i]*R[0][i] + g1[i]*R[1][i] + g2[i]*R[2][i];
+		}
+	} else {
+		const float *g3 = g2 + numSamples;
+		for(size_t i=0; i<numSamples; i++){
+			outputL[i] = g0[i]*L[0][i] + g1[i]*L[1][i] + g2[i]*L[2][i] + g3[i]*L[3][i];
+			outputR[i] = g0[i]*R[0][i] + g1[i]*R[1][i] + g2[i]*R[2][i] + g3[i]*R[3][i];
+		}
+	}
+}
+
+
+
+
+void BMMultibandCompressor_processStereo(BMMultibandCompressor *This,
+										 const float *inputL, const float *inputR,
+										 float *outputL, float *outputR,
+										 float *minGainDb,
+										 size_t numSamples){
+	size_t numBands = This->numBands;
+
+	if(minGainDb)
+		for(size_t i=0; i<numBands; i++)
+			minGainDb[i] = FLT_MAX;
+
+	while(numSamples > 0){
+		size_t samplesProcessing = BM_MIN(numSamples, BM_BUFFER_CHUNK_SIZE);
+		size_t length = samplesProcessing * numBands;
+
+		// split into bands
+		if(numBands == 3)
+			BMCrossover3way_processStereo(&This->crossover3, inputL, inputR,
+										  This->bandsL[0], This->bandsR[0],
+										  This->bandsL[1], This->bandsR[1],
+										  This->bandsL[2], This->bandsR[2],
+										  samplesProcessing);
+		else
+			BMCrossover4way_processStereo(&This->crossover4, inputL, inputR,
+										  This->bandsL[0], This->bandsR[0],
+										  This->bandsL[1], This->bandsR[1],
+										  This->bandsL[2], This->bandsR[2],
+										  This->bandsL[3], This->bandsR[3],
+										  samplesProcessing);
+
+		// the detector signal for band i is at detector + i*samplesProcessing
+		const float *detectorPointers [BMMBC_MAX_BANDS];
+		float *envelopePointers [BMMBC_MAX_BANDS];
+		for(size_t i=0; i<numBands; i++){
+			float *d = This->detector + i*samplesProcessing;
+			detectorPointers[i] = envelopePointers[i] = d;
+
+			// rectify the arithmetic mean of left and right, as
+			// BMCompressor does, so that the thresholds behave the same
+			float half = 0.5f;
+			vDSP_vasm(This->bandsL[i], 1, This->bandsR[i], 1, &half, d, 1, samplesProcessing);
+			vDSP_vabs(d, 1, d, 1, samplesProcessing);
+		}
+
+		// move zero values up to near-zero min value and convert to
+		// decibels, all bands at once
+		float lowerLimit = BM_DB_TO_GAIN(-140.0f);
+		vDSP_vthr(This->detector, 1, &lowerLimit, This->detector, 1, length);
+		float one = 1.0f;
+		uint32_t use20dBRule = 1;
+		vDSP_vdbcon(This->detector, 1, &one, This->detector, 1, length, use20dBRule);
+
+		// soft knee threshold and ratio with the settings of each band
+		for(size_t i=0; i<numBands; i++){
+			float *d = envelopePointers[i];
+			float *b = This->buffer + i*samplesProcessing;
+			BMQuadraticThreshold_lowerBuffer(&This->quadraticThresholds[i], d, b, samplesProcessing);
+			float oppositeThreshold = -This->thresholdInDB[i];
+			vDSP_vsadd(b, 1, &oppositeThreshold, d, 1, samplesProcessing);
+			vDSP_vsmul(d, 1, &This->slope[i], d, 1, samplesProcessing);
+		}
+
+		// filter to get a smooth volume change envelope, with one band in
+		// each vector lane
+		BMEnvelopeFollower_processMultichannel(This->envelopeFollowers, detectorPointers, envelopePointers, numBands, samplesProcessing);
+
+		// negate the signal to get the dB change required to apply the
+		// compression
+		vDSP_vneg(This->detector, 1, This->detector, 1, length);
+
+		// track the minimum gain set by the compressor in each band
+		if(minGainDb){
+			for(size_t i=0; i<numBands; i++){
+				float minGainThisChunk;
+				vDSP_minv(envelopePointers[i], 1, &minGainThisChunk, samplesProcessing);
+				minGainDb[i] = BM_MIN(minGainDb[i], minGainThisChunk);
+			}
+		}
+
+		// convert to linear gain control signal
+		BMConv_dBToGainV(This->detector, This->detector, length);
+
+		BMMultibandCompressor_applyGainAndRecombine(This, This->detector, outputL, outputR, samplesProcessing);
+
+		// advance pointers
+		numSamples -= samplesProcessing;
+		inputL += samplesProcessing;
+		inputR += samplesProcessing;
+		outputL += samplesProcessing;
+		outputR += samplesProcessing;
+	}
+}
+
+
+
+
+void BMMultibandCompressor_setCrossoverFrequency(BMMultibandCompressor *This, size_t index, float fc){
+	assert(index + 1 < This->numBands);
+
+	if(This->numBands == 3){
+		if(index == 0) BMCrossover3way_setCutoff1(&This->crossover3, fc);
+		else BMCrossover3way_setCutoff2(&This->crossover3, fc);
+	} else {
+		if(index == 0) BMCrossover4way_setCutoff1(&This->crossover4, fc);
+		else if(index == 1) BMCrossover4way_setCutoff2(&This->crossover4, fc);
+		else BMCrossover4way_setCutoff3(&This->crossover4, fc);
+	}
+}
+
+
+
+
+void BMMultibandCompressor_setThresholdInDB(BMMultibandCompressor *This, size_t band, float threshold){
+	assert(band < This->numBands);
+
+	This->thresholdInDB[band] = threshold;
+	BMQuadraticThreshold_initLower(&This->quadraticThresholds[band], threshold, This->kneeWidthInDB[band]);
+}
+
+
+
+
+void BMMultibandCompressor_setKneeWidthInDB(BMMultibandCompressor *This, size_t band, float kneeWidth){
+	assert(band < This->numBands && kneeWidth > 0.0f);
+
+	This->kneeWidthInDB[band] = kneeWidth;
+	BMQuadraticThreshold_initLower(&This->quadraticThresholds[band], This->thresholdInDB[band], kneeWidth);
+}
+
+
+
+
+void BMMultibandCompressor_setRatio(BMMultibandCompressor *This, size_t band, float ratio){
+	assert(band < This->numBands && ratio > 0.0f);
+
+	This->slope[band] = 1.0f - (1.0f / ratio);
+}
+
+
+
+
+void BMMultibandCompressor_setAttackTime(BMMultibandCompressor *This, size_t band, float attackTime){
+	assert(band < This->numBands && attackTime >= 0.0f);
+
+	This->attackTime[band] = attackTime;
+	BMEnvelopeFollower_setAttackTime(&This->envelopeFollowers[band], attackTime);
+}
+
+
+
+
+void BMMultibandCompressor_setReleaseTime(BMMultibandCompressor *This, size_t band, float releaseTime){
+	assert(band < This->numBands && releaseTime > 0.0f);
+
+	This->releaseTime[band] = releaseTime;
+	BMEnvelopeFollower_setReleaseTime(&This->envelopeFollowers[band], releaseTime);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
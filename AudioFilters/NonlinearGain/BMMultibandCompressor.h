@@ -0,0 +1,114 @@
+//
+//  BMMultibandCompressor.h
+//  AudioFiltersXcodeProject
+//
+//  A stereo compressor with three or four frequency bands, each with its
+//  own threshold, ratio, knee and timing.
+//
+//  The signal is split once by a BMCrossover3way or BMCrossover4way into
+//  band buffers that are allocated at init, one chunk long. The level
+//  detection for all bands runs together: the decibel conversion is done
+//  in a single pass over the detector buffers of all bands, and the
+//  envelope followers of the bands run in parallel vector lanes with
+//  BMEnvelopeFollower_processMultichannel. The gain is applied to each band
+//  in the same pass that adds the bands back together. Each band is
+//  linked in stereo and detects the level of the mean of left and right,
+//  like BMCompressor_ProcessBufferStereo.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMMultibandCompressor_h
+#define BMMultibandCompressor_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "BMCrossover.h"
+#include "BMEnvelopeFollower.h"
+#include "BMQuadraticThreshold.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMMBC_MAX_BANDS 4
+
+typedef struct BMMultibandCompressor {
+	BMCrossover3way crossover3;
+	BMCrossover4way crossover4;
+	BMEnvelopeFollower envelopeFollowers [BMMBC_MAX_BANDS];
+	BMQuadraticThreshold quadraticThresholds [BMMBC_MAX_BANDS];
+	float thresholdInDB [BMMBC_MAX_BANDS];
+	float kneeWidthInDB [BMMBC_MAX_BANDS];
+	float slope [BMMBC_MAX_BANDS];
+	float attackTime [BMMBC_MAX_BANDS];
+	float releaseTime [BMMBC_MAX_BANDS];
+
+	// band signals, and detector signals for all bands in one contiguous
+	// buffer, one chunk for each band
+	float *bandsL [BMMBC_MAX_BANDS], *bandsR [BMMBC_MAX_BANDS];
+	float *detector, *buffer;
+
+	size_t numBands;
+} BMMultibandCompressor;
+
+
+
+/*!
+ *BMMultibandCompressor_init
+ *
+ * @abstract init with the crossover frequencies at 200 and 2000 Hz for three bands or 120, 1000 and 6000 Hz for four bands, and the same default settings as BMCompressor_init in each band
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param numBands    3 or 4
+ * @param sampleRate  audio system sampling rate
+ */
+void BMMultibandCompressor_init(BMMultibandCompressor *This, size_t numBands, float sampleRate);
+
+
+/*!
+ *BMMultibandCompressor_free
+ */
+void BMMultibandCompressor_free(BMMultibandCompressor *This);
+
+
+/*!
+ *BMMultibandCompressor_processStereo
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputL      left input
+ * @param inputR      right input
+ * @param outputL     left output. In place processing is supported.
+ * @param outputR     right output
+ * @param minGainDb   array of numBands. Returns the lowest gain applied to each band during the buffer. May be NULL.
+ * @param numSamples  length of the buffers
+ */
+void BMMultibandCompressor_processStereo(BMMultibandCompressor *This,
+										 const float *inputL, const float *inputR,
+										 float *outputL, float *outputR,
+										 float *minGainDb,
+										 size_t numSamples);
+
+
+/*!
+ *BMMultibandCompressor_setCrossoverFrequency
+ *
+ * @param This   pointer to an initialised struct
+ * @param index  0 for the crossover between bands 0 and 1, up to numBands - 2
+ * @param fc     cutoff frequency in Hz
+ */
+void BMMultibandCompressor_setCrossoverFrequency(BMMultibandCompressor *This, size_t index, float fc);
+
+void BMMultibandCompressor_setThresholdInDB(BMMultibandCompressor *This, size_t band, float threshold);
+void BMMultibandCompressor_setKneeWidthInDB(BMMultibandCompressor *This, size_t band, float kneeWidth);
+void BMMultibandCompressor_setRatio(BMMultibandCompressor *This, size_t band, float ratio);
+void BMMultibandCompressor_setAttackTime(BMMultibandCompressor *This, size_t band, float attackTime);
+void BMMultibandCompressor_setReleaseTime(BMMultibandCompressor *This, size_t band, float releaseTime);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMMultibandCompressor_h */
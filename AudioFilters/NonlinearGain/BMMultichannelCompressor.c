@@ -0,0 +1,293 @@
+//
+//  BMMultichannelCompressor.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMMultichannelCompressor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <assert.h>
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+#include "Constants.h"
+#include "BMUnitConversion.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+
+static void BMMultichannelCompressor_initEnvelopeFollowers(BMMultichannelCompressor *This, float sampleRate){
+	for(size_t i=0; i<This->numChannels; i++){
+		BMEnvelopeFollower_init(&This->envelopeFollowers[i], sampleRate);
+		BMEnvelopeFollower_setAttackTime(&This->envelopeFollowers[i], This->attackTime);
+		BMEnvelopeFollower_setReleaseTime(&This->envelopeFollowers[i], This->releaseTime);
+	}
+}
+
+
+
+
+void BMMultichannelCompressor_init(BMMultichannelCompressor *This, float sampleRate, size_t numChannels){
+	float threshold = -10.0f;
+	float kneeWidth = 25.0f;
+	float ratio = 4.0f;
+	float attackTime = 0.010;
+	float releaseTime = 0.080;
+
+	BMMultichannelCompressor_initWithSettings(This,
+											  sampleRate,
+											  numChannels,
+											  threshold,
+											  kneeWidth,
+											  ratio,
+											  attackTime,
+											  releaseTime,
+											  true);
+}
+
+
+
+
+void BMMultichannelCompressor_initWithSettings(BMMultichannelCompressor *This,
+											   float sampleRate,
+											   size_t numChannels,
+											   float thresholdInDB,
+											   float kneeWidthInDB,
+											   float ratio,
+											   float attackTime,
+											   float releaseTime,
+											   bool linked){
+	assert(numChannels > 0 && numChannels <= BMMC_MAX_CHANNELS);
+
+	This->numChannels = numChannels;
+	This->linked = linked;
+	This->slope = 1.0f - (1.0f / ratio);
+	This->thresholdInDB = thresholdInDB;
+	This->kneeWidthInDB = kneeWidthInDB;
+	This->attackTime = attackTime;
+	This->releaseTime = releaseTime;
+
+	BMMultichannelCompressor_initEnvelopeFollowers(This, sampleRate);
+	BMQuadraticThreshold_initLower(&This->quadraticThreshold,
+								   This->thresholdInDB,
+								   This->kneeWidthInDB);
+
+	// one chunk for each channel, contiguous so that the gain computation
+	// can run over all channels at once
+	This->detector = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE * numChannels);
+	This->buffer = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE * numChannels);
+}
+
+
+
+
+void BMMultichannelCompressor_free(BMMultichannelCompressor *This){
+	free(This->detector);
+	This->detector = NULL;
+	free(This->buffer);
+	This->buffer = NULL;
+	for(size_t i=0; i<This->numChannels; i++)
+		BMEnvelopeFollower_free(&This->envelopeFollowers[i]);
+}
+
+
+
+
+void BMMultichannelCompressor_processWithSideChain(BMMultichannelCompressor *This,
+												   const float **inputs,
+												   const float **scInputs,
+												   float **outputs,
+												   float *minGainDb,
+												   size_t numSamples){
+	size_t numChannels = This->numChannels;
+	size_t numDetectors = This->linked ? 1 : numChannels;
+
+	if(minGainDb)
+		for(size_t i=0; i<numChannels; i++)
+			minGainDb[i] = FLT_MAX;
+
+	size_t samplesProcessed = 0;
+	while(samplesProcessed < numSamples){
+		size_t samplesProcessing = BM_MIN(numSamples - samplesProcessed, BM_BUFFER_CHUNK_SIZE);
+		size_t length = samplesProcessing * numDetectors;
+
+		// the detector signal for channel i is at detector + i*samplesProcessing
+		float *detector = This->detector;
+		const float *detectorPointers [BMMC_MAX_CHANNELS];
+		float *envelopePointers [BMMC_MAX_CHANNELS];
+		for(size_t i=0; i<numDetectors; i++)
+			detectorPointers[i] = envelopePointers[i] = detector + i*samplesProcessing;
+
+		// rectify the sidechain signal. In linked mode, take the largest
+		// magnitude across all channels.
+		if(This->linked){
+			vDSP_vabs(scInputs[0] + samplesProcessed, 1, detector, 1, samplesProcessing);
+			for(size_t i=1; i<numChannels; i++)
+				vDSP_vmaxmg(detector, 1, scInputs[i] + samplesProcessed, 1, detector, 1, samplesProcessing);
+		} else {
+			for(size_t i=0; i<numChannels; i++)
+				vDSP_vabs(scInputs[i] + samplesProcessed, 1, envelopePointers[i], 1, samplesProcessing);
+		}
+
+		// move zero values up to near-zero min value
+		float lowerLimit = BM_DB_TO_GAIN(-140.0f);
+		vDSP_vthr(detector, 1, &lowerLimit, detector, 1, length);
+
+		// convert linear gain to decibel scale
+		float one = 1.0f;
+		uint32_t use20dBRule = 1;
+		vDSP_vdbcon(detector, 1, &one, detector, 1, length, use20dBRule);
+
+		// clip values below the threshold with a soft knee
+		BMQuadraticThreshold_lowerBuffer(&This->quadraticThreshold, detector, This->buffer, length);
+
+		// shift the values up so that zero is the minimum
+		float oppositeThreshold = -This->thresholdInDB;
+		vDSP_vsadd(This->buffer, 1, &oppositeThreshold, detector, 1, length);
+
+		// apply the compression ratio
+		vDSP_vsmul(detector, 1, &This->slope, detector, 1, length);
+
+		// filter to get a smooth volume change envelope
+		if(This->linked)
+			BMEnvelopeFollower_processBuffer(&This->envelopeFollowers[0], detector, detector, samplesProcessing);
+		else
+			BMEnvelopeFollower_processMultichannel(This->envelopeFollowers, detectorPointers, envelopePointers, numChannels, samplesProcessing);
+
+		// negate the signal to get the dB change required to apply the compression
+		vDSP_vneg(detector, 1, detector, 1, length);
+
+		// track the minimum gain set by the compressor
+		if(minGainDb){
+			for(size_t i=0; i<numChannels; i++){
+				float minGainThisChunk;
+				vDSP_minv(envelopePointers[This->linked ? 0 : i], 1, &minGainThisChunk, samplesProcessing);
+				minGainDb[i] = BM_MIN(minGainDb[i], minGainThisChunk);
+			}
+		}
+
+		// convert to linear gain control signal
+		BMConv_dBToGainV(detector, detector, length);
+
+		// apply the gain adjustment to the audio signal
+		for(size_t i=0; i<numChannels; i++){
+			const float *gain = envelopePointers[This->linked ? 0 : i];
+			vDSP_vmul(gain, 1, inputs[i] + samplesProcessed, 1, outputs[i] + samplesProcessed, 1, samplesProcessing);
+		}
+
+		samplesProcessed += samplesProcessing;
+	}
+}
+
+
+
+
+void BMMultichannelCompressor_process(BMMultichannelCompressor *This,
+									  const float **inputs,
+									  float **outputs,
+									  float *minGainDb,
+									  size_t numSamples){
+	BMMultichannelCompressor_processWithSideChain(This, inputs, inputs, outputs, minGainDb, numSamples);
+}
+
+
+
+
+void BMMultichannelCompressor_setLinked(BMMultichannelCompressor *This, bool linked){
+	// when unlinking, start all the channels from the state of the linked
+	// envelope so that the gain does not jump
+	if(This->linked && !linked){
+		BMEnvelopeFollower *src = &This->envelopeFollowers[0];
+		for(size_t i=1; i<This->numChannels; i++){
+			BMEnvelopeFollower *dst = &This->envelopeFollowers[i];
+			memcpy(dst->releaseFilters, src->releaseFilters, sizeof(BMReleaseFilter) * src->numReleaseStages);
+			memcpy(dst->attackFilters, src->attackFilters, sizeof(BMAttackFilter) * src->numAttackStages);
+		}
+	}
+	This->linked = linked;
+}
+
+
+
+
+static void BMMultichannelCompressor_updateThreshold(BMMultichannelCompressor *This){
+	BMQuadraticThreshold_initLower(&This->quadraticThreshold,
+								   This->thresholdInDB,
+								   This->kneeWidthInDB);
+}
+
+
+
+
+void BMMultichannelCompressor_setThresholdInDB(BMMultichannelCompressor *This, float threshold){
+	This->thresholdInDB = threshold;
+	BMMultichannelCompressor_updateThreshold(This);
+}
+
+
+
+
+void BMMultichannelCompressor_setKneeWidthInDB(BMMultichannelCompressor *This, float kneeWidth){
+	assert(kneeWidth > 0.0f);
+
+	This->kneeWidthInDB = kneeWidth;
+	BMMultichannelCompressor_updateThreshold(This);
+}
+
+
+
+
+void BMMultichannelCompressor_setRatio(BMMultichannelCompressor *This, float ratio){
+	assert(ratio > 0.0);
+
+	This->slope = 1.0f - (1.0f / ratio);
+}
+
+
+
+
+void BMMultichannelCompressor_setAttackTime(BMMultichannelCompressor *This, float attackTime){
+	assert(attackTime >= 0.0f);
+
+	This->attackTime = attackTime;
+	for(size_t i=0; i<This->numChannels; i++)
+		BMEnvelopeFollower_setAttackTime(&This->envelopeFollowers[i], attackTime);
+}
+
+
+
+
+void BMMultichannelCompressor_setReleaseTime(BMMultichannelCompressor *This, float releaseTime){
+	assert(releaseTime > 0.0f);
+
+	This->releaseTime = releaseTime;
+	for(size_t i=0; i<This->numChannels; i++)
+		BMEnvelopeFollower_setReleaseTime(&This->envelopeFollowers[i], releaseTime);
+}
+
+
+
+
+void BMMultichannelCompressor_setSampleRate(BMMultichannelCompressor *This, float sampleRate){
+	assert(sampleRate > 0.0f);
+
+	for(size_t i=0; i<This->numChannels; i++)
+		BMEnvelopeFollower_free(&This->envelopeFollowers[i]);
+	BMMultichannelCompressor_initEnvelopeFollowers(This, sampleRate);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,150 @@
+//
+//  BMMultichannelCompressor.h
+//  AudioFiltersXcodeProject
+//
+//  A compressor for up to BMMC_MAX_CHANNELS channels, for example a 7.1.4
+//  bed, processed in a single call.
+//
+//  In linked mode all channels get the same gain, computed from the
+//  largest magnitude across the detector channels at each sample, so the
+//  spatial image does not shift when one channel is loud. In unlinked mode
+//  each channel is compressed according to its own level.
+//
+//  The detector inputs may be the audio inputs themselves or a separate
+//  sidechain signal for each channel.
+//
+//  The gain computation is the same as in BMCompressor. The level
+//  conversion and soft-knee threshold are computed for all channels in one
+//  pass over a contiguous buffer, and in unlinked mode the envelope
+//  followers process the channels in parallel vector lanes with
+//  BMEnvelopeFollower_processMultichannel.
+//
+//  For a limiter, set the ratio to INFINITY.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMMultichannelCompressor_h
+#define BMMultichannelCompressor_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "BMEnvelopeFollower.h"
+#include "BMQuadraticThreshold.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMMC_MAX_CHANNELS 16
+
+typedef struct BMMultichannelCompressor {
+	float thresholdInDB, kneeWidthInDB, releaseTime, attackTime, slope;
+	BMEnvelopeFollower envelopeFollowers [BMMC_MAX_CHANNELS];
+	BMQuadraticThreshold quadraticThreshold;
+	float *detector, *buffer;
+	size_t numChannels;
+	bool linked;
+} BMMultichannelCompressor;
+
+
+
+/*!
+ *BMMultichannelCompressor_init
+ *
+ * @abstract init with the same default settings as BMCompressor_init, in linked mode
+ *
+ * @param This         pointer to an uninitialised struct
+ * @param sampleRate   audio system sampling rate
+ * @param numChannels  number of channels, <= BMMC_MAX_CHANNELS
+ */
+void BMMultichannelCompressor_init(BMMultichannelCompressor *This, float sampleRate, size_t numChannels);
+
+
+/*!
+ *BMMultichannelCompressor_initWithSettings
+ *
+ * @param This           pointer to an uninitialised struct
+ * @param sampleRate     audio system sampling rate
+ * @param numChannels    number of channels, <= BMMC_MAX_CHANNELS
+ * @param thresholdInDB  above this threshold, we start compressing
+ * @param kneeWidthInDB  soften the transition from compressing to not compressing in [threshold-knee,threshold+knee]
+ * @param ratio          compressor ratio
+ * @param attackTime     time from onset of note to 90% compressor gain change
+ * @param releaseTime    time from release of note to 90% compressor gain change
+ * @param linked         true to apply the same gain to all channels
+ */
+void BMMultichannelCompressor_initWithSettings(BMMultichannelCompressor *This,
+											   float sampleRate,
+											   size_t numChannels,
+											   float thresholdInDB,
+											   float kneeWidthInDB,
+											   float ratio,
+											   float attackTime,
+											   float releaseTime,
+											   bool linked);
+
+
+/*!
+ *BMMultichannelCompressor_free
+ */
+void BMMultichannelCompressor_free(BMMultichannelCompressor *This);
+
+
+/*!
+ *BMMultichannelCompressor_process
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of numChannels input buffers
+ * @param outputs     array of numChannels output buffers. In place processing is supported.
+ * @param minGainDb   array of numChannels. Returns the lowest gain applied to each channel during the buffer. May be NULL.
+ * @param numSamples  length of each buffer
+ */
+void BMMultichannelCompressor_process(BMMultichannelCompressor *This,
+									  const float **inputs,
+									  float **outputs,
+									  float *minGainDb,
+									  size_t numSamples);
+
+
+/*!
+ *BMMultichannelCompressor_processWithSideChain
+ *
+ * @abstract compress inputs according to the level of scInputs
+ *
+ * @param This        pointer to an initialised struct
+ * @param inputs      array of numChannels input buffers
+ * @param scInputs    array of numChannels sidechain buffers. Channel i of the sidechain controls the gain of channel i of the input in unlinked mode.
+ * @param outputs     array of numChannels output buffers. In place processing is supported.
+ * @param minGainDb   array of numChannels. Returns the lowest gain applied to each channel during the buffer. May be NULL.
+ * @param numSamples  length of each buffer
+ */
+void BMMultichannelCompressor_processWithSideChain(BMMultichannelCompressor *This,
+												   const float **inputs,
+												   const float **scInputs,
+												   float **outputs,
+												   float *minGainDb,
+												   size_t numSamples);
+
+
+/*!
+ *BMMultichannelCompressor_setLinked
+ *
+ * @abstract in linked mode, all channels get the same gain
+ */
+void BMMultichannelCompressor_setLinked(BMMultichannelCompressor *This, bool linked);
+
+void BMMultichannelCompressor_setThresholdInDB(BMMultichannelCompressor *This, float threshold);
+void BMMultichannelCompressor_setKneeWidthInDB(BMMultichannelCompressor *This, float kneeWidth);
+void BMMultichannelCompressor_setRatio(BMMultichannelCompressor *This, float ratio);
+void BMMultichannelCompressor_setAttackTime(BMMultichannelCompressor *This, float attackTime);
+void BMMultichannelCompressor_setReleaseTime(BMMultichannelCompressor *This, float releaseTime);
+void BMMultichannelCompressor_setSampleRate(BMMultichannelCompressor *This, float sampleRate);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMMultichannelCompressor_h */
@@ -14,7 +14,11 @@ extern "C" {
 	
 #include "BMNoiseGate.h"
 #include "BMEnvelopeFollower.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 	
 	
 #define BM_NOISE_GATE_DEFAULT_ATTACK_TIME 0.001
@@ -7,8 +7,13 @@
 //
 
 #include "BMPeakLimiter.h"
+#include <stdlib.h>
 #include <string.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 #define BM_PEAK_LIMITER_LOOKAHEAD_TIME_DV 0.00025f
@@ -16,6 +21,13 @@
 #define BM_PEAK_LIMITER_RELEASE_TIME_DV 0.200f
 #define BM_PEAK_LIMITER_THRESHOLD_GAIN_DV BM_DB_TO_GAIN(-2.0f)
 
+// In true peak mode, the values interpolated between samples n and n+1
+// are computed from samples n-5 through n+6. The gain reduction for a peak
+// is held this many extra samples on each side of those two samples so
+// that the gain is constant over all the samples the output peak is
+// interpolated from.
+#define BM_PEAK_LIMITER_TRUE_PEAK_HOLD (BMTP_TAPS_PER_PHASE / 2 - 1)
+
 
 
 void BMPeakLimiter_init(BMPeakLimiter *This, bool stereo, float sampleRate){
@@ -37,6 +49,21 @@ void BMPeakLimiter_init(BMPeakLimiter *This, bool stereo, float sampleRate){
     
     // not limiting yet on startup
     This->isLimiting = false;
+    
+    // true peak mode is off by default. The window buffers are allocated
+    // for the longest look-ahead now so that switching true peak mode on
+    // or changing the look-ahead doesn't allocate on the audio thread. The
+    // maximum is taken over one sample more than the moving average
+    // because each detected peak applies to two input samples, plus the
+    // hold time on both sides.
+    BMTruePeakDetector_init(&This->truePeakDetector, numChannels);
+    This->truePeakMode = This->targetTruePeakMode = false;
+    This->maxWindowLength = BM_MAX((size_t)(BM_PEAK_LIMITER_MAX_TRUE_PEAK_LOOKAHEAD_TIME * sampleRate), 1);
+    size_t maxQueueCapacity = This->maxWindowLength + 1 + 2*BM_PEAK_LIMITER_TRUE_PEAK_HOLD;
+    This->maxQueueValues = malloc(sizeof(float) * maxQueueCapacity);
+    This->maxQueueTimes = malloc(sizeof(size_t) * maxQueueCapacity);
+    This->averageBuffer = malloc(sizeof(float) * This->maxWindowLength);
+    This->windowLength = 0;
 }
 
 
@@ -46,6 +73,13 @@ void BMPeakLimiter_init(BMPeakLimiter *This, bool stereo, float sampleRate){
 void BMPeakLimiter_free(BMPeakLimiter *This){
     BMEnvelopeFollower_free(&This->envelopeFollower);
     BMShortSimpleDelay_free(&This->delay);
+    BMTruePeakDetector_free(&This->truePeakDetector);
+    free(This->maxQueueValues);
+    This->maxQueueValues = NULL;
+    free(This->maxQueueTimes);
+    This->maxQueueTimes = NULL;
+    free(This->averageBuffer);
+    This->averageBuffer = NULL;
 }
 
 
@@ -70,8 +104,63 @@ void BMPeakLimiter_setThreshold(BMPeakLimiter *This, float thresholdDb){
 
 
 
+void BMPeakLimiter_setTruePeakMode(BMPeakLimiter *This, bool truePeak){
+    This->targetTruePeakMode = truePeak;
+}
+
+
+
+/*
+ * the length of the true peak window for a look-ahead of lookaheadInSamples
+ */
+static size_t BMPeakLimiter_truePeakWindowLength(BMPeakLimiter *This, size_t lookaheadInSamples){
+    return BM_MIN(BM_MAX(lookaheadInSamples, 1), This->maxWindowLength);
+}
+
+
+
+size_t BMPeakLimiter_getLatencyInSamples(BMPeakLimiter *This){
+    size_t lookaheadInSamples = This->targetLookaheadTime * This->sampleRate;
+    if(This->targetTruePeakMode)
+        return BMPeakLimiter_truePeakWindowLength(This, lookaheadInSamples) + BM_PEAK_LIMITER_TRUE_PEAK_HOLD + BMTP_LATENCY;
+    return lookaheadInSamples;
+}
+
+
+
+/*
+ * Clear the true peak look-ahead window. The moving average starts full of
+ * threshold values so that the gain starts at 1.
+ */
+static void BMPeakLimiter_resetTruePeakWindow(BMPeakLimiter *This){
+    This->maxQueueStart = This->maxQueueCount = 0;
+    This->time = 0;
+    This->averageIndex = 0;
+    vDSP_vfill(&This->thresholdGain, This->averageBuffer, 1, This->windowLength);
+    This->averageSum = (double)This->thresholdGain * (double)This->windowLength;
+    BMTruePeakDetector_reset(&This->truePeakDetector);
+}
+
+
+
+static void BMPeakLimiter_initTruePeakWindow(BMPeakLimiter *This, size_t lookaheadInSamples){
+    This->windowLength = BMPeakLimiter_truePeakWindowLength(This, lookaheadInSamples);
+    BMPeakLimiter_resetTruePeakWindow(This);
+}
+
+
+
 void BMPeakLimiter_update(BMPeakLimiter *This){
     size_t delayInSamples = This->targetLookaheadTime * This->sampleRate;
+    
+    // in true peak mode, the delay includes the latency of the true peak
+    // detector and the hold time before each peak
+    This->truePeakMode = This->targetTruePeakMode;
+    if(This->truePeakMode){
+        BMPeakLimiter_initTruePeakWindow(This, delayInSamples);
+        delayInSamples = This->windowLength + BM_PEAK_LIMITER_TRUE_PEAK_HOLD + BMTP_LATENCY;
+    }
+    
     BMShortSimpleDelay_changeLength(&This->delay, delayInSamples);
     BMEnvelopeFollower_setAttackTime(&This->envelopeFollower, This->targetLookaheadTime * BM_PEAK_LIMITER_ATTACK_LOOKAHEAD_RATIO);
     
@@ -81,6 +170,113 @@ void BMPeakLimiter_update(BMPeakLimiter *This){
 
 
 
+static inline bool BMPeakLimiter_needsUpdate(BMPeakLimiter *This){
+    return This->lookaheadTime != This->targetLookaheadTime ||
+           This->truePeakMode != This->targetTruePeakMode;
+}
+
+
+
+/*
+ * Smooth the true peak envelope so that the gain reaches its lowest value
+ * by the time the peak comes out of the delay, and holds it until the peak
+ * has passed.
+ *
+ * Each detected peak is held for windowLength + 1 + 2 * hold samples by a
+ * sliding window maximum, computed with a monotonic queue: the queue holds the
+ * values that could still become the maximum, in decreasing order, so the
+ * front of the queue is the maximum of the window. Each value enters and
+ * leaves the queue once, so the cost per sample is constant.
+ *
+ * The moving average of length windowLength that follows ramps the
+ * envelope up smoothly. Because every value in the average is at least as
+ * high as the peak, the envelope reaches the peak level hold samples
+ * before the peak comes out of the delay, and stays there until hold
+ * samples after it.
+ */
+static void BMPeakLimiter_lookaheadEnvelope(BMPeakLimiter *This, float *envelope, size_t numSamples){
+    size_t windowLength = This->windowLength;
+    size_t capacity = windowLength + 1 + 2*BM_PEAK_LIMITER_TRUE_PEAK_HOLD;
+    float *values = This->maxQueueValues;
+    size_t *times = This->maxQueueTimes;
+    size_t start = This->maxQueueStart;
+    size_t count = This->maxQueueCount;
+    size_t time = This->time;
+    size_t averageIndex = This->averageIndex;
+    double averageSum = This->averageSum;
+    double averageScale = 1.0 / (double)windowLength;
+    
+    for(size_t i=0; i<numSamples; i++){
+        float x = envelope[i];
+        
+        // remove the front value if it is older than the window
+        if(count > 0 && time - times[start] >= capacity){
+            start = (start + 1 == capacity) ? 0 : start + 1;
+            count--;
+        }
+        
+        // remove values at the back that are not larger than the new value
+        while(count > 0){
+            size_t back = start + count - 1;
+            if(back >= capacity) back -= capacity;
+            if(values[back] > x) break;
+            count--;
+        }
+        
+        // add the new value at the back
+        size_t end = start + count;
+        if(end >= capacity) end -= capacity;
+        values[end] = x;
+        times[end] = time;
+        count++;
+        time++;
+        
+        // moving average of the window maximum
+        float windowMax = values[start];
+        averageSum += windowMax - This->averageBuffer[averageIndex];
+        This->averageBuffer[averageIndex] = windowMax;
+        if(++averageIndex == windowLength){
+            averageIndex = 0;
+            
+            // recompute the sum once per cycle so that rounding errors do
+            // not accumulate
+            averageSum = 0.0;
+            for(size_t j=0; j<windowLength; j++)
+                averageSum += This->averageBuffer[j];
+        }
+        envelope[i] = averageSum * averageScale;
+    }
+    
+    This->maxQueueStart = start;
+    This->maxQueueCount = count;
+    This->time = time;
+    This->averageIndex = averageIndex;
+    This->averageSum = averageSum;
+}
+
+
+
+/*
+ * Compute the envelope for true peak mode from the thresholded true peak
+ * signal
+ */
+static void BMPeakLimiter_truePeakEnvelope(BMPeakLimiter *This, float *envelope, float *scratch, size_t numSamples){
+    // release smoothing. The release filters follow rising input instantly.
+    // Taking the max with the input keeps the envelope from falling below
+    // the peaks if the filter output dips.
+    memcpy(scratch, envelope, sizeof(float)*numSamples);
+    BMEnvelopeFollower *ef = &This->envelopeFollower;
+    BMEnvelopeFilterChain_process(ef->releaseFilters, ef->numReleaseStages,
+                                  ef->attackFilters, 0,
+                                  envelope, envelope, numSamples);
+    vDSP_vmax(scratch, 1, envelope, 1, envelope, 1, numSamples);
+    
+    // look ahead
+    BMPeakLimiter_lookaheadEnvelope(This, envelope, numSamples);
+}
+
+
+
 
 
 void BMPeakLimiter_processStereo(BMPeakLimiter *This,
@@ -88,7 +284,7 @@ void BMPeakLimiter_processStereo(BMPeakLimiter *This,
                                  float *outL, float *outR,
                                  size_t numSamples){
     // if the lookahead needs an update, do that instead of processing audio
-    if(This->lookaheadTime != This->targetLookaheadTime){
+    if(BMPeakLimiter_needsUpdate(This)){
         // clear the output buffers in case we don't finish the output on time
         memset(outL,0,sizeof(float)*numSamples);
         memset(outR,0,sizeof(float)*numSamples);
@@ -102,21 +298,30 @@ void BMPeakLimiter_processStereo(BMPeakLimiter *This,
     while(samplesProcessed< numSamples){
         size_t samplesProcessing = BM_MIN(BM_BUFFER_CHUNK_SIZE, numSamples-samplesProcessed);
         
-        // rectify the left and right channels into the buffers
-        vDSP_vabs(inL+samplesProcessed, 1, This->bufferL, 1, samplesProcessing);
-        vDSP_vabs(inR+samplesProcessed, 1, This->bufferR, 1, samplesProcessing);
-        
         // make an alias pointer for code readability
         float* envelope = This->controlSignal;
         
-        // take the max of the left and right channels into the envelope buffer
-        vDSP_vmax(This->bufferL, 1, This->bufferR, 1, envelope, 1, samplesProcessing);
+        if(This->truePeakMode){
+            // detect the true peak of the left and right channels
+            const float* inputs [2] = {inL+samplesProcessed,inR+samplesProcessed};
+            BMTruePeakDetector_process(&This->truePeakDetector, inputs, envelope, samplesProcessing);
+        } else {
+            // rectify the left and right channels into the buffers
+            vDSP_vabs(inL+samplesProcessed, 1, This->bufferL, 1, samplesProcessing);
+            vDSP_vabs(inR+samplesProcessed, 1, This->bufferR, 1, samplesProcessing);
+            
+            // take the max of the left and right channels into the envelope buffer
+            vDSP_vmax(This->bufferL, 1, This->bufferR, 1, envelope, 1, samplesProcessing);
+        }
         
         // replace values below the threshold with the threshold itself
         vDSP_vthr(envelope, 1, &This->thresholdGain, envelope, 1, samplesProcessing);
         
         // apply an envelope follower to the control signal to smooth it out
-        BMEnvelopeFollower_processBuffer(&This->envelopeFollower, envelope, envelope, samplesProcessing);
+        if(This->truePeakMode)
+            BMPeakLimiter_truePeakEnvelope(This, envelope, This->bufferL, samplesProcessing);
+        else
+            BMEnvelopeFollower_processBuffer(&This->envelopeFollower, envelope, envelope, samplesProcessing);
         
         // control signal = threshold / envelope
         vDSP_svdiv(&This->thresholdGain, envelope, 1, This->controlSignal, 1, samplesProcessing);
@@ -147,7 +352,7 @@ void BMPeakLimiter_processMono(BMPeakLimiter *This,
                                float *output,
                                size_t numSamples){
     // if the lookahead needs an update, do that instead of processing audio
-    if(This->lookaheadTime != This->targetLookaheadTime){
+    if(BMPeakLimiter_needsUpdate(This)){
         // clear the output buffer in case we don't finish the output on time
         memset(output,0,sizeof(float)*numSamples);
         
@@ -165,13 +370,20 @@ void BMPeakLimiter_processMono(BMPeakLimiter *This,
         float* envelope = This->controlSignal;
         
         // rectify the input into the envelope buffer
-        vDSP_vabs(input+samplesProcessed, 1, envelope, 1, samplesProcessing);
+        if(This->truePeakMode){
+            const float* inputs [1] = {input+samplesProcessed};
+            BMTruePeakDetector_process(&This->truePeakDetector, inputs, envelope, samplesProcessing);
+        } else
+            vDSP_vabs(input+samplesProcessed, 1, envelope, 1, samplesProcessing);
         
         // replace values below the threshold with the threshold itself
         vDSP_vthr(envelope, 1, &This->thresholdGain, envelope, 1, samplesProcessing);
         
         // apply an envelope follower to the envelope to smooth it out
-        BMEnvelopeFollower_processBuffer(&This->envelopeFollower, envelope, envelope, samplesProcessing);
+        if(This->truePeakMode)
+            BMPeakLimiter_truePeakEnvelope(This, envelope, This->bufferL, samplesProcessing);
+        else
+            BMEnvelopeFollower_processBuffer(&This->envelopeFollower, envelope, envelope, samplesProcessing);
         
         // control signal = threshold / envelope
         vDSP_svdiv(&This->thresholdGain, envelope, 1, This->controlSignal, 1, samplesProcessing);
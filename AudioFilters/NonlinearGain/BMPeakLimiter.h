@@ -2,6 +2,18 @@
 //  BMPeakLimiter.h
 //  AudioFiltersXcodeProject
 //
+//  A look-ahead peak limiter.
+//
+//  In true peak mode the limiter detects the peaks of the signal upsampled
+//  by four with BMTruePeakDetector (ITU-R BS.1770-4), so that the
+//  output stays below the threshold in dBTP. The upsampling is done only on
+//  the sidechain. The look-ahead envelope is the maximum over a sliding
+//  window, computed with a monotonic queue, followed by a moving average
+//  of the same length. The cost per sample does not depend on the length
+//  of the look-ahead. The latency in true peak mode is the look-ahead
+//  time plus BMTP_LATENCY samples plus a short hold before each peak; see
+//  BMPeakLimiter_getLatencyInSamples.
+//
 //  Created by hans anderson on 12/5/19.
 //  Anyone may use this file without restrictions
 //
@@ -12,8 +24,14 @@
 #include <stdio.h>
 #include "BMShortSimpleDelay.h"
 #include "BMEnvelopeFollower.h"
+#include "BMTruePeakDetector.h"
 #include "Constants.h"
 
+// the longest look-ahead time in true peak mode. The true peak window is
+// allocated for this length on init so that changing the look-ahead
+// doesn't allocate memory on the audio thread.
+#define BM_PEAK_LIMITER_MAX_TRUE_PEAK_LOOKAHEAD_TIME 0.050f
+
 
 typedef struct BMPeakLimiter {
 	BMShortSimpleDelay delay;
@@ -23,6 +41,14 @@ typedef struct BMPeakLimiter {
 	float bufferR [BM_BUFFER_CHUNK_SIZE];
 	float controlSignal [BM_BUFFER_CHUNK_SIZE];
 	bool isLimiting;
+
+	// true peak mode
+	BMTruePeakDetector truePeakDetector;
+	float *maxQueueValues, *averageBuffer;
+	size_t *maxQueueTimes;
+	size_t maxQueueStart, maxQueueCount, windowLength, maxWindowLength, averageIndex, time;
+	double averageSum;
+	bool truePeakMode, targetTruePeakMode;
 } BMPeakLimiter;
 
 
@@ -48,6 +74,8 @@ void BMPeakLimiter_setThreshold(BMPeakLimiter *This, float thresholdDb);
 
 /*!
  *BMPeakLimiter_setLookahead
+ *
+ * @abstract In true peak mode, the look-ahead time is limited to BM_PEAK_LIMITER_MAX_TRUE_PEAK_LOOKAHEAD_TIME.
  */
 void BMPeakLimiter_setLookahead(BMPeakLimiter *This, float timeInSeconds);
 
@@ -76,6 +104,26 @@ void BMPeakLimiter_processMono(BMPeakLimiter *This,
 
 
 
+/*!
+ *BMPeakLimiter_setTruePeakMode
+ *
+ * @abstract In true peak mode, the threshold applies to the inter-sample peaks of the output, as measured by BMTruePeakDetector. The gain is held constant over the samples each peak is interpolated from, so the output stays at or below the threshold up to float rounding (about 1e-5 dB) for any look-ahead time. A look-ahead time of at least 1 ms is recommended in this mode to keep the gain changes smooth. The change takes effect at the start of the next call to process.
+ *
+ * @param truePeak  true to enable true peak mode
+ */
+void BMPeakLimiter_setTruePeakMode(BMPeakLimiter *This, bool truePeak);
+
+
+
+/*!
+ *BMPeakLimiter_getLatencyInSamples
+ *
+ * @returns the delay of the output relative to the input
+ */
+size_t BMPeakLimiter_getLatencyInSamples(BMPeakLimiter *This);
+
+
+
 /*!
  *BMPeakLimiter_isLimiting
  *
@@ -9,7 +9,11 @@
 #ifndef BMQuadraticThreshold_h
 #define BMQuadraticThreshold_h
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 typedef struct BMQuadraticThreshold {
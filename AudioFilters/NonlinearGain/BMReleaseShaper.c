@@ -7,7 +7,11 @@
 //
 
 #include "BMReleaseShaper.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 #include "BMUnitConversion.h"
 
@@ -37,8 +41,7 @@ void BMReleaseShaper_processStereo(BMReleaseShaper *This,
         vDSP_vdbcon(This->b1, 1, &zeroDb, This->b1, 1, samplesProcessing, use20dB);
         
         // release filter to get fast decay envelope -> buffer1
-        for(size_t i=0; i<BMRS_NUM_RELEASE_FILTERS; i++)
-        BMReleaseFilter_processBuffer(&This->fastRelease[i], This->b1, This->b1, samplesProcessing);
+        BMEnvelopeFilterChain_process(This->fastRelease, BMRS_NUM_RELEASE_FILTERS, NULL, 0, This->b1, This->b1, samplesProcessing);
         
         // release filter again to get slow decay envelope -> buffer2
         BMReleaseFilter_processBuffer(&This->slowRelease, This->b1, This->b2, samplesProcessing);
@@ -7,7 +7,11 @@
 //
 
 #include "BMTanhLimiter.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <assert.h>
 #include <simd/simd.h>
 
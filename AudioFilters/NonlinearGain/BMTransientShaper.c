@@ -8,7 +8,11 @@
 
 #include "BMTransientShaper.h"
 #include <assert.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMIntegerMath.h"
 
 
@@ -145,9 +149,7 @@ void BMTransientEnveloper_processBuffer(BMTransientEnveloper *This,
     float* slowRelease = releaseEnvelope;
     
     // compute the fast release envelope
-    BMReleaseFilter_processBuffer(&This->releaseRF1[0], input, fastRelease, numSamples);
-    for (size_t i=1; i<BMENV_NUM_STAGES; i++)
-        BMReleaseFilter_processBuffer(&This->releaseRF1[i], fastRelease, fastRelease, numSamples);
+    BMEnvelopeFilterChain_process(This->releaseRF1, BMENV_NUM_STAGES, NULL, 0, input, fastRelease, numSamples);
     
     // release filter the complete envelope another time to get slower release
     BMReleaseFilter_processBuffer(&This->releaseRF2,fastRelease,slowRelease,numSamples);
@@ -176,10 +178,7 @@ void BMTransientEnveloper_processBuffer(BMTransientEnveloper *This,
     // follow closely after each other will not be detected at correct amplitude.
     //
     // Recommended setting: 1/2 second
-    BMReleaseFilter_processBuffer(&This->attackRF1[0],
-                                  input, fastAttack, numSamples);
-    for(size_t i=1; i<BMENV_NUM_STAGES; i++)
-        BMReleaseFilter_processBuffer(&This->attackRF1[i], fastAttack, fastAttack, numSamples);
+    BMEnvelopeFilterChain_process(This->attackRF1, BMENV_NUM_STAGES, NULL, 0, input, fastAttack, numSamples);
     
     
     // Create a slower attack envelope to compare with the fast attack envelope
@@ -191,9 +190,7 @@ void BMTransientEnveloper_processBuffer(BMTransientEnveloper *This,
     // of the transients.
     //
     // Recommended setting: 1/20 second
-    BMAttackFilter_processBuffer(&This->attackAF1[0], fastAttack, slowAttack, numSamples);
-    for(size_t i=1; i<BMENV_NUM_STAGES; i++)
-        BMAttackFilter_processBuffer(&This->attackAF1[i], slowAttack, slowAttack, numSamples);
+    BMEnvelopeFilterChain_process(NULL, 0, This->attackAF1, BMENV_NUM_STAGES, fastAttack, slowAttack, numSamples);
     
     
     // take (fast - slow) to get the unfiltered attack transient envelope
@@ -213,8 +210,8 @@ void BMTransientEnveloper_processBuffer(BMTransientEnveloper *This,
     // the length of the attack transients.
     //
     // Recommended setting: in the range [1/8, 1/3] seconds
-    for (size_t i=0; i<BMENV_NUM_STAGES; i++)
-        BMReleaseFilter_processBuffer(&This->attackRF2[i], attackEnvelope, attackEnvelope, numSamples);
+    //
+    // (processed together with attack filter 2 below)
     
     
     // Implement attack onset time
@@ -226,10 +223,10 @@ void BMTransientEnveloper_processBuffer(BMTransientEnveloper *This,
     // be set to zero, in which case, we will not do the filtering.
     //
     // Recommended setting: in the range [0,1/200]
-    if(This->filterAttackOnset){
-        for (size_t i=0; i<BMENV_NUM_STAGES; i++)
-            BMAttackFilter_processBuffer(&This->attackAF2[i], attackEnvelope, attackEnvelope, numSamples);
-    }
+    size_t numOnsetStages = This->filterAttackOnset ? BMENV_NUM_STAGES : 0;
+    BMEnvelopeFilterChain_process(This->attackRF2, BMENV_NUM_STAGES,
+                                  This->attackAF2, numOnsetStages,
+                                  attackEnvelope, attackEnvelope, numSamples);
     
     // Process a dynamic smoothing filter.
     // The purpose of this is to further reduce control signal bleeding through
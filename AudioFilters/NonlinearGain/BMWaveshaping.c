@@ -6,7 +6,11 @@
 //  Anyone may use this file without restrictions of any kind
 //
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <simd/simd.h>
 
 /*!
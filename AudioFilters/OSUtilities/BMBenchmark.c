@@ -0,0 +1,285 @@
+//
+//  BMBenchmark.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMBenchmark.h"
+#include "BMRealTimeSafety.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <time.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMBENCHMARK_NUM_RUNS 5
+#define BMBENCHMARK_INITIAL_RESULTS 64
+
+const size_t BMBenchmark_blockSizes [BMBENCHMARK_NUM_BLOCK_SIZES] = {32, 128, 512, 4096};
+
+
+
+
+/*
+ * monotonic time in seconds
+ */
+static double BMBenchmark_time(void){
+#ifdef __APPLE__
+	static mach_timebase_info_data_t timebase;
+	if(timebase.denom == 0)
+		mach_timebase_info(&timebase);
+	return (double)mach_absolute_time() * (double)timebase.numer / (double)timebase.denom * 1.0e-9;
+#else
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1.0e-9;
+#endif
+}
+
+
+
+
+/*
+ * returns a file descriptor for a counter of hardware cache misses in this
+ * thread, or -1 if counters are not available
+ */
+static int BMBenchmark_openCacheMissCounter(void){
+#ifdef __linux__
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	return (int)fd;
+#else
+	return -1;
+#endif
+}
+
+
+
+
+static void BMBenchmark_startCacheMissCounter(const BMBenchmark *This){
+#ifdef __linux__
+	if(This->cacheMissCounter < 0) return;
+	ioctl(This->cacheMissCounter, PERF_EVENT_IOC_RESET, 0);
+	ioctl(This->cacheMissCounter, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+
+
+
+/*
+ * returns the number of cache misses since the counter was started, or -1
+ */
+static double BMBenchmark_stopCacheMissCounter(const BMBenchmark *This){
+#ifdef __linux__
+	if(This->cacheMissCounter < 0) return -1.0;
+	ioctl(This->cacheMissCounter, PERF_EVENT_IOC_DISABLE, 0);
+	uint64_t count;
+	if(read(This->cacheMissCounter, &count, sizeof(count)) != sizeof(count))
+		return -1.0;
+	return (double)count;
+#else
+	return -1.0;
+#endif
+}
+
+
+
+
+void BMBenchmark_init(BMBenchmark *This, double sampleRate, double secondsPerRun){
+	This->sampleRate = sampleRate;
+	This->secondsPerRun = secondsPerRun;
+	This->numRuns = BMBENCHMARK_NUM_RUNS;
+
+	// Fill the source buffer with white noise at -6 dB. We use a fixed
+	// linear congruential generator so that the input is the same on
+	// every platform.
+	size_t inputLength = BMBENCHMARK_MAX_BLOCK_SIZE * BMBENCHMARK_MAX_CHANNELS;
+	This->inputSource = malloc(sizeof(float) * inputLength);
+	uint32_t state = 1;
+	for(size_t i=0; i<inputLength; i++){
+		state = state * 1664525u + 1013904223u;
+		This->inputSource[i] = ((float)(state >> 8) / (float)(1 << 24) - 0.5f);
+	}
+
+	for(size_t i=0; i<BMBENCHMARK_MAX_CHANNELS; i++){
+		This->inputs[i] = malloc(sizeof(float) * BMBENCHMARK_MAX_BLOCK_SIZE);
+		This->outputs[i] = malloc(sizeof(float) * BMBENCHMARK_MAX_BLOCK_SIZE * BMBENCHMARK_MAX_OUTPUT_RATIO);
+	}
+
+	This->maxResults = BMBENCHMARK_INITIAL_RESULTS;
+	This->numResults = 0;
+	This->results = malloc(sizeof(BMBenchmarkResult) * This->maxResults);
+
+	This->cacheMissCounter = BMBenchmark_openCacheMissCounter();
+}
+
+
+
+
+void BMBenchmark_free(BMBenchmark *This){
+	for(size_t i=0; i<BMBENCHMARK_MAX_CHANNELS; i++){
+		free(This->inputs[i]);
+		This->inputs[i] = NULL;
+		free(This->outputs[i]);
+		This->outputs[i] = NULL;
+	}
+	free(This->inputSource);
+	This->inputSource = NULL;
+	free(This->results);
+	This->results = NULL;
+
+#ifdef __linux__
+	if(This->cacheMissCounter >= 0)
+		close(This->cacheMissCounter);
+#endif
+	This->cacheMissCounter = -1;
+}
+
+
+
+
+/*
+ * Copy fresh noise into the input buffers. The process functions are
+ * allowed to overwrite their inputs, so we do this before each call.
+ */
+static void BMBenchmark_refillInputs(BMBenchmark *This, size_t numSamples){
+	for(size_t i=0; i<BMBENCHMARK_MAX_CHANNELS; i++)
+		memcpy(This->inputs[i], This->inputSource + i*BMBENCHMARK_MAX_BLOCK_SIZE, sizeof(float) * numSamples);
+}
+
+
+
+
+static BMBenchmarkResult* BMBenchmark_newResult(BMBenchmark *This){
+	if(This->numResults == This->maxResults){
+		This->maxResults *= 2;
+		This->results = realloc(This->results, sizeof(BMBenchmarkResult) * This->maxResults);
+	}
+	return &This->results[This->numResults++];
+}
+
+
+
+
+void BMBenchmark_measure(BMBenchmark *This,
+						 const char *name,
+						 BMBenchmarkProcessFunction process,
+						 void *object){
+	for(size_t b=0; b<BMBENCHMARK_NUM_BLOCK_SIZES; b++){
+		size_t blockSize = BMBenchmark_blockSizes[b];
+
+		// warm up the caches and let the object settle into its steady state
+		for(size_t i=0; i<8; i++){
+			BMBenchmark_refillInputs(This, blockSize);
+			BM_REALTIME_BEGIN(name);
+			process(object, This->inputs, This->outputs, blockSize);
+			BM_REALTIME_END();
+		}
+
+		double bestNsPerSample = 0.0;
+		double bestCacheMisses = -1.0;
+		for(size_t run=0; run<This->numRuns; run++){
+			double elapsed = 0.0, cacheMisses = 0.0;
+			size_t samples = 0;
+			bool countersWork = true;
+			while(elapsed < This->secondsPerRun){
+				BMBenchmark_refillInputs(This, blockSize);
+
+				// the input copy is not included in the time
+				BMBenchmark_startCacheMissCounter(This);
+				double start = BMBenchmark_time();
+				BM_REALTIME_BEGIN(name);
+				process(object, This->inputs, This->outputs, blockSize);
+				BM_REALTIME_END();
+				elapsed += BMBenchmark_time() - start;
+				double misses = BMBenchmark_stopCacheMissCounter(This);
+
+				if(misses < 0.0) countersWork = false;
+				else cacheMisses += misses;
+				samples += blockSize;
+			}
+
+			double nsPerSample = elapsed * 1.0e9 / (double)samples;
+			if(run == 0 || nsPerSample < bestNsPerSample){
+				bestNsPerSample = nsPerSample;
+				bestCacheMisses = countersWork ? cacheMisses / (double)samples : -1.0;
+			}
+		}
+
+		BMBenchmarkResult *result = BMBenchmark_newResult(This);
+		strncpy(result->name, name, sizeof(result->name) - 1);
+		result->name[sizeof(result->name) - 1] = '\0';
+		result->blockSize = blockSize;
+		result->nsPerSample = bestNsPerSample;
+		result->realTimeFactor = 1.0e9 / (This->sampleRate * bestNsPerSample);
+		result->cacheMissesPerSample = bestCacheMisses;
+	}
+}
+
+
+
+
+void BMBenchmark_writeJSON(const BMBenchmark *This, FILE *file){
+	fprintf(file, "{\n");
+	fprintf(file, "  \"sampleRate\": %g,\n", This->sampleRate);
+	fprintf(file, "  \"results\": [\n");
+	for(size_t i=0; i<This->numResults; i++){
+		const BMBenchmarkResult *r = &This->results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"blockSize\": %zu, \"nsPerSample\": %.4f, \"realTimeFactor\": %.2f, \"cacheMissesPerSample\": ",
+				r->name, r->blockSize, r->nsPerSample, r->realTimeFactor);
+		if(r->cacheMissesPerSample < 0.0)
+			fprintf(file, "null");
+		else
+			fprintf(file, "%.5f", r->cacheMissesPerSample);
+		fprintf(file, "}%s\n", i+1 < This->numResults ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+
+
+
+void BMBenchmark_printSummary(const BMBenchmark *This, FILE *file){
+	fprintf(file, "%-44s %6s %12s %14s %14s\n", "name", "block", "ns/sample", "x real time", "misses/sample");
+	for(size_t i=0; i<This->numResults; i++){
+		const BMBenchmarkResult *r = &This->results[i];
+		fprintf(file, "%-44s %6zu %12.3f %14.1f ", r->name, r->blockSize, r->nsPerSample, r->realTimeFactor);
+		if(r->cacheMissesPerSample < 0.0)
+			fprintf(file, "%14s\n", "-");
+		else
+			fprintf(file, "%14.4f\n", r->cacheMissesPerSample);
+	}
+
+#ifdef BM_REALTIME_SAFETY_CHECKS
+	fprintf(file, "\n");
+	BMRealTimeSafety_printReport(file);
+#endif
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,149 @@
+//
+//  BMBenchmark.h
+//  AudioFiltersXcodeProject
+//
+//  Measures the processing cost of audio processing functions at a range of
+//  buffer lengths and writes the results as JSON so that they can be
+//  compared between releases.
+//
+//  For each function and each buffer length in BMBenchmark_blockSizes, the
+//  function is called repeatedly on noise input until the measurement time
+//  has elapsed. This is repeated several times and the fastest run is
+//  reported, because interruptions by the operating system only ever make a
+//  run slower. Costs are reported per sample frame, so a stereo function that
+//  processes 512 samples in each channel has processed 512 frames.
+//
+//  On Linux the number of hardware cache misses is read from the kernel's
+//  performance counters. On other platforms, or when the counters are not
+//  accessible, the cache miss count is reported as null in the JSON.
+//
+//  When the library is built with BM_REALTIME_SAFETY_CHECKS, each call to a
+//  process function is checked for memory allocation, I/O and locks (see
+//  BMRealTimeSafety.h) and BMBenchmark_printSummary lists the violations.
+//  The checks slow down the functions that allocate, so don't compare the
+//  times with those of a normal build.
+//
+//  See BMBenchmarkSuite.h for benchmarks of the classes in this library.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMBenchmark_h
+#define BMBenchmark_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMBENCHMARK_NUM_BLOCK_SIZES 4
+#define BMBENCHMARK_MAX_BLOCK_SIZE 4096
+#define BMBENCHMARK_MAX_CHANNELS 2
+
+// functions that change the sample rate may write up to this many output
+// samples for each input sample
+#define BMBENCHMARK_MAX_OUTPUT_RATIO 16
+
+// buffer lengths at which each function is measured
+extern const size_t BMBenchmark_blockSizes [BMBENCHMARK_NUM_BLOCK_SIZES];
+
+
+/*
+ * Process numSamples frames of audio. inputs and outputs have one array per
+ * channel. The input arrays have length BMBENCHMARK_MAX_BLOCK_SIZE and the
+ * outputs have length BMBENCHMARK_MAX_BLOCK_SIZE * BMBENCHMARK_MAX_OUTPUT_RATIO.
+ * The function may overwrite the inputs.
+ */
+typedef void (*BMBenchmarkProcessFunction)(void *object,
+										   float **inputs,
+										   float **outputs,
+										   size_t numSamples);
+
+
+typedef struct BMBenchmarkResult {
+	char name [64];
+	size_t blockSize;
+
+	// processing time per sample frame in nanoseconds
+	double nsPerSample;
+
+	// how many times faster than real time the function ran
+	double realTimeFactor;
+
+	// hardware cache misses per sample frame, negative if unavailable
+	double cacheMissesPerSample;
+} BMBenchmarkResult;
+
+
+typedef struct BMBenchmark {
+	float *inputs [BMBENCHMARK_MAX_CHANNELS];
+	float *outputs [BMBENCHMARK_MAX_CHANNELS];
+	float *inputSource;
+
+	BMBenchmarkResult *results;
+	size_t numResults, maxResults;
+
+	double sampleRate, secondsPerRun;
+	size_t numRuns;
+	int cacheMissCounter;
+} BMBenchmark;
+
+
+
+/*!
+ *BMBenchmark_init
+ *
+ * @param This           pointer to an uninitialised struct
+ * @param sampleRate     sample rate used to compute the real time factor
+ * @param secondsPerRun  minimum duration of each timed run. The fastest of several runs is reported.
+ */
+void BMBenchmark_init(BMBenchmark *This, double sampleRate, double secondsPerRun);
+
+
+/*!
+ *BMBenchmark_free
+ */
+void BMBenchmark_free(BMBenchmark *This);
+
+
+/*!
+ *BMBenchmark_measure
+ *
+ * @abstract measure the cost of process at each of the sizes in BMBenchmark_blockSizes and store the results
+ *
+ * @param This     pointer to an initialised struct
+ * @param name     name of the function, used as the key in the output. It must be a string literal or otherwise outlive the benchmark.
+ * @param process  function to measure
+ * @param object   passed to process as the first argument
+ */
+void BMBenchmark_measure(BMBenchmark *This,
+						 const char *name,
+						 BMBenchmarkProcessFunction process,
+						 void *object);
+
+
+/*!
+ *BMBenchmark_writeJSON
+ *
+ * @abstract write all results measured so far to file as a JSON object
+ */
+void BMBenchmark_writeJSON(const BMBenchmark *This, FILE *file);
+
+
+/*!
+ *BMBenchmark_printSummary
+ *
+ * @abstract write all results measured so far to file as a human readable table
+ */
+void BMBenchmark_printSummary(const BMBenchmark *This, FILE *file);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMBenchmark_h */
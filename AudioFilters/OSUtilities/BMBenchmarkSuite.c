@@ -0,0 +1,400 @@
+//
+//  BMBenchmarkSuite.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMBenchmarkSuite.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "Constants.h"
+#include "BMMultiLevelBiquad.h"
+#include "BMCrossover.h"
+#include "BMFIRFilter.h"
+#include "BMReverb.h"
+#include "BMCloudReverb.h"
+#include "BMSimpleFDN.h"
+#include "BMMultiTapDelay.h"
+#include "BMVelvetNoiseDecorrelator.h"
+#include "BMConvolutionReverb.h"
+#include "BMCompressor.h"
+#include "BMPeakLimiter.h"
+#include "BMUpsampler.h"
+#include "BMDownsampler.h"
+#include "BMPolyphaseResampler.h"
+#include "BMSpectrogram.h"
+#include "BMLoudnessMeter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMBS_FIR_LENGTH 256
+#define BMBS_NUM_TAPS 64
+#define BMBS_CONVOLUTION_SECONDS 2.0f
+#define BMBS_SPECTROGRAM_FFT_SIZE 1024
+#define BMBS_SPECTROGRAM_HEIGHT 256
+
+// the spectrogram draws one column for each BMBS_SPECTROGRAM_HOP samples
+#define BMBS_SPECTROGRAM_HOP 16
+
+
+
+
+/*
+ * Random numbers in [-0.5, 0.5) for filter kernels and tap settings. We
+ * don't use rand() so that the benchmarks are the same on every platform.
+ */
+static float BMBenchmarkSuite_random(uint32_t *state){
+	*state = *state * 1664525u + 1013904223u;
+	return (float)(*state >> 8) / (float)(1 << 24) - 0.5f;
+}
+
+
+
+
+#pragma mark - filters
+
+static void BMBenchmarkSuite_multiLevelBiquadStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMMultiLevelBiquad_processBufferStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+static void BMBenchmarkSuite_multiLevelBiquadMono(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMMultiLevelBiquad_processBufferMono(object, inputs[0], outputs[0], numSamples);
+}
+
+static void BMBenchmarkSuite_crossoverStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	// the highpass outputs go after the lowpass outputs in the output buffers
+	BMCrossover_processStereo(object,
+							  inputs[0], inputs[1],
+							  outputs[0], outputs[1],
+							  outputs[0] + numSamples, outputs[1] + numSamples,
+							  numSamples);
+}
+
+static void BMBenchmarkSuite_FIRFilter(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMFIRFilter_process(object, inputs[0], outputs[0], numSamples);
+}
+
+
+
+
+static void BMBenchmarkSuite_runFilters(BMBenchmark *benchmark){
+	float sampleRate = (float)benchmark->sampleRate;
+
+	// an eight band equaliser
+	BMMultiLevelBiquad biquad;
+	BMMultiLevelBiquad_init(&biquad, 8, sampleRate, true, false, false);
+	for(size_t i=0; i<8; i++)
+		BMMultiLevelBiquad_setBell(&biquad, 100.0f * powf(2.0f, (float)i), 1.0f, 3.0f, i);
+	BMBenchmark_measure(benchmark, "BMMultiLevelBiquad_processBufferStereo", BMBenchmarkSuite_multiLevelBiquadStereo, &biquad);
+	BMMultiLevelBiquad_free(&biquad);
+
+	BMMultiLevelBiquad_init(&biquad, 8, sampleRate, false, false, false);
+	for(size_t i=0; i<8; i++)
+		BMMultiLevelBiquad_setBell(&biquad, 100.0f * powf(2.0f, (float)i), 1.0f, 3.0f, i);
+	BMBenchmark_measure(benchmark, "BMMultiLevelBiquad_processBufferMono", BMBenchmarkSuite_multiLevelBiquadMono, &biquad);
+	BMMultiLevelBiquad_free(&biquad);
+
+	BMCrossover crossover;
+	BMCrossover_init(&crossover, 1000.0f, sampleRate, true, true);
+	BMBenchmark_measure(benchmark, "BMCrossover_processStereo", BMBenchmarkSuite_crossoverStereo, &crossover);
+	BMCrossover_free(&crossover);
+
+	float kernel [BMBS_FIR_LENGTH];
+	uint32_t state = 1;
+	for(size_t i=0; i<BMBS_FIR_LENGTH; i++)
+		kernel[i] = BMBenchmarkSuite_random(&state) / (float)BMBS_FIR_LENGTH;
+	BMFIRFilter fir;
+	BMFIRFilter_init(&fir, kernel, BMBS_FIR_LENGTH);
+	BMBenchmark_measure(benchmark, "BMFIRFilter_process", BMBenchmarkSuite_FIRFilter, &fir);
+	BMFIRFilter_free(&fir);
+}
+
+
+
+
+#pragma mark - delays and reverbs
+
+static void BMBenchmarkSuite_reverb(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMReverbProcessBuffer(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+static void BMBenchmarkSuite_cloudReverb(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMCloudReverb_processStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples, false);
+}
+
+static void BMBenchmarkSuite_simpleFDN(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMSimpleFDN_processBuffer(object, inputs[0], outputs[0], numSamples);
+}
+
+static void BMBenchmarkSuite_multiTapDelay(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMMultiTapDelay_processBufferStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+static void BMBenchmarkSuite_velvetNoiseDecorrelator(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMVelvetNoiseDecorrelator_processBufferStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+static void BMBenchmarkSuite_convolutionReverb(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMConvolutionReverb_processStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+
+
+
+static void BMBenchmarkSuite_runReverbs(BMBenchmark *benchmark){
+	float sampleRate = (float)benchmark->sampleRate;
+	uint32_t state = 1;
+
+	BMReverb *reverb = malloc(sizeof(BMReverb));
+	BMReverbInit(reverb, sampleRate);
+	BMBenchmark_measure(benchmark, "BMReverbProcessBuffer", BMBenchmarkSuite_reverb, reverb);
+	BMReverbFree(reverb);
+	free(reverb);
+
+	BMCloudReverb *cloudReverb = malloc(sizeof(BMCloudReverb));
+	BMCloudReverb_init(cloudReverb, sampleRate);
+	BMBenchmark_measure(benchmark, "BMCloudReverb_processStereo", BMBenchmarkSuite_cloudReverb, cloudReverb);
+	BMCloudReverb_destroy(cloudReverb);
+	free(cloudReverb);
+
+	BMSimpleFDN fdn;
+	BMSimpleFDN_init(&fdn, sampleRate, 16, DTM_VELVETNOISE, 0.007f, 0.1f, 2.0f);
+	BMBenchmark_measure(benchmark, "BMSimpleFDN_processBuffer", BMBenchmarkSuite_simpleFDN, &fdn);
+	BMSimpleFDN_free(&fdn);
+
+	// taps spread over 100 ms with random gains
+	size_t maxDelay = (size_t)(0.1f * sampleRate);
+	size_t delayTimesL [BMBS_NUM_TAPS], delayTimesR [BMBS_NUM_TAPS];
+	float gainsL [BMBS_NUM_TAPS], gainsR [BMBS_NUM_TAPS];
+	for(size_t i=0; i<BMBS_NUM_TAPS; i++){
+		delayTimesL[i] = 1 + (size_t)((BMBenchmarkSuite_random(&state) + 0.5f) * (float)(maxDelay - 1));
+		delayTimesR[i] = 1 + (size_t)((BMBenchmarkSuite_random(&state) + 0.5f) * (float)(maxDelay - 1));
+		gainsL[i] = BMBenchmarkSuite_random(&state) / sqrtf(BMBS_NUM_TAPS);
+		gainsR[i] = BMBenchmarkSuite_random(&state) / sqrtf(BMBS_NUM_TAPS);
+	}
+	BMMultiTapDelay multiTapDelay;
+	BMMultiTapDelay_Init(&multiTapDelay, true, delayTimesL, delayTimesR, maxDelay, gainsL, gainsR, BMBS_NUM_TAPS, BMBS_NUM_TAPS);
+	BMBenchmark_measure(benchmark, "BMMultiTapDelay_processBufferStereo", BMBenchmarkSuite_multiTapDelay, &multiTapDelay);
+	BMMultiTapDelay_free(&multiTapDelay);
+
+	BMVelvetNoiseDecorrelator decorrelator;
+	BMVelvetNoiseDecorrelator_init(&decorrelator, 0.1f, 32, 0.2f, true, sampleRate);
+	BMBenchmark_measure(benchmark, "BMVelvetNoiseDecorrelator_processBufferStereo", BMBenchmarkSuite_velvetNoiseDecorrelator, &decorrelator);
+	BMVelvetNoiseDecorrelator_free(&decorrelator);
+
+	// exponentially decaying noise
+	size_t IRLength = (size_t)(BMBS_CONVOLUTION_SECONDS * sampleRate);
+	float *IRL = malloc(sizeof(float) * IRLength);
+	float *IRR = malloc(sizeof(float) * IRLength);
+	float decay = expf(-6.9f / (float)IRLength);
+	float envelope = 1.0f;
+	for(size_t i=0; i<IRLength; i++){
+		IRL[i] = envelope * BMBenchmarkSuite_random(&state);
+		IRR[i] = envelope * BMBenchmarkSuite_random(&state);
+		envelope *= decay;
+	}
+	BMConvolutionReverb convolutionReverb;
+	BMConvolutionReverb_initStereo(&convolutionReverb, IRL, IRR, IRLength, sampleRate);
+	BMBenchmark_measure(benchmark, "BMConvolutionReverb_processStereo", BMBenchmarkSuite_convolutionReverb, &convolutionReverb);
+	BMConvolutionReverb_free(&convolutionReverb);
+	free(IRL);
+	free(IRR);
+}
+
+
+
+
+#pragma mark - dynamics
+
+static void BMBenchmarkSuite_compressorStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	float minGainDb;
+	BMCompressor_ProcessBufferStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], &minGainDb, numSamples);
+}
+
+static void BMBenchmarkSuite_compressorMono(void *object, float **inputs, float **outputs, size_t numSamples){
+	float minGainDb;
+	BMCompressor_ProcessBufferMono(object, inputs[0], outputs[0], &minGainDb, numSamples);
+}
+
+static void BMBenchmarkSuite_peakLimiterStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMPeakLimiter_processStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+
+
+
+static void BMBenchmarkSuite_runDynamics(BMBenchmark *benchmark){
+	float sampleRate = (float)benchmark->sampleRate;
+
+	BMCompressor compressor;
+	BMCompressor_initWithSettings(&compressor, sampleRate, -20.0f, 6.0f, 4.0f, 0.005f, 0.1f);
+	BMBenchmark_measure(benchmark, "BMCompressor_ProcessBufferStereo", BMBenchmarkSuite_compressorStereo, &compressor);
+	BMCompressor_Free(&compressor);
+
+	BMCompressor_initWithSettings(&compressor, sampleRate, -20.0f, 6.0f, 4.0f, 0.005f, 0.1f);
+	BMBenchmark_measure(benchmark, "BMCompressor_ProcessBufferMono", BMBenchmarkSuite_compressorMono, &compressor);
+	BMCompressor_Free(&compressor);
+
+	BMPeakLimiter limiter;
+	BMPeakLimiter_init(&limiter, true, sampleRate);
+	BMBenchmark_measure(benchmark, "BMPeakLimiter_processStereo", BMBenchmarkSuite_peakLimiterStereo, &limiter);
+	BMPeakLimiter_free(&limiter);
+
+	BMPeakLimiter_init(&limiter, true, sampleRate);
+	BMPeakLimiter_setLookahead(&limiter, 0.002f);
+	BMPeakLimiter_setTruePeakMode(&limiter, true);
+	BMBenchmark_measure(benchmark, "BMPeakLimiter_processStereo true peak", BMBenchmarkSuite_peakLimiterStereo, &limiter);
+	BMPeakLimiter_free(&limiter);
+}
+
+
+
+
+#pragma mark - sample rate conversion
+
+static void BMBenchmarkSuite_upsamplerStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMUpsampler_processBufferStereo(object, inputs[0], inputs[1], outputs[0], outputs[1], numSamples);
+}
+
+/*
+ * The downsampler needs factor * numSamples samples of input. We take them
+ * from the output buffers, which are long enough and contain whatever the
+ * previous benchmark left there.
+ */
+typedef struct BMBenchmarkSuiteDownsampler {
+	BMDownsampler downsampler;
+	size_t factor;
+} BMBenchmarkSuiteDownsampler;
+
+static void BMBenchmarkSuite_downsamplerStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMBenchmarkSuiteDownsampler *context = object;
+	size_t numSamplesIn = numSamples * context->factor;
+	float *inL = outputs[0] + numSamples;
+	float *inR = outputs[1] + numSamples;
+	memcpy(inL, inputs[0], sizeof(float) * numSamples);
+	memcpy(inR, inputs[1], sizeof(float) * numSamples);
+	BMDownsampler_processBufferStereo(&context->downsampler, inL, inR, outputs[0], outputs[1], numSamplesIn);
+}
+
+static void BMBenchmarkSuite_polyphaseResamplerStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMPolyphaseResampler_process(object, (const float **)inputs, outputs, numSamples);
+}
+
+
+
+
+static void BMBenchmarkSuite_runSampleRateConversion(BMBenchmark *benchmark){
+	BMUpsampler upsampler;
+	BMUpsampler_init(&upsampler, true, 2, BMRESAMPLER_FULL_SPECTRUM);
+	BMBenchmark_measure(benchmark, "BMUpsampler_processBufferStereo_2x", BMBenchmarkSuite_upsamplerStereo, &upsampler);
+	BMUpsampler_free(&upsampler);
+
+	BMUpsampler_init(&upsampler, true, 8, BMRESAMPLER_FULL_SPECTRUM);
+	BMBenchmark_measure(benchmark, "BMUpsampler_processBufferStereo_8x", BMBenchmarkSuite_upsamplerStereo, &upsampler);
+	BMUpsampler_free(&upsampler);
+
+	// costs are per output sample
+	BMBenchmarkSuiteDownsampler downsampler;
+	downsampler.factor = 2;
+	BMDownsampler_init(&downsampler.downsampler, true, downsampler.factor, BMRESAMPLER_FULL_SPECTRUM);
+	BMBenchmark_measure(benchmark, "BMDownsampler_processBufferStereo_2x", BMBenchmarkSuite_downsamplerStereo, &downsampler);
+	BMDownsampler_free(&downsampler.downsampler);
+
+	// costs are per input sample
+	BMPolyphaseResampler resampler;
+	BMPolyphaseResampler_init(&resampler, 2, 44100.0, 48000.0, BMPR_TAPS_STANDARD);
+	BMBenchmark_measure(benchmark, "BMPolyphaseResampler_process_44100_48000", BMBenchmarkSuite_polyphaseResamplerStereo, &resampler);
+	BMPolyphaseResampler_free(&resampler);
+
+	BMPolyphaseResampler_init(&resampler, 2, 48000.0, 44100.0, BMPR_TAPS_STANDARD);
+	BMBenchmark_measure(benchmark, "BMPolyphaseResampler_process_48000_44100", BMBenchmarkSuite_polyphaseResamplerStereo, &resampler);
+	BMPolyphaseResampler_free(&resampler);
+}
+
+
+
+
+#pragma mark - measurement
+
+/*
+ * The spectrogram draws a window of numSamples samples with one column of
+ * pixels for every BMBS_SPECTROGRAM_HOP samples, as when scrolling a live
+ * display. The cost is per sample of audio in the window.
+ */
+typedef struct BMBenchmarkSuiteSpectrogram {
+	BMSpectrogram spectrogram;
+	float *audio;
+	uint8_t *image;
+	size_t paddingLeft, audioLength;
+} BMBenchmarkSuiteSpectrogram;
+
+static void BMBenchmarkSuite_spectrogram(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMBenchmarkSuiteSpectrogram *context = object;
+	SInt32 start = (SInt32)context->paddingLeft;
+	SInt32 end = start + (SInt32)numSamples - 1;
+	SInt32 width = (SInt32)BM_MAX(2, numSamples / BMBS_SPECTROGRAM_HOP);
+	BMSpectrogram_process(&context->spectrogram,
+						  context->audio,
+						  (SInt32)context->audioLength,
+						  start, end,
+						  BMBS_SPECTROGRAM_FFT_SIZE,
+						  context->image,
+						  width,
+						  BMBS_SPECTROGRAM_HEIGHT,
+						  20.0f, 20000.0f);
+}
+
+
+
+
+static void BMBenchmarkSuite_loudnessMeterStereo(void *object, float **inputs, float **outputs, size_t numSamples){
+	BMLoudnessMeter_process(object, (const float**)inputs, numSamples);
+}
+
+
+
+
+static void BMBenchmarkSuite_runMeasurement(BMBenchmark *benchmark){
+	BMBenchmarkSuiteSpectrogram spectrogram;
+	BMSpectrogram_init(&spectrogram.spectrogram, BMBS_SPECTROGRAM_FFT_SIZE, BMBS_SPECTROGRAM_HEIGHT + 1, (float)benchmark->sampleRate);
+	spectrogram.paddingLeft = (size_t)BMSpectrogram_getPaddingLeft(BMBS_SPECTROGRAM_FFT_SIZE);
+	size_t paddingRight = (size_t)BMSpectrogram_getPaddingRight(BMBS_SPECTROGRAM_FFT_SIZE);
+	spectrogram.audioLength = spectrogram.paddingLeft + BMBENCHMARK_MAX_BLOCK_SIZE + paddingRight;
+	spectrogram.audio = malloc(sizeof(float) * spectrogram.audioLength);
+	uint32_t state = 1;
+	for(size_t i=0; i<spectrogram.audioLength; i++)
+		spectrogram.audio[i] = BMBenchmarkSuite_random(&state);
+	size_t maxWidth = BMBENCHMARK_MAX_BLOCK_SIZE / BMBS_SPECTROGRAM_HOP;
+	spectrogram.image = malloc(4 * maxWidth * BMBS_SPECTROGRAM_HEIGHT);
+	BMBenchmark_measure(benchmark, "BMSpectrogram_process", BMBenchmarkSuite_spectrogram, &spectrogram);
+	BMSpectrogram_free(&spectrogram.spectrogram);
+	free(spectrogram.audio);
+	free(spectrogram.image);
+
+	BMLoudnessMeter loudnessMeter;
+	BMLoudnessMeter_init(&loudnessMeter, 2, (float)benchmark->sampleRate);
+	BMBenchmark_measure(benchmark, "BMLoudnessMeter_process", BMBenchmarkSuite_loudnessMeterStereo, &loudnessMeter);
+	BMLoudnessMeter_free(&loudnessMeter);
+}
+
+
+
+
+void BMBenchmarkSuite_run(BMBenchmark *benchmark){
+	BMBenchmarkSuite_runFilters(benchmark);
+	BMBenchmarkSuite_runReverbs(benchmark);
+	BMBenchmarkSuite_runDynamics(benchmark);
+	BMBenchmarkSuite_runSampleRateConversion(benchmark);
+	BMBenchmarkSuite_runMeasurement(benchmark);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+//
+//  BMBenchmarkSuite.h
+//  AudioFiltersXcodeProject
+//
+//  Benchmarks for the main processing functions in this library. To check
+//  for performance regressions, call BMBenchmarkSuite_run from a command
+//  line tool or a unit test, write the results to a JSON file with
+//  BMBenchmark_writeJSON and compare them with the results from the
+//  previous release.
+//
+//  To add a benchmark, write an adapter function with the signature of
+//  BMBenchmarkProcessFunction and add it to BMBenchmarkSuite_run.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMBenchmarkSuite_h
+#define BMBenchmarkSuite_h
+
+#include "BMBenchmark.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ *BMBenchmarkSuite_run
+ *
+ * @abstract measure each of the processing functions in the suite and add the results to benchmark. This takes about numBenchmarks * BMBENCHMARK_NUM_BLOCK_SIZES * 5 * benchmark->secondsPerRun seconds.
+ *
+ * @param benchmark  pointer to an initialised struct. The objects being measured are initialised at benchmark->sampleRate.
+ */
+void BMBenchmarkSuite_run(BMBenchmark *benchmark);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMBenchmarkSuite_h */
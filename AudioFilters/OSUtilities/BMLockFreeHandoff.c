@@ -0,0 +1,106 @@
+//
+//  BMLockFreeHandoff.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMLockFreeHandoff.h"
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BMLockFreeHandoff_init(BMLockFreeHandoff *This, BMLockFreeHandoffFreeFunction freeObject){
+	assert(freeObject != NULL);
+	This->freeObject = freeObject;
+	This->deferred = NULL;
+	atomic_init(&This->pending, NULL);
+	for(size_t i=0; i<BMLOCKFREEHANDOFF_RETIRED_SLOTS; i++)
+		atomic_init(&This->retired[i], NULL);
+}
+
+
+
+
+void BMLockFreeHandoff_collect(BMLockFreeHandoff *This){
+	for(size_t i=0; i<BMLOCKFREEHANDOFF_RETIRED_SLOTS; i++){
+		void *object = atomic_exchange(&This->retired[i], NULL);
+		if(object) This->freeObject(object);
+	}
+}
+
+
+
+
+void BMLockFreeHandoff_free(BMLockFreeHandoff *This){
+	BMLockFreeHandoff_collect(This);
+
+	void *object = atomic_exchange(&This->pending, NULL);
+	if(object) This->freeObject(object);
+
+	if(This->deferred){
+		This->freeObject(This->deferred);
+		This->deferred = NULL;
+	}
+}
+
+
+
+
+void BMLockFreeHandoff_publish(BMLockFreeHandoff *This, void *object){
+	BMLockFreeHandoff_collect(This);
+
+	// if the audio thread hasn't taken the previous object yet, it never will
+	void *replaced = atomic_exchange(&This->pending, object);
+	if(replaced) This->freeObject(replaced);
+}
+
+
+
+
+void* BMLockFreeHandoff_take(BMLockFreeHandoff *This){
+	// only load and exchange if there is something there, so that the
+	// common case doesn't write to memory shared with the other thread
+	if(atomic_load_explicit(&This->pending, memory_order_relaxed) == NULL)
+		return NULL;
+	return atomic_exchange(&This->pending, NULL);
+}
+
+
+
+
+/*
+ * put object in an empty slot. Returns false if there are none.
+ */
+static bool BMLockFreeHandoff_putInSlot(BMLockFreeHandoff *This, void *object){
+	for(size_t i=0; i<BMLOCKFREEHANDOFF_RETIRED_SLOTS; i++){
+		void *expected = NULL;
+		if(atomic_compare_exchange_strong(&This->retired[i], &expected, object))
+			return true;
+	}
+	return false;
+}
+
+
+
+
+void BMLockFreeHandoff_retire(BMLockFreeHandoff *This, void *object){
+	// retry an object that didn't fit last time
+	if(This->deferred && BMLockFreeHandoff_putInSlot(This, This->deferred))
+		This->deferred = NULL;
+
+	if(object && !BMLockFreeHandoff_putInSlot(This, object)){
+		// This only happens if the publishing thread stops collecting. We
+		// can't free on this thread so we keep the object for next time.
+		assert(This->deferred == NULL);
+		This->deferred = object;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,108 @@
+//
+//  BMLockFreeHandoff.h
+//  AudioFiltersXcodeProject
+//
+//  Passes objects that were built on another thread to the audio thread,
+//  and passes the objects they replace back again to be freed, without
+//  locks and without allocating or freeing memory on the audio thread.
+//
+//  Use it for settings that require memory allocation. The thread that
+//  changes the setting allocates and fills a new object and publishes it.
+//  At the start or end of a buffer the audio thread takes the newest
+//  published object, switches to it and retires the one it was using. The
+//  next call to publish, or to free, releases the retired objects.
+//
+//  If several objects are published before the audio thread takes one,
+//  only the newest is kept and the others are freed immediately.
+//
+//  There must be only one publishing thread and one audio thread.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMLockFreeHandoff_h
+#define BMLockFreeHandoff_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Between two calls to publish, the audio thread retires at most two
+// objects, so a few more slots than that is always enough.
+#define BMLOCKFREEHANDOFF_RETIRED_SLOTS 4
+
+typedef void (*BMLockFreeHandoffFreeFunction)(void *object);
+
+typedef struct BMLockFreeHandoff {
+	_Atomic(void*) pending;
+	_Atomic(void*) retired [BMLOCKFREEHANDOFF_RETIRED_SLOTS];
+	BMLockFreeHandoffFreeFunction freeObject;
+
+	// used only by the audio thread, for an object that could not be
+	// retired because every slot was full
+	void *deferred;
+} BMLockFreeHandoff;
+
+
+
+/*!
+ *BMLockFreeHandoff_init
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param freeObject  called on the publishing thread to release objects that are no longer needed
+ */
+void BMLockFreeHandoff_init(BMLockFreeHandoff *This, BMLockFreeHandoffFreeFunction freeObject);
+
+
+/*!
+ *BMLockFreeHandoff_free
+ *
+ * @abstract releases the pending and retired objects. The audio thread must not be using the handoff.
+ */
+void BMLockFreeHandoff_free(BMLockFreeHandoff *This);
+
+
+/*!
+ *BMLockFreeHandoff_publish
+ *
+ * @abstract make object available to the audio thread, replacing any object that was published but not yet taken. Not for use on the audio thread.
+ */
+void BMLockFreeHandoff_publish(BMLockFreeHandoff *This, void *object);
+
+
+/*!
+ *BMLockFreeHandoff_collect
+ *
+ * @abstract release the objects retired by the audio thread. Not for use on the audio thread. publish does this automatically.
+ */
+void BMLockFreeHandoff_collect(BMLockFreeHandoff *This);
+
+
+/*!
+ *BMLockFreeHandoff_take
+ *
+ * @abstract call from the audio thread
+ *
+ * @returns the newest published object, or NULL if nothing was published since the last call
+ */
+void* BMLockFreeHandoff_take(BMLockFreeHandoff *This);
+
+
+/*!
+ *BMLockFreeHandoff_retire
+ *
+ * @abstract call from the audio thread to pass an object that is no longer in use back to the publishing thread to be released
+ */
+void BMLockFreeHandoff_retire(BMLockFreeHandoff *This, void *object);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMLockFreeHandoff_h */
@@ -0,0 +1,143 @@
+//
+//  BMParameterQueue.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMParameterQueue.h"
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BMParameterQueue_init(BMParameterQueue *This, size_t capacity){
+	assert(capacity > 0);
+
+	// a power of two capacity lets the indices wrap around naturally
+	This->capacity = 1;
+	while(This->capacity < capacity) This->capacity *= 2;
+
+	This->events = malloc(sizeof(BMParameterEvent) * This->capacity);
+	atomic_init(&This->readIndex, 0);
+	atomic_init(&This->writeIndex, 0);
+	atomic_init(&This->sampleTime, 0);
+}
+
+
+
+
+void BMParameterQueue_free(BMParameterQueue *This){
+	free(This->events);
+	This->events = NULL;
+}
+
+
+
+
+bool BMParameterQueue_push(BMParameterQueue *This, const BMParameterEvent *event){
+	size_t writeIndex = atomic_load_explicit(&This->writeIndex, memory_order_relaxed);
+	size_t readIndex = atomic_load_explicit(&This->readIndex, memory_order_acquire);
+	if(writeIndex - readIndex == This->capacity)
+		return false;
+
+	This->events[writeIndex & (This->capacity - 1)] = *event;
+
+	// the release makes the event visible before the index that publishes it
+	atomic_store_explicit(&This->writeIndex, writeIndex + 1, memory_order_release);
+	return true;
+}
+
+
+
+
+bool BMParameterQueue_pushSnapshot(BMParameterQueue *This,
+								   const BMParameterEvent *events,
+								   size_t numEvents,
+								   uint64_t sampleTime){
+	size_t writeIndex = atomic_load_explicit(&This->writeIndex, memory_order_relaxed);
+	size_t readIndex = atomic_load_explicit(&This->readIndex, memory_order_acquire);
+	if(This->capacity - (writeIndex - readIndex) < numEvents)
+		return false;
+
+	for(size_t i=0; i<numEvents; i++){
+		BMParameterEvent *event = &This->events[(writeIndex + i) & (This->capacity - 1)];
+		*event = events[i];
+		event->sampleTime = sampleTime;
+	}
+
+	// publishing all the events with one store keeps the audio thread from
+	// seeing only part of the snapshot
+	atomic_store_explicit(&This->writeIndex, writeIndex + numEvents, memory_order_release);
+	return true;
+}
+
+
+
+
+uint64_t BMParameterQueue_currentTime(BMParameterQueue *This){
+	return atomic_load_explicit(&This->sampleTime, memory_order_relaxed);
+}
+
+
+
+
+size_t BMParameterQueue_applyDueEvents(BMParameterQueue *This,
+									   size_t maxSamples,
+									   BMParameterQueueApplyFunction apply,
+									   void *object){
+	assert(maxSamples > 0);
+
+	uint64_t now = atomic_load_explicit(&This->sampleTime, memory_order_relaxed);
+	size_t readIndex = atomic_load_explicit(&This->readIndex, memory_order_relaxed);
+	size_t writeIndex = atomic_load_explicit(&This->writeIndex, memory_order_acquire);
+	size_t firstIndex = readIndex;
+	size_t segmentLength = maxSamples;
+
+	// apply the events that are due, stopping at the first one in the future
+	while(readIndex != writeIndex){
+		const BMParameterEvent *event = &This->events[readIndex & (This->capacity - 1)];
+		if(event->sampleTime > now){
+			if(event->sampleTime - now < segmentLength)
+				segmentLength = (size_t)(event->sampleTime - now);
+			break;
+		}
+		apply(object, event);
+		readIndex++;
+	}
+
+	// the release keeps the control thread from overwriting the events we
+	// just applied before we finished reading them
+	if(readIndex != firstIndex)
+		atomic_store_explicit(&This->readIndex, readIndex, memory_order_release);
+
+	return segmentLength;
+}
+
+
+
+
+void BMParameterQueue_advanceTime(BMParameterQueue *This, size_t numSamples){
+	uint64_t now = atomic_load_explicit(&This->sampleTime, memory_order_relaxed);
+	atomic_store_explicit(&This->sampleTime, now + numSamples, memory_order_relaxed);
+}
+
+
+
+
+size_t BMParameterQueue_nextSegment(BMParameterQueue *This,
+									size_t maxSamples,
+									BMParameterQueueApplyFunction apply,
+									void *object){
+	size_t segmentLength = BMParameterQueue_applyDueEvents(This, maxSamples, apply, object);
+	BMParameterQueue_advanceTime(This, segmentLength);
+	return segmentLength;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,179 @@
+//
+//  BMParameterQueue.h
+//  AudioFiltersXcodeProject
+//
+//  A lock-free queue that carries timestamped parameter changes from one
+//  control thread to the audio thread.
+//
+//  The control thread pushes events. Each event names a parameter and
+//  carries every value that the parameter's setter needs, so the audio
+//  thread always applies a complete setting, never half of one.
+//
+//  The processing function of the struct that owns the queue calls
+//  BMParameterQueue_nextSegment in a loop. Each call applies the events
+//  that are due and returns the number of samples to process before the
+//  next event is due, so that every change takes effect on the sample
+//  given by its timestamp.
+//
+//  Timestamps count samples processed since the queue was initialised. Call
+//  BMParameterQueue_currentTime to find the current time. Events that are
+//  already due when they arrive, for example those with time 0, take effect
+//  at the start of the next buffer.
+//
+//  To change several parameters together, push them with
+//  BMParameterQueue_pushSnapshot. The audio thread sees either all of them
+//  or none, and applies them on the same sample, so it never processes a
+//  mix of old and new settings.
+//
+//  Push events in order of time. Events are applied in the order they were
+//  pushed, so an event that is earlier than the one before it is applied
+//  late, together with the one before it.
+//
+//  There must be only one control thread and one audio thread.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMParameterQueue_h
+#define BMParameterQueue_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMPARAMETERQUEUE_MAX_VALUES 4
+#define BMPARAMETERQUEUE_DEFAULT_CAPACITY 32
+
+typedef struct BMParameterEvent {
+	// the sample on which the change takes effect
+	uint64_t sampleTime;
+
+	// identifies the setting. Each struct that has a queue defines an enum
+	// of parameters.
+	uint32_t parameter;
+
+	// filter level, channel, or whatever else the parameter applies to
+	uint32_t index;
+
+	float values [BMPARAMETERQUEUE_MAX_VALUES];
+} BMParameterEvent;
+
+// called on the audio thread to apply one event to the struct that owns the queue
+typedef void (*BMParameterQueueApplyFunction)(void *object, const BMParameterEvent *event);
+
+typedef struct BMParameterQueue {
+	BMParameterEvent *events;
+	size_t capacity;
+
+	// the audio thread writes readIndex and sampleTime; the control thread
+	// writes writeIndex
+	_Atomic(size_t) readIndex;
+	_Atomic(size_t) writeIndex;
+	_Atomic(uint64_t) sampleTime;
+} BMParameterQueue;
+
+
+
+/*!
+ *BMParameterQueue_init
+ *
+ * @param This      pointer to an uninitialised struct
+ * @param capacity  maximum number of events waiting at one time. Rounded up to a power of two.
+ */
+void BMParameterQueue_init(BMParameterQueue *This, size_t capacity);
+
+
+/*!
+ *BMParameterQueue_free
+ */
+void BMParameterQueue_free(BMParameterQueue *This);
+
+
+/*!
+ *BMParameterQueue_push
+ *
+ * @abstract add an event to the queue. Call this from the control thread only.
+ *
+ * @returns false if the queue is full. The event is not added in that case.
+ */
+bool BMParameterQueue_push(BMParameterQueue *This, const BMParameterEvent *event);
+
+
+/*!
+ *BMParameterQueue_pushSnapshot
+ *
+ * @abstract add a group of events that take effect together. Call this from the control thread only.
+ *
+ * @discussion The events are published to the audio thread at once, so it can't apply some of them in one buffer and the rest in the next.
+ *
+ * @param This        pointer to an initialised struct
+ * @param events      array of numEvents events. Their sampleTime is ignored.
+ * @param numEvents   number of events
+ * @param sampleTime  the sample on which all the events take effect
+ *
+ * @returns false if there isn't room for all the events. None of them are added in that case.
+ */
+bool BMParameterQueue_pushSnapshot(BMParameterQueue *This,
+								   const BMParameterEvent *events,
+								   size_t numEvents,
+								   uint64_t sampleTime);
+
+
+/*!
+ *BMParameterQueue_currentTime
+ *
+ * @returns the number of samples the audio thread has processed. An event with this time takes effect at the start of the next buffer.
+ */
+uint64_t BMParameterQueue_currentTime(BMParameterQueue *This);
+
+
+/*!
+ *BMParameterQueue_nextSegment
+ *
+ * @abstract apply the events that are due and find how many samples to process before the next one. Call this from the audio thread only.
+ *
+ * @param This        pointer to an initialised struct
+ * @param maxSamples  number of samples remaining in the buffer. Must be > 0.
+ * @param apply       function that applies an event to object
+ * @param object      the struct that owns the queue
+ *
+ * @returns the number of samples to process before calling this again, in [1, maxSamples]. The clock advances by this amount.
+ */
+size_t BMParameterQueue_nextSegment(BMParameterQueue *This,
+									size_t maxSamples,
+									BMParameterQueueApplyFunction apply,
+									void *object);
+
+
+/*!
+ *BMParameterQueue_applyDueEvents
+ *
+ * @abstract the first half of BMParameterQueue_nextSegment. This applies the events that are due and finds how many samples to process before the next one, but doesn't advance the clock. Use it with BMParameterQueue_advanceTime when several structs with their own queues are processed in segments of the same length. Call this from the audio thread only.
+ *
+ * @returns the number of samples until the next event, in [1, maxSamples]
+ */
+size_t BMParameterQueue_applyDueEvents(BMParameterQueue *This,
+									   size_t maxSamples,
+									   BMParameterQueueApplyFunction apply,
+									   void *object);
+
+
+/*!
+ *BMParameterQueue_advanceTime
+ *
+ * @abstract advance the clock after processing numSamples. numSamples must not be more than the value returned by the last call to BMParameterQueue_applyDueEvents. Call this from the audio thread only.
+ */
+void BMParameterQueue_advanceTime(BMParameterQueue *This, size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMParameterQueue_h */
@@ -0,0 +1,389 @@
+//
+//  BMRealTimeSafety.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMRealTimeSafety.h"
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#if defined(BM_REALTIME_SAFETY_CHECKS) && defined(__linux__)
+#include <dlfcn.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The initial-exec model puts the thread-local variables in static TLS,
+// so reading them never calls malloc, which would call back into this file.
+#if defined(__GNUC__) && !defined(__APPLE__)
+#define BMRT_THREAD_LOCAL static _Thread_local __attribute__((tls_model("initial-exec")))
+#else
+#define BMRT_THREAD_LOCAL static _Thread_local
+#endif
+
+typedef struct BMRealTimeRecord {
+	atomic_bool valid;
+	const char *section;
+	const char *function;
+	enum BMRealTimeViolationType type;
+	atomic_size_t count;
+} BMRealTimeRecord;
+
+static BMRealTimeRecord BMRealTimeSafety_records [BMREALTIMESAFETY_MAX_RECORDS];
+
+// may exceed BMREALTIMESAFETY_MAX_RECORDS if there are too many combinations
+static atomic_size_t BMRealTimeSafety_numRecords;
+static atomic_size_t BMRealTimeSafety_totalViolations;
+static atomic_bool BMRealTimeSafety_abortOnViolation;
+
+BMRT_THREAD_LOCAL size_t BMRealTimeSafety_depth;
+BMRT_THREAD_LOCAL const char *BMRealTimeSafety_section;
+
+
+
+
+void BMRealTimeSafety_enter(const char *sectionName){
+	if(BMRealTimeSafety_depth++ == 0)
+		BMRealTimeSafety_section = sectionName;
+}
+
+
+
+
+void BMRealTimeSafety_exit(void){
+	if(BMRealTimeSafety_depth > 0 && --BMRealTimeSafety_depth == 0)
+		BMRealTimeSafety_section = NULL;
+}
+
+
+
+
+bool BMRealTimeSafety_isInSection(void){
+	return BMRealTimeSafety_depth > 0;
+}
+
+
+
+
+void BMRealTimeSafety_setAbortOnViolation(bool abort){
+	atomic_store(&BMRealTimeSafety_abortOnViolation, abort);
+}
+
+
+
+
+#ifdef BM_REALTIME_SAFETY_CHECKS
+/*
+ * Count a call to function if this thread is in a section. Two threads
+ * that record the same new combination at the same time may both add a
+ * record for it. The report adds them together.
+ */
+static void BMRealTimeSafety_record(const char *function, enum BMRealTimeViolationType type){
+	if(BMRealTimeSafety_depth == 0) return;
+	const char *section = BMRealTimeSafety_section;
+
+	atomic_fetch_add(&BMRealTimeSafety_totalViolations, 1);
+
+	// look for an existing record
+	size_t numRecords = atomic_load(&BMRealTimeSafety_numRecords);
+	if(numRecords > BMREALTIMESAFETY_MAX_RECORDS)
+		numRecords = BMREALTIMESAFETY_MAX_RECORDS;
+	bool found = false;
+	for(size_t i=0; i<numRecords && !found; i++){
+		BMRealTimeRecord *r = &BMRealTimeSafety_records[i];
+		if(atomic_load(&r->valid) && r->section == section && r->function == function){
+			atomic_fetch_add(&r->count, 1);
+			found = true;
+		}
+	}
+
+	// claim a new one
+	if(!found){
+		size_t i = atomic_fetch_add(&BMRealTimeSafety_numRecords, 1);
+		if(i < BMREALTIMESAFETY_MAX_RECORDS){
+			BMRealTimeRecord *r = &BMRealTimeSafety_records[i];
+			r->section = section;
+			r->function = function;
+			r->type = type;
+			atomic_store(&r->count, 1);
+			atomic_store(&r->valid, true);
+		}
+	}
+
+	if(atomic_load(&BMRealTimeSafety_abortOnViolation))
+		abort();
+}
+#endif
+
+
+
+
+size_t BMRealTimeSafety_numViolations(void){
+	return atomic_load(&BMRealTimeSafety_totalViolations);
+}
+
+
+
+
+size_t BMRealTimeSafety_getViolations(BMRealTimeViolation *violations, size_t maxViolations){
+	size_t numRecords = atomic_load(&BMRealTimeSafety_numRecords);
+	if(numRecords > BMREALTIMESAFETY_MAX_RECORDS)
+		numRecords = BMREALTIMESAFETY_MAX_RECORDS;
+
+	size_t numCopied = 0;
+	for(size_t i=0; i<numRecords && numCopied < maxViolations; i++){
+		BMRealTimeRecord *r = &BMRealTimeSafety_records[i];
+		if(!atomic_load(&r->valid)) continue;
+		violations[numCopied].section = r->section;
+		violations[numCopied].function = r->function;
+		violations[numCopied].type = r->type;
+		violations[numCopied].count = atomic_load(&r->count);
+		numCopied++;
+	}
+	return numCopied;
+}
+
+
+
+
+void BMRealTimeSafety_reset(void){
+	for(size_t i=0; i<BMREALTIMESAFETY_MAX_RECORDS; i++){
+		atomic_store(&BMRealTimeSafety_records[i].valid, false);
+		atomic_store(&BMRealTimeSafety_records[i].count, 0);
+	}
+	atomic_store(&BMRealTimeSafety_numRecords, 0);
+	atomic_store(&BMRealTimeSafety_totalViolations, 0);
+}
+
+
+
+
+void BMRealTimeSafety_printReport(FILE *file){
+	static const char *typeNames [] = {"allocation", "I/O", "lock"};
+	BMRealTimeViolation violations [BMREALTIMESAFETY_MAX_RECORDS];
+	size_t numViolations = BMRealTimeSafety_getViolations(violations, BMREALTIMESAFETY_MAX_RECORDS);
+
+	fprintf(file, "real time safety: %zu violations\n", BMRealTimeSafety_numViolations());
+	for(size_t i=0; i<numViolations; i++){
+		// skip records that duplicate an earlier one
+		bool duplicate = false;
+		for(size_t j=0; j<i; j++)
+			if(violations[j].section == violations[i].section &&
+			   violations[j].function == violations[i].function)
+				duplicate = true;
+		if(duplicate) continue;
+
+		size_t count = violations[i].count;
+		for(size_t j=i+1; j<numViolations; j++)
+			if(violations[j].section == violations[i].section &&
+			   violations[j].function == violations[i].function)
+				count += violations[j].count;
+
+		fprintf(file, "  %-48s %-10s %-20s %zu\n",
+				violations[i].section ? violations[i].section : "(unnamed)",
+				typeNames[violations[i].type],
+				violations[i].function,
+				count);
+	}
+	if(atomic_load(&BMRealTimeSafety_numRecords) > BMREALTIMESAFETY_MAX_RECORDS)
+		fprintf(file, "  some violations were counted but not listed\n");
+}
+
+
+
+
+#if defined(BM_REALTIME_SAFETY_CHECKS) && defined(__linux__)
+
+/*
+ * glibc exports its allocator under these names so that replacement
+ * functions can call it without going through dlsym, which allocates.
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+// the next definition of name after this one, which is normally the one in libc
+#define BMRT_NEXT(name) static __typeof__(&name) next_##name = NULL; \
+	if(!next_##name) next_##name = (__typeof__(&name))dlsym(RTLD_NEXT, #name)
+
+void *malloc(size_t size){
+	BMRealTimeSafety_record("malloc", BMRT_ALLOCATION);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size){
+	BMRealTimeSafety_record("calloc", BMRT_ALLOCATION);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size){
+	BMRealTimeSafety_record("realloc", BMRT_ALLOCATION);
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr){
+	if(ptr) BMRealTimeSafety_record("free", BMRT_ALLOCATION);
+	__libc_free(ptr);
+}
+
+int printf(const char *format, ...){
+	BMRealTimeSafety_record("printf", BMRT_IO);
+	BMRT_NEXT(vfprintf);
+	va_list args;
+	va_start(args, format);
+	int result = next_vfprintf(stdout, format, args);
+	va_end(args);
+	return result;
+}
+
+int fprintf(FILE *file, const char *format, ...){
+	BMRealTimeSafety_record("fprintf", BMRT_IO);
+	BMRT_NEXT(vfprintf);
+	va_list args;
+	va_start(args, format);
+	int result = next_vfprintf(file, format, args);
+	va_end(args);
+	return result;
+}
+
+int puts(const char *string){
+	BMRealTimeSafety_record("puts", BMRT_IO);
+	BMRT_NEXT(puts);
+	return next_puts(string);
+}
+
+int putchar(int c){
+	BMRealTimeSafety_record("putchar", BMRT_IO);
+	BMRT_NEXT(putchar);
+	return next_putchar(c);
+}
+
+int fputs(const char *string, FILE *file){
+	BMRealTimeSafety_record("fputs", BMRT_IO);
+	BMRT_NEXT(fputs);
+	return next_fputs(string, file);
+}
+
+size_t fwrite(const void *ptr, size_t size, size_t count, FILE *file){
+	BMRealTimeSafety_record("fwrite", BMRT_IO);
+	BMRT_NEXT(fwrite);
+	return next_fwrite(ptr, size, count, file);
+}
+
+FILE *fopen(const char *path, const char *mode){
+	BMRealTimeSafety_record("fopen", BMRT_IO);
+	BMRT_NEXT(fopen);
+	return next_fopen(path, mode);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex){
+	BMRealTimeSafety_record("pthread_mutex_lock", BMRT_LOCK);
+	BMRT_NEXT(pthread_mutex_lock);
+	return next_pthread_mutex_lock(mutex);
+}
+
+#elif defined(BM_REALTIME_SAFETY_CHECKS) && defined(__APPLE__)
+
+/*
+ * dyld replaces calls to the second function with calls to the first in
+ * every image except this one, so the replacements can call the originals
+ * directly.
+ */
+#define BMRT_INTERPOSE(replacement, original) \
+	__attribute__((used)) static struct { const void *r; const void *o; } \
+	BMRT_interpose_##original __attribute__((section("__DATA,__interpose"))) = \
+	{(const void*)(unsigned long)&replacement, (const void*)(unsigned long)&original}
+
+static void *BMRealTimeSafety_malloc(size_t size){
+	BMRealTimeSafety_record("malloc", BMRT_ALLOCATION);
+	return malloc(size);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_malloc, malloc);
+
+static void *BMRealTimeSafety_calloc(size_t count, size_t size){
+	BMRealTimeSafety_record("calloc", BMRT_ALLOCATION);
+	return calloc(count, size);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_calloc, calloc);
+
+static void *BMRealTimeSafety_realloc(void *ptr, size_t size){
+	BMRealTimeSafety_record("realloc", BMRT_ALLOCATION);
+	return realloc(ptr, size);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_realloc, realloc);
+
+static void BMRealTimeSafety_free(void *ptr){
+	if(ptr) BMRealTimeSafety_record("free", BMRT_ALLOCATION);
+	free(ptr);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_free, free);
+
+static int BMRealTimeSafety_printf(const char *format, ...){
+	BMRealTimeSafety_record("printf", BMRT_IO);
+	va_list args;
+	va_start(args, format);
+	int result = vprintf(format, args);
+	va_end(args);
+	return result;
+}
+BMRT_INTERPOSE(BMRealTimeSafety_printf, printf);
+
+static int BMRealTimeSafety_fprintf(FILE *file, const char *format, ...){
+	BMRealTimeSafety_record("fprintf", BMRT_IO);
+	va_list args;
+	va_start(args, format);
+	int result = vfprintf(file, format, args);
+	va_end(args);
+	return result;
+}
+BMRT_INTERPOSE(BMRealTimeSafety_fprintf, fprintf);
+
+static int BMRealTimeSafety_puts(const char *string){
+	BMRealTimeSafety_record("puts", BMRT_IO);
+	return puts(string);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_puts, puts);
+
+static int BMRealTimeSafety_putchar(int c){
+	BMRealTimeSafety_record("putchar", BMRT_IO);
+	return putchar(c);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_putchar, putchar);
+
+static int BMRealTimeSafety_fputs(const char *string, FILE *file){
+	BMRealTimeSafety_record("fputs", BMRT_IO);
+	return fputs(string, file);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_fputs, fputs);
+
+static size_t BMRealTimeSafety_fwrite(const void *ptr, size_t size, size_t count, FILE *file){
+	BMRealTimeSafety_record("fwrite", BMRT_IO);
+	return fwrite(ptr, size, count, file);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_fwrite, fwrite);
+
+static FILE *BMRealTimeSafety_fopen(const char *path, const char *mode){
+	BMRealTimeSafety_record("fopen", BMRT_IO);
+	return fopen(path, mode);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_fopen, fopen);
+
+static int BMRealTimeSafety_pthread_mutex_lock(pthread_mutex_t *mutex){
+	BMRealTimeSafety_record("pthread_mutex_lock", BMRT_LOCK);
+	return pthread_mutex_lock(mutex);
+}
+BMRT_INTERPOSE(BMRealTimeSafety_pthread_mutex_lock, pthread_mutex_lock);
+
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,144 @@
+//
+//  BMRealTimeSafety.h
+//  AudioFiltersXcodeProject
+//
+//  Checks that audio processing functions do not allocate memory, do file
+//  or console I/O or lock mutexes. Any of these can block for an unbounded
+//  time and cause dropouts on the audio thread.
+//
+//  Wrap each call to a processing function with BM_REALTIME_BEGIN and
+//  BM_REALTIME_END. When the library is built with BM_REALTIME_SAFETY_CHECKS
+//  defined, this file replaces malloc, calloc, realloc, free, the stdio
+//  output functions and pthread_mutex_lock with versions that record a
+//  violation whenever they are called between BEGIN and END on the same
+//  thread, and then call the original function. Call
+//  BMRealTimeSafety_printReport from another thread, or after processing, to
+//  see which functions were called and from which sections.
+//
+//  Without BM_REALTIME_SAFETY_CHECKS the macros expand to nothing and
+//  nothing is replaced.
+//
+//  On Linux the replacement functions take effect wherever this file is
+//  linked. On macOS they use dyld interposing, which only works when this
+//  file is built into a dynamic library, such as a unit test bundle.
+//
+//  Recording a violation does not allocate, lock or print, so the checks
+//  do not change the behaviour of the code being checked, only its speed.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMRealTimeSafety_h
+#define BMRealTimeSafety_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef BM_REALTIME_SAFETY_CHECKS
+#define BM_REALTIME_BEGIN(sectionName) BMRealTimeSafety_enter(sectionName)
+#define BM_REALTIME_END() BMRealTimeSafety_exit()
+#else
+#define BM_REALTIME_BEGIN(sectionName) ((void)0)
+#define BM_REALTIME_END() ((void)0)
+#endif
+
+// violations are counted separately for each combination of section and
+// function, up to this many combinations
+#define BMREALTIMESAFETY_MAX_RECORDS 128
+
+enum BMRealTimeViolationType {BMRT_ALLOCATION, BMRT_IO, BMRT_LOCK};
+
+typedef struct BMRealTimeViolation {
+	// the name passed to BMRealTimeSafety_enter for the outermost section
+	const char *section;
+
+	// the name of the function that was called, for example "malloc"
+	const char *function;
+
+	enum BMRealTimeViolationType type;
+	size_t count;
+} BMRealTimeViolation;
+
+
+
+/*!
+ *BMRealTimeSafety_enter
+ *
+ * @abstract mark the start of a section of code on this thread that must be real time safe. Sections may be nested.
+ *
+ * @param sectionName  identifies the section in the report. It is not copied, so it must be a string literal or otherwise outlive the report.
+ */
+void BMRealTimeSafety_enter(const char *sectionName);
+
+
+/*!
+ *BMRealTimeSafety_exit
+ *
+ * @abstract mark the end of the section started by the matching call to BMRealTimeSafety_enter
+ */
+void BMRealTimeSafety_exit(void);
+
+
+/*!
+ *BMRealTimeSafety_isInSection
+ *
+ * @returns true if the calling thread is between BMRealTimeSafety_enter and BMRealTimeSafety_exit
+ */
+bool BMRealTimeSafety_isInSection(void);
+
+
+/*!
+ *BMRealTimeSafety_setAbortOnViolation
+ *
+ * @abstract if abort is true, the first violation calls abort() so that a debugger stops at the offending call
+ */
+void BMRealTimeSafety_setAbortOnViolation(bool abort);
+
+
+/*!
+ *BMRealTimeSafety_numViolations
+ *
+ * @returns the total number of violations recorded since the last reset
+ */
+size_t BMRealTimeSafety_numViolations(void);
+
+
+/*!
+ *BMRealTimeSafety_getViolations
+ *
+ * @abstract copy the violation records into violations
+ *
+ * @param violations     array of length maxViolations
+ * @param maxViolations  length of violations
+ * @returns the number of records copied
+ */
+size_t BMRealTimeSafety_getViolations(BMRealTimeViolation *violations, size_t maxViolations);
+
+
+/*!
+ *BMRealTimeSafety_reset
+ *
+ * @abstract clear all records. Don't call this while another thread is in a section.
+ */
+void BMRealTimeSafety_reset(void);
+
+
+/*!
+ *BMRealTimeSafety_printReport
+ *
+ * @abstract write the violations to file, one line for each section and function. Don't call this from inside a section.
+ */
+void BMRealTimeSafety_printReport(FILE *file);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMRealTimeSafety_h */
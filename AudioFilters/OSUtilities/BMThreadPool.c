@@ -0,0 +1,241 @@
+//
+//  BMThreadPool.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMThreadPool.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BMThreadPoolWorker {
+	BMThreadPool *pool;
+	size_t threadIndex;
+} BMThreadPoolWorker;
+
+
+
+
+/*
+ * Take the next index from the front of the range of thread t
+ */
+static bool BMThreadPool_popOwn(BMThreadPool *This, size_t t, size_t *index){
+	BMThreadPoolRange *r = &This->ranges[t];
+	bool found = false;
+	pthread_mutex_lock(&r->lock);
+	if(r->begin < r->end){
+		*index = r->begin++;
+		found = true;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return found;
+}
+
+
+
+
+/*
+ * Move the upper half of the range of another thread into the range of
+ * thread t, which must be empty. Returns false if all the other ranges are
+ * empty.
+ */
+static bool BMThreadPool_steal(BMThreadPool *This, size_t t){
+	for(size_t i=1; i<This->numThreads; i++){
+		BMThreadPoolRange *victim = &This->ranges[(t + i) % This->numThreads];
+
+		size_t begin = 0, end = 0;
+		pthread_mutex_lock(&victim->lock);
+		if(victim->begin < victim->end){
+			// when only one index is left, take it
+			begin = victim->begin + (victim->end - victim->begin)/2;
+			end = victim->end;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if(begin < end){
+			BMThreadPoolRange *own = &This->ranges[t];
+			pthread_mutex_lock(&own->lock);
+			own->begin = begin;
+			own->end = end;
+			pthread_mutex_unlock(&own->lock);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+/*
+ * Run the current job on thread t until there is no work left to do or to
+ * steal. Each index is in exactly one range at a time and it only leaves
+ * that range when the owner processes it or when it is moved to another
+ * range by stealing, so every index is processed once. A thread may stop
+ * while another thread is moving a stolen range, but the thief processes
+ * that range itself.
+ */
+static void BMThreadPool_work(BMThreadPool *This, size_t t){
+	size_t index;
+	while(true){
+		if(BMThreadPool_popOwn(This, t, &index))
+			This->function(This->context, index, t);
+		else if(!BMThreadPool_steal(This, t))
+			break;
+	}
+}
+
+
+
+
+static void* BMThreadPool_workerThread(void *arg){
+	BMThreadPoolWorker *worker = (BMThreadPoolWorker*)arg;
+	BMThreadPool *This = worker->pool;
+	size_t t = worker->threadIndex;
+	free(worker);
+
+	size_t generation = 0;
+	while(true){
+		// wait for a new job
+		pthread_mutex_lock(&This->lock);
+		while(!This->quit && This->generation == generation)
+			pthread_cond_wait(&This->jobStarted, &This->lock);
+		bool quit = This->quit;
+		generation = This->generation;
+		pthread_mutex_unlock(&This->lock);
+
+		if(quit) break;
+
+		BMThreadPool_work(This, t);
+
+		// signal the calling thread if this was the last worker to finish
+		pthread_mutex_lock(&This->lock);
+		if(--This->activeWorkers == 0)
+			pthread_cond_signal(&This->jobFinished);
+		pthread_mutex_unlock(&This->lock);
+	}
+
+	return NULL;
+}
+
+
+
+
+void BMThreadPool_init(BMThreadPool *This, size_t numThreads){
+	if(numThreads == 0){
+		long numCores = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = numCores > 0 ? (size_t)numCores : 1;
+	}
+
+	This->numThreads = numThreads;
+	This->generation = 0;
+	This->activeWorkers = 0;
+	This->quit = false;
+	This->function = NULL;
+	This->context = NULL;
+	pthread_mutex_init(&This->lock, NULL);
+	pthread_cond_init(&This->jobStarted, NULL);
+	pthread_cond_init(&This->jobFinished, NULL);
+
+	This->ranges = malloc(sizeof(BMThreadPoolRange) * numThreads);
+	for(size_t i=0; i<numThreads; i++){
+		pthread_mutex_init(&This->ranges[i].lock, NULL);
+		This->ranges[i].begin = This->ranges[i].end = 0;
+	}
+
+	// thread 0 is the calling thread so we start one fewer workers
+	This->workers = NULL;
+	if(numThreads > 1){
+		This->workers = malloc(sizeof(pthread_t) * (numThreads - 1));
+		for(size_t i=1; i<numThreads; i++){
+			BMThreadPoolWorker *worker = malloc(sizeof(BMThreadPoolWorker));
+			worker->pool = This;
+			worker->threadIndex = i;
+			pthread_create(&This->workers[i-1], NULL, BMThreadPool_workerThread, worker);
+		}
+	}
+}
+
+
+
+
+void BMThreadPool_free(BMThreadPool *This){
+	pthread_mutex_lock(&This->lock);
+	This->quit = true;
+	pthread_cond_broadcast(&This->jobStarted);
+	pthread_mutex_unlock(&This->lock);
+
+	for(size_t i=1; i<This->numThreads; i++)
+		pthread_join(This->workers[i-1], NULL);
+	free(This->workers);
+	This->workers = NULL;
+
+	for(size_t i=0; i<This->numThreads; i++)
+		pthread_mutex_destroy(&This->ranges[i].lock);
+	free(This->ranges);
+	This->ranges = NULL;
+
+	pthread_cond_destroy(&This->jobStarted);
+	pthread_cond_destroy(&This->jobFinished);
+	pthread_mutex_destroy(&This->lock);
+}
+
+
+
+
+void BMThreadPool_parallelFor(BMThreadPool *This,
+							  size_t count,
+							  BMThreadPoolFunction function,
+							  void *context){
+	// with one thread, or nothing to share, run the loop here
+	if(This->numThreads == 1 || count <= 1){
+		for(size_t i=0; i<count; i++)
+			function(context, i, 0);
+		return;
+	}
+
+	// split the index range evenly. The workers are all waiting, so we can
+	// set the ranges without locking them.
+	for(size_t t=0; t<This->numThreads; t++){
+		This->ranges[t].begin = (count * t) / This->numThreads;
+		This->ranges[t].end = (count * (t + 1)) / This->numThreads;
+	}
+
+	// start the workers
+	pthread_mutex_lock(&This->lock);
+	This->function = function;
+	This->context = context;
+	This->activeWorkers = This->numThreads - 1;
+	This->generation++;
+	pthread_cond_broadcast(&This->jobStarted);
+	pthread_mutex_unlock(&This->lock);
+
+	// do a share of the work on this thread
+	BMThreadPool_work(This, 0);
+
+	// wait for the workers to finish
+	pthread_mutex_lock(&This->lock);
+	while(This->activeWorkers > 0)
+		pthread_cond_wait(&This->jobFinished, &This->lock);
+	pthread_mutex_unlock(&This->lock);
+}
+
+
+
+
+size_t BMThreadPool_getNumThreads(BMThreadPool *This){
+	return This->numThreads;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
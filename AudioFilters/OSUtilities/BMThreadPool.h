@@ -0,0 +1,101 @@
+//
+//  BMThreadPool.h
+//  AudioFiltersXcodeProject
+//
+//  A pool of worker threads for parallel loops, built on pthreads so that
+//  it works on every platform we support.
+//
+//  BMThreadPool_parallelFor splits the index range evenly between the
+//  threads. The thread that calls it does a share of the work as well.
+//  Each thread takes indices one at a time from the front of its own range.
+//  When its range is empty it steals the upper half of the range of
+//  another thread, so the load stays balanced when some items take longer
+//  than others.
+//
+//  This is not for use on the audio thread: it locks mutexes and waits for
+//  the workers.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMThreadPool_h
+#define BMThreadPool_h
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * the function called for each index in the loop
+ *
+ * @param context      the context pointer passed to BMThreadPool_parallelFor
+ * @param index        the loop index
+ * @param threadIndex  in [0, numThreads). Use this to choose per-thread scratch memory.
+ */
+typedef void (*BMThreadPoolFunction)(void *context, size_t index, size_t threadIndex);
+
+typedef struct BMThreadPoolRange {
+	pthread_mutex_t lock;
+	size_t begin, end;
+} BMThreadPoolRange;
+
+typedef struct BMThreadPool {
+	pthread_t *workers;
+	BMThreadPoolRange *ranges;
+	size_t numThreads;
+
+	// the current job
+	BMThreadPoolFunction function;
+	void *context;
+	size_t generation, activeWorkers;
+	bool quit;
+
+	pthread_mutex_t lock;
+	pthread_cond_t jobStarted, jobFinished;
+} BMThreadPool;
+
+
+/*!
+ *BMThreadPool_init
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param numThreads  number of threads working on each loop, including the calling thread. Pass 0 to use the number of processor cores.
+ */
+void BMThreadPool_init(BMThreadPool *This, size_t numThreads);
+
+
+/*!
+ *BMThreadPool_free
+ *
+ * @abstract stops and joins the worker threads
+ */
+void BMThreadPool_free(BMThreadPool *This);
+
+
+/*!
+ *BMThreadPool_parallelFor
+ *
+ * @abstract calls function(context, i, threadIndex) for each i in [0, count) and returns when all calls have finished. Calls to this function must not overlap.
+ */
+void BMThreadPool_parallelFor(BMThreadPool *This,
+							  size_t count,
+							  BMThreadPoolFunction function,
+							  void *context);
+
+
+/*!
+ *BMThreadPool_getNumThreads
+ */
+size_t BMThreadPool_getNumThreads(BMThreadPool *This);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMThreadPool_h */
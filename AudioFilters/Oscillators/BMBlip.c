@@ -7,7 +7,11 @@
 //
 
 #include "BMBlip.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "BMIntegerMath.h"
 #include "Constants.h"
 
@@ -11,7 +11,11 @@
 #include <assert.h>
 #include "BMIntegerMath.h"
 #include "Constants.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 
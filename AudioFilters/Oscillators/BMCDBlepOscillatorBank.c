@@ -0,0 +1,374 @@
+//
+//  BMCDBlepOscillatorBank.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMCDBlepOscillatorBank.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "BMIntegerMath.h"
+#include "Constants.h"
+#ifdef __APPLE__
+#include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BMCDBlepOscillatorBank_init(BMCDBlepOscillatorBank *This,
+								 size_t maxVoices,
+								 size_t filterOrder,
+								 size_t oversampleFactor,
+								 float sampleRate){
+	assert(maxVoices > 0 && maxVoices <= BMCDBLEP_BANK_MAX_VOICES);
+	assert(filterOrder > 0 && filterOrder <= BMCDBLEP_BANK_MAX_FILTER_ORDER);
+	assert(isPowerOfTwo(oversampleFactor) && oversampleFactor > 0);
+
+	This->maxVoices = maxVoices;
+	This->filterOrder = filterOrder;
+	This->oversampleFactor = oversampleFactor;
+	This->sampleRate = sampleRate;
+	This->numActive = 0;
+	This->noteCount = 0;
+
+	// the blep input increases by this much each oversampled sample. This is
+	// the same as in BMCDBlepOscillator.
+	float blepScale = 1.0 / 2.0;
+	This->blepInputIncrement = (blepScale * 48000.0) / (sampleRate * (float)oversampleFactor);
+
+	// the step response of the nth order critically damped filter is
+	//
+	//   2 * Sum[g_m[t], {m, 0, n-1}],  g_m[t_] := E^(-t) t^m / m!
+	//
+	// which goes from 2 to 0, the size of the step in a saw wave in [-1,1].
+	// Advancing t by h gives
+	//
+	//   g_m[t + h] = E^(-h) Sum[g_j[t] h^(m-j) / (m-j)!, {j, 0, m}]
+	//
+	// These are the coefficients of that transition.
+	double h = This->blepInputIncrement;
+	for(size_t m=0; m<filterOrder; m++){
+		double coefficient = exp(-h);
+		for(size_t k=0; k<=m; k++){
+			This->blepTransition[m][m-k] = (float)coefficient;
+			coefficient *= h / (double)(k+1);
+		}
+	}
+
+	// allocate the voice state
+	This->phases = malloc(sizeof(float) * maxVoices);
+	This->phaseIncrements = malloc(sizeof(float) * maxVoices);
+	This->targetIncrements = malloc(sizeof(float) * maxVoices);
+	This->incrementSteps = malloc(sizeof(float) * maxVoices);
+	This->gains = malloc(sizeof(float) * maxVoices);
+	This->targetGains = malloc(sizeof(float) * maxVoices);
+	This->gainSteps = malloc(sizeof(float) * maxVoices);
+	This->voiceOutputs = malloc(sizeof(float) * maxVoices);
+	This->wrapped = malloc(sizeof(int32_t) * maxVoices);
+	This->releasing = malloc(sizeof(bool) * maxVoices);
+	This->startTimes = malloc(sizeof(uint64_t) * maxVoices);
+
+	// g_m of the voice in slot v is at index m*maxVoices + v
+	This->blepStates = malloc(sizeof(float) * maxVoices * filterOrder);
+
+	// every voice starts in the free part of the pool
+	for(size_t i=0; i<maxVoices; i++)
+		This->slotVoice[i] = This->voiceSlot[i] = i;
+
+	This->bus = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE * oversampleFactor);
+
+	// the voices share one downsampler and one DC blocking filter
+	bool stereo = false;
+	BMDownsampler_init(&This->downsampler, stereo, oversampleFactor, BMRESAMPLER_FULL_SPECTRUM);
+	BMMultiLevelBiquad_init(&This->highpass, 1, sampleRate, stereo, true, false);
+	BMMultiLevelBiquad_setHighPass6db(&This->highpass, 40.0f, 0);
+}
+
+
+
+
+void BMCDBlepOscillatorBank_free(BMCDBlepOscillatorBank *This){
+	BMDownsampler_free(&This->downsampler);
+	BMMultiLevelBiquad_free(&This->highpass);
+
+	free(This->phases);
+	This->phases = NULL;
+	free(This->phaseIncrements);
+	This->phaseIncrements = NULL;
+	free(This->targetIncrements);
+	This->targetIncrements = NULL;
+	free(This->incrementSteps);
+	This->incrementSteps = NULL;
+	free(This->gains);
+	This->gains = NULL;
+	free(This->targetGains);
+	This->targetGains = NULL;
+	free(This->gainSteps);
+	This->gainSteps = NULL;
+	free(This->voiceOutputs);
+	This->voiceOutputs = NULL;
+	free(This->wrapped);
+	This->wrapped = NULL;
+	free(This->releasing);
+	This->releasing = NULL;
+	free(This->startTimes);
+	This->startTimes = NULL;
+	free(This->blepStates);
+	This->blepStates = NULL;
+	free(This->bus);
+	This->bus = NULL;
+}
+
+
+
+
+static float BMCDBlepOscillatorBank_phaseIncrement(BMCDBlepOscillatorBank *This, float frequency){
+	// the naive saw goes from -1 to 1 in each period
+	return 2.0f * frequency / (This->sampleRate * (float)This->oversampleFactor);
+}
+
+
+
+
+/*
+ * Exchange the state of two slots, keeping the voice index mapping in sync
+ */
+static void BMCDBlepOscillatorBank_swapSlots(BMCDBlepOscillatorBank *This, size_t a, size_t b){
+	if(a == b) return;
+
+#define BMCDBLEP_BANK_SWAP(type, array) { type t = array[a]; array[a] = array[b]; array[b] = t; }
+	BMCDBLEP_BANK_SWAP(float, This->phases);
+	BMCDBLEP_BANK_SWAP(float, This->phaseIncrements);
+	BMCDBLEP_BANK_SWAP(float, This->targetIncrements);
+	BMCDBLEP_BANK_SWAP(float, This->gains);
+	BMCDBLEP_BANK_SWAP(float, This->targetGains);
+	BMCDBLEP_BANK_SWAP(bool, This->releasing);
+	BMCDBLEP_BANK_SWAP(uint64_t, This->startTimes);
+	BMCDBLEP_BANK_SWAP(size_t, This->slotVoice);
+#undef BMCDBLEP_BANK_SWAP
+
+	for(size_t m=0; m<This->filterOrder; m++){
+		float *g = This->blepStates + m*This->maxVoices;
+		float temp = g[a]; g[a] = g[b]; g[b] = temp;
+	}
+
+	This->voiceSlot[This->slotVoice[a]] = a;
+	This->voiceSlot[This->slotVoice[b]] = b;
+}
+
+
+
+
+size_t BMCDBlepOscillatorBank_noteOn(BMCDBlepOscillatorBank *This, float frequency, float gain){
+	size_t slot;
+
+	// take a free voice if there is one. Otherwise restart the oldest.
+	if(This->numActive < This->maxVoices){
+		slot = This->numActive++;
+	} else {
+		slot = 0;
+		for(size_t i=1; i<This->numActive; i++)
+			if(This->startTimes[i] < This->startTimes[slot])
+				slot = i;
+	}
+
+	This->phases[slot] = 0.0f;
+	This->phaseIncrements[slot] = This->targetIncrements[slot] = BMCDBlepOscillatorBank_phaseIncrement(This, frequency);
+	This->gains[slot] = 0.0f;
+	This->targetGains[slot] = gain;
+	This->releasing[slot] = false;
+	This->startTimes[slot] = This->noteCount++;
+
+	// clear the bleps
+	for(size_t m=0; m<This->filterOrder; m++)
+		This->blepStates[m*This->maxVoices + slot] = 0.0f;
+
+	return This->slotVoice[slot];
+}
+
+
+
+
+void BMCDBlepOscillatorBank_noteOff(BMCDBlepOscillatorBank *This, size_t voice){
+	size_t slot = This->voiceSlot[voice];
+	assert(slot < This->numActive);
+	This->releasing[slot] = true;
+	This->targetGains[slot] = 0.0f;
+}
+
+
+
+
+void BMCDBlepOscillatorBank_setFrequency(BMCDBlepOscillatorBank *This, size_t voice, float frequency){
+	size_t slot = This->voiceSlot[voice];
+	assert(slot < This->numActive);
+	This->targetIncrements[slot] = BMCDBlepOscillatorBank_phaseIncrement(This, frequency);
+}
+
+
+
+
+void BMCDBlepOscillatorBank_setGain(BMCDBlepOscillatorBank *This, size_t voice, float gain){
+	size_t slot = This->voiceSlot[voice];
+	assert(slot < This->numActive);
+	if(!This->releasing[slot])
+		This->targetGains[slot] = gain;
+}
+
+
+
+
+size_t BMCDBlepOscillatorBank_getNumActiveVoices(BMCDBlepOscillatorBank *This){
+	return This->numActive;
+}
+
+
+
+
+/*
+ * Start a blep on each voice whose phase wrapped in the current sample
+ */
+static void BMCDBlepOscillatorBank_startBleps(BMCDBlepOscillatorBank *This){
+	for(size_t v=0; v<This->numActive; v++){
+		if(This->wrapped[v]){
+			// the discontinuity was this many samples before the current one.
+			// See BMCDBlepOscillator_getFractionalOffset.
+			float offset = (This->phases[v] + 1.0f) / This->phaseIncrements[v];
+			float t = This->blepInputIncrement * offset;
+
+			// add 2 * g_m[t] to the state
+			float g = 2.0f * expf(-t);
+			for(size_t m=0; m<This->filterOrder; m++){
+				This->blepStates[m*This->maxVoices + v] += g;
+				g *= t / (float)(m+1);
+			}
+		}
+	}
+}
+
+
+
+
+/*
+ * Generate numSamplesOS samples of the sum of all voices at the oversampled
+ * rate. The outer loop is over time and the inner loops are over voices.
+ */
+static void BMCDBlepOscillatorBank_renderBus(BMCDBlepOscillatorBank *This, float *bus, size_t numSamplesOS){
+	size_t n = This->numActive;
+	size_t order = This->filterOrder;
+	size_t stride = This->maxVoices;
+	float *phases = This->phases;
+	float *increments = This->phaseIncrements;
+	const float *incrementSteps = This->incrementSteps;
+	float *gains = This->gains;
+	const float *gainSteps = This->gainSteps;
+	float *y = This->voiceOutputs;
+	float *states = This->blepStates;
+	int32_t *wrapped = This->wrapped;
+
+	for(size_t i=0; i<numSamplesOS; i++){
+		// advance the naive saw and note which voices wrapped around
+		int32_t anyWrapped = 0;
+		for(size_t v=0; v<n; v++){
+			increments[v] += incrementSteps[v];
+			float p = phases[v] + increments[v];
+			int32_t w = p >= 1.0f;
+			phases[v] = p - 2.0f * (float)w;
+			wrapped[v] = w;
+			anyWrapped |= w;
+		}
+		if(anyWrapped)
+			BMCDBlepOscillatorBank_startBleps(This);
+
+		// the output of each voice is the naive saw plus the sum of its bleps
+		memcpy(y, phases, sizeof(float)*n);
+		for(size_t m=0; m<order; m++){
+			const float *g = states + m*stride;
+			for(size_t v=0; v<n; v++)
+				y[v] += g[v];
+		}
+
+		// advance the blep states to the next sample. We go from the top down
+		// because g_m depends on g_j for j <= m.
+		for(size_t m=order; m-- > 0;){
+			float *gm = states + m*stride;
+			float a = This->blepTransition[m][m];
+			for(size_t v=0; v<n; v++)
+				gm[v] *= a;
+			for(size_t j=0; j<m; j++){
+				const float *gj = states + j*stride;
+				float b = This->blepTransition[m][j];
+				for(size_t v=0; v<n; v++)
+					gm[v] += b * gj[v];
+			}
+		}
+
+		// apply the gains and sum the voices
+		for(size_t v=0; v<n; v++)
+			gains[v] += gainSteps[v];
+		vDSP_dotpr(y, 1, gains, 1, bus + i, n);
+	}
+}
+
+
+
+
+void BMCDBlepOscillatorBank_process(BMCDBlepOscillatorBank *This, float *output, size_t numSamples){
+	size_t n = This->numActive;
+	if(numSamples == 0)
+		return;
+
+	// ramp the frequencies and gains linearly to their targets over this call
+	float stepScale = 1.0f / (float)(numSamples * This->oversampleFactor);
+	for(size_t v=0; v<n; v++){
+		This->incrementSteps[v] = (This->targetIncrements[v] - This->phaseIncrements[v]) * stepScale;
+		This->gainSteps[v] = (This->targetGains[v] - This->gains[v]) * stepScale;
+	}
+
+	size_t samplesRemaining = numSamples;
+	size_t i = 0;
+	while(samplesRemaining > 0){
+		size_t samplesProcessing = BM_MIN(BM_BUFFER_CHUNK_SIZE, samplesRemaining);
+		size_t samplesProcessingOS = This->oversampleFactor * samplesProcessing;
+
+		if(n > 0)
+			BMCDBlepOscillatorBank_renderBus(This, This->bus, samplesProcessingOS);
+		else
+			memset(This->bus, 0, sizeof(float)*samplesProcessingOS);
+
+		// downsample the sum of the voices
+		BMDownsampler_processBufferMono(&This->downsampler, This->bus, output + i, samplesProcessingOS);
+
+		samplesRemaining -= samplesProcessing;
+		i += samplesProcessing;
+	}
+
+	// remove the rounding error in the ramps
+	memcpy(This->phaseIncrements, This->targetIncrements, sizeof(float)*n);
+	memcpy(This->gains, This->targetGains, sizeof(float)*n);
+
+	// return released voices to the pool, keeping the active voices at the
+	// start of the arrays
+	for(size_t v=n; v-- > 0;){
+		if(This->releasing[v]){
+			BMCDBlepOscillatorBank_swapSlots(This, v, This->numActive - 1);
+			This->numActive--;
+		}
+	}
+
+	// highpass filter
+	BMMultiLevelBiquad_processBufferMono(&This->highpass, output, output, numSamples);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
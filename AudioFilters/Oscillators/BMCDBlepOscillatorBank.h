@@ -0,0 +1,152 @@
+//
+//  BMCDBlepOscillatorBank.h
+//  AudioFiltersXcodeProject
+//
+//  A polyphonic bank of critically-damped BLEP saw oscillators. Each voice
+//  is the same waveform as BMCDBlepOscillator: a naive saw plus the step
+//  response of a critically-damped lowpass filter at each discontinuity,
+//  generated at an oversampled rate.
+//
+//  The voice state is stored in structure-of-arrays layout and the inner
+//  loops run across voices, so the compiler can vectorise them. The
+//  downsampler and the DC blocking highpass are linear and time-invariant,
+//  so instead of running one of each per voice we sum the voices at the
+//  oversampled rate and filter the sum once.
+//
+//  BMCDBlepOscillator evaluates each BLEP separately. Here we use the fact
+//  that the step response of the nth order filter is a sum of the n
+//  functions g_m(t) = E^(-t) t^m / m!, and that advancing t by a fixed step
+//  maps the vector (g_0, ..., g_n-1) to itself by a constant lower
+//  triangular matrix. The BLEPs of a voice therefore add up to a single
+//  state vector that we advance once per sample. A new BLEP adds its g_m
+//  values to the state. The cost per voice depends on the filter order but
+//  not on the number of overlapping BLEPs, and there is no limit on how many
+//  may overlap.
+//
+//  Voices come from a fixed pool. The active voices are kept at the start
+//  of the arrays so that the cost depends on the number of voices playing,
+//  not on the size of the pool.
+//
+//  BMDPWOscillator is not included: its header notes that it needs more
+//  than double precision to work.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMCDBlepOscillatorBank_h
+#define BMCDBlepOscillatorBank_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "BMDownsampler.h"
+#include "BMMultiLevelBiquad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BMCDBLEP_BANK_MAX_VOICES 64
+#define BMCDBLEP_BANK_MAX_FILTER_ORDER 20
+
+typedef struct BMCDBlepOscillatorBank {
+	// voice state, one entry per slot. Slots [0, numActive) are playing.
+	float *phases, *phaseIncrements, *targetIncrements, *incrementSteps;
+	float *gains, *targetGains, *gainSteps;
+	float *blepStates, *voiceOutputs;
+	int32_t *wrapped;
+	bool *releasing;
+	uint64_t *startTimes;
+	size_t slotVoice [BMCDBLEP_BANK_MAX_VOICES];
+	size_t voiceSlot [BMCDBLEP_BANK_MAX_VOICES];
+	size_t numActive, maxVoices;
+
+	size_t filterOrder, oversampleFactor;
+	float sampleRate, blepInputIncrement;
+	float blepTransition [BMCDBLEP_BANK_MAX_FILTER_ORDER][BMCDBLEP_BANK_MAX_FILTER_ORDER];
+	uint64_t noteCount;
+	float *bus;
+	BMDownsampler downsampler;
+	BMMultiLevelBiquad highpass;
+} BMCDBlepOscillatorBank;
+
+
+/*!
+ *BMCDBlepOscillatorBank_init
+ *
+ * @param This              pointer to an uninitialised struct
+ * @param maxVoices         size of the voice pool, up to BMCDBLEP_BANK_MAX_VOICES
+ * @param filterOrder       order of the BLEP lowpass filter, as in BMCDBlepOscillator
+ * @param oversampleFactor  a power of two
+ * @param sampleRate        output sample rate
+ */
+void BMCDBlepOscillatorBank_init(BMCDBlepOscillatorBank *This,
+								 size_t maxVoices,
+								 size_t filterOrder,
+								 size_t oversampleFactor,
+								 float sampleRate);
+
+
+/*!
+ *BMCDBlepOscillatorBank_free
+ */
+void BMCDBlepOscillatorBank_free(BMCDBlepOscillatorBank *This);
+
+
+/*!
+ *BMCDBlepOscillatorBank_noteOn
+ *
+ * @abstract start a voice. The gain ramps up from zero over the next call to process. If all voices are playing, the voice that started first is restarted with the new note.
+ *
+ * @returns the voice index, in [0, maxVoices). It remains valid until the voice has finished releasing or is restarted by another note.
+ */
+size_t BMCDBlepOscillatorBank_noteOn(BMCDBlepOscillatorBank *This, float frequency, float gain);
+
+
+/*!
+ *BMCDBlepOscillatorBank_noteOff
+ *
+ * @abstract ramp the gain of the voice down to zero over the next call to process and then return it to the pool
+ */
+void BMCDBlepOscillatorBank_noteOff(BMCDBlepOscillatorBank *This, size_t voice);
+
+
+/*!
+ *BMCDBlepOscillatorBank_setFrequency
+ *
+ * @abstract the frequency ramps linearly to the new value over the next call to process
+ */
+void BMCDBlepOscillatorBank_setFrequency(BMCDBlepOscillatorBank *This, size_t voice, float frequency);
+
+
+/*!
+ *BMCDBlepOscillatorBank_setGain
+ *
+ * @abstract the gain ramps linearly to the new value over the next call to process
+ */
+void BMCDBlepOscillatorBank_setGain(BMCDBlepOscillatorBank *This, size_t voice, float gain);
+
+
+/*!
+ *BMCDBlepOscillatorBank_getNumActiveVoices
+ */
+size_t BMCDBlepOscillatorBank_getNumActiveVoices(BMCDBlepOscillatorBank *This);
+
+
+/*!
+ *BMCDBlepOscillatorBank_process
+ *
+ * @abstract render the sum of all active voices
+ *
+ * @param output      mono output
+ * @param numSamples  any length is supported
+ */
+void BMCDBlepOscillatorBank_process(BMCDBlepOscillatorBank *This, float *output, size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMCDBlepOscillatorBank_h */
@@ -13,7 +13,11 @@
 
 #include "BMDPWOscillator.h"
 #include <math.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 #include "BMIntegerMath.h"
 
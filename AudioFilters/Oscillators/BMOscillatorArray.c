@@ -8,7 +8,11 @@
 
 #include "BMOscillatorArray.h"
 #include "BMQuadratureOscillator.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include <stdlib.h>
 
 #ifdef __cplusplus
@@ -7,7 +7,11 @@
 //
 
 #include "BMPanLFO.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
 
 void BMPanLFO_init(BMPanLFO *This,
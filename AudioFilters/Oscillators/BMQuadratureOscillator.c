@@ -17,7 +17,11 @@
 #include <stdio.h>
 #include <string.h>
 #include "BM2x2Matrix.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,87 @@
+//
+//  BMWavetable.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMWavetable.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include "BMFFT.h"
+#include "BMIntegerMath.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// every level has at most tableLength / (2 * BMWT_TABLE_OVERSAMPLING)
+// harmonics. Changing this requires changing the level selection in
+// BMWavetableOscillator.
+#define BMWT_TABLE_OVERSAMPLING 4
+
+void BMWavetable_init(BMWavetable *This, const float *frames, size_t numFrames, size_t tableLength){
+	assert(isPowerOfTwo(tableLength) && tableLength >= 16);
+	assert(numFrames > 0);
+
+	This->tableLength = tableLength;
+	This->numFrames = numFrames;
+
+	// the top level has only the fundamental
+	size_t maxHarmonics = tableLength / (2 * BMWT_TABLE_OVERSAMPLING);
+	This->numLevels = log2i((uint32_t)maxHarmonics) + 1;
+
+	// one sample of padding before each table and two after
+	This->frameStride = tableLength + 3;
+	This->levelStride = This->frameStride * numFrames;
+	This->tables = malloc(sizeof(float) * This->levelStride * This->numLevels);
+
+	BMFFT fft;
+	BMFFT_init(&fft, tableLength);
+	size_t numBins = tableLength / 2;
+	float *buffer = malloc(sizeof(float) * 4 * numBins);
+	DSPSplitComplex spectrum = {buffer, buffer + numBins};
+	DSPSplitComplex filtered = {buffer + 2*numBins, buffer + 3*numBins};
+
+	for(size_t f=0; f<numFrames; f++){
+		BMFFT_FFTComplexOutput(&fft, frames + f*tableLength, &spectrum, tableLength);
+
+		for(size_t l=0; l<This->numLevels; l++){
+			// keep DC and harmonics 1 ... numHarmonics. The Nyquist term is in
+			// imagp[0] and is always removed.
+			size_t numHarmonics = maxHarmonics >> l;
+			memset(filtered.realp, 0, sizeof(float)*numBins);
+			memset(filtered.imagp, 0, sizeof(float)*numBins);
+			memcpy(filtered.realp, spectrum.realp, sizeof(float)*(numHarmonics+1));
+			memcpy(filtered.imagp + 1, spectrum.imagp + 1, sizeof(float)*numHarmonics);
+
+			float *table = This->tables + l*This->levelStride + f*This->frameStride;
+			BMFFT_IFFTComplexInput(&fft, &filtered, table + 1, tableLength);
+
+			// wrap around for interpolation
+			table[0] = table[tableLength];
+			table[tableLength + 1] = table[1];
+			table[tableLength + 2] = table[2];
+		}
+	}
+
+	free(buffer);
+	BMFFT_free(&fft);
+}
+
+
+
+
+void BMWavetable_free(BMWavetable *This){
+	free(This->tables);
+	This->tables = NULL;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,80 @@
+//
+//  BMWavetable.h
+//  AudioFiltersXcodeProject
+//
+//  A set of single cycle waveforms (frames) stored as band-limited mip-maps
+//  for BMWavetableOscillator.
+//
+//  Each frame is stored at several levels, one per octave. Level L keeps
+//  harmonics 1 to tableLength / 2^(L+3) of the frame and removes the rest
+//  using BMFFT. An oscillator playing at a frequency where one output sample
+//  advances through 2^(L+1) to 2^(L+2) table samples reads from level L, so
+//  the highest harmonic it plays is below the Nyquist frequency. Because
+//  every level has at most tableLength / 8 harmonics, the tables are at
+//  least four times oversampled, which keeps the error of cubic interpolation
+//  low.
+//
+//  The lowest level has the full bandwidth down to a fundamental frequency of
+//  2 * sampleRate / tableLength. Below that the waveform contains only the
+//  first tableLength / 8 harmonics. A table length of 4096 gives full
+//  bandwidth above 24 Hz at 48 KHz.
+//
+//  The tables are written only by BMWavetable_init. After that they are read
+//  only, so any number of oscillators on any number of threads may share one
+//  BMWavetable.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMWavetable_h
+#define BMWavetable_h
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BMWavetable {
+	// table for level l, frame f is at tables + l*levelStride + f*frameStride
+	float *tables;
+	size_t tableLength, numFrames, numLevels;
+	size_t frameStride, levelStride;
+} BMWavetable;
+
+
+/*!
+ *BMWavetable_init
+ *
+ * @abstract compute the mip-maps. This allocates memory and runs FFTs so don't call it on the audio thread.
+ *
+ * @param This         pointer to an uninitialised struct
+ * @param frames       numFrames single cycle waveforms of tableLength samples each, one after another
+ * @param numFrames    number of waveforms. The oscillator crossfades between neighbouring frames.
+ * @param tableLength  a power of two, at least 16
+ */
+void BMWavetable_init(BMWavetable *This, const float *frames, size_t numFrames, size_t tableLength);
+
+
+/*!
+ *BMWavetable_free
+ */
+void BMWavetable_free(BMWavetable *This);
+
+
+/*!
+ *BMWavetable_getTable
+ *
+ * @returns a pointer to the first sample of the given level and frame. The samples at index -1, tableLength and tableLength+1 are also valid; they wrap around so that cubic interpolation does not need to check the index.
+ */
+static inline const float* BMWavetable_getTable(const BMWavetable *This, size_t level, size_t frame){
+	return This->tables + level*This->levelStride + frame*This->frameStride + 1;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMWavetable_h */
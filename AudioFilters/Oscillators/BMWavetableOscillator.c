@@ -0,0 +1,207 @@
+//
+//  BMWavetableOscillator.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMWavetableOscillator.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void BMWavetableOscillator_init(BMWavetableOscillator *This, const BMWavetable *wavetable, float sampleRate){
+	// offsets into the tables are stored as int32_t so that the loop that
+	// computes them vectorises
+	assert(wavetable->levelStride * wavetable->numLevels < INT32_MAX);
+
+	This->wavetable = wavetable;
+	This->sampleRate = sampleRate;
+	This->phase = 0.0;
+
+	This->phases = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+	This->fractions = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+	This->mixes = malloc(sizeof(float) * BM_BUFFER_CHUNK_SIZE);
+	This->offsets = malloc(sizeof(int32_t) * BM_BUFFER_CHUNK_SIZE);
+	This->levels = malloc(sizeof(int32_t) * BM_BUFFER_CHUNK_SIZE);
+}
+
+
+
+
+void BMWavetableOscillator_free(BMWavetableOscillator *This){
+	free(This->phases);
+	This->phases = NULL;
+	free(This->fractions);
+	This->fractions = NULL;
+	free(This->mixes);
+	This->mixes = NULL;
+	free(This->offsets);
+	This->offsets = NULL;
+	free(This->levels);
+	This->levels = NULL;
+}
+
+
+
+
+void BMWavetableOscillator_setPhase(BMWavetableOscillator *This, double phase){
+	assert(phase >= 0.0 && phase < 1.0);
+	This->phase = phase;
+}
+
+
+
+
+/*
+ * Four point cubic Hermite interpolation between p[0] and p[1]
+ */
+static inline float BMWavetableOscillator_cubic(const float *p, float t){
+	float c1 = 0.5f * (p[1] - p[-1]);
+	float c2 = p[-1] - 2.5f * p[0] + 2.0f * p[1] - 0.5f * p[2];
+	float c3 = 0.5f * (p[2] - p[-1]) + 1.5f * (p[0] - p[1]);
+	return ((c3 * t + c2) * t + c1) * t + p[0];
+}
+
+
+
+
+/*
+ * Find the mip-map level for each sample. A sample advances
+ * step = frequency * tableLength / sampleRate samples through the table. Level
+ * L has tableLength / 2^(L+3) harmonics, so it is free of aliasing when
+ * step <= 2^(L+2). We use L = floor(log2(step)) - 1, reading the exponent
+ * directly from the bits of the floating point number.
+ */
+static void BMWavetableOscillator_levels(BMWavetableOscillator *This, const float *frequencies, size_t numSamples){
+	const BMWavetable *wt = This->wavetable;
+	float stepScale = (float)wt->tableLength / This->sampleRate;
+	float *steps = This->fractions;
+	int32_t *levels = This->levels;
+
+	for(size_t i=0; i<numSamples; i++)
+		steps[i] = frequencies[i] * stepScale;
+	memcpy(levels, steps, sizeof(float)*numSamples);
+
+	int32_t maxLevel = (int32_t)wt->numLevels - 1;
+	for(size_t i=0; i<numSamples; i++){
+		int32_t exponent = ((levels[i] >> 23) & 0xFF) - 127;
+		int32_t l = exponent - 1;
+		l = l > 0 ? l : 0;
+		levels[i] = l < maxLevel ? l : maxLevel;
+	}
+}
+
+
+
+
+static void BMWavetableOscillator_processChunk(BMWavetableOscillator *This,
+											   const float *frequencies,
+											   const float *framePositions,
+											   float *output,
+											   size_t numSamples){
+	const BMWavetable *wt = This->wavetable;
+	float *phases = This->phases;
+	float *fractions = This->fractions;
+	float *mixes = This->mixes;
+	int32_t *offsets = This->offsets;
+	const int32_t *levels = This->levels;
+
+	// advance the phase. This is sequential so we keep it in a separate loop
+	// and do it in double precision.
+	double phaseScale = 1.0 / This->sampleRate;
+	double phase = This->phase;
+	for(size_t i=0; i<numSamples; i++){
+		phases[i] = (float)phase;
+		phase += frequencies[i] * phaseScale;
+		if(phase >= 1.0) phase -= 1.0;
+	}
+	This->phase = phase;
+
+	BMWavetableOscillator_levels(This, frequencies, numSamples);
+
+	// find the position in the tables. The mask handles phases that round up
+	// to 1.0 when converted to float.
+	float tableLengthF = (float)wt->tableLength;
+	int32_t mask = (int32_t)wt->tableLength - 1;
+	int32_t levelStride = (int32_t)wt->levelStride;
+	int32_t frameStride = (int32_t)wt->frameStride;
+	bool crossfade = framePositions != NULL && wt->numFrames > 1;
+	if(crossfade){
+		float lastFrame = (float)(wt->numFrames - 1);
+		int32_t lastStart = (int32_t)wt->numFrames - 2;
+		for(size_t i=0; i<numSamples; i++){
+			float x = phases[i] * tableLengthF;
+			int32_t index = (int32_t)x;
+			fractions[i] = x - (float)index;
+
+			// frame f0 and f0 + 1, with f0 <= numFrames - 2 so that the last
+			// frame is played with mix = 1
+			float position = framePositions[i];
+			position = position > 0.0f ? position : 0.0f;
+			position = position < lastFrame ? position : lastFrame;
+			int32_t f0 = (int32_t)position;
+			f0 = f0 < lastStart ? f0 : lastStart;
+			mixes[i] = position - (float)f0;
+
+			offsets[i] = levels[i]*levelStride + f0*frameStride + (index & mask) + 1;
+		}
+	} else {
+		for(size_t i=0; i<numSamples; i++){
+			float x = phases[i] * tableLengthF;
+			int32_t index = (int32_t)x;
+			fractions[i] = x - (float)index;
+			offsets[i] = levels[i]*levelStride + (index & mask) + 1;
+		}
+	}
+
+	// interpolate
+	const float *tables = wt->tables;
+	if(crossfade){
+		for(size_t i=0; i<numSamples; i++){
+			const float *p = tables + offsets[i];
+			float y0 = BMWavetableOscillator_cubic(p, fractions[i]);
+			float y1 = BMWavetableOscillator_cubic(p + frameStride, fractions[i]);
+			output[i] = y0 + mixes[i] * (y1 - y0);
+		}
+	} else {
+		for(size_t i=0; i<numSamples; i++)
+			output[i] = BMWavetableOscillator_cubic(tables + offsets[i], fractions[i]);
+	}
+}
+
+
+
+
+void BMWavetableOscillator_process(BMWavetableOscillator *This,
+								   const float *frequencies,
+								   const float *framePositions,
+								   float *output,
+								   size_t numSamples){
+	size_t samplesRemaining = numSamples;
+	size_t i = 0;
+	while(samplesRemaining > 0){
+		size_t samplesProcessing = BM_MIN(BM_BUFFER_CHUNK_SIZE, samplesRemaining);
+
+		BMWavetableOscillator_processChunk(This,
+										   frequencies + i,
+										   framePositions ? framePositions + i : NULL,
+										   output + i,
+										   samplesProcessing);
+
+		samplesRemaining -= samplesProcessing;
+		i += samplesProcessing;
+	}
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,86 @@
+//
+//  BMWavetableOscillator.h
+//  AudioFiltersXcodeProject
+//
+//  A wavetable oscillator that reads from the band-limited mip-maps of a
+//  BMWavetable. For each sample it selects the level whose highest harmonic
+//  is below Nyquist at the current frequency, reads the two frames on either
+//  side of the frame position with four point cubic interpolation and
+//  crossfades between them.
+//
+//  The oscillator does not modify the wavetable. Many voices can play from
+//  one table and each voice only needs a few buffers of scratch space.
+//
+//  Each chunk is processed in three passes. The phase accumulator is
+//  sequential; the table offsets and interpolation fractions are computed in
+//  a loop that vectorises; the last loop reads the table and evaluates the
+//  interpolating polynomials.
+//
+//  Created by hans anderson on 10/17/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMWavetableOscillator_h
+#define BMWavetableOscillator_h
+
+#include <stdint.h>
+#include "BMWavetable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BMWavetableOscillator {
+	const BMWavetable *wavetable;
+	double phase;
+	float sampleRate;
+	float *phases, *fractions, *mixes;
+	int32_t *offsets, *levels;
+} BMWavetableOscillator;
+
+
+/*!
+ *BMWavetableOscillator_init
+ *
+ * @param This        pointer to an uninitialised struct
+ * @param wavetable   an initialised wavetable. It must not be freed before the oscillator.
+ * @param sampleRate  output sample rate
+ */
+void BMWavetableOscillator_init(BMWavetableOscillator *This, const BMWavetable *wavetable, float sampleRate);
+
+
+/*!
+ *BMWavetableOscillator_free
+ */
+void BMWavetableOscillator_free(BMWavetableOscillator *This);
+
+
+/*!
+ *BMWavetableOscillator_setPhase
+ *
+ * @param phase  in [0,1), the position in the cycle of the next output sample
+ */
+void BMWavetableOscillator_setPhase(BMWavetableOscillator *This, double phase);
+
+
+/*!
+ *BMWavetableOscillator_process
+ *
+ * @param This            pointer to an initialised struct
+ * @param frequencies     frequency in Hz for each output sample, in [0, sampleRate/2]
+ * @param framePositions  position in the wavetable for each output sample, in [0, numFrames-1]. Fractional positions crossfade between neighbouring frames. Pass NULL to play frame 0.
+ * @param output          array of length numSamples
+ * @param numSamples      any length is supported
+ */
+void BMWavetableOscillator_process(BMWavetableOscillator *This,
+								   const float *frequencies,
+								   const float *framePositions,
+								   float *output,
+								   size_t numSamples);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMWavetableOscillator_h */
@@ -17,7 +17,11 @@ extern "C" {
 #ifndef BMMidSide_h
 #define BMMidSide_h
 
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
     
     /*
      * convert 
@@ -8,7 +8,11 @@
 
 #include "BMOffset.h"
 #import "assert.h"
+#ifdef __APPLE__
 #import <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 /*
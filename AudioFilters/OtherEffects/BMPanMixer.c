@@ -8,7 +8,11 @@
 
 #include "BMPanMixer.h"
 #import <math.h>
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMPanMixer_init(BMPanMixer* This,PanMode mode, float sampleRate){
     This->panMix = 0.5;
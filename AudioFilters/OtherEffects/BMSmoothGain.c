@@ -13,7 +13,11 @@ extern "C" {
 #endif
     
 #include "BMSmoothGain.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
     
     // returns the ratio that would affect a gain change of dB if applied
@@ -14,7 +14,11 @@ extern "C" {
 #endif
     
 #include "BMTremolo.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
     
     /*
      * Uses a primary LFO to do tremolo and a secondary LFO to modulate the
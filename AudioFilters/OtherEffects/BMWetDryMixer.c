@@ -15,7 +15,11 @@ extern "C" {
 #endif
     
 #include "BMWetDryMixer.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 #include "Constants.h"
     
 #define BM_WETDRYMIXER_SMALL_CHUNK_SIZE 128
@@ -164,7 +168,7 @@ extern "C" {
                 inputDryL += numSamplesThisChunk;
                 inputWetL += numSamplesThisChunk;
                 inputDryR += numSamplesThisChunk;
-                inputWetL += numSamplesThisChunk;
+                inputWetR += numSamplesThisChunk;
                 outputL += numSamplesThisChunk;
                 outputR += numSamplesThisChunk;
                 numSamples -= numSamplesThisChunk;
@@ -11,6 +11,9 @@
 //  two or more. It will result in aliasing if used for downsampling unless the
 //  input signal has been lowpass fitlered prior to calling these functions.
 //
+//  For bandlimited conversion by any ratio in either direction, without
+//  CoreAudio, use BMPolyphaseResampler.
+//
 //  Created by hans anderson on 12/13/19.
 //  Anyone may use this file - no restrictions.
 //
@@ -12,7 +12,11 @@
 //
 
 #include "BMGaussianUpsampler.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMGaussianUpsampler_init(BMGaussianUpsampler *This, size_t upsampleFactor, size_t lowpassNumPasses){
 	This->upsampleFactor = upsampleFactor;
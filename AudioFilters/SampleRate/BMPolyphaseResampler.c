@@ -0,0 +1,368 @@
+//
+//  BMPolyphaseResampler.c
+//  AudioFiltersXcodeProject
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#include "BMPolyphaseResampler.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "Constants.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// the vector helpers below are always inlined, so the calling convention
+// for 256 bit vectors without AVX never applies
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+// filter lengths are rounded up to a multiple of BMPR_LANES
+#define BMPR_LANES 8
+
+// the input buffers hold the filter length plus this many new samples
+#define BMPR_INPUT_CHUNK BM_BUFFER_CHUNK_SIZE
+
+#define BMPR_FRACTION_BITS 32
+#define BMPR_ONE ((uint64_t)1 << BMPR_FRACTION_BITS)
+
+// unaligned vector of 8 floats
+typedef float BMPRVec __attribute__((vector_size(sizeof(float)*BMPR_LANES),aligned(4),__may_alias__));
+
+#define BMPR_INLINE static inline __attribute__((always_inline))
+
+
+
+
+BMPR_INLINE BMPRVec BMPRVec_load(const float *p){
+	return *(const BMPRVec *)p;
+}
+
+BMPR_INLINE float BMPRVec_sum(BMPRVec v){
+	float s = 0.0f;
+	for(size_t i=0; i<BMPR_LANES; i++)
+		s += v[i];
+	return s;
+}
+
+
+
+
+/*
+ * zeroth order modified Bessel function of the first kind, for the Kaiser
+ * window
+ */
+static double BMPolyphaseResampler_besselI0(double x){
+	double sum = 1.0;
+	double term = 1.0;
+	double halfX = 0.5 * x;
+	for(size_t k=1; k<64; k++){
+		term *= (halfX / (double)k) * (halfX / (double)k);
+		sum += term;
+		if(term < sum * 1.0e-17) break;
+	}
+	return sum;
+}
+
+
+
+
+/*
+ * Fill the coefficient table with a Kaiser windowed sinc lowpass filter
+ * with cutoff frequency cutoff, in cycles per input sample.
+ *
+ * Tap k of phase p multiplies the input sample at distance
+ * (numTaps/2 - 1 + p/numPhases - k) from the output time. Each phase is
+ * normalised to unity gain at DC so that the interpolation between phases
+ * does not modulate a DC signal.
+ */
+static void BMPolyphaseResampler_designTable(BMPolyphaseResampler *This, double cutoff, double beta){
+	size_t N = This->numTaps;
+	double halfLength = (double)N * 0.5;
+	double i0Beta = BMPolyphaseResampler_besselI0(beta);
+	double *phase = malloc(sizeof(double) * N);
+
+	for(size_t p=0; p<=BMPR_NUM_PHASES; p++){
+		double fraction = (double)p / (double)BMPR_NUM_PHASES;
+		double sum = 0.0;
+		for(size_t k=0; k<N; k++){
+			double d = halfLength - 1.0 + fraction - (double)k;
+			double x = d / halfLength;
+			if(fabs(x) >= 1.0){
+				phase[k] = 0.0;
+				continue;
+			}
+			double arg = 2.0 * M_PI * cutoff * d;
+			double sinc = (d == 0.0) ? 1.0 : sin(arg) / arg;
+			double window = BMPolyphaseResampler_besselI0(beta * sqrt(1.0 - x*x)) / i0Beta;
+			phase[k] = 2.0 * cutoff * sinc * window;
+			sum += phase[k];
+		}
+		float *c = This->coefficients + p*N;
+		for(size_t k=0; k<N; k++)
+			c[k] = (float)(phase[k] / sum);
+	}
+
+	free(phase);
+}
+
+
+
+
+void BMPolyphaseResampler_init(BMPolyphaseResampler *This,
+							   size_t numChannels,
+							   double inputSampleRate,
+							   double outputSampleRate,
+							   size_t numTaps){
+	assert(numChannels > 0);
+	assert(inputSampleRate > 0.0 && outputSampleRate > 0.0);
+	assert(numTaps >= BMPR_LANES);
+
+	This->numChannels = numChannels;
+	This->inputSampleRate = inputSampleRate;
+	This->outputSampleRate = outputSampleRate;
+
+	// when decreasing the sample rate, lower the cutoff and lengthen the
+	// filter by the same factor, so the transition band has the same
+	// width relative to the output sample rate
+	double ratio = outputSampleRate / inputSampleRate;
+	double bandwidth = BM_MIN(ratio, 1.0);
+	size_t N = (size_t)ceil((double)numTaps / bandwidth);
+	N = ((N + BMPR_LANES - 1) / BMPR_LANES) * BMPR_LANES;
+	This->numTaps = N;
+
+	// Kaiser's formulas for the window parameter and the transition width,
+	// with the stopband starting at the lower of the two Nyquist
+	// frequencies
+	double A = BMPR_STOPBAND_DB;
+	double beta = 0.1102 * (A - 8.7);
+	double transitionWidth = (A - 7.95) / (2.285 * 2.0 * M_PI * (double)N);
+	double cutoff = 0.5 * bandwidth - 0.5 * transitionWidth;
+	assert(cutoff > 0.0);
+
+	This->coefficients = malloc(sizeof(float) * N * (BMPR_NUM_PHASES + 1));
+	BMPolyphaseResampler_designTable(This, cutoff, beta);
+
+	This->bufferLength = N + BMPR_INPUT_CHUNK;
+	This->buffers = malloc(sizeof(float*) * numChannels);
+	for(size_t i=0; i<numChannels; i++)
+		This->buffers[i] = malloc(sizeof(float) * This->bufferLength);
+
+	BMPolyphaseResampler_setRatio(This, ratio);
+	BMPolyphaseResampler_reset(This);
+}
+
+
+
+
+void BMPolyphaseResampler_free(BMPolyphaseResampler *This){
+	free(This->coefficients);
+	This->coefficients = NULL;
+
+	for(size_t i=0; i<This->numChannels; i++){
+		free(This->buffers[i]);
+		This->buffers[i] = NULL;
+	}
+	free(This->buffers);
+	This->buffers = NULL;
+}
+
+
+
+
+void BMPolyphaseResampler_reset(BMPolyphaseResampler *This){
+	for(size_t i=0; i<This->numChannels; i++)
+		memset(This->buffers[i], 0, sizeof(float) * This->bufferLength);
+
+	// start with half a filter length of silence so that the first output
+	// is centred on the first input sample
+	This->numBuffered = This->numTaps / 2 - 1;
+	This->position = 0;
+}
+
+
+
+
+void BMPolyphaseResampler_setRatio(BMPolyphaseResampler *This, double ratio){
+	assert(ratio > 0.0);
+	This->step = (uint64_t)llround((double)BMPR_ONE / ratio);
+	assert(This->step > 0);
+}
+
+
+
+
+float BMPolyphaseResampler_getLatency(const BMPolyphaseResampler *This){
+	return (float)(This->numTaps / 2);
+}
+
+
+
+
+size_t BMPolyphaseResampler_outputLengthForInput(const BMPolyphaseResampler *This, size_t numInputFrames){
+	// an output can be computed when the whole filter fits in the input,
+	// that is, when floor(position) + numTaps <= numBuffered
+	size_t available = This->numBuffered + numInputFrames;
+	if(available < This->numTaps)
+		return 0;
+	uint64_t limit = (uint64_t)(available - This->numTaps + 1) << BMPR_FRACTION_BITS;
+	if(This->position >= limit)
+		return 0;
+	return (size_t)((limit - This->position + This->step - 1) / This->step);
+}
+
+
+
+
+size_t BMPolyphaseResampler_inputLengthForOutput(const BMPolyphaseResampler *This, size_t numOutputFrames){
+	if(numOutputFrames == 0)
+		return 0;
+	uint64_t last = This->position + (uint64_t)(numOutputFrames - 1) * This->step;
+	size_t required = (size_t)(last >> BMPR_FRACTION_BITS) + This->numTaps;
+	return required > This->numBuffered ? required - This->numBuffered : 0;
+}
+
+
+
+
+/*
+ * Compute as many outputs as the buffered input allows, up to maxOutput,
+ * writing them to output starting at outputIndex.
+ *
+ * For each output we compute the inner products with the two phases on
+ * either side of the fractional position in a single pass and interpolate
+ * between the results.
+ *
+ * @returns the number of outputs written
+ */
+BM_SIMD_DISPATCH
+static size_t BMPolyphaseResampler_generate(BMPolyphaseResampler *This,
+											float **output,
+											size_t outputIndex,
+											size_t maxOutput){
+	const size_t N = This->numTaps;
+	const uint64_t step = This->step;
+	const size_t phaseShift = BMPR_FRACTION_BITS - BMPR_NUM_PHASES_LOG2;
+	const uint64_t phaseMask = ((uint64_t)1 << phaseShift) - 1;
+	const float phaseScale = 1.0f / (float)((uint64_t)1 << phaseShift);
+
+	uint64_t position = This->position;
+	size_t count = 0;
+	while(count < maxOutput &&
+		  (size_t)(position >> BMPR_FRACTION_BITS) + N <= This->numBuffered){
+		size_t start = (size_t)(position >> BMPR_FRACTION_BITS);
+		size_t phase = (size_t)((position & (BMPR_ONE - 1)) >> phaseShift);
+		float f = (float)(position & phaseMask) * phaseScale;
+		const float *c0 = This->coefficients + phase*N;
+		const float *c1 = c0 + N;
+
+		for(size_t ch=0; ch<This->numChannels; ch++){
+			const float *x = This->buffers[ch] + start;
+			BMPRVec acc0 = {0}, acc1 = {0};
+			for(size_t k=0; k<N; k+=BMPR_LANES){
+				BMPRVec xk = BMPRVec_load(x + k);
+				acc0 += xk * BMPRVec_load(c0 + k);
+				acc1 += xk * BMPRVec_load(c1 + k);
+			}
+			float y0 = BMPRVec_sum(acc0);
+			float y1 = BMPRVec_sum(acc1);
+			output[ch][outputIndex + count] = y0 + f * (y1 - y0);
+		}
+
+		position += step;
+		count++;
+	}
+
+	This->position = position;
+	return count;
+}
+
+
+
+
+/*
+ * Discard the input that no future output will need
+ */
+static void BMPolyphaseResampler_compact(BMPolyphaseResampler *This){
+	size_t discard = (size_t)(This->position >> BMPR_FRACTION_BITS);
+	if(discard > This->numBuffered)
+		discard = This->numBuffered;
+	if(discard == 0)
+		return;
+
+	size_t remaining = This->numBuffered - discard;
+	for(size_t ch=0; ch<This->numChannels; ch++)
+		memmove(This->buffers[ch], This->buffers[ch] + discard, sizeof(float) * remaining);
+	This->numBuffered = remaining;
+	This->position -= (uint64_t)discard << BMPR_FRACTION_BITS;
+}
+
+
+
+
+/*
+ * Copy numInputFrames of input through the buffers, writing up to
+ * maxOutput frames of output
+ *
+ * @returns the number of frames written to output
+ */
+static size_t BMPolyphaseResampler_run(BMPolyphaseResampler *This,
+									   const float **input,
+									   float **output,
+									   size_t numInputFrames,
+									   size_t maxOutput){
+	size_t numConsumed = 0;
+	size_t numOutput = 0;
+
+	do {
+		// copy as much input as fits in the buffers
+		size_t space = This->bufferLength - This->numBuffered;
+		size_t n = BM_MIN(space, numInputFrames - numConsumed);
+		for(size_t ch=0; ch<This->numChannels; ch++)
+			memcpy(This->buffers[ch] + This->numBuffered, input[ch] + numConsumed, sizeof(float) * n);
+		This->numBuffered += n;
+		numConsumed += n;
+
+		numOutput += BMPolyphaseResampler_generate(This, output, numOutput, maxOutput - numOutput);
+		BMPolyphaseResampler_compact(This);
+	} while(numConsumed < numInputFrames);
+
+	return numOutput;
+}
+
+
+
+
+size_t BMPolyphaseResampler_process(BMPolyphaseResampler *This,
+									const float **input,
+									float **output,
+									size_t numInputFrames){
+	return BMPolyphaseResampler_run(This, input, output, numInputFrames, SIZE_MAX);
+}
+
+
+
+
+size_t BMPolyphaseResampler_pull(BMPolyphaseResampler *This,
+								 const float **input,
+								 float **output,
+								 size_t numOutputFrames){
+	// the last output needs all of this input, so no chunk of it can fill
+	// the buffers before the outputs are taken out
+	size_t numInputFrames = BMPolyphaseResampler_inputLengthForOutput(This, numOutputFrames);
+	size_t numOutput = BMPolyphaseResampler_run(This, input, output, numInputFrames, numOutputFrames);
+	assert(numOutput == numOutputFrames);
+	return numInputFrames;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+//
+//  BMPolyphaseResampler.h
+//  AudioFiltersXcodeProject
+//
+//  Bandlimited sample rate conversion by any ratio, for example between
+//  44.1, 48 and 96 kHz, or between two clocks that drift slightly apart.
+//
+//  Each output sample is computed by a windowed sinc filter centred at the
+//  fractional position in the input that corresponds to the output time.
+//  The filter coefficients are stored in a table of BMPR_NUM_PHASES
+//  fractional positions and the output is interpolated linearly between the
+//  two nearest positions in the table. When decreasing the sample rate the
+//  cutoff frequency is lowered to the new Nyquist frequency and the filter
+//  is made proportionally longer, so there is no aliasing.
+//
+//  The filter has linear phase, so the output is delayed by half the filter
+//  length. Use BMAudioStreamConverter instead when very low latency is more
+//  important than accuracy.
+//
+//  Streaming: the resampler keeps the input it still needs between calls,
+//  so audio may be passed in buffers of any length. To push audio through,
+//  call BMPolyphaseResampler_process with whatever input is available, after
+//  checking BMPolyphaseResampler_outputLengthForInput to make sure the output
+//  buffers are long enough. To pull an exact number of output samples, for
+//  example in an audio callback, call BMPolyphaseResampler_inputLengthForOutput
+//  to find out how much input is required, then call BMPolyphaseResampler_pull
+//  with that much input. There is no limit on the length of input or output
+//  in a single call.
+//
+//  The read position is kept in 32.32 bit fixed point, so that the ratio
+//  stays exact over any length of time.
+//
+//  Created by hans anderson on 10/16/26.
+//  Anyone may use this file without restrictions
+//
+
+#ifndef BMPolyphaseResampler_h
+#define BMPolyphaseResampler_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of fractional positions in the coefficient table, a power of two
+#define BMPR_NUM_PHASES_LOG2 8
+#define BMPR_NUM_PHASES (1 << BMPR_NUM_PHASES_LOG2)
+
+// stopband attenuation of the filter
+#define BMPR_STOPBAND_DB 96.0
+
+// recommended filter lengths
+#define BMPR_TAPS_STANDARD 64
+#define BMPR_TAPS_HIGH_QUALITY 128
+
+typedef struct BMPolyphaseResampler {
+	// (numPhases + 1) * numTaps coefficients. Phase p of the table is the
+	// filter kernel for a fractional position of p / numPhases.
+	float *coefficients;
+
+	// input samples that are still needed, one buffer per channel
+	float **buffers;
+	size_t numChannels, numTaps, bufferLength, numBuffered;
+
+	// position of the next output in the input buffers and the distance
+	// between outputs, in input samples in 32.32 bit fixed point
+	uint64_t position, step;
+
+	double inputSampleRate, outputSampleRate;
+} BMPolyphaseResampler;
+
+
+
+/*!
+ *BMPolyphaseResampler_init
+ *
+ * @param This              pointer to an uninitialised struct
+ * @param numChannels       number of audio channels
+ * @param inputSampleRate   sample rate of the input
+ * @param outputSampleRate  sample rate of the output
+ * @param numTaps           filter length when increasing the sample rate. When decreasing, the filter is longer by the ratio of the rates. The passband extends to about 81% of the Nyquist frequency with BMPR_TAPS_STANDARD and 90% with BMPR_TAPS_HIGH_QUALITY.
+ */
+void BMPolyphaseResampler_init(BMPolyphaseResampler *This,
+							   size_t numChannels,
+							   double inputSampleRate,
+							   double outputSampleRate,
+							   size_t numTaps);
+
+
+/*!
+ *BMPolyphaseResampler_free
+ */
+void BMPolyphaseResampler_free(BMPolyphaseResampler *This);
+
+
+/*!
+ *BMPolyphaseResampler_process
+ *
+ * @abstract resample numInputFrames frames of input and write all the output that can be computed from the input received so far.
+ *
+ * @param This            pointer to an initialised struct
+ * @param input           array of numChannels input buffers
+ * @param output          array of numChannels output buffers. Each must have room for BMPolyphaseResampler_outputLengthForInput(This, numInputFrames) samples.
+ * @param numInputFrames  length of input
+ *
+ * @returns the number of frames written to output
+ */
+size_t BMPolyphaseResampler_process(BMPolyphaseResampler *This,
+									const float **input,
+									float **output,
+									size_t numInputFrames);
+
+
+/*!
+ *BMPolyphaseResampler_pull
+ *
+ * @abstract output exactly numOutputFrames frames. Any output that the input allows beyond that is kept for the next call.
+ *
+ * @param This             pointer to an initialised struct
+ * @param input            array of numChannels input buffers, each BMPolyphaseResampler_inputLengthForOutput(This, numOutputFrames) samples long
+ * @param output           array of numChannels output buffers
+ * @param numOutputFrames  length of output
+ *
+ * @returns the number of input frames consumed
+ */
+size_t BMPolyphaseResampler_pull(BMPolyphaseResampler *This,
+								 const float **input,
+								 float **output,
+								 size_t numOutputFrames);
+
+
+/*!
+ *BMPolyphaseResampler_outputLengthForInput
+ *
+ * @returns the exact number of frames that BMPolyphaseResampler_process will output if it is called next with numInputFrames of input
+ */
+size_t BMPolyphaseResampler_outputLengthForInput(const BMPolyphaseResampler *This, size_t numInputFrames);
+
+
+/*!
+ *BMPolyphaseResampler_inputLengthForOutput
+ *
+ * @returns the number of input frames that BMPolyphaseResampler_pull needs next to output numOutputFrames frames. This is the smallest amount of input that makes numOutputFrames of output available.
+ */
+size_t BMPolyphaseResampler_inputLengthForOutput(const BMPolyphaseResampler *This, size_t numOutputFrames);
+
+
+/*!
+ *BMPolyphaseResampler_setRatio
+ *
+ * @abstract change the conversion ratio without interrupting the output, for following a clock that drifts. The filter cutoff is not changed, so this is only for small adjustments. For a different pair of sample rates, init a new resampler.
+ *
+ * @param This   pointer to an initialised struct
+ * @param ratio  outputSampleRate / inputSampleRate
+ */
+void BMPolyphaseResampler_setRatio(BMPolyphaseResampler *This, double ratio);
+
+
+/*!
+ *BMPolyphaseResampler_getLatency
+ *
+ * @returns the delay from input to output, in input samples
+ */
+float BMPolyphaseResampler_getLatency(const BMPolyphaseResampler *This);
+
+
+/*!
+ *BMPolyphaseResampler_reset
+ *
+ * @abstract clear the input history, as at init
+ */
+void BMPolyphaseResampler_reset(BMPolyphaseResampler *This);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BMPolyphaseResampler_h */
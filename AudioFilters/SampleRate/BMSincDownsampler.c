@@ -7,7 +7,11 @@
 //
 
 #include "BMSincDownsampler.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 void BMSincDownsampler_genKernel(BMSincDownsampler *This);
 
@@ -7,7 +7,11 @@
 //
 
 #include "Decimation.h"
+#ifdef __APPLE__
 #include <Accelerate/Accelerate.h>
+#else
+#include "BMCrossPlatformVDSP.h"
+#endif
 
 
 void maxDecimation(const float* input, float* output, size_t N, size_t outputLength){
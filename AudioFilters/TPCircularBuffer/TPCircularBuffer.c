@@ -27,11 +27,17 @@
 //  3. This notice may not be removed or altered from any source distribution.
 //
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // memfd_create
+#endif
+
 #include "TPCircularBuffer.h"
-#include <mach/mach.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__APPLE__)
+#include <mach/mach.h>
+
 #define reportResult(result,operation) (_reportResult((result),(operation),strrchr(__FILE__, '/')+1,__LINE__))
 static inline bool _reportResult(kern_return_t result, const char *operation, const char* file, int line) {
     if ( result != ERR_SUCCESS ) {
@@ -137,6 +143,125 @@ void TPCircularBufferCleanup(TPCircularBuffer *buffer) {
     memset(buffer, 0, sizeof(TPCircularBuffer));
 }
 
+#elif defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifndef MFD_HUGETLB
+#define MFD_HUGETLB 0x0004U
+#endif
+
+// The default huge page size on x86_64 and arm64 with 4k base pages
+#define TPCIRCULARBUFFER_HUGE_PAGE_SIZE (2*1024*1024)
+
+static inline size_t _roundUp(size_t length, size_t multiple) {
+    return ((length + multiple - 1) / multiple) * multiple;
+}
+
+/*
+ * Creates a memory file of the given length and maps it twice into a
+ * contiguous region of the address space, so that the second mapping
+ * mirrors the first. Returns NULL on failure.
+ */
+static void* _mapMirrored(size_t length, size_t alignment, unsigned int memfdFlags) {
+    int fd = memfd_create("TPCircularBuffer", MFD_CLOEXEC | memfdFlags);
+    if ( fd < 0 ) return NULL;
+    
+    if ( ftruncate(fd, (off_t)length) != 0 ) {
+        close(fd);
+        return NULL;
+    }
+    
+    // Reserve enough contiguous address space for both copies of the
+    // buffer, plus some slack so that we can align the start if needed
+    size_t reserveLength = length * 2 + (alignment > (size_t)getpagesize() ? alignment : 0);
+    char *reserved = mmap(NULL, reserveLength, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if ( reserved == MAP_FAILED ) {
+        close(fd);
+        return NULL;
+    }
+    char *bufferAddress = (char*)_roundUp((size_t)reserved, alignment);
+    
+    // Release the slack on either side of the aligned region
+    if ( bufferAddress > reserved ) munmap(reserved, bufferAddress - reserved);
+    char *reservedEnd = reserved + reserveLength;
+    char *bufferEnd = bufferAddress + length * 2;
+    if ( reservedEnd > bufferEnd ) munmap(bufferEnd, reservedEnd - bufferEnd);
+    
+    // Map the file into the first half and then again into the second half,
+    // replacing the reservation
+    void *first = mmap(bufferAddress, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void *second = first == MAP_FAILED ? MAP_FAILED :
+        mmap(bufferAddress + length, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    
+    // The mappings keep the memory alive after the file descriptor is closed
+    close(fd);
+    
+    if ( first == MAP_FAILED || second == MAP_FAILED ) {
+        munmap(bufferAddress, length * 2);
+        return NULL;
+    }
+    
+    return bufferAddress;
+}
+
+bool _TPCircularBufferInit(TPCircularBuffer *buffer, uint32_t length, size_t structSize) {
+    
+    assert(length > 0);
+    
+    if ( structSize != sizeof(TPCircularBuffer) ) {
+        fprintf(stderr, "TPCircularBuffer: Header version mismatch. Check for old versions of TPCircularBuffer in your project\n");
+        abort();
+    }
+    
+    void *bufferAddress = NULL;
+    
+    // Long buffers, such as multi-second delay lines, go into huge pages
+    // if the system has any reserved. This reduces TLB misses when the read
+    // and write pointers are far apart.
+    if ( length >= TPCIRCULARBUFFER_HUGE_PAGE_THRESHOLD ) {
+        size_t hugeLength = _roundUp(length, TPCIRCULARBUFFER_HUGE_PAGE_SIZE);
+        if ( hugeLength * 2 <= UINT32_MAX ) {
+            bufferAddress = _mapMirrored(hugeLength, TPCIRCULARBUFFER_HUGE_PAGE_SIZE, MFD_HUGETLB);
+            if ( bufferAddress ) buffer->length = (uint32_t)hugeLength;
+        }
+    }
+    
+    // Regular pages
+    if ( !bufferAddress ) {
+        size_t pageLength = _roundUp(length, (size_t)getpagesize());
+        bufferAddress = _mapMirrored(pageLength, (size_t)getpagesize(), 0);
+        if ( !bufferAddress ) {
+            printf("TPCircularBuffer: Couldn't map mirrored buffer memory: %s\n", strerror(errno));
+            return false;
+        }
+        buffer->length = (uint32_t)pageLength;
+        
+        // Ask for transparent huge pages where shared memory supports them
+        #ifdef MADV_HUGEPAGE
+        if ( length >= TPCIRCULARBUFFER_HUGE_PAGE_THRESHOLD )
+            madvise(bufferAddress, pageLength * 2, MADV_HUGEPAGE);
+        #endif
+    }
+    
+    buffer->buffer = bufferAddress;
+    buffer->fillCount = 0;
+    buffer->head = buffer->tail = 0;
+    buffer->atomic = true;
+    
+    return true;
+}
+
+void TPCircularBufferCleanup(TPCircularBuffer *buffer) {
+    munmap(buffer->buffer, (size_t)buffer->length * 2);
+    memset(buffer, 0, sizeof(TPCircularBuffer));
+}
+
+#else
+#error "TPCircularBuffer requires either Mach or Linux virtual memory mirroring"
+#endif
+
 void TPCircularBufferClear(TPCircularBuffer *buffer) {
     uint32_t fillCount;
     if ( TPCircularBufferTail(buffer, &fillCount) ) {
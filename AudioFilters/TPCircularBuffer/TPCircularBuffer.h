@@ -43,9 +43,14 @@
 #define TPCircularBuffer_h
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <assert.h>
 
+#ifndef __deprecated_msg
+#define __deprecated_msg(_msg) __attribute__((deprecated(_msg)))
+#endif
+
 #ifdef __cplusplus
     extern "C++" {
         #include <atomic>
@@ -61,6 +66,11 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+
+// On Linux, buffers at least this many bytes long try to use huge pages
+#ifndef TPCIRCULARBUFFER_HUGE_PAGE_THRESHOLD
+#define TPCIRCULARBUFFER_HUGE_PAGE_THRESHOLD (2*1024*1024)
+#endif
     
 typedef struct {
     void             *buffer;
@@ -78,6 +88,11 @@ typedef struct {
  *  memory mirroring technique works, the true buffer length will
  *  be multiples of the device page size (e.g. 4096 bytes)
  *
+ *  On Linux, buffers of at least TPCIRCULARBUFFER_HUGE_PAGE_THRESHOLD
+ *  bytes are first allocated from huge pages (rounding the length up to
+ *  a multiple of the huge page size). If the system has no huge pages
+ *  available, the buffer falls back to regular pages.
+ *
  *  If you intend to use the AudioBufferList utilities, you should
  *  always allocate a bit more space than you need for pure audio
  *  data, so there's room for the metadata. How much extra is required